@@ -0,0 +1,272 @@
+// standard library includes
+#include <algorithm>
+#include <cstring>
+
+// ToolAnalysis includes
+#include "ANNIEEventBlockFile.h"
+#include "ADCPulse.h"
+#include "Hit.h"
+#include "Waveform.h"
+
+namespace {
+
+  constexpr char BLOCK_FILE_MAGIC[8] = { 'A', 'N', 'N', 'I', 'E', 'B', 'L', 'K' };
+  constexpr uint32_t BLOCK_FILE_VERSION = 1;
+
+}
+
+std::map<std::string, std::shared_ptr<ANNIEEventBlockCodec> >&
+  ANNIEEventBlockCodec::codecs()
+{
+  // The bulky keys written by the event building, hit finding and MC loading
+  // tools. The type must match the one the key is Set with.
+  typedef std::map<unsigned long, std::vector<Waveform<uint16_t> > > RawWaveformMap;
+  typedef std::map<unsigned long, std::vector<std::vector<ADCPulse> > > PulseMap;
+  typedef std::map<unsigned long, std::vector<Hit> > HitMap;
+  typedef std::map<unsigned long, std::vector<MCHit> > MCHitMap;
+  static std::map<std::string, std::shared_ptr<ANNIEEventBlockCodec> > codecs = {
+    { "RawADCData", std::make_shared<ANNIEEventBlockCodecT<RawWaveformMap> >() },
+    { "RawADCAuxData", std::make_shared<ANNIEEventBlockCodecT<RawWaveformMap> >() },
+    { "RecoADCHits", std::make_shared<ANNIEEventBlockCodecT<PulseMap> >() },
+    { "RecoADCAuxHits", std::make_shared<ANNIEEventBlockCodecT<PulseMap> >() },
+    { "Hits", std::make_shared<ANNIEEventBlockCodecT<HitMap> >() },
+    { "AuxHits", std::make_shared<ANNIEEventBlockCodecT<HitMap> >() },
+    { "MCHits", std::make_shared<ANNIEEventBlockCodecT<MCHitMap> >() }
+  };
+  // TDCData is not registered: it holds Hits in data and MCHits in simulation
+  return codecs;
+}
+
+const ANNIEEventBlockCodec* ANNIEEventBlockCodec::find(const std::string& key)
+{
+  auto iter = codecs().find(key);
+  if ( iter == codecs().end() ) return nullptr;
+  return iter->second.get();
+}
+
+bool ANNIEEventBlockFileWriter::Open(const std::string& filename)
+{
+  Close();
+  entries_.clear();
+  key_names_.clear();
+  key_ids_.clear();
+
+  out_.open(filename, std::ios::out | std::ios::binary | std::ios::trunc);
+  if ( !out_.is_open() ) return false;
+
+  // Placeholder header, filled in by Close()
+  ANNIEEventBlockFileHeader header;
+  std::memset(&header, 0, sizeof(header));
+  out_.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  return out_.good();
+}
+
+int ANNIEEventBlockFileWriter::AddEntry(BoostStore& store,
+  const std::vector<std::string>& keys, bool remove_keys)
+{
+  if ( !out_.is_open() ) return -1;
+
+  std::vector<ANNIEEventBlockRecord> records;
+  std::vector<std::string> blocks;
+  for (const auto& key : keys) {
+    const ANNIEEventBlockCodec* codec = ANNIEEventBlockCodec::find(key);
+    std::string block;
+    if ( !codec || !codec->write(store, key, block) ) continue;
+
+    auto id_iter = key_ids_.find(key);
+    if ( id_iter == key_ids_.end() ) {
+      id_iter = key_ids_.emplace(key, key_names_.size()).first;
+      key_names_.push_back(key);
+    }
+    ANNIEEventBlockRecord record;
+    std::memset(&record, 0, sizeof(record));
+    record.key = id_iter->second;
+    record.size = block.size();
+    records.push_back(record);
+    blocks.push_back(std::move(block));
+  }
+
+  // The block table comes first, followed by the blocks
+  ANNIEEventBlockEntryRecord entry;
+  std::memset(&entry, 0, sizeof(entry));
+  entry.offset = out_.tellp();
+  entry.num_blocks = records.size();
+
+  uint64_t offset = entry.offset + records.size()*sizeof(ANNIEEventBlockRecord);
+  for (auto& record : records) {
+    record.offset = offset;
+    offset += (record.size + 7) / 8 * 8;
+  }
+  out_.write(reinterpret_cast<const char*>(records.data()),
+    records.size()*sizeof(ANNIEEventBlockRecord));
+  for (const auto& block : blocks) {
+    out_.write(block.data(), block.size());
+    write_padding();
+  }
+  if ( !out_.good() ) return -1;
+
+  entries_.push_back(entry);
+  if (remove_keys) {
+    for (const auto& record : records) store.Remove(key_names_[record.key]);
+  }
+  return records.size();
+}
+
+bool ANNIEEventBlockFileWriter::Close()
+{
+  if ( !out_.is_open() ) return true;
+
+  ANNIEEventBlockFileHeader header;
+  std::memset(&header, 0, sizeof(header));
+  std::memcpy(header.magic, BLOCK_FILE_MAGIC, sizeof(header.magic));
+  header.version = BLOCK_FILE_VERSION;
+  header.num_keys = key_names_.size();
+  header.num_entries = entries_.size();
+
+  header.keys_offset = out_.tellp();
+  for (const auto& name : key_names_) {
+    ANNIEEventBlockKeyRecord key;
+    std::memset(&key, 0, sizeof(key));
+    std::memcpy(key.name, name.data(), std::min(sizeof(key.name) - 1, name.size()));
+    out_.write(reinterpret_cast<const char*>(&key), sizeof(key));
+  }
+  header.index_offset = out_.tellp();
+  out_.write(reinterpret_cast<const char*>(entries_.data()),
+    entries_.size()*sizeof(ANNIEEventBlockEntryRecord));
+
+  out_.seekp(0);
+  out_.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  bool ok = out_.good();
+  out_.close();
+  return ok;
+}
+
+void ANNIEEventBlockFileWriter::write_padding()
+{
+  static const char zeros[8] = { 0 };
+  size_t remainder = static_cast<uint64_t>(out_.tellp()) % 8;
+  if (remainder != 0) out_.write(zeros, 8 - remainder);
+}
+
+bool ANNIEEventBlockFile::Open(const std::string& filename)
+{
+  Close();
+
+  in_.open(filename, std::ios::in | std::ios::binary);
+  if ( !in_.is_open() ) {
+    error_ = "could not open " + filename;
+    return false;
+  }
+  in_.seekg(0, std::ios::end);
+  size_ = in_.tellg();
+  in_.seekg(0);
+
+  ANNIEEventBlockFileHeader header;
+  bool ok = size_ >= sizeof(header)
+    && in_.read(reinterpret_cast<char*>(&header), sizeof(header))
+    && std::memcmp(header.magic, BLOCK_FILE_MAGIC, sizeof(BLOCK_FILE_MAGIC)) == 0
+    && header.version == BLOCK_FILE_VERSION
+    && header.keys_offset <= size_
+    && header.num_keys <= (size_ - header.keys_offset) / sizeof(ANNIEEventBlockKeyRecord)
+    && header.index_offset <= size_
+    && header.num_entries <= (size_ - header.index_offset) / sizeof(ANNIEEventBlockEntryRecord);
+
+  if (ok) {
+    std::vector<ANNIEEventBlockKeyRecord> keys(header.num_keys);
+    in_.seekg(header.keys_offset);
+    ok = static_cast<bool>( in_.read(reinterpret_cast<char*>(keys.data()),
+      keys.size()*sizeof(ANNIEEventBlockKeyRecord)) );
+    for (size_t k = 0; ok && k < keys.size(); ++k) {
+      key_names_.push_back( std::string(keys[k].name,
+        strnlen(keys[k].name, sizeof(keys[k].name))) );
+      key_ids_[key_names_.back()] = k;
+    }
+  }
+  if (ok) {
+    index_.resize(header.num_entries);
+    in_.seekg(header.index_offset);
+    ok = static_cast<bool>( in_.read(reinterpret_cast<char*>(index_.data()),
+      index_.size()*sizeof(ANNIEEventBlockEntryRecord)) );
+    for (size_t e = 0; ok && e < index_.size(); ++e) {
+      ok = index_[e].offset <= size_ && index_[e].num_blocks
+        <= (size_ - index_[e].offset) / sizeof(ANNIEEventBlockRecord);
+    }
+  }
+
+  if ( !ok ) {
+    Close();
+    error_ = filename + " is not a valid ANNIEEvent block file";
+    return false;
+  }
+  loaded_.assign(key_names_.size(), false);
+  return true;
+}
+
+void ANNIEEventBlockFile::Close()
+{
+  if ( in_.is_open() ) in_.close();
+  in_.clear();
+  size_ = 0;
+  key_names_.clear();
+  key_ids_.clear();
+  index_.clear();
+  blocks_.clear();
+  loaded_.clear();
+  error_.clear();
+}
+
+bool ANNIEEventBlockFile::SetEntry(size_t entry)
+{
+  blocks_.clear();
+  loaded_.assign(key_names_.size(), false);
+  if ( entry >= index_.size() ) return false;
+
+  blocks_.resize(index_[entry].num_blocks);
+  in_.seekg(index_[entry].offset);
+  if ( !in_.read(reinterpret_cast<char*>(blocks_.data()),
+    blocks_.size()*sizeof(ANNIEEventBlockRecord)) )
+  {
+    in_.clear();
+    blocks_.clear();
+    return false;
+  }
+  return true;
+}
+
+int ANNIEEventBlockFile::find_block(const std::string& key) const
+{
+  auto id_iter = key_ids_.find(key);
+  if ( id_iter == key_ids_.end() ) return -1;
+  for (size_t b = 0; b < blocks_.size(); ++b) {
+    if ( blocks_[b].key == id_iter->second ) return b;
+  }
+  return -1;
+}
+
+bool ANNIEEventBlockFile::Has(const std::string& key) const
+{
+  return find_block(key) >= 0;
+}
+
+bool ANNIEEventBlockFile::Load(const std::string& key, BoostStore& store)
+{
+  int b = find_block(key);
+  if (b < 0) return false;
+  const ANNIEEventBlockRecord& block = blocks_[b];
+  if ( loaded_[block.key] ) return true;
+
+  const ANNIEEventBlockCodec* codec = ANNIEEventBlockCodec::find(key);
+  if ( !codec || block.offset > size_ || block.size > size_ - block.offset ) {
+    return false;
+  }
+  buffer_.resize(block.size);
+  in_.seekg(block.offset);
+  if ( !in_.read(&buffer_[0], block.size) ) {
+    in_.clear();
+    return false;
+  }
+  bytes_read_ += block.size;
+  if ( !codec->read(buffer_, key, store) ) return false;
+  loaded_[block.key] = true;
+  return true;
+}
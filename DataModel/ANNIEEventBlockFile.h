@@ -0,0 +1,205 @@
+#pragma once
+// Block file holding the bulky keys of a processed ANNIEEvent file next to it
+// (<file>.blocks): each key of each entry is serialised as its own block, so a
+// key is only read from disk and decoded when it is requested. The other keys
+// stay in the ANNIEEvent BoostStore file.
+//
+// Layout (all values in host byte order, every block 8-byte aligned):
+//   ANNIEEventBlockFileHeader
+//   one block table per entry: an ANNIEEventBlockRecord (offset table entry)
+//     for each key in the entry, followed by the blocks (boost binary archives
+//     of the key's value)
+//   key table: num_keys ANNIEEventBlockKeyRecord entries
+//   entry index: num_entries ANNIEEventBlockEntryRecord entries
+
+// standard library includes
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <stdint.h>
+
+// boost includes
+#include <boost/archive/binary_iarchive.hpp>
+#include <boost/archive/binary_oarchive.hpp>
+
+// ToolAnalysis includes
+#include "BoostStore.h"
+
+struct ANNIEEventBlockFileHeader {
+  char magic[8];              // "ANNIEBLK"
+  uint32_t version;
+  uint32_t num_keys;
+  uint64_t num_entries;
+  uint64_t keys_offset;
+  uint64_t index_offset;
+};
+
+struct ANNIEEventBlockKeyRecord {
+  char name[64];
+};
+
+struct ANNIEEventBlockEntryRecord {
+  uint64_t offset;            // position of the entry's block table
+  uint32_t num_blocks;
+  uint32_t padding;
+};
+
+struct ANNIEEventBlockRecord {
+  uint32_t key;
+  uint32_t padding;
+  uint64_t offset;
+  uint64_t size;
+};
+
+/// @brief Converts the value of an ANNIEEvent key between the BoostStore and a
+/// block. Blocks can only be written for keys whose type has been registered.
+class ANNIEEventBlockCodec {
+
+  public:
+
+    virtual ~ANNIEEventBlockCodec() {}
+    virtual bool write(BoostStore& store, const std::string& key,
+      std::string& block) const = 0;
+    virtual bool read(const std::string& block, const std::string& key,
+      BoostStore& store) const = 0;
+
+    /// @brief Codec of a key, nullptr if its type is not registered. The raw
+    /// waveforms, hits and ADC pulses of the ANNIEEvent are registered by default.
+    static const ANNIEEventBlockCodec* find(const std::string& key);
+
+    template<typename T> static void register_key(const std::string& key);
+
+  protected:
+
+    static std::map<std::string,
+      std::shared_ptr<ANNIEEventBlockCodec> >& codecs();
+};
+
+template<typename T> class ANNIEEventBlockCodecT : public ANNIEEventBlockCodec {
+
+  public:
+
+    bool write(BoostStore& store, const std::string& key, std::string& block)
+      const override
+    {
+      T* value = nullptr;
+      if ( !store.Has(key) || !store.Get(key, value) || !value ) return false;
+      std::ostringstream out;
+      {
+        boost::archive::binary_oarchive archive(out);
+        archive << *value;
+      }
+      block = out.str();
+      return true;
+    }
+
+    bool read(const std::string& block, const std::string& key,
+      BoostStore& store) const override
+    {
+      std::istringstream in(block);
+      T value;
+      try {
+        boost::archive::binary_iarchive archive(in);
+        archive >> value;
+      }
+      catch (const std::exception&) {
+        return false;
+      }
+      store.Set(key, value);
+      return true;
+    }
+};
+
+template<typename T> void ANNIEEventBlockCodec::register_key(
+  const std::string& key)
+{
+  codecs()[key] = std::make_shared<ANNIEEventBlockCodecT<T> >();
+}
+
+/// @brief Writes a block file one ANNIEEvent entry at a time
+class ANNIEEventBlockFileWriter {
+
+  public:
+
+    ANNIEEventBlockFileWriter() {}
+    ~ANNIEEventBlockFileWriter() { Close(); }
+
+    bool Open(const std::string& filename);
+
+    /// @brief Write the listed keys present in the store as the blocks of the
+    /// next entry, removing them from the store if requested. Keys without a
+    /// registered codec are left in the store.
+    /// @return the number of blocks written, -1 on a write error
+    int AddEntry(BoostStore& store, const std::vector<std::string>& keys,
+      bool remove_keys);
+
+    /// @brief Write the key table and the entry index, and fill in the header
+    bool Close();
+
+    inline uint64_t num_entries() const { return entries_.size(); }
+
+  protected:
+
+    void write_padding();
+
+    std::ofstream out_;
+    std::vector<ANNIEEventBlockEntryRecord> entries_;
+    std::vector<std::string> key_names_;
+    std::map<std::string, uint32_t> key_ids_;
+};
+
+/// @brief Reads the blocks of a block file on demand
+class ANNIEEventBlockFile {
+
+  public:
+
+    ANNIEEventBlockFile() {}
+    ~ANNIEEventBlockFile() { Close(); }
+    ANNIEEventBlockFile(const ANNIEEventBlockFile&) = delete;
+    ANNIEEventBlockFile& operator=(const ANNIEEventBlockFile&) = delete;
+
+    /// @brief Name of the block file kept next to an ANNIEEvent file
+    static std::string BlockFileName(const std::string& annie_event_file)
+      { return annie_event_file + ".blocks"; }
+
+    /// @brief Read the header, key table and entry index, checking that all
+    /// offsets are within the file. On failure, error_message() describes the
+    /// problem.
+    bool Open(const std::string& filename);
+    void Close();
+
+    inline size_t num_entries() const { return index_.size(); }
+    inline const std::vector<std::string>& keys() const { return key_names_; }
+    inline const std::string& error_message() const { return error_; }
+    inline uint64_t bytes_read() const { return bytes_read_; }
+
+    /// @brief Read the block table of an entry. Keys loaded for the previous
+    /// entry are forgotten.
+    bool SetEntry(size_t entry);
+
+    /// @brief True if the current entry has a block for the key
+    bool Has(const std::string& key) const;
+
+    /// @brief Read and decode a key of the current entry into the store. The
+    /// block is only read the first time the key is requested for an entry.
+    /// @return false if the entry has no block for the key or it can't be decoded
+    bool Load(const std::string& key, BoostStore& store);
+
+  protected:
+
+    int find_block(const std::string& key) const;
+
+    std::ifstream in_;
+    uint64_t size_ = 0;
+    std::vector<std::string> key_names_;
+    std::map<std::string, uint32_t> key_ids_;
+    std::vector<ANNIEEventBlockEntryRecord> index_;
+    std::vector<ANNIEEventBlockRecord> blocks_;
+    std::vector<bool> loaded_;
+    std::string buffer_;
+    uint64_t bytes_read_ = 0;
+    std::string error_;
+};
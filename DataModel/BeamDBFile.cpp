@@ -0,0 +1,344 @@
+// standard library includes
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+// POSIX includes
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// ToolAnalysis includes
+#include "BeamDBFile.h"
+
+namespace {
+
+  constexpr char BEAM_DB_MAGIC[8] = { 'A', 'N', 'N', 'I', 'E', 'B', 'D', 'B' };
+  constexpr uint32_t BEAM_DB_VERSION = 1;
+
+  // Copy a string into a fixed-size, zero-padded field (truncating if needed)
+  template<size_t N> void copy_field(char (&field)[N], const std::string& s) {
+    std::memset(field, 0, N);
+    std::memcpy(field, s.data(), std::min(N - 1, s.size()));
+  }
+
+  template<size_t N> std::string read_field(const char (&field)[N]) {
+    return std::string(field, strnlen(field, N));
+  }
+
+}
+
+bool BeamDBFileWriter::Open(const std::string& filename)
+{
+  Close();
+  chunks_.clear();
+  devices_.clear();
+  device_ids_.clear();
+
+  out_.open(filename, std::ios::out | std::ios::binary | std::ios::trunc);
+  if ( !out_.is_open() ) return false;
+
+  // Placeholder header, filled in by Close()
+  BeamDBFileHeader header;
+  std::memset(&header, 0, sizeof(header));
+  out_.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  return out_.good();
+}
+
+bool BeamDBFileWriter::AddChunk(const std::map<std::string,
+  std::map<uint64_t, BeamDataPoint> >& beam_data, uint64_t start_ms,
+  uint64_t end_ms)
+{
+  if ( !out_.is_open() ) return false;
+
+  std::vector<BeamDBColumnRecord> columns;
+  for (const auto& device_pair : beam_data) {
+    if ( device_pair.second.empty() ) continue;
+
+    auto id_iter = device_ids_.find(device_pair.first);
+    if ( id_iter == device_ids_.end() ) {
+      BeamDBDeviceRecord device;
+      copy_field(device.name, device_pair.first);
+      copy_field(device.unit, device_pair.second.cbegin()->second.unit);
+      id_iter = device_ids_.emplace(device_pair.first,
+        devices_.size()).first;
+      devices_.push_back(device);
+    }
+
+    BeamDBColumnRecord column;
+    std::memset(&column, 0, sizeof(column));
+    column.device = id_iter->second;
+    column.count = device_pair.second.size();
+    columns.push_back(column);
+  }
+
+  // The column table comes first, followed by the time and value arrays
+  // of each column
+  BeamDBChunkRecord chunk;
+  std::memset(&chunk, 0, sizeof(chunk));
+  chunk.start_ms = start_ms;
+  chunk.end_ms = end_ms;
+  chunk.offset = out_.tellp();
+  chunk.num_columns = columns.size();
+
+  uint64_t offset = chunk.offset + columns.size()*sizeof(BeamDBColumnRecord);
+  for (auto& column : columns) {
+    column.times_offset = offset;
+    column.values_offset = offset + column.count*sizeof(uint64_t);
+    offset = column.values_offset + column.count*sizeof(double);
+  }
+  out_.write(reinterpret_cast<const char*>(columns.data()),
+    columns.size()*sizeof(BeamDBColumnRecord));
+
+  std::vector<uint64_t> times;
+  std::vector<double> values;
+  for (const auto& device_pair : beam_data) {
+    if ( device_pair.second.empty() ) continue;
+    times.clear();
+    values.clear();
+    for (const auto& point : device_pair.second) {
+      times.push_back(point.first);
+      values.push_back(point.second.value);
+    }
+    out_.write(reinterpret_cast<const char*>(times.data()),
+      times.size()*sizeof(uint64_t));
+    out_.write(reinterpret_cast<const char*>(values.data()),
+      values.size()*sizeof(double));
+  }
+
+  chunks_.push_back(chunk);
+  return out_.good();
+}
+
+bool BeamDBFileWriter::Close()
+{
+  if ( !out_.is_open() ) return true;
+
+  BeamDBFileHeader header;
+  std::memset(&header, 0, sizeof(header));
+  std::memcpy(header.magic, BEAM_DB_MAGIC, sizeof(header.magic));
+  header.version = BEAM_DB_VERSION;
+  header.num_chunks = chunks_.size();
+  header.num_devices = devices_.size();
+
+  header.devices_offset = out_.tellp();
+  out_.write(reinterpret_cast<const char*>(devices_.data()),
+    devices_.size()*sizeof(BeamDBDeviceRecord));
+  write_padding();
+
+  // The BeamFetcher downloads chunks backwards in time: sort them for the
+  // binary search in BeamDBFile::FindChunk
+  std::stable_sort(chunks_.begin(), chunks_.end(),
+    [](const BeamDBChunkRecord& a, const BeamDBChunkRecord& b) -> bool {
+      return a.start_ms < b.start_ms;
+    }
+  );
+  header.index_offset = out_.tellp();
+  out_.write(reinterpret_cast<const char*>(chunks_.data()),
+    chunks_.size()*sizeof(BeamDBChunkRecord));
+
+  header.start_ms = std::numeric_limits<uint64_t>::max();
+  header.end_ms = 0ull;
+  for (const auto& chunk : chunks_) {
+    header.start_ms = std::min(header.start_ms, chunk.start_ms);
+    header.end_ms = std::max(header.end_ms, chunk.end_ms);
+  }
+  if ( chunks_.empty() ) header.start_ms = 0ull;
+
+  out_.seekp(0);
+  out_.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  bool ok = out_.good();
+  out_.close();
+  return ok;
+}
+
+void BeamDBFileWriter::write_padding()
+{
+  static const char zeros[8] = { 0 };
+  size_t remainder = static_cast<uint64_t>(out_.tellp()) % 8;
+  if (remainder != 0) out_.write(zeros, 8 - remainder);
+}
+
+bool BeamDBFile::IsBeamDBFile(const std::string& filename)
+{
+  std::ifstream in_file(filename, std::ios::in | std::ios::binary);
+  char magic[sizeof(BEAM_DB_MAGIC)];
+  if ( !in_file.read(magic, sizeof(magic)) ) return false;
+  return std::memcmp(magic, BEAM_DB_MAGIC, sizeof(magic)) == 0;
+}
+
+bool BeamDBFile::Open(const std::string& filename)
+{
+  Close();
+
+  fd_ = open(filename.c_str(), O_RDONLY);
+  struct stat file_stat;
+  if ( fd_ < 0 || fstat(fd_, &file_stat) != 0 ) {
+    error_ = "could not open " + filename;
+    Close();
+    return false;
+  }
+  size_ = file_stat.st_size;
+  if ( size_ < sizeof(BeamDBFileHeader) ) {
+    error_ = filename + " is too short to be a beam database file";
+    Close();
+    return false;
+  }
+
+  void* mapped = mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd_, 0);
+  if ( mapped == MAP_FAILED ) {
+    error_ = "could not memory-map " + filename;
+    data_ = nullptr;
+    Close();
+    return false;
+  }
+  data_ = static_cast<const char*>(mapped);
+  header_ = at<BeamDBFileHeader>(0);
+
+  // Check that everything the lookups will touch lies inside the file
+  auto in_file = [this](uint64_t offset, uint64_t count, size_t record_size)
+    -> bool {
+    return offset % 8 == 0 && offset <= size_
+      && count <= (size_ - offset) / record_size;
+  };
+
+  bool ok = std::memcmp(header_->magic, BEAM_DB_MAGIC, sizeof(BEAM_DB_MAGIC)) == 0
+    && header_->version == BEAM_DB_VERSION
+    && in_file(header_->devices_offset, header_->num_devices,
+      sizeof(BeamDBDeviceRecord))
+    && in_file(header_->index_offset, header_->num_chunks,
+      sizeof(BeamDBChunkRecord));
+
+  if (ok) {
+    index_ = at<BeamDBChunkRecord>(header_->index_offset);
+    for (size_t c = 0; ok && c < header_->num_chunks; ++c) {
+      ok = in_file(index_[c].offset, index_[c].num_columns,
+        sizeof(BeamDBColumnRecord))
+        && ( c == 0 || index_[c - 1].start_ms <= index_[c].start_ms );
+      const BeamDBColumnRecord* cols = ok ? columns(c) : nullptr;
+      for (size_t j = 0; ok && j < index_[c].num_columns; ++j) {
+        ok = cols[j].device < header_->num_devices
+          && in_file(cols[j].times_offset, cols[j].count, sizeof(uint64_t))
+          && in_file(cols[j].values_offset, cols[j].count, sizeof(double));
+      }
+    }
+  }
+
+  if ( !ok ) {
+    error_ = filename + " is not a valid beam database file";
+    Close();
+    return false;
+  }
+
+  const BeamDBDeviceRecord* devices
+    = at<BeamDBDeviceRecord>(header_->devices_offset);
+  for (size_t d = 0; d < header_->num_devices; ++d) {
+    device_names_.push_back( read_field(devices[d].name) );
+    device_units_.push_back( read_field(devices[d].unit) );
+  }
+
+  // Latest end time of the chunks up to each position in the index, which
+  // bounds the backwards search in FindChunk
+  max_end_ms_.clear();
+  for (size_t c = 0; c < header_->num_chunks; ++c) {
+    max_end_ms_.push_back( std::max<uint64_t>(index_[c].end_ms,
+      c > 0 ? max_end_ms_.back() : 0ull) );
+  }
+
+  return true;
+}
+
+void BeamDBFile::Close()
+{
+  if (data_) munmap(const_cast<char*>(data_), size_);
+  if (fd_ >= 0) close(fd_);
+  fd_ = -1;
+  data_ = nullptr;
+  size_ = 0;
+  header_ = nullptr;
+  index_ = nullptr;
+  device_names_.clear();
+  device_units_.clear();
+  max_end_ms_.clear();
+}
+
+const BeamDBColumnRecord* BeamDBFile::columns(int chunk) const
+{
+  return at<BeamDBColumnRecord>(index_[chunk].offset);
+}
+
+int BeamDBFile::FindChunk(uint64_t ms_since_epoch) const
+{
+  if ( !header_ ) return -1;
+
+  // Last chunk that starts at or before the requested time
+  const BeamDBChunkRecord* first = index_;
+  const BeamDBChunkRecord* last = index_ + header_->num_chunks;
+  const BeamDBChunkRecord* iter = std::upper_bound(first, last, ms_since_epoch,
+    [](uint64_t ms, const BeamDBChunkRecord& chunk) -> bool {
+      return ms < chunk.start_ms;
+    }
+  );
+
+  // Step back to the latest such chunk that still covers it
+  while ( iter != first ) {
+    --iter;
+    int c = iter - first;
+    if ( max_end_ms_[c] < ms_since_epoch ) break;
+    if ( iter->end_ms >= ms_since_epoch ) return c;
+  }
+  return -1;
+}
+
+void BeamDBFile::Lookup(const std::vector<uint64_t>& ms_since_epoch,
+  std::vector<int>& chunks,
+  std::vector<std::vector<BeamDBMeasurement> >& measurements) const
+{
+  chunks.assign(ms_since_epoch.size(), -1);
+  measurements.resize(ms_since_epoch.size());
+
+  // Position in each column of the current chunk reached by the previous query
+  int current_chunk = -1;
+  std::vector<uint64_t> cursors;
+  uint64_t previous_ms = 0ull;
+
+  for (size_t q = 0; q < ms_since_epoch.size(); ++q) {
+    uint64_t ms = ms_since_epoch[q];
+    measurements[q].clear();
+
+    int c = FindChunk(ms);
+    chunks[q] = c;
+    if (c < 0) continue;
+
+    size_t num_columns = index_[c].num_columns;
+    if ( c != current_chunk || ms < previous_ms ) {
+      cursors.assign(num_columns, 0ull);
+      current_chunk = c;
+    }
+    previous_ms = ms;
+
+    const BeamDBColumnRecord* cols = columns(c);
+    for (size_t j = 0; j < num_columns; ++j) {
+      const uint64_t* times = at<uint64_t>(cols[j].times_offset);
+      const double* values = at<double>(cols[j].values_offset);
+      uint64_t count = cols[j].count;
+
+      // First measurement at or after the requested time
+      uint64_t pos = cursors[j];
+      if ( pos < count && times[pos] < ms ) {
+        pos = std::lower_bound(times + pos, times + count, ms) - times;
+      }
+      cursors[j] = pos;
+      if (pos == count) continue;
+
+      // Use the previous measurement instead if it is strictly closer
+      uint64_t nearest = pos;
+      if ( pos > 0 && (ms - times[pos - 1]) < (times[pos] - ms) ) {
+        nearest = pos - 1;
+      }
+      measurements[q].push_back({ cols[j].device, times[nearest],
+        values[nearest] });
+    }
+  }
+}
@@ -0,0 +1,159 @@
+#pragma once
+// Columnar beam database file: an alternative to the BoostStore written by
+// the BeamFetcher tool that can be memory-mapped and searched without
+// deserializing whole chunks of beam data
+//
+// Layout (all values in host byte order, every block 8-byte aligned):
+//   BeamDBFileHeader
+//   one block per chunk: a BeamDBColumnRecord for each device with data in
+//     the chunk, followed by the uint64_t times (ms since the Unix epoch,
+//     ascending) and double values of each column
+//   device table: num_devices BeamDBDeviceRecord entries (name and unit)
+//   chunk index: num_chunks BeamDBChunkRecord entries sorted by start time
+
+// standard library includes
+#include <map>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <stdint.h>
+
+// ToolAnalysis includes
+#include "BeamDataPoint.h"
+
+struct BeamDBFileHeader {
+  char magic[8];              // "ANNIEBDB"
+  uint32_t version;
+  uint32_t num_chunks;
+  uint32_t num_devices;
+  uint32_t padding;
+  uint64_t start_ms;          // earliest covered time
+  uint64_t end_ms;            // latest covered time
+  uint64_t devices_offset;
+  uint64_t index_offset;
+};
+
+struct BeamDBDeviceRecord {
+  char name[64];
+  char unit[32];
+};
+
+/// @brief Interval of times covered by a chunk (the range of times of the
+/// POT device, as in the BeamDBIndex of the BoostStore format) and the
+/// position of its column table in the file
+struct BeamDBChunkRecord {
+  uint64_t start_ms;
+  uint64_t end_ms;
+  uint64_t offset;
+  uint32_t num_columns;
+  uint32_t padding;
+};
+
+struct BeamDBColumnRecord {
+  uint32_t device;
+  uint32_t padding;
+  uint64_t count;
+  uint64_t times_offset;
+  uint64_t values_offset;
+};
+
+/// @brief A single device measurement returned by a beam database lookup
+struct BeamDBMeasurement {
+  uint32_t device;
+  uint64_t ms_since_epoch;
+  double value;
+};
+
+/// @brief Writes a columnar beam database file one chunk at a time
+class BeamDBFileWriter {
+
+  public:
+
+    BeamDBFileWriter() {}
+    ~BeamDBFileWriter() { Close(); }
+
+    bool Open(const std::string& filename);
+
+    /// @brief Append the measurements of one beam database query covering
+    /// the times [start_ms, end_ms]
+    bool AddChunk(const std::map<std::string,
+      std::map<uint64_t, BeamDataPoint> >& beam_data, uint64_t start_ms,
+      uint64_t end_ms);
+
+    /// @brief Write the device table and the sorted chunk index, and fill in
+    /// the file header
+    bool Close();
+
+  protected:
+
+    void write_padding();
+
+    std::ofstream out_;
+    std::vector<BeamDBChunkRecord> chunks_;
+    std::vector<BeamDBDeviceRecord> devices_;
+    std::map<std::string, uint32_t> device_ids_;
+};
+
+/// @brief Read-only, memory-mapped view of a columnar beam database file
+class BeamDBFile {
+
+  public:
+
+    BeamDBFile() {}
+    ~BeamDBFile() { Close(); }
+    BeamDBFile(const BeamDBFile&) = delete;
+    BeamDBFile& operator=(const BeamDBFile&) = delete;
+
+    /// @brief Returns true if the file starts with the columnar beam
+    /// database magic string
+    static bool IsBeamDBFile(const std::string& filename);
+
+    /// @brief Map the file and check that all offsets are within it.
+    /// On failure, error_message() describes the problem.
+    bool Open(const std::string& filename);
+    void Close();
+
+    inline uint64_t start_ms() const { return header_->start_ms; }
+    inline uint64_t end_ms() const { return header_->end_ms; }
+    inline size_t num_chunks() const { return header_->num_chunks; }
+    inline size_t num_devices() const { return header_->num_devices; }
+    inline const std::string& device_name(uint32_t device) const
+      { return device_names_.at(device); }
+    inline const std::string& device_unit(uint32_t device) const
+      { return device_units_.at(device); }
+    inline const std::string& error_message() const { return error_; }
+
+    /// @brief Index of the chunk used for a time: of the chunks whose
+    /// interval contains it, the one that starts last. -1 if there is none.
+    int FindChunk(uint64_t ms_since_epoch) const;
+
+    /// @brief Find the measurement of every device nearest in time to each
+    /// of the query times, using the chunk returned by FindChunk.
+    /// @details The query times must be sorted in ascending order. They are
+    /// resolved in one merge pass: within a chunk the search in each column
+    /// continues from the position of the previous query. For each query,
+    /// chunks[i] is the chunk used (-1 if the time is not covered) and
+    /// measurements[i] holds the nearest measurement of each device with
+    /// data in that chunk, leaving out devices with no measurement at or
+    /// after the query time.
+    void Lookup(const std::vector<uint64_t>& ms_since_epoch,
+      std::vector<int>& chunks,
+      std::vector<std::vector<BeamDBMeasurement> >& measurements) const;
+
+  protected:
+
+    const BeamDBColumnRecord* columns(int chunk) const;
+
+    template<typename T> const T* at(uint64_t offset) const
+      { return reinterpret_cast<const T*>(data_ + offset); }
+
+    int fd_ = -1;
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+    const BeamDBFileHeader* header_ = nullptr;
+    const BeamDBChunkRecord* index_ = nullptr;
+    std::vector<std::string> device_names_;
+    std::vector<std::string> device_units_;
+    std::vector<uint64_t> max_end_ms_;
+    std::string error_;
+};
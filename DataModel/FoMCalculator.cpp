@@ -11,6 +11,11 @@ FoMCalculator::FoMCalculator() {
   
   // default Mean time calculator type
   fMeanTimeCalculatorType = 0;
+
+  fUseFastKernels = true;
+  fCacheVtxGeo = 0;
+  fCacheLoadCount = 0;
+  fConeAllCharge = 0.0;
 }
 
 //Destructor
@@ -24,8 +29,95 @@ void FoMCalculator::LoadVertexGeometry(VertexGeometry* vtxgeo) {
 }
 
 
+void FoMCalculator::UpdateDigitCache()
+{
+  if( fCacheVtxGeo==fVtxGeo && fCacheLoadCount==fVtxGeo->GetDigitLoadCount() ) return;
+  fCacheVtxGeo = fVtxGeo;
+  fCacheLoadCount = fVtxGeo->GetDigitLoadCount();
+
+  int ndigits = fVtxGeo->GetNDigits();
+  const double* sigmas = fVtxGeo->GetDeltaSigmaArray();
+  const double* charges = fVtxGeo->GetDigitQArray();
+  const int* types = fVtxGeo->GetDigitTypeArray();
+  const bool* filtered = fVtxGeo->GetIsFilteredArray();
+  double Pnoise = 1e-8; //FIXME; Need implementation of noise model
+
+  fTimeNorm.resize(ndigits);
+  fTimeInvTwoSigma2.resize(ndigits);
+  fConeDigits.clear();
+  fConeCharge.clear();
+  fConeAllCharge = 0.0;
+  for( int idigit=0; idigit<ndigits; idigit++ ){
+    double sigma = sigmas[idigit];
+    if( types[idigit]==RecoDigit::PMT8inch ) sigma = 1.5*sigma;
+    if( types[idigit]==RecoDigit::lappd_v0 ) sigma = 1.2*sigma;
+    double A = 1.0 / ( 2.0*sigma*sqrt(0.5*TMath::Pi()) ); //normalisation constant
+    fTimeNorm[idigit] = (1.0-Pnoise)*A;
+    fTimeInvTwoSigma2[idigit] = 1.0/(2.0*sigma*sigma);
+    if( filtered[idigit] && types[idigit]==RecoDigit::PMT8inch ){
+      fConeDigits.push_back(idigit);
+      fConeCharge.push_back(charges[idigit]);
+      fConeAllCharge += charges[idigit];
+    }
+  }
+}
+
+void FoMCalculator::TimePropertiesLnLFast(double vtxTime, double& vtxFOM)
+{
+  // same likelihood as TimePropertiesLnL, with the per-digit constants cached
+  this->UpdateDigitCache();
+  int ndigits = fVtxGeo->GetNDigits();
+  const double* deltas = fVtxGeo->GetDeltaArray();
+  const double* norm = fTimeNorm.data();
+  const double* invtwosigma2 = fTimeInvTwoSigma2.data();
+  double Pnoise = 1e-8; //FIXME; Need implementation of noise model
+  double lnL = 0.0;
+  for( int idigit=0; idigit<ndigits; idigit++ ){
+    double delta = deltas[idigit] - vtxTime;
+    double P = norm[idigit]*exp(-(delta*delta)*invtwosigma2[idigit]) + Pnoise;
+    lnL += log(P);
+  }
+  double fom = -9999.;
+  if( ndigits>0 ){
+    fom = fBaseFOM - 5.0*(-2.0*lnL)/double(ndigits);
+  }
+  vtxFOM = fom;
+  return;
+}
+
+void FoMCalculator::ConePropertiesFoMFast(double coneEdge, double& coneFOM)
+{
+  // same figure of merit as ConePropertiesFoM, looping only over the cached cone digits
+  this->UpdateDigitCache();
+  double invConeEdgeLow2 = 1.0/(21.0*21.0);  // cone edge (low side)
+  double invConeEdgeHigh2 = 1.0/(3.0*3.0);   // cone edge (high side)   [muons: 3.0, electrons: 7.0]
+  const double* zenith = fVtxGeo->GetZenithArray();
+  const int* digits = fConeDigits.data();
+  const double* charges = fConeCharge.data();
+  int ncone = fConeDigits.size();
+  double coneCharge = 0.0;
+  for( int icone=0; icone<ncone; icone++ ){
+    double deltaAngle = zenith[digits[icone]] - coneEdge;
+    double d2 = deltaAngle*deltaAngle;
+    double low = 0.75 + 0.25/( 1.0 + d2*invConeEdgeLow2 );
+    double high = 1.00/( 1.0 + d2*invConeEdgeHigh2 );
+    coneCharge += charges[icone]*( deltaAngle<=0.0 ? low : high );
+  }
+  double fom = -9999.;
+  if( fConeAllCharge>0.0 ){
+    fom = fBaseFOM*coneCharge/fConeAllCharge;
+  }
+  coneFOM = fom;
+  return;
+}
+
 void FoMCalculator::TimePropertiesLnL(double vtxTime, double& vtxFOM)
 { 
+  if( fUseFastKernels ){
+    this->TimePropertiesLnLFast(vtxTime, vtxFOM);
+    return;
+  }
+
   // internal variables
   // ==================
   double weight = 0.0;
@@ -88,6 +180,11 @@ void FoMCalculator::TimePropertiesLnL(double vtxTime, double& vtxFOM)
 
 void FoMCalculator::ConePropertiesFoM(double coneEdge, double& coneFOM)
 {  
+  if( fUseFastKernels ){
+    this->ConePropertiesFoMFast(coneEdge, coneFOM);
+    return;
+  }
+
   // calculate figure of merit
   // =========================
   double coneEdgeLow = 21.0;  // cone edge (low side)      
@@ -224,7 +321,8 @@ void FoMCalculator::PointPositionChi2(double vtxX, double vtxY, double vtxZ, dou
   
   // calculate residuals
   // ===================
-  this->fVtxGeo->CalcPointResiduals(vtxX, vtxY, vtxZ, 0.0, 0.0, 0.0, 0.0); //calculate expected point vertex time for each digit
+  if( fUseFastKernels ) this->fVtxGeo->CalcPointDeltas(vtxX, vtxY, vtxZ, 0.0);
+  else this->fVtxGeo->CalcPointResiduals(vtxX, vtxY, vtxZ, 0.0, 0.0, 0.0, 0.0); //calculate expected point vertex time for each digit
 
   // calculate figure of merit
   // =========================
@@ -253,7 +351,8 @@ void FoMCalculator::PointDirectionChi2(double vtxX, double vtxY,
   
   // calculate residuals
   // ===================
-  this->fVtxGeo->CalcPointResiduals(vtxX, vtxY, vtxZ, 0.0, 
+  if( fUseFastKernels ) this->fVtxGeo->CalcDirectionalDeltas(vtxX, vtxY, vtxZ, 0.0, dirX, dirY, dirZ, false);
+  else this->fVtxGeo->CalcPointResiduals(vtxX, vtxY, vtxZ, 0.0, 
                                  dirX, dirY, dirZ); //load expected vertex time for each digit
 
   // calculate figure of merit
@@ -280,7 +379,8 @@ void FoMCalculator::PointVertexChi2(double vtxX, double vtxY, double vtxZ,
 
   // calculate residuals
   // ===================
-  this->fVtxGeo->CalcPointResiduals(vtxX, vtxY, vtxZ, 0.0, 
+  if( fUseFastKernels ) this->fVtxGeo->CalcDirectionalDeltas(vtxX, vtxY, vtxZ, 0.0, dirX, dirY, dirZ, false);
+  else this->fVtxGeo->CalcPointResiduals(vtxX, vtxY, vtxZ, 0.0, 
                                  dirX, dirY, dirZ); //calculate expected vertex time for each digit
   // calculate figure of merit
   // =========================
@@ -313,7 +413,8 @@ void FoMCalculator::ExtendedVertexChi2(double vtxX, double vtxY, double vtxZ, do
 
   // calculate residuals
   // ===================
-  this->fVtxGeo->CalcExtendedResiduals(vtxX,vtxY,vtxZ,0.0,dirX,dirY,dirZ);
+  if( fUseFastKernels ) this->fVtxGeo->CalcDirectionalDeltas(vtxX,vtxY,vtxZ,0.0,dirX,dirY,dirZ,true);
+  else this->fVtxGeo->CalcExtendedResiduals(vtxX,vtxY,vtxZ,0.0,dirX,dirY,dirZ);
   
   // calculate figure of merit
   // =========================
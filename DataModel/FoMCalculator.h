@@ -39,6 +39,10 @@ public:
   //bool fIntegralsDone;
   
   VertexGeometry* fVtxGeo;
+
+  // When true (default) the Chi2 functions use the lean VertexGeometry kernels and
+  // the cached per-digit constants below instead of the full residual calculation.
+  bool fUseFastKernels;
   
  	
   FoMCalculator();
@@ -46,6 +50,7 @@ public:
   void SetTimeFitWeight(double tweight){ fTimeFitWeight=tweight;}
   void SetConeFitWeight(double cweight){ fConeFitWeight=cweight;}
   void SetMeanTimeCalculatorType(int type) {fMeanTimeCalculatorType = type;}
+  void SetUseFastKernels(bool usefast) {fUseFastKernels = usefast;}
   void LoadVertexGeometry(VertexGeometry* vtxgeo);
   double FindSimpleTimeProperties(double myConeEdge);
   void TimePropertiesLnL(double vtxTime, double& vtxFom);
@@ -58,6 +63,22 @@ public:
   void ExtendedVertexChi2(double vtxX, double vtxY, double vtxZ, 
 	                                    double dirX, double dirY, double dirZ, 
 	                                    double coneAngle, double vtxTime, double& fom);
+
+private:
+  // per-digit constants, rebuilt only when the VertexGeometry loads new digits
+  void UpdateDigitCache();
+  void TimePropertiesLnLFast(double vtxTime, double& vtxFom);
+  void ConePropertiesFoMFast(double coneEdge, double& chi2);
+
+  VertexGeometry* fCacheVtxGeo;
+  unsigned int fCacheLoadCount;
+  std::vector<double> fTimeNorm;        // (1-Pnoise)*A for each digit
+  std::vector<double> fTimeInvTwoSigma2;// 1/(2 sigma^2) for each digit
+  std::vector<int> fConeDigits;         // filtered PMT digits entering the cone FoM
+  std::vector<double> fConeCharge;      // their charges
+  double fConeAllCharge;
+
+public:
 //  void ConePropertiesLnL(double coneParam0, double coneParam1, double coneParam2, double& coneAngle, double& coneFOM);
 //  void CorrectedVertexChi2(double vtxX, double vtxY, double vtxZ, 
 //	                                    double dirX, double dirY, double dirZ, 
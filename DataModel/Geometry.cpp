@@ -1,5 +1,6 @@
 /* vim:set noexpandtab tabstop=4 wrap */
 #include "Geometry.h"
+#include <chrono>
 
 Geometry::Geometry(double ver, Position tankc, double tankr, double tankhh, double pmtencr, double pmtenchh, double mrdw, double mrdh, double mrdd, double mrds, int ntankpmts, int nmrdpmts, int nvetopmts, int nlappds, geostatus statin, std::map<std::string,std::map<unsigned long,Detector> >dets){
 	NextFreeChannelKey=0;
@@ -40,15 +41,13 @@ Detector*  Geometry::GetDetector(unsigned long DetectorKey){
 }
 
 Detector* Geometry::ChannelToDetector(unsigned long ChannelKey){
-	if(ChannelMap.size()==0) InitChannelMap();
-	if(ChannelMap.count(ChannelKey)) return ChannelMap.at(ChannelKey);
-	return 0;
+	const ChannelLookup* thechannel = LookupChannel(ChannelKey);
+	return (thechannel) ? thechannel->detector : 0;
 }
 
 Channel* Geometry::GetChannel(unsigned long ChannelKey){
-	if(ChannelMap.size()==0) InitChannelMap();
-	if(ChannelMap.count(ChannelKey)) return &(ChannelMap.at(ChannelKey)->GetChannels()->at(ChannelKey));
-	return 0;
+	const ChannelLookup* thechannel = LookupChannel(ChannelKey);
+	return (thechannel) ? thechannel->channel : 0;
 }
 
 void Geometry::InitChannelMap(){
@@ -75,6 +74,76 @@ void Geometry::InitChannelMap(){
 			}
 		}
 	}
+	
+	// build the flat lookup table. Channel keys are normally handed out consecutively
+	// from 0, so they index an array directly; any keys far above the number of
+	// channels go to a sorted list instead so a stray large key can't blow up the array.
+	ChannelLookupTable.clear();
+	DenseChannelSlots.clear();
+	SparseChannelKeys.clear();
+	SparseChannelSlots.clear();
+	DetectorTypeNames.clear();
+	if(ChannelMap.size()==0) return;
+	unsigned long denselimit = std::min(ChannelMap.rbegin()->first+1, 4*ChannelMap.size()+4096);
+	DenseChannelSlots.assign(denselimit,-1);
+	ChannelLookupTable.reserve(ChannelMap.size());
+	for(std::map<unsigned long,Detector*>::iterator it=ChannelMap.begin(); it!=ChannelMap.end(); ++it){
+		Detector* thedetector = it->second;
+		ChannelLookup thechannel;
+		thechannel.detector = thedetector;
+		thechannel.channel = &(thedetector->GetChannels()->at(it->first));
+		thechannel.detectorkey = thedetector->GetDetectorID();
+		thechannel.element = DetectorElementFromString(thedetector->GetDetectorElement());
+		std::string thetype = thedetector->GetDetectorType();
+		std::vector<std::string>::iterator typeit = std::find(DetectorTypeNames.begin(),DetectorTypeNames.end(),thetype);
+		thechannel.typeindex = std::distance(DetectorTypeNames.begin(),typeit);
+		if(typeit==DetectorTypeNames.end()) DetectorTypeNames.push_back(thetype);
+		thechannel.position = thedetector->GetDetectorPosition();
+		int slot = ChannelLookupTable.size();
+		ChannelLookupTable.push_back(thechannel);
+		if(it->first<denselimit){
+			DenseChannelSlots.at(it->first) = slot;
+		} else {
+			SparseChannelKeys.push_back(it->first);   // map order, so already sorted
+			SparseChannelSlots.push_back(slot);
+		}
+	}
+}
+
+void Geometry::BenchmarkChannelLookup(long nlookups, double& maprate, double& tablerate){
+	if(ChannelMap.size()==0) InitChannelMap();
+	maprate = 0.;
+	tablerate = 0.;
+	if(ChannelMap.size()==0 || nlookups<=0) return;
+	// visit the channels in a scrambled but fixed order, as the hits of an event would
+	std::vector<unsigned long> keys;
+	for(std::map<unsigned long,Detector*>::iterator it=ChannelMap.begin(); it!=ChannelMap.end(); ++it) keys.push_back(it->first);
+	std::vector<unsigned long> lookupkeys(nlookups);
+	for(long i=0; i<nlookups; i++) lookupkeys[i] = keys[(i*7919)%keys.size()];
+	
+	long ntankmap=0;
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	for(long i=0; i<nlookups; i++){
+		unsigned long chankey = lookupkeys[i];
+		if(ChannelMap.count(chankey)==0) continue;
+		Detector* thedetector = ChannelMap.at(chankey);
+		if(thedetector->GetDetectorElement()=="Tank") ntankmap++;
+	}
+	std::chrono::steady_clock::time_point mid = std::chrono::steady_clock::now();
+	long ntanktable=0;
+	for(long i=0; i<nlookups; i++){
+		const ChannelLookup* thechannel = LookupChannel(lookupkeys[i]);
+		if(thechannel && thechannel->element==detectorelement::TANK) ntanktable++;
+	}
+	std::chrono::steady_clock::time_point stop = std::chrono::steady_clock::now();
+	if(ntankmap!=ntanktable){
+		cerr<<"Geometry::BenchmarkChannelLookup: map and table lookups disagree! ("
+			<<ntankmap<<" vs "<<ntanktable<<" tank channels)"<<endl;
+	}
+	double mapseconds = std::chrono::duration<double>(mid-start).count();
+	double tableseconds = std::chrono::duration<double>(stop-mid).count();
+	if(mapseconds>0) maprate = nlookups/mapseconds;
+	if(tableseconds>0) tablerate = nlookups/tableseconds;
 }
 
 void Geometry::PrintChannels(){
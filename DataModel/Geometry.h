@@ -8,9 +8,23 @@
 #include "Paddle.h"
 #include "Particle.h"
 #include "Channel.h"
+#include <vector>
+#include <algorithm>
 using namespace std;
 
 enum class geostatus : uint8_t { FULLY_OPERATIONAL, TANK_ONLY, MRD_ONLY, };
+enum class detectorelement : uint8_t { TANK, MRD, VETO, LAPPD, OTHER };
+
+// Everything the hit loops need about a channel, stored contiguously so that a
+// channel key resolves with one array index (see Geometry::LookupChannel)
+struct ChannelLookup {
+	Detector* detector;
+	Channel* channel;
+	int detectorkey;
+	detectorelement element;
+	int typeindex;          // index into Geometry::GetDetectorTypeName
+	Position position;      // detector position
+};
 
 class Geometry : public SerialisableObject{
 	
@@ -135,6 +149,39 @@ class Geometry : public SerialisableObject{
 	Detector* GetDetector(unsigned long DetectorKey);
 	Detector* ChannelToDetector(unsigned long ChannelKey);
 	Channel* GetChannel(unsigned long ChannelKey);
+	
+	// O(1) channel lookup; returns 0 for an unknown channel key
+	inline const ChannelLookup* LookupChannel(unsigned long ChannelKey){
+		if(ChannelMap.size()==0) InitChannelMap();
+		int slot = -1;
+		if(ChannelKey<DenseChannelSlots.size()){
+			slot = DenseChannelSlots[ChannelKey];
+		} else if(!SparseChannelKeys.empty()){
+			std::vector<unsigned long>::iterator it = std::lower_bound(SparseChannelKeys.begin(),SparseChannelKeys.end(),ChannelKey);
+			if(it!=SparseChannelKeys.end() && (*it)==ChannelKey) slot = SparseChannelSlots[it-SparseChannelKeys.begin()];
+		}
+		return (slot<0) ? 0 : &ChannelLookupTable[slot];
+	}
+	inline detectorelement ChannelToDetectorElement(unsigned long ChannelKey){
+		const ChannelLookup* thechannel = LookupChannel(ChannelKey);
+		return (thechannel) ? thechannel->element : detectorelement::OTHER;
+	}
+	inline int ChannelToDetectorKey(unsigned long ChannelKey){
+		const ChannelLookup* thechannel = LookupChannel(ChannelKey);
+		return (thechannel) ? thechannel->detectorkey : -1;
+	}
+	inline const std::string& GetDetectorTypeName(int typeindex){ return DetectorTypeNames.at(typeindex); }
+	static detectorelement DetectorElementFromString(const std::string& elementname){
+		if(elementname=="Tank") return detectorelement::TANK;
+		if(elementname=="MRD") return detectorelement::MRD;
+		if(elementname=="Veto") return detectorelement::VETO;
+		if(elementname=="LAPPD") return detectorelement::LAPPD;
+		return detectorelement::OTHER;
+	}
+	// time nlookups channel-key lookups (and a Tank check) through the ChannelMap and
+	// through LookupChannel, returning lookups per second for each
+	void BenchmarkChannelLookup(long nlookups, double& maprate, double& tablerate);
+	
 	Paddle* GetDetectorPaddle(unsigned long DetectorKey){
 		if(Paddles.count(DetectorKey)){
 			return (&(Paddles.at(DetectorKey)));
@@ -268,6 +315,11 @@ class Geometry : public SerialisableObject{
 	unsigned long NextFreeChannelKey;
 	std::map<int,int> DetectorKeys;
 	std::map<unsigned long,Detector*> ChannelMap;
+	std::vector<ChannelLookup> ChannelLookupTable;   // one entry per channel, built by InitChannelMap
+	std::vector<int> DenseChannelSlots;              // channel key -> table entry (-1 if none), for keys below the dense limit
+	std::vector<unsigned long> SparseChannelKeys;    // sorted channel keys above the dense limit
+	std::vector<int> SparseChannelSlots;             // table entries for SparseChannelKeys
+	std::vector<std::string> DetectorTypeNames;
 	std::map<std::string,std::map<unsigned long,Detector>> RealDetectors;
 	std::map<std::string,std::map<unsigned long,Detector*>> Detectors;
 	std::map<unsigned long, Paddle> Paddles;
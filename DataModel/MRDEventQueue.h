@@ -0,0 +1,29 @@
+#ifndef MRDEVENTQUEUE_H
+#define MRDEVENTQUEUE_H
+
+#include <deque>
+#include <string>
+#include <utility>
+#include <vector>
+#include <stdint.h>
+
+/**
+ * \struct DecodedMRDEvent
+ *
+ * One MRD trigger as decoded by the MRDDataDecoder tool.  Decoded triggers are
+ * appended to an MRDEventQueue owned (and deleted) by the decoder; the queue's
+ * address is placed in the CStore as an intptr_t ("MRDEventQueue") and the
+ * ANNIEEventBuilder drains it, so each trigger is handed over once instead of
+ * re-serialising the full maps of all pending MRD events every entry.
+ */
+struct DecodedMRDEvent{
+  uint64_t Timestamp = 0;                            //MRD trigger time, UTC ns
+  std::vector<std::pair<unsigned long, int> > Hits;  //(channel key, TDC value) pairs
+  std::string TriggerType = "No Loopback";           //"Beam", "Cosmic" or "No Loopback"
+  int BeamLoopbackTDC = -1;
+  int CosmicLoopbackTDC = -1;
+};
+
+typedef std::deque<DecodedMRDEvent> MRDEventQueue;
+
+#endif
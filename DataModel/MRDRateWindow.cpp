@@ -0,0 +1,112 @@
+#include "MRDRateWindow.h"
+
+MRDRateWindow::MRDRateWindow(uint64_t window_ms, int num_buckets, int num_channels,
+    int tdc_bins, double tdc_min, double tdc_max,
+    int paddle_bins, double paddle_min, double paddle_max)
+  : NumBuckets(num_buckets), TDCBins(tdc_bins), TDCMin(tdc_min), TDCMax(tdc_max),
+    PaddleBins(paddle_bins), PaddleMin(paddle_min), PaddleMax(paddle_max){
+
+  if (NumBuckets < 1) NumBuckets = 1;
+  BucketMs = window_ms/NumBuckets;
+  if (BucketMs == 0) BucketMs = 1;
+
+  //One bucket more than the window, for the bucket currently being filled
+  Ring.resize(NumBuckets+1);
+  for (auto& bucket : Ring){
+    bucket.channel_counts.assign(num_channels, 0);
+    bucket.tdc_counts.assign(TDCBins+2, 0);
+    bucket.paddle_counts.assign(PaddleBins+2, 0);
+  }
+  ChannelCounts.assign(num_channels, 0);
+  TDCCountsTotal.assign(TDCBins+2, 0);
+  PaddleCountsTotal.assign(PaddleBins+2, 0);
+}
+
+void MRDRateWindow::AddHit(uint64_t time_ms, int channel, unsigned int tdc){
+  Bucket* bucket = BucketFor(time_ms);
+  if (!bucket) return;
+  int bin = FindBin(tdc, TDCBins, TDCMin, TDCMax);
+  bucket->channel_counts.at(channel)++;
+  bucket->tdc_counts[bin]++;
+  bucket->num_hits++;
+  ChannelCounts.at(channel)++;
+  TDCCountsTotal[bin]++;
+  NumHitsTotal++;
+}
+
+void MRDRateWindow::AddEvent(uint64_t time_ms, unsigned int n_paddles){
+  Bucket* bucket = BucketFor(time_ms);
+  if (!bucket) return;
+  int bin = FindBin(n_paddles, PaddleBins, PaddleMin, PaddleMax);
+  bucket->paddle_counts[bin]++;
+  bucket->num_events++;
+  PaddleCountsTotal[bin]++;
+  NumEventsTotal++;
+}
+
+void MRDRateWindow::Expire(uint64_t now_ms){
+  if (OldestId < 0) return;
+  int64_t first_kept = int64_t(now_ms/BucketMs) - NumBuckets;
+  if (first_kept <= OldestId) return;
+
+  //Each bucket id is passed once; after a gap longer than the ring all buckets expire
+  if (first_kept - OldestId >= int64_t(Ring.size())){
+    for (auto& bucket : Ring) EvictBucket(bucket);
+    OldestId = first_kept;
+    return;
+  }
+  for (; OldestId < first_kept; OldestId++){
+    Bucket& bucket = Ring[OldestId % Ring.size()];
+    if (bucket.id == OldestId) EvictBucket(bucket);
+  }
+}
+
+MRDRateWindow::Bucket* MRDRateWindow::BucketFor(uint64_t time_ms){
+  if (Ring.empty()) return nullptr;
+  int64_t id = time_ms/BucketMs;
+  if (id > NewestId){
+    NewestId = id;
+    if (OldestId < 0) OldestId = (id > NumBuckets) ? id-NumBuckets : 0;
+    Expire(time_ms);
+  }
+  if (id < OldestId) return nullptr;
+
+  Bucket& bucket = Ring[id % Ring.size()];
+  if (bucket.id != id){
+    EvictBucket(bucket);
+    bucket.id = id;
+  }
+  return &bucket;
+}
+
+void MRDRateWindow::EvictBucket(Bucket& bucket){
+  if (bucket.id < 0) return;
+  if (bucket.num_hits > 0){
+    for (size_t ch = 0; ch < bucket.channel_counts.size(); ch++){
+      ChannelCounts[ch] -= bucket.channel_counts[ch];
+      bucket.channel_counts[ch] = 0;
+    }
+    for (size_t bin = 0; bin < bucket.tdc_counts.size(); bin++){
+      TDCCountsTotal[bin] -= bucket.tdc_counts[bin];
+      bucket.tdc_counts[bin] = 0;
+    }
+  }
+  if (bucket.num_events > 0){
+    for (size_t bin = 0; bin < bucket.paddle_counts.size(); bin++){
+      PaddleCountsTotal[bin] -= bucket.paddle_counts[bin];
+      bucket.paddle_counts[bin] = 0;
+    }
+  }
+  NumHitsTotal -= bucket.num_hits;
+  NumEventsTotal -= bucket.num_events;
+  bucket.num_hits = 0;
+  bucket.num_events = 0;
+  bucket.id = -1;
+}
+
+int MRDRateWindow::FindBin(double value, int nbins, double min, double max){
+  if (value < min) return 0;
+  if (value >= max) return nbins+1;
+  int bin = 1 + int((value-min)*nbins/(max-min));
+  return (bin > nbins) ? nbins : bin;
+}
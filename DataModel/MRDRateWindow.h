@@ -0,0 +1,77 @@
+#ifndef MRDRATEWINDOW_H
+#define MRDRATEWINDOW_H
+
+#include <cstddef>
+#include <vector>
+#include <stdint.h>
+
+/**
+ * \class MRDRateWindow
+ *
+ * Sliding-window aggregate of live MRD data, as used by MonitorMRDLive for the
+ * 5 minute and 1 hour rate plots.  Hits and events are counted in a ring of
+ * time buckets (window/num_buckets wide); each bucket keeps its hit count per
+ * channel and its TDC and paddle-multiplicity histograms, and the totals over
+ * the window are kept up to date as hits are added and buckets expire.
+ * Expiring a bucket subtracts it from the totals once, so eviction is
+ * amortised O(1) per hit and the plots read the totals directly.  Data older
+ * than the window is dropped with a resolution of one bucket.
+ *
+ * Histogram counts use the ROOT bin numbering: bin 0 is the underflow and bin
+ * nbins+1 the overflow.
+ */
+
+class MRDRateWindow{
+
+ public:
+
+  MRDRateWindow(){}
+  MRDRateWindow(uint64_t window_ms, int num_buckets, int num_channels,
+      int tdc_bins, double tdc_min, double tdc_max,
+      int paddle_bins, double paddle_min, double paddle_max);
+
+  void AddHit(uint64_t time_ms, int channel, unsigned int tdc);  ///< @param channel active channel number
+  void AddEvent(uint64_t time_ms, unsigned int n_paddles);
+  void Expire(uint64_t now_ms);  ///< Drop the buckets older than the window ending at now_ms
+
+  uint32_t ChannelCount(int channel) const { return ChannelCounts.at(channel); }
+  const std::vector<uint32_t>& TDCCounts() const { return TDCCountsTotal; }
+  const std::vector<uint32_t>& PaddleCounts() const { return PaddleCountsTotal; }
+  uint64_t NumHits() const { return NumHitsTotal; }
+  uint64_t NumEvents() const { return NumEventsTotal; }
+
+ private:
+
+  struct Bucket{
+    int64_t id = -1;                       //time_ms/BucketMs of the data in the bucket; -1 if empty
+    std::vector<uint32_t> channel_counts;
+    std::vector<uint32_t> tdc_counts;
+    std::vector<uint32_t> paddle_counts;
+    uint32_t num_hits = 0;
+    uint32_t num_events = 0;
+  };
+
+  Bucket* BucketFor(uint64_t time_ms);  ///< Bucket of a time stamp; nullptr if it is older than the window
+  void EvictBucket(Bucket& bucket);
+  static int FindBin(double value, int nbins, double min, double max);
+
+  uint64_t BucketMs = 1;
+  int NumBuckets = 0;
+  int64_t NewestId = -1;
+  int64_t OldestId = -1;    //oldest bucket id that may still hold data
+  std::vector<Bucket> Ring; //NumBuckets+1 buckets, indexed by id%Ring.size()
+
+  int TDCBins = 0;
+  double TDCMin = 0., TDCMax = 0.;
+  int PaddleBins = 0;
+  double PaddleMin = 0., PaddleMax = 0.;
+
+  std::vector<uint32_t> ChannelCounts;
+  std::vector<uint32_t> TDCCountsTotal;
+  std::vector<uint32_t> PaddleCountsTotal;
+  uint64_t NumHitsTotal = 0;
+  uint64_t NumEventsTotal = 0;
+
+};
+
+#endif
@@ -16,10 +16,17 @@
 #include <iostream>
 #include <iomanip>
 #include <cassert>
+#include <mutex>
 using namespace std;
 
-static MinuitOptimizer* fgMinuitOptimizer = 0;
-static FoMCalculator* fgFoMCalculator = 0;
+// The TMinuit callbacks below reach the fitter through these pointers. They are
+// thread_local and re-pointed by SetCurrentFitContext() at the start of every fit,
+// so independent MinuitOptimizers can run on different threads at the same time.
+static thread_local MinuitOptimizer* fgMinuitOptimizer = 0;
+static thread_local FoMCalculator* fgFoMCalculator = 0;
+// TMinuit registers itself with ROOT's global lists on construction and
+// destruction, so creating and deleting the minimisers is serialised.
+static std::mutex fgMinuitConstructionMutex;
 static void vertex_time_lnl(int&, double*, double& f, double* par, int)
 {  
 
@@ -167,8 +174,7 @@ static void extended_vertex_chi2(int&, double*, double& f, double* par, int)
 
 //Constructor
 MinuitOptimizer::MinuitOptimizer() {
-  fgMinuitOptimizer = this;
-  fgFoMCalculator = new FoMCalculator();
+  fFoMCalculator = new FoMCalculator();
   fSeedVtx = 0;
   fFittedVtx = new RecoVertex();
   fVtxX = -9999.;
@@ -215,6 +221,7 @@ MinuitOptimizer::MinuitOptimizer() {
   // default Mean time calculator type
   this->SetMeanTimeCalculatorType(0);
   
+  std::lock_guard<std::mutex> lock(fgMinuitConstructionMutex);
   fMinuitPointPosition = new TMinuit();
   fMinuitPointPosition->SetPrintLevel(-1);
   fMinuitPointPosition->SetMaxIterations(5000);
@@ -247,7 +254,12 @@ MinuitOptimizer::MinuitOptimizer() {
 //Destructor
 MinuitOptimizer::~MinuitOptimizer() {
 	fSeedVtx = 0;
-    delete fgFoMCalculator; fgFoMCalculator = 0;
+  if( fgMinuitOptimizer==this ) {
+    fgMinuitOptimizer = 0;
+    fgFoMCalculator = 0;
+  }
+  delete fFoMCalculator; fFoMCalculator = 0;
+  std::lock_guard<std::mutex> lock(fgMinuitConstructionMutex);
 	delete fMinuitTimeFit; fMinuitTimeFit = 0;
 	delete fMinuitPointPosition; fMinuitPointPosition = 0;
 	delete fMinuitPointDirection; fMinuitPointDirection = 0;
@@ -259,13 +271,18 @@ MinuitOptimizer::~MinuitOptimizer() {
 }
 	
 
+void MinuitOptimizer::SetCurrentFitContext() {
+  fgMinuitOptimizer = this;
+  fgFoMCalculator = fFoMCalculator;
+}
+
 void MinuitOptimizer::SetFitterTimeRange(double tmin, double tmax) {
   fTmin = tmin;
   fTmax = tmax;
 }
 
 void MinuitOptimizer::LoadVertexGeometry(VertexGeometry* vtxgeo) {
-  fgFoMCalculator->fVtxGeo = vtxgeo;	
+  fFoMCalculator->fVtxGeo = vtxgeo;	
 }
 
 void MinuitOptimizer::SetNumberOfIterations(int iterations) {
@@ -281,15 +298,15 @@ void MinuitOptimizer::SetNumberOfIterations(int iterations) {
 }
 
 void MinuitOptimizer::SetTimeFitWeight(double tweight) {
-  fgFoMCalculator->SetTimeFitWeight(tweight);	
+  fFoMCalculator->SetTimeFitWeight(tweight);	
 }
 
 void MinuitOptimizer::SetConeFitWeight(double cweight) {
-  fgFoMCalculator->SetConeFitWeight(cweight);	
+  fFoMCalculator->SetConeFitWeight(cweight);	
 }
 
 void MinuitOptimizer::SetMeanTimeCalculatorType(int type) {
-  fgFoMCalculator->SetMeanTimeCalculatorType(type);	
+  fFoMCalculator->SetMeanTimeCalculatorType(type);	
 }
 
 //Load vertex
@@ -320,12 +337,13 @@ void MinuitOptimizer::LoadVertex(double vtxX, double vtxY, double vtxZ, double v
 
 
 void MinuitOptimizer::FitPointTimeWithMinuit() {
-  fgFoMCalculator->fVtxGeo->CalcPointResiduals(fVtxX, fVtxY, fVtxZ, 0.0, 0.0, 0.0, 0.0);
+  this->SetCurrentFitContext();
+  fFoMCalculator->fVtxGeo->CalcPointResiduals(fVtxX, fVtxY, fVtxZ, 0.0, 0.0, 0.0, 0.0);
 
   // calculate mean and rms
   // ====================== 
   double meanvtxTime = 0.0;
-  meanvtxTime = fgFoMCalculator->FindSimpleTimeProperties(fConeAngle);  //returns weighted average of the expected vertex time
+  meanvtxTime = fFoMCalculator->FindSimpleTimeProperties(fConeAngle);  //returns weighted average of the expected vertex time
   // reset counter
   // =============
   time_fit_reset_itr();
@@ -359,7 +377,7 @@ void MinuitOptimizer::FitPointTimeWithMinuit() {
   // fitting done; calculate best-fit figure of merit
   // =========================
   double fom = -9999.;
-  fgFoMCalculator->TimePropertiesLnL(fitTime, fom);
+  fFoMCalculator->TimePropertiesLnL(fitTime, fom);
   
   fVtxTime = fitTime;
   fVtxFOM = fom;
@@ -371,6 +389,7 @@ void MinuitOptimizer::FitPointTimeWithMinuit() {
 
 //Fit point position in 3D
 void MinuitOptimizer::FitPointPositionWithMinuit() {
+  this->SetCurrentFitContext();
 	// seed vertex
   // ===========
   bool foundSeed = fSeedVtx->FoundVertex();
@@ -454,7 +473,7 @@ void MinuitOptimizer::FitPointPositionWithMinuit() {
   if( flag==0 ) fPass = 1; // anything else: abnormal termination 
 
   fItr = point_position_iterations();
-  fgFoMCalculator->PointPositionChi2(fVtxX,fVtxY,fVtxZ,fVtxTime,fVtxFOM);
+  fFoMCalculator->PointPositionChi2(fVtxX,fVtxY,fVtxZ,fVtxTime,fVtxFOM);
   
   // set vertex and direction
   // ========================
@@ -483,6 +502,7 @@ void MinuitOptimizer::FitPointPositionWithMinuit() {
 }
 
 void MinuitOptimizer::FitPointDirectionWithMinuit() {
+  this->SetCurrentFitContext();
   // initialization
   // ==============
   bool foundSeed = ( fSeedVtx->FoundVertex() && fSeedVtx->FoundDirection() );
@@ -573,7 +593,7 @@ void MinuitOptimizer::FitPointDirectionWithMinuit() {
   
   // calculate vertex
   // ================
-  fgFoMCalculator->PointDirectionChi2(fVtxX,fVtxY,fVtxZ,fDirX,fDirY,fDirZ,fConeAngle,fVtxFOM);
+  fFoMCalculator->PointDirectionChi2(fVtxX,fVtxY,fVtxZ,fDirX,fDirY,fDirZ,fConeAngle,fVtxFOM);
 
   // set vertex and direction
   // ========================
@@ -603,6 +623,7 @@ void MinuitOptimizer::FitPointDirectionWithMinuit() {
 }
 
 void MinuitOptimizer::FitPointVertexWithMinuit() {
+  this->SetCurrentFitContext();
   
   // seed vertex
   // ===========  
@@ -726,7 +747,7 @@ void MinuitOptimizer::FitPointVertexWithMinuit() {
   
   // fitting complete; calculate vertex FOM
   // ================
-  fgFoMCalculator->PointVertexChi2(fVtxX,fVtxY,fVtxZ,fDirX,fDirY,fDirZ,fConeAngle, fVtxTime,fVtxFOM); 
+  fFoMCalculator->PointVertexChi2(fVtxX,fVtxY,fVtxZ,fDirX,fDirY,fDirZ,fConeAngle, fVtxTime,fVtxFOM); 
   
   // set vertex and direction
   // ========================
@@ -756,6 +777,7 @@ void MinuitOptimizer::FitPointVertexWithMinuit() {
 }
 
 void MinuitOptimizer::FitExtendedVertexWithMinuit() {
+  this->SetCurrentFitContext();
   // seed vertex
   // ===========
   bool foundSeed = ( fSeedVtx->FoundVertex() 
@@ -880,7 +902,7 @@ void MinuitOptimizer::FitExtendedVertexWithMinuit() {
   
   // fit complete; calculate fit results
   // ================
-  fgFoMCalculator->ExtendedVertexChi2(fVtxX,fVtxY,fVtxZ,
+  fFoMCalculator->ExtendedVertexChi2(fVtxX,fVtxY,fVtxZ,
                            fDirX,fDirY,fDirZ, 
                            fConeAngle, fVtxTime,fVtxFOM);
                            
@@ -62,6 +62,8 @@ public:
   RecoVertex* fSeedVtx;
   RecoVertex* fFittedVtx;
   
+  FoMCalculator* fFoMCalculator;
+  
   TMinuit* fMinuitPointPosition;
   TMinuit* fMinuitPointDirection;
   TMinuit* fMinuitPointVertex; 
@@ -80,6 +82,8 @@ public:
   void SetNumberOfIterations(int iterations);
   void SetConeAngle(double cangle){ fConeAngle=cangle;}
   void LoadVertexGeometry(VertexGeometry* vtxgeo);
+  // Point the TMinuit callbacks of the calling thread at this optimizer; called by each Fit method
+  void SetCurrentFitContext();
   void LoadVertex(RecoVertex* vtx);
   void LoadVertex(double vtxX, double vtxY, double vtxZ, double vtxTime, double vtxDirX, double vtxDirY, double vtxDirZ);
   void FitPointTimeWithMinuit();
@@ -3,8 +3,13 @@
 
 #include "BoostStore.h"
 #include <Python.h>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
 
 static BoostStore* gstore;
+static std::map<std::string,BoostStore*>* gstores=NULL;  // m_data->Stores, for the array functions
 
 static PyObject* GetStoreInt(PyObject *self, PyObject *args){
   const char *command;
@@ -62,6 +67,270 @@ static PyObject* SetStoreString(PyObject *self, PyObject *args){
 }
 
 
+//////////////////////////////////////////////////////////////////////////
+// Numeric arrays
+//
+// Store.GetArray(store, key, type) returns a Store.Array: a view of the
+// std::vector<type> that BoostStore::Get(key, std::vector<type>*&) hands out
+// from m_data->Stores[store]. It exports the buffer protocol, so
+// numpy.asarray(a) or memoryview(a) use the vector's memory without copying,
+// and writing to them changes the vector in the store. A view is only valid
+// until the vector is resized or replaced, i.e. within the current Execute.
+//
+// type is one of "double", "float", "int", "unsigned int", "long" or
+// "unsigned long", and must be the element type of the stored vector.
+//
+// Maps are not contiguous: Store.GetMapArrays(store, key, keytype, valuetype)
+// returns copies of the keys and values of a std::map<keytype,valuetype> as a
+// tuple of two arrays (keytype "int" or "unsigned long").
+//
+// Store.SetArray(store, key, type, buffer) and
+// Store.SetMapArrays(store, key, keytype, valuetype, keys, values) Set a
+// std::vector<type> or std::map<keytype,valuetype> by value from any object
+// with the buffer protocol (e.g. a numpy array of the matching dtype).
+//////////////////////////////////////////////////////////////////////////
+
+typedef struct {
+  PyObject_HEAD
+  char* data;
+  Py_ssize_t shape[1];
+  Py_ssize_t strides[1];
+  Py_ssize_t itemsize;
+  const char* format;
+  void* owned;   // memory of a copy, freed with the array; NULL for views of store objects
+} StoreArrayObject;
+
+static PyTypeObject StoreArrayType = { PyVarObject_HEAD_INIT(NULL, 0) };
+static PyBufferProcs StoreArrayBufferProcs;
+static PySequenceMethods StoreArraySequenceMethods;
+
+static int StoreArrayGetBuffer(PyObject *exporter, Py_buffer *view, int flags){
+  StoreArrayObject* self=(StoreArrayObject*)exporter;
+  view->obj=exporter;
+  Py_INCREF(exporter);
+  view->buf=self->data;
+  view->len=self->shape[0]*self->itemsize;
+  view->readonly=0;
+  view->itemsize=self->itemsize;
+  view->format=(flags & PyBUF_FORMAT) ? (char*)self->format : NULL;
+  view->ndim=1;
+  view->shape=(flags & PyBUF_ND) ? self->shape : NULL;
+  view->strides=((flags & PyBUF_STRIDES)==PyBUF_STRIDES) ? self->strides : NULL;
+  view->suboffsets=NULL;
+  view->internal=NULL;
+  return 0;
+}
+
+static Py_ssize_t StoreArrayLength(PyObject *self){
+  return ((StoreArrayObject*)self)->shape[0];
+}
+
+static void StoreArrayDealloc(PyObject *self){
+  if(((StoreArrayObject*)self)->owned) PyMem_Free(((StoreArrayObject*)self)->owned);
+  PyObject_Del(self);
+}
+
+static PyObject* NewStoreArray(void* data, Py_ssize_t size, Py_ssize_t itemsize, const char* format, bool copy){
+  StoreArrayObject* self=PyObject_New(StoreArrayObject, &StoreArrayType);
+  if(self==NULL) return NULL;
+  self->owned=NULL;
+  if(copy){
+    self->owned=PyMem_Malloc(size>0 ? size*itemsize : 1);
+    if(self->owned==NULL){
+      PyObject_Del(self);
+      return PyErr_NoMemory();
+    }
+    if(size>0) std::memcpy(self->owned,data,size*itemsize);
+    data=self->owned;
+  }
+  self->data=(char*)data;
+  self->shape[0]=size;
+  self->strides[0]=itemsize;
+  self->itemsize=itemsize;
+  self->format=format;
+  return (PyObject*)self;
+}
+
+static BoostStore* GetNamedStore(const char *storename){
+  if(gstores==NULL || gstores->count(storename)==0 || gstores->at(storename)==NULL){
+    PyErr_Format(PyExc_KeyError, "No store named %s", storename);
+    return NULL;
+  }
+  return gstores->at(storename);
+}
+
+// struct module format character(s) a buffer may have to be copied into std::vector<T>
+template<typename T> struct StoreArrayFormat {};
+template<> struct StoreArrayFormat<double> { static const char* format(){ return "d"; } static const char* accepted(){ return "d"; } };
+template<> struct StoreArrayFormat<float> { static const char* format(){ return "f"; } static const char* accepted(){ return "f"; } };
+template<> struct StoreArrayFormat<int> { static const char* format(){ return "i"; } static const char* accepted(){ return "i"; } };
+template<> struct StoreArrayFormat<unsigned int> { static const char* format(){ return "I"; } static const char* accepted(){ return "I"; } };
+template<> struct StoreArrayFormat<long> { static const char* format(){ return "l"; } static const char* accepted(){ return "lq"; } };
+template<> struct StoreArrayFormat<unsigned long> { static const char* format(){ return "L"; } static const char* accepted(){ return "LQ"; } };
+
+// Get a C-contiguous 1-d buffer whose elements are of type T
+template<typename T> static bool GetTypedBuffer(PyObject *obj, Py_buffer *buffer){
+  if(PyObject_GetBuffer(obj, buffer, PyBUF_FORMAT | PyBUF_C_CONTIGUOUS)<0) return false;
+  const char* format=(buffer->format) ? buffer->format : "B";
+  if(*format=='@' || *format=='=' || *format=='<') format++;
+  if(buffer->ndim>1 || buffer->itemsize!=(Py_ssize_t)sizeof(T) || std::strlen(format)!=1 ||
+     std::strchr(StoreArrayFormat<T>::accepted(),*format)==NULL){
+    PyErr_Format(PyExc_TypeError, "Buffer of format %s does not match the requested type %s",
+                 (buffer->format) ? buffer->format : "B", StoreArrayFormat<T>::format());
+    PyBuffer_Release(buffer);
+    return false;
+  }
+  return true;
+}
+
+template<typename T> static PyObject* GetStoreVectorArray(BoostStore *store, const char *key){
+  std::vector<T>* vec=NULL;
+  if(store->Has(key)) store->Get(key,vec);
+  if(vec==NULL){
+    PyErr_Format(PyExc_KeyError, "No vector %s in the store", key);
+    return NULL;
+  }
+  return NewStoreArray(vec->data(), vec->size(), sizeof(T), StoreArrayFormat<T>::format(), false);
+}
+
+template<typename T> static PyObject* SetStoreVectorArray(BoostStore *store, const char *key, PyObject *obj){
+  Py_buffer buffer;
+  if(!GetTypedBuffer<T>(obj,&buffer)) return NULL;
+  const T* first=(const T*)buffer.buf;
+  std::vector<T> vec(first, first+buffer.len/sizeof(T));
+  PyBuffer_Release(&buffer);
+  store->Set(key,vec);
+  return Py_BuildValue("n", (Py_ssize_t)vec.size());
+}
+
+template<typename K, typename V> static PyObject* GetStoreMapArrays(BoostStore *store, const char *key){
+  std::map<K,V>* themap=NULL;
+  if(store->Has(key)) store->Get(key,themap);
+  if(themap==NULL){
+    PyErr_Format(PyExc_KeyError, "No map %s in the store", key);
+    return NULL;
+  }
+  std::vector<K> keys;
+  std::vector<V> values;
+  keys.reserve(themap->size());
+  values.reserve(themap->size());
+  for(typename std::map<K,V>::const_iterator it=themap->begin(); it!=themap->end(); ++it){
+    keys.push_back(it->first);
+    values.push_back(it->second);
+  }
+  PyObject* keyarray=NewStoreArray(keys.data(), keys.size(), sizeof(K), StoreArrayFormat<K>::format(), true);
+  PyObject* valuearray=NewStoreArray(values.data(), values.size(), sizeof(V), StoreArrayFormat<V>::format(), true);
+  if(keyarray==NULL || valuearray==NULL){
+    Py_XDECREF(keyarray);
+    Py_XDECREF(valuearray);
+    return NULL;
+  }
+  return Py_BuildValue("(NN)", keyarray, valuearray);
+}
+
+template<typename K, typename V> static PyObject* SetStoreMapArrays(BoostStore *store, const char *key, PyObject *keyobj, PyObject *valueobj){
+  Py_buffer keybuffer, valuebuffer;
+  if(!GetTypedBuffer<K>(keyobj,&keybuffer)) return NULL;
+  if(!GetTypedBuffer<V>(valueobj,&valuebuffer)){
+    PyBuffer_Release(&keybuffer);
+    return NULL;
+  }
+  Py_ssize_t n=keybuffer.len/sizeof(K);
+  if(n!=(Py_ssize_t)(valuebuffer.len/sizeof(V))){
+    PyBuffer_Release(&keybuffer);
+    PyBuffer_Release(&valuebuffer);
+    PyErr_SetString(PyExc_ValueError, "keys and values have different lengths");
+    return NULL;
+  }
+  std::map<K,V> themap;
+  const K* keys=(const K*)keybuffer.buf;
+  const V* values=(const V*)valuebuffer.buf;
+  for(Py_ssize_t i=0; i<n; i++) themap[keys[i]]=values[i];
+  PyBuffer_Release(&keybuffer);
+  PyBuffer_Release(&valuebuffer);
+  store->Set(key,themap);
+  return Py_BuildValue("n", (Py_ssize_t)themap.size());
+}
+
+template<typename K> static PyObject* GetStoreMapArraysForKey(BoostStore *store, const char *key, const std::string &valuetype){
+  if(valuetype=="double") return GetStoreMapArrays<K,double>(store,key);
+  if(valuetype=="float") return GetStoreMapArrays<K,float>(store,key);
+  if(valuetype=="int") return GetStoreMapArrays<K,int>(store,key);
+  PyErr_Format(PyExc_TypeError, "Unsupported map value type %s", valuetype.c_str());
+  return NULL;
+}
+
+template<typename K> static PyObject* SetStoreMapArraysForKey(BoostStore *store, const char *key, const std::string &valuetype, PyObject *keys, PyObject *values){
+  if(valuetype=="double") return SetStoreMapArrays<K,double>(store,key,keys,values);
+  if(valuetype=="float") return SetStoreMapArrays<K,float>(store,key,keys,values);
+  if(valuetype=="int") return SetStoreMapArrays<K,int>(store,key,keys,values);
+  PyErr_Format(PyExc_TypeError, "Unsupported map value type %s", valuetype.c_str());
+  return NULL;
+}
+
+static PyObject* GetStoreArray(PyObject *self, PyObject *args){
+  const char *storename, *key, *type;
+  if (!PyArg_ParseTuple(args, "sss", &storename, &key, &type)) return NULL;
+  BoostStore* store=GetNamedStore(storename);
+  if(store==NULL) return NULL;
+  std::string thetype(type);
+  if(thetype=="double") return GetStoreVectorArray<double>(store,key);
+  if(thetype=="float") return GetStoreVectorArray<float>(store,key);
+  if(thetype=="int") return GetStoreVectorArray<int>(store,key);
+  if(thetype=="unsigned int") return GetStoreVectorArray<unsigned int>(store,key);
+  if(thetype=="long") return GetStoreVectorArray<long>(store,key);
+  if(thetype=="unsigned long") return GetStoreVectorArray<unsigned long>(store,key);
+  PyErr_Format(PyExc_TypeError, "Unsupported array type %s", type);
+  return NULL;
+
+}
+
+static PyObject* SetStoreArray(PyObject *self, PyObject *args){
+  const char *storename, *key, *type;
+  PyObject *obj;
+  if (!PyArg_ParseTuple(args, "sssO", &storename, &key, &type, &obj)) return NULL;
+  BoostStore* store=GetNamedStore(storename);
+  if(store==NULL) return NULL;
+  std::string thetype(type);
+  if(thetype=="double") return SetStoreVectorArray<double>(store,key,obj);
+  if(thetype=="float") return SetStoreVectorArray<float>(store,key,obj);
+  if(thetype=="int") return SetStoreVectorArray<int>(store,key,obj);
+  if(thetype=="unsigned int") return SetStoreVectorArray<unsigned int>(store,key,obj);
+  if(thetype=="long") return SetStoreVectorArray<long>(store,key,obj);
+  if(thetype=="unsigned long") return SetStoreVectorArray<unsigned long>(store,key,obj);
+  PyErr_Format(PyExc_TypeError, "Unsupported array type %s", type);
+  return NULL;
+
+}
+
+static PyObject* GetStoreMapArraysPy(PyObject *self, PyObject *args){
+  const char *storename, *key, *keytype, *valuetype;
+  if (!PyArg_ParseTuple(args, "ssss", &storename, &key, &keytype, &valuetype)) return NULL;
+  BoostStore* store=GetNamedStore(storename);
+  if(store==NULL) return NULL;
+  std::string thekeytype(keytype);
+  if(thekeytype=="int") return GetStoreMapArraysForKey<int>(store,key,valuetype);
+  if(thekeytype=="unsigned long") return GetStoreMapArraysForKey<unsigned long>(store,key,valuetype);
+  PyErr_Format(PyExc_TypeError, "Unsupported map key type %s", keytype);
+  return NULL;
+
+}
+
+static PyObject* SetStoreMapArraysPy(PyObject *self, PyObject *args){
+  const char *storename, *key, *keytype, *valuetype;
+  PyObject *keys, *values;
+  if (!PyArg_ParseTuple(args, "ssssOO", &storename, &key, &keytype, &valuetype, &keys, &values)) return NULL;
+  BoostStore* store=GetNamedStore(storename);
+  if(store==NULL) return NULL;
+  std::string thekeytype(keytype);
+  if(thekeytype=="int") return SetStoreMapArraysForKey<int>(store,key,valuetype,keys,values);
+  if(thekeytype=="unsigned long") return SetStoreMapArraysForKey<unsigned long>(store,key,valuetype,keys,values);
+  PyErr_Format(PyExc_TypeError, "Unsupported map key type %s", keytype);
+  return NULL;
+
+}
+
+
 static PyMethodDef StoreMethods[] = {
   {"GetInt", GetStoreInt, METH_VARARGS,
    "Return the value of an int in the store"},
@@ -75,6 +344,14 @@ static PyMethodDef StoreMethods[] = {
    "Return the value of an int in the store"},
   {"SetString", SetStoreString, METH_VARARGS,
    "Return the value of an int in the store"},
+  {"GetArray", GetStoreArray, METH_VARARGS,
+   "Return a Store.Array view of a numeric vector in a named store"},
+  {"SetArray", SetStoreArray, METH_VARARGS,
+   "Set a numeric vector in a named store from a buffer"},
+  {"GetMapArrays", GetStoreMapArraysPy, METH_VARARGS,
+   "Return copies of the keys and values of a numeric map in a named store"},
+  {"SetMapArrays", SetStoreMapArraysPy, METH_VARARGS,
+   "Set a numeric map in a named store from buffers of keys and values"},
   {NULL, NULL, 0, NULL}
 };
 
@@ -87,5 +364,27 @@ static struct PyModuleDef StoreModule = {
     StoreMethods
 };
 
+// Create the Store module, including the Store.Array type
+static PyObject* CreateStoreModule(){
+  if(StoreArrayType.tp_name==NULL){
+    StoreArrayBufferProcs.bf_getbuffer=StoreArrayGetBuffer;
+    StoreArrayBufferProcs.bf_releasebuffer=NULL;
+    StoreArraySequenceMethods.sq_length=StoreArrayLength;
+    StoreArrayType.tp_name="Store.Array";
+    StoreArrayType.tp_basicsize=sizeof(StoreArrayObject);
+    StoreArrayType.tp_dealloc=StoreArrayDealloc;
+    StoreArrayType.tp_as_buffer=&StoreArrayBufferProcs;
+    StoreArrayType.tp_as_sequence=&StoreArraySequenceMethods;
+    StoreArrayType.tp_flags=Py_TPFLAGS_DEFAULT;
+    StoreArrayType.tp_doc="Numeric array shared with a BoostStore, use numpy.asarray or memoryview";
+  }
+  if(PyType_Ready(&StoreArrayType)<0) return NULL;
+  PyObject* module=PyModule_Create(&StoreModule);
+  if(module==NULL) return NULL;
+  Py_INCREF(&StoreArrayType);
+  PyModule_AddObject(module, "Array", (PyObject*)&StoreArrayType);
+  return module;
+}
+
 
 #endif
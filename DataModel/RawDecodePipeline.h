@@ -0,0 +1,284 @@
+#ifndef RAWDECODEPIPELINE_H
+#define RAWDECODEPIPELINE_H
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+#include <stdint.h>
+
+#include "CardData.h"
+#include "MRDOut.h"
+#include "TriggerData.h"
+#include "MRDEventQueue.h"
+
+/**
+ * \struct RawDataEntry
+ *
+ * One raw data entry of a stream as read by LoadRawData, with the run information
+ * of the file it came from, so a decoder running behind the reader still sees the
+ * run and file boundaries at the right entry.
+ */
+template<typename T> struct RawDataEntry{
+  int RunNumber = -1;
+  int SubRunNumber = -1;
+  bool NewFile = false;   //first entry of this stream in a new raw data file
+  T Data;
+};
+
+typedef RawDataEntry<std::vector<CardData> > RawPMTEntry;
+typedef RawDataEntry<MRDOut> RawMRDEntry;
+typedef RawDataEntry<TriggerData> RawCTCEntry;
+
+//Waveforms finished while decoding one PMT entry.  Key: {MTCTime}, value: "WaveMap" with key (CardID,ChannelID), value FinishedWaveform
+typedef std::map<uint64_t, std::map<std::vector<int>, std::vector<uint16_t> > > DecodedTankWaves;
+
+//Trigger words decoded from one CTC entry
+struct DecodedCTCTriggers{
+  bool NewRun = false;   //the decoder moved to a new run or subrun: drop the trigger words still pending
+  std::vector<std::pair<uint64_t,uint32_t> > Triggers;   //(CTC time in ns, trigger word)
+};
+
+/**
+ * \struct PipelineStageStats
+ *
+ * Time accounting of one stage of the pipeline: how long it was busy, and how
+ * long it stalled waiting for input or for space in the queue downstream.
+ */
+struct PipelineStageStats{
+  uint64_t Items = 0;
+  double BusySeconds = 0.;
+  double InputWaitSeconds = 0.;
+  double OutputWaitSeconds = 0.;
+  std::chrono::steady_clock::time_point Start = std::chrono::steady_clock::now();
+
+  std::string Summary() const {
+    double WallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now()-Start).count();
+    std::ostringstream out;
+    out << Items << " entries in " << WallSeconds << " s, busy " << BusySeconds << " s ("
+        << ((WallSeconds > 0.) ? 100.*BusySeconds/WallSeconds : 0.) << "% occupancy), stalled "
+        << InputWaitSeconds << " s waiting for input and " << OutputWaitSeconds << " s waiting for space downstream";
+    return out.str();
+  }
+};
+
+/**
+ * \class RawDecodePipeline
+ *
+ * Bounded queues connecting the stages of the pipelined raw data decoding
+ * (LoadRawData DecodeMode Pipelined).  A reader thread in LoadRawData pushes raw
+ * PMT, MRD and CTC entries to one input queue per stream; the PMTDataDecoder,
+ * MRDDataDecoder and TriggerDataDecoder each decode their stream in a worker thread
+ * and push one result per entry to the stream's output queue, which the
+ * ANNIEEventBuilder drains.  A full queue stalls the stage feeding it, so a stream
+ * the event builder stops draining stops being read: this back-pressure replaces
+ * the Pause*Decoding CStore flags.
+ *
+ * The pipeline is not serialisable, so its address is placed in the CStore as an
+ * intptr_t ("RawDecodePipeline").  LoadRawData creates it; every other tool that
+ * keeps the pointer Retains it in Initialise and Releases it in Finalise once its
+ * worker has joined, and the last Release deletes it.  Decoders Attach to their
+ * stream in Initialise; LoadRawData only reads attached streams.  One mutex guards all queues: items are whole raw data entries, so it
+ * is only taken a few times per entry.
+*/
+class RawDecodePipeline{
+
+ public:
+  enum Stream { Tank = 0, MRD = 1, CTC = 2, NumStreams = 3 };
+
+  explicit RawDecodePipeline(size_t capacity) : fCapacity(std::max<size_t>(capacity,1)) {}
+
+  //Pipeline of the CStore, nullptr in Sequential decoding
+  static RawDecodePipeline* FromCStore(intptr_t address){ return reinterpret_cast<RawDecodePipeline*>(address); }
+  void Retain(){ std::lock_guard<std::mutex> lock(fMutex); fUsers++; }
+  //Drop a tool's reference; the last one deletes the pipeline
+  static void Release(RawDecodePipeline*& pipeline){
+    if(!pipeline) return;
+    bool last;
+    {
+      std::lock_guard<std::mutex> lock(pipeline->fMutex);
+      last = (--pipeline->fUsers == 0);
+    }
+    if(last) delete pipeline;
+    pipeline = nullptr;
+  }
+
+  void Attach(Stream s){ std::lock_guard<std::mutex> lock(fMutex); fAttached[s] = true; }
+  bool Attached(Stream s){ std::lock_guard<std::mutex> lock(fMutex); return fAttached[s]; }
+  size_t Capacity() const { return fCapacity; }
+
+  //######### READER (LoadRawData) #########
+  bool InputFull(Stream s){ std::lock_guard<std::mutex> lock(fMutex); return InputSize(s) >= fCapacity; }
+  bool PushInput(RawPMTEntry&& entry){ return Push(fTankInput,std::move(entry),nullptr,-1); }
+  bool PushInput(RawMRDEntry&& entry){ return Push(fMRDInput,std::move(entry),nullptr,-1); }
+  bool PushInput(RawCTCEntry&& entry){ return Push(fCTCInput,std::move(entry),nullptr,-1); }
+  //Mark whether the reader has read every entry of a stream in the current file
+  void SetExhausted(Stream s, bool exhausted){ std::lock_guard<std::mutex> lock(fMutex); fExhausted[s] = exhausted; }
+  //Wait until one of the streams has space in its input queue.  false once the inputs are closed
+  bool WaitForInputSpace(const std::vector<Stream>& streams, double& WaitSeconds){
+    std::unique_lock<std::mutex> lock(fMutex);
+    auto start = std::chrono::steady_clock::now();
+    fCondition.wait(lock, [&]{
+      if(fInputsClosed) return true;
+      for(Stream s : streams) if(InputSize(s) < fCapacity) return true;
+      return false;
+    });
+    WaitSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count();
+    return !fInputsClosed;
+  }
+  //No more raw data: decoders finish the entries already queued, then close their output
+  void CloseInputs(){
+    {
+      std::lock_guard<std::mutex> lock(fMutex);
+      fInputsClosed = true;
+      fTankInput.Closed = fMRDInput.Closed = fCTCInput.Closed = true;
+    }
+    fCondition.notify_all();
+  }
+
+  //######### DECODERS #########
+  //Pop blocks until an entry is available; false once the input is closed and empty
+  bool PopInput(RawPMTEntry& entry, PipelineStageStats& stats){ return Pop(fTankInput,entry,&stats.InputWaitSeconds,Tank); }
+  bool PopInput(RawMRDEntry& entry, PipelineStageStats& stats){ return Pop(fMRDInput,entry,&stats.InputWaitSeconds,MRD); }
+  bool PopInput(RawCTCEntry& entry, PipelineStageStats& stats){ return Pop(fCTCInput,entry,&stats.InputWaitSeconds,CTC); }
+  //Push blocks while the output is full; false if it was closed (the result is dropped)
+  bool PushOutput(DecodedTankWaves&& waves, PipelineStageStats& stats){ return Push(fTankOutput,std::move(waves),&stats.OutputWaitSeconds,Tank); }
+  bool PushOutput(DecodedMRDEvent&& event, PipelineStageStats& stats){ return Push(fMRDOutput,std::move(event),&stats.OutputWaitSeconds,MRD); }
+  bool PushOutput(DecodedCTCTriggers&& triggers, PipelineStageStats& stats){ return Push(fCTCOutput,std::move(triggers),&stats.OutputWaitSeconds,CTC); }
+  void CloseOutput(Stream s){
+    {
+      std::lock_guard<std::mutex> lock(fMutex);
+      if(s == Tank) fTankOutput.Closed = true;
+      else if(s == MRD) fMRDOutput.Closed = true;
+      else fCTCOutput.Closed = true;
+    }
+    fCondition.notify_all();
+  }
+  //Used by a decoder's Finalise: unblock its worker whatever the state of the other stages
+  void Shutdown(Stream s){
+    {
+      std::lock_guard<std::mutex> lock(fMutex);
+      if(s == Tank) fTankInput.Closed = fTankOutput.Closed = true;
+      else if(s == MRD) fMRDInput.Closed = fMRDOutput.Closed = true;
+      else fCTCInput.Closed = fCTCOutput.Closed = true;
+    }
+    fCondition.notify_all();
+  }
+
+  //######### EVENT BUILDER #########
+  bool TryPopOutput(DecodedTankWaves& waves){ return Pop(fTankOutput,waves,nullptr,-1,false); }
+  bool TryPopOutput(DecodedMRDEvent& event){ return Pop(fMRDOutput,event,nullptr,-1,false); }
+  bool TryPopOutput(DecodedCTCTriggers& triggers){ return Pop(fCTCOutput,triggers,nullptr,-1,false); }
+  bool PopOutput(DecodedTankWaves& waves, double& WaitSeconds){ return Pop(fTankOutput,waves,&WaitSeconds,-1); }
+  bool PopOutput(DecodedMRDEvent& event, double& WaitSeconds){ return Pop(fMRDOutput,event,&WaitSeconds,-1); }
+  bool PopOutput(DecodedCTCTriggers& triggers, double& WaitSeconds){ return Pop(fCTCOutput,triggers,&WaitSeconds,-1); }
+  //Wait at most 'timeout' seconds for decoded data (or a closed output) on one of the streams
+  void WaitForOutput(const std::vector<Stream>& streams, double timeout, double& WaitSeconds){
+    std::unique_lock<std::mutex> lock(fMutex);
+    auto start = std::chrono::steady_clock::now();
+    fCondition.wait_for(lock, std::chrono::duration<double>(timeout), [&]{
+      for(Stream s : streams) if(OutputSize(s) > 0 || OutputClosed(s)) return true;
+      return false;
+    });
+    WaitSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count();
+  }
+  //Nothing of this stream is left to decode in the current file
+  bool Starved(Stream s){
+    std::lock_guard<std::mutex> lock(fMutex);
+    return (fExhausted[s] || fInputsClosed) && InputSize(s) == 0 && OutputSize(s) == 0 && !fBusy[s];
+  }
+
+  //Mean and maximum fill of a stream's queues, as seen by the stage pushing to them
+  std::string QueueSummary(Stream s){
+    std::lock_guard<std::mutex> lock(fMutex);
+    std::ostringstream out;
+    if(s == Tank) out << FillSummary("input",fTankInput) << ", " << FillSummary("output",fTankOutput);
+    else if(s == MRD) out << FillSummary("input",fMRDInput) << ", " << FillSummary("output",fMRDOutput);
+    else out << FillSummary("input",fCTCInput) << ", " << FillSummary("output",fCTCOutput);
+    return out.str();
+  }
+
+ private:
+  template<typename T> struct Queue{
+    std::deque<T> Items;
+    bool Closed = false;
+    uint64_t Pushes = 0;
+    double FillSum = 0.;  //sum of the queue length seen by each push
+    size_t MaxFill = 0;
+  };
+
+  //Push and Pop take the stream whose worker is busy between popping an entry and
+  //pushing its result (-1: not a worker), which Starved needs
+  template<typename T> bool Push(Queue<T>& q, T&& item, double* WaitSeconds, int busystream){
+    std::unique_lock<std::mutex> lock(fMutex);
+    if(!q.Closed && q.Items.size() >= fCapacity){
+      auto start = std::chrono::steady_clock::now();
+      fCondition.wait(lock, [&]{ return q.Closed || q.Items.size() < fCapacity; });
+      if(WaitSeconds) *WaitSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count();
+    }
+    if(busystream >= 0) fBusy[busystream] = false;
+    if(q.Closed){
+      lock.unlock();
+      fCondition.notify_all();
+      return false;
+    }
+    q.FillSum += q.Items.size();
+    q.Pushes++;
+    q.Items.push_back(std::move(item));
+    q.MaxFill = std::max(q.MaxFill,q.Items.size());
+    lock.unlock();
+    fCondition.notify_all();
+    return true;
+  }
+
+  template<typename T> bool Pop(Queue<T>& q, T& item, double* WaitSeconds, int busystream, bool wait=true){
+    std::unique_lock<std::mutex> lock(fMutex);
+    if(wait && !q.Closed && q.Items.empty()){
+      auto start = std::chrono::steady_clock::now();
+      fCondition.wait(lock, [&]{ return q.Closed || !q.Items.empty(); });
+      if(WaitSeconds) *WaitSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count();
+    }
+    if(q.Items.empty()) return false;
+    item = std::move(q.Items.front());
+    q.Items.pop_front();
+    if(busystream >= 0) fBusy[busystream] = true;
+    lock.unlock();
+    fCondition.notify_all();
+    return true;
+  }
+
+  template<typename T> std::string FillSummary(const std::string& name, const Queue<T>& q){
+    std::ostringstream out;
+    out << name << " queue mean fill " << ((q.Pushes > 0) ? q.FillSum/q.Pushes : 0.) << "/" << fCapacity
+        << " (max " << q.MaxFill << ")";
+    return out.str();
+  }
+
+  //Callers hold fMutex
+  size_t InputSize(int s) const { return (s == Tank) ? fTankInput.Items.size() : (s == MRD) ? fMRDInput.Items.size() : fCTCInput.Items.size(); }
+  size_t OutputSize(int s) const { return (s == Tank) ? fTankOutput.Items.size() : (s == MRD) ? fMRDOutput.Items.size() : fCTCOutput.Items.size(); }
+  bool OutputClosed(int s) const { return (s == Tank) ? fTankOutput.Closed : (s == MRD) ? fMRDOutput.Closed : fCTCOutput.Closed; }
+
+  size_t fCapacity;
+  int fUsers = 1;   //the creator holds the first reference
+  std::mutex fMutex;
+  std::condition_variable fCondition;   //notified on every change of any queue
+  bool fAttached[NumStreams] = {false,false,false};
+  bool fExhausted[NumStreams] = {false,false,false};
+  bool fBusy[NumStreams] = {false,false,false};
+  bool fInputsClosed = false;
+  Queue<RawPMTEntry> fTankInput;
+  Queue<RawMRDEntry> fMRDInput;
+  Queue<RawCTCEntry> fCTCInput;
+  Queue<DecodedTankWaves> fTankOutput;
+  Queue<DecodedMRDEvent> fMRDOutput;
+  Queue<DecodedCTCTriggers> fCTCOutput;
+};
+
+#endif
@@ -0,0 +1,83 @@
+#include "RawTimeIndex.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+namespace {
+  const char RAW_TIME_INDEX_MAGIC[8] = {'A','N','N','I','E','T','I','X'};
+  const uint32_t RAW_TIME_INDEX_VERSION = 1;
+}
+
+void RawTimeIndex::Clear(){
+  for (int stream=0; stream<NumStreams; stream++) StreamEntries[stream].clear();
+}
+
+RawTimeIndexEntry& RawTimeIndex::Entry(int stream, int entry){
+  std::vector<RawTimeIndexEntry>& entries = StreamEntries[stream];
+  if (entry >= int(entries.size())) entries.resize(entry+1);
+  return entries[entry];
+}
+
+bool RawTimeIndex::Write(const std::string& filename) const{
+  std::ofstream out(filename, std::ios::out | std::ios::binary | std::ios::trunc);
+  if (!out.is_open()) return false;
+
+  RawTimeIndexHeader header;
+  std::memset(&header, 0, sizeof(header));
+  std::memcpy(header.magic, RAW_TIME_INDEX_MAGIC, sizeof(header.magic));
+  header.version = RAW_TIME_INDEX_VERSION;
+  header.num_streams = NumStreams;
+  for (int stream=0; stream<NumStreams; stream++) header.num_entries[stream] = StreamEntries[stream].size();
+  out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  for (int stream=0; stream<NumStreams; stream++){
+    out.write(reinterpret_cast<const char*>(StreamEntries[stream].data()),
+        StreamEntries[stream].size()*sizeof(RawTimeIndexEntry));
+  }
+  return out.good();
+}
+
+bool RawTimeIndex::Read(const std::string& filename){
+  Clear();
+  std::ifstream in(filename, std::ios::in | std::ios::binary);
+  if (!in.is_open()) return false;
+
+  RawTimeIndexHeader header;
+  if (!in.read(reinterpret_cast<char*>(&header), sizeof(header))) return false;
+  if (std::memcmp(header.magic, RAW_TIME_INDEX_MAGIC, sizeof(header.magic)) != 0 ||
+      header.version != RAW_TIME_INDEX_VERSION || header.num_streams != NumStreams) return false;
+
+  //Check the entry counts against the file size before allocating anything
+  in.seekg(0, std::ios::end);
+  uint64_t remaining = uint64_t(in.tellg()) - sizeof(header);
+  in.seekg(sizeof(header));
+  for (int stream=0; stream<NumStreams; stream++){
+    if (header.num_entries[stream] > remaining/sizeof(RawTimeIndexEntry)) return false;
+    remaining -= header.num_entries[stream]*sizeof(RawTimeIndexEntry);
+  }
+  for (int stream=0; stream<NumStreams; stream++){
+    StreamEntries[stream].resize(header.num_entries[stream]);
+    if (!in.read(reinterpret_cast<char*>(StreamEntries[stream].data()),
+          StreamEntries[stream].size()*sizeof(RawTimeIndexEntry))){
+      Clear();
+      return false;
+    }
+  }
+  return true;
+}
+
+bool RawTimeIndex::EntryRange(int stream, uint64_t start_ns, uint64_t end_ns, int& first, int& last) const{
+  //Entries are not strictly ordered in time (cards are read out asynchronously), so
+  //every entry is checked; the index is small compared to the raw file
+  const std::vector<RawTimeIndexEntry>& entries = StreamEntries[stream];
+  first = -1;
+  last = -1;
+  for (int entry=0; entry<int(entries.size()); entry++){
+    const RawTimeIndexEntry& record = entries[entry];
+    if (record.last_ns == 0 || record.first_ns > end_ns || record.last_ns < start_ns) continue;
+    int lookback = (record.lookback_entry >= 0) ? std::min(record.lookback_entry, entry) : entry;
+    if (first < 0 || lookback < first) first = lookback;
+    last = entry;
+  }
+  return last >= 0;
+}
@@ -0,0 +1,68 @@
+#ifndef RAWTIMEINDEX_H
+#define RAWTIMEINDEX_H
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+/**
+ * \class RawTimeIndex
+ *
+ * Timestamp index of one raw data (BoostStore) file, kept in a small sidecar file
+ * next to it (<raw file>.tidx).  For each stream (PMTData, CCData, TrigData) and each
+ * entry of the stream it holds the first and last decoded timestamp (UTC ns), the
+ * range of card SequenceIDs in the entry, and for PMT data the earliest entry holding
+ * samples of the waveforms finished in the entry (look-back).  The index is written
+ * by the RawDataIndexer tool and used by LoadRawData (TimeWindowStart/End) to load
+ * only the entries of a time window.
+ *
+ * File layout (host byte order): RawTimeIndexHeader, then the RawTimeIndexEntry
+ * records of the Tank, MRD and CTC streams one after the other.
+ */
+
+struct RawTimeIndexHeader{
+  char magic[8];             //"ANNIETIX"
+  uint32_t version;
+  uint32_t num_streams;
+  uint64_t num_entries[3];   //Entries of each stream, in RawTimeIndex::Stream order
+};
+
+struct RawTimeIndexEntry{
+  uint64_t first_ns = 0;       //Earliest timestamp decoded from the entry; 0 if none
+  uint64_t last_ns = 0;        //Latest timestamp decoded from the entry; 0 if none
+  int32_t lookback_entry = -1; //Earliest entry needed to decode the entry's timestamps
+  int32_t min_sequence_id = -1;  //Card SequenceIDs of the entry (PMT data); -1 if none
+  int32_t max_sequence_id = -1;
+  int32_t padding = 0;
+};
+
+class RawTimeIndex{
+
+ public:
+
+  enum Stream {Tank=0, MRD=1, CTC=2, NumStreams=3};
+
+  RawTimeIndex(){}
+
+  static std::string SidecarName(const std::string& RawFile){ return RawFile+".tidx"; }
+
+  void Clear();
+  bool Write(const std::string& filename) const;
+  bool Read(const std::string& filename);  ///< @return false if the file is missing or not a valid index
+
+  /// Entry record of a stream, growing the stream if needed
+  RawTimeIndexEntry& Entry(int stream, int entry);
+  const std::vector<RawTimeIndexEntry>& Entries(int stream) const { return StreamEntries[stream]; }
+
+  /// Range of entries of a stream to load for the timestamps in [start_ns, end_ns]:
+  /// the entries whose timestamps overlap the window, extended back to their
+  /// look-back entry.  @return false if no entry of the stream overlaps the window
+  bool EntryRange(int stream, uint64_t start_ns, uint64_t end_ns, int& first, int& last) const;
+
+ private:
+
+  std::vector<RawTimeIndexEntry> StreamEntries[NumStreams];
+
+};
+
+#endif
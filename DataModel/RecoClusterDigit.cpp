@@ -22,6 +22,16 @@ RecoClusterDigit::~RecoClusterDigit()
   ANNIERecoObjectTable::Instance()->DeleteClusterDigit();
 }
 
+void RecoClusterDigit::Reset(RecoDigit* recoDigit)
+{
+  fIsClustered = 0;
+  fIsAllClustered = 0;
+
+  fRecoDigit = recoDigit;
+
+  fClusterDigitList->clear();
+}
+
 void RecoClusterDigit::AddClusterDigit(RecoClusterDigit* clusterDigit)
 { 
   fClusterDigitList->push_back(clusterDigit); 
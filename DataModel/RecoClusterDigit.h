@@ -14,6 +14,9 @@ class RecoClusterDigit : public SerialisableObject {
   RecoClusterDigit( RecoDigit* recoDigit );
   ~RecoClusterDigit();
 
+  // Reuse this cluster digit for another RecoDigit, keeping the list storage
+  void Reset( RecoDigit* recoDigit );
+
   void AddClusterDigit(RecoClusterDigit* clusterDigit);
   
   int GetNClusterDigits(); 
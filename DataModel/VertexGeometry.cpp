@@ -3,6 +3,7 @@
 
 #include <vector>
 #include <cmath>
+#include <algorithm>
 #include <iostream>
 #include <cassert>
 
@@ -24,6 +25,7 @@ VertexGeometry* VertexGeometry::Instance()
 VertexGeometry::VertexGeometry()
 {
   fNDigitsMax = 10000;
+  fDigitLoadCount = 0;
   fNDigits = 0;
   fNFilterDigits = 0;
   fThisDigit = 0;
@@ -80,6 +82,7 @@ VertexGeometry::VertexGeometry()
   fExtendedResidual = new double[fNDigitsMax];
 
   fDelta = new double[fNDigitsMax];
+  fCosZenith = new double[fNDigitsMax];
   
   for( int n=0; n<fNDigitsMax; n++ ){
     fIsFiltered[n] = 0.0;
@@ -109,6 +112,7 @@ VertexGeometry::VertexGeometry()
     fPointResidual[n] = 0.0;
     fExtendedResidual[n] = 0.0;
     fDelta[n] = 0.0;
+    fCosZenith[n] = 0.0;
   }
 }
 
@@ -168,6 +172,7 @@ VertexGeometry::~VertexGeometry()
   if( fExtendedResidual ) delete [] fExtendedResidual;
 
   if( fDelta ) delete [] fDelta; 
+  if( fCosZenith ) delete [] fCosZenith;
 }
 
 void VertexGeometry::LoadDigits(std::vector<RecoDigit>* vDigitList)
@@ -175,6 +180,7 @@ void VertexGeometry::LoadDigits(std::vector<RecoDigit>* vDigitList)
 
   fNDigits = 0;
   fNFilterDigits = 0;
+  fDigitLoadCount++;
   
   fThisDigit = 0;
   fLastEntry = 0;
@@ -256,7 +262,7 @@ void VertexGeometry::LoadDigits(std::vector<RecoDigit>* vDigitList)
     fDistScatter[idigit] = 0.0;
 
     fDeltaTime[idigit] = 0.0;
-    fDeltaSigma[idigit] = 0.0;
+    fDeltaSigma[idigit] = Parameters::TimeResolution(fDigitType[idigit]); // only depends on the digit type
     
     fDeltaAngle[idigit] = 0.0;
     fDeltaPoint[idigit] = 0.0;
@@ -423,6 +429,80 @@ void VertexGeometry::CalcResiduals(RecoVertex* myVertex)
                               dirX, dirY, dirZ );
 }
 
+void VertexGeometry::CalcPointDeltas(double vtxX, double vtxY, double vtxZ, double vtxTime)
+{
+  // point residual only: dt - n*L/c
+  double fC = Parameters::SpeedOfLight();
+  double fN = Parameters::Index0();
+  double invVphoton = fN/fC;
+  const double* digitX = fDigitX;
+  const double* digitY = fDigitY;
+  const double* digitZ = fDigitZ;
+  const double* digitT = fDigitT;
+  double* delta = fDelta;
+  for( int idigit=0; idigit<fNDigits; idigit++ ){
+    double dx = digitX[idigit]-vtxX;
+    double dy = digitY[idigit]-vtxY;
+    double dz = digitZ[idigit]-vtxZ;
+    double ds = sqrt(dx*dx+dy*dy+dz*dz);
+    delta[idigit] = (digitT[idigit]-vtxTime) - ds*invVphoton;
+  }
+  return;
+}
+
+void VertexGeometry::CalcDirectionalDeltas(double vtxX, double vtxY, double vtxZ, double vtxTime,
+                                           double dirX, double dirY, double dirZ, bool extended)
+{
+  // Same geometry as CalcResiduals. The photon/track split of the extended path uses
+  // sin(theta-phi) = sin(theta)cos(phi) - cos(theta)sin(phi), so the only
+  // transcendental call left per digit is the acos for the zenith angle, done in a
+  // separate pass so the first loop has no library calls.
+  double thetadeg = Parameters::CherenkovAngle(); // degrees
+  double theta = thetadeg*(TMath::Pi()/180.0);   // radians
+  double costheta = cos(theta);
+  double sintheta = sin(theta);
+  double cottheta = costheta/sintheta;
+  double fC = Parameters::SpeedOfLight();
+  double fN = Parameters::Index0();
+  double invVphoton = fN/fC;
+  double invVmu = 1.0/fC;
+  bool hasdir = ( dirX*dirX + dirY*dirY + dirZ*dirZ>0.0 );
+  if( !hasdir ){ dirX = 0.0; dirY = 0.0; dirZ = 0.0; }
+
+  const double* digitX = fDigitX;
+  const double* digitY = fDigitY;
+  const double* digitZ = fDigitZ;
+  const double* digitT = fDigitT;
+  double* delta = fDelta;
+  double* cosz = fCosZenith;
+  for( int idigit=0; idigit<fNDigits; idigit++ ){
+    double dx = digitX[idigit]-vtxX;
+    double dy = digitY[idigit]-vtxY;
+    double dz = digitZ[idigit]-vtxZ;
+    double ds = sqrt(dx*dx+dy*dy+dz*dz);
+    double cosphi = hasdir ? (dx*dirX+dy*dirY+dz*dirZ)/ds : 1.0;
+    double dt = digitT[idigit]-vtxTime;
+    cosz[idigit] = cosphi;
+    if( extended ){
+      double sinphi = sqrt(std::max(0.0,1.0-cosphi*cosphi));
+      bool insidecone = ( cosphi>costheta ); // phi<theta
+      double Ltrack = insidecone ? ds*(cosphi-cottheta*sinphi) : 0.0;
+      double Lphoton = insidecone ? ds*sinphi/sintheta : ds;
+      delta[idigit] = dt - Ltrack*invVmu - Lphoton*invVphoton;
+    }
+    else delta[idigit] = dt - ds*invVphoton;
+  }
+  double* zenith = fZenith;
+  double radtodeg = 180.0/TMath::Pi();
+  if( hasdir ){
+    for( int idigit=0; idigit<fNDigits; idigit++ ) zenith[idigit] = acos(cosz[idigit])*radtodeg;
+  }
+  else {
+    for( int idigit=0; idigit<fNDigits; idigit++ ) zenith[idigit] = 0.0;
+  }
+  return;
+}
+
 void VertexGeometry::CalcPointResiduals(double vtxX, double vtxY, double vtxZ, double vtxTime, double dirX, double dirY, double dirZ)
 {
   this->CalcResiduals( vtxX, vtxY, vtxZ, vtxTime,
@@ -450,32 +530,10 @@ void VertexGeometry::CalcExtendedResiduals(double vtxX, double vtxY, double vtxZ
 
 void VertexGeometry::CalcResiduals(double vtxX, double vtxY, double vtxZ, double vtxTime, double dirX, double dirY, double dirZ )
 {
-  // reset arrays
-  // ============
-  for( int idigit=0; idigit<fNDigits; idigit++ ){
-    fConeAngle[idigit] = 0.0;
-    fZenith[idigit] = 0.0;
-    fAzimuth[idigit] = 0.0;
-    fSolidAngle[idigit] = 0.0;
-    fDistPoint[idigit] = 0.0;
-    fDistTrack[idigit] = 0.0;
-    fDistPhoton[idigit] = 0.0;  
-    fDistScatter[idigit] = 0.0; 
-    fDeltaTime[idigit] = 0.0; 
-    fDeltaSigma[idigit] = 0.0;
-    fDeltaAngle[idigit] = 0.0;
-    fDeltaPoint[idigit] = 0.0;
-    fDeltaTrack[idigit] = 0.0;
-    fDeltaPhoton[idigit] = 0.0;
-    fDeltaScatter[idigit] = 0.0;
-    fPointPath[idigit] = 0.0;
-    fExtendedPath[idigit] = 0.0;
-    fPointResidual[idigit] = 0.0;
-    fExtendedResidual[idigit] = 0.0;
-    fDelta[idigit] = 0.0;
-    fPointResidualMean = 0.0;
-    fExtendedResidualMean = 0.0;
-  }
+  // every per-digit array is overwritten in the loop below, so only the means are reset
+  fPointResidualMean = 0.0;
+  fExtendedResidualMean = 0.0;
+
   // cone angle
   // ==========
   double thetadeg = Parameters::CherenkovAngle(); // degrees
@@ -17,6 +17,12 @@ class VertexGeometry {
  	
   static VertexGeometry* Instance();
 
+  // Tools share the Instance() geometry. A fitter running several fits concurrently
+  // creates one VertexGeometry per worker thread, as the residual arrays are
+  // overwritten by every Calc*Residuals call.
+  VertexGeometry();
+  ~VertexGeometry();
+
   void LoadDigits(std::vector<RecoDigit>* vDigitList);
 
   void CalcResiduals(std::vector<RecoDigit>* vDigitList, RecoVertex* vtx);
@@ -29,6 +35,14 @@ class VertexGeometry {
   void CalcExtendedResiduals(double vx, double vy, double vz, double vtxTime,
 		              double px, double py, double pz);
 
+  // Lean residual kernels used by the FoMCalculator during fits. They fill fDelta
+  // (point or extended residual) and, when a direction is given, fZenith; the other
+  // per-digit arrays are not updated. Use the Calc*Residuals methods above when the
+  // full set of quantities is needed.
+  void CalcPointDeltas(double vx, double vy, double vz, double vtxTime);
+  void CalcDirectionalDeltas(double vx, double vy, double vz, double vtxTime,
+                             double px, double py, double pz, bool extended);
+
   void CalcVertexSeeds(int NSeeds = 1);
 
   RecoVertex* CalcSimpleVertex(std::vector<RecoDigit>* vDigitList);
@@ -222,6 +236,16 @@ class VertexGeometry {
     else return 0.0;
   }
 
+  // Raw per-digit arrays (length GetNDigits()) for the FoM kernels
+  const double* GetDeltaArray() const { return fDelta; }
+  const double* GetDeltaSigmaArray() const { return fDeltaSigma; }
+  const double* GetZenithArray() const { return fZenith; }
+  const double* GetDigitQArray() const { return fDigitQ; }
+  const int* GetDigitTypeArray() const { return fDigitType; }
+  const bool* GetIsFilteredArray() const { return fIsFiltered; }
+  // Incremented by every LoadDigits call, so per-event caches can tell when the digits change
+  unsigned int GetDigitLoadCount() const { return fDigitLoadCount; }
+
   double GetDelta(int idigit) {
     if( idigit>=0 && idigit<fNDigits ) {
       return fDelta[idigit];
@@ -267,8 +291,6 @@ class VertexGeometry {
 
   private:
  	void Clear();
-  VertexGeometry();
-  ~VertexGeometry();
 
   void CalcSimpleVertex(double& vtxX, double& vtxY, double& vtxZ, double& vtxTime);
 
@@ -280,6 +302,7 @@ class VertexGeometry {
   void ChooseNextDigit(double& x, double& y, double& z, double& t);
 
   int fNDigitsMax;
+  unsigned int fDigitLoadCount;
   int fNDigits;
   int fNFilterDigits;
 
@@ -344,6 +367,7 @@ class VertexGeometry {
   double* fPointResidual;    // PointResidual = DeltaTime - PointPath
   double* fExtendedResidual; // ExtendedResidual = DeltaTime - ExtendedPath
   double* fDelta;            // Chosen Residual [Point/Extended/Null]
+  double* fCosZenith;        // Scratch for the residual kernels: cosine of the zenith angle
   double fPointResidualMean;
   double fExtendedResidualMean;
 
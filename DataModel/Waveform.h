@@ -4,6 +4,8 @@
 
 #include <SerialisableObject.h>
 #include <iostream>
+#include <utility>
+#include <vector>
 
 using namespace std;
 
@@ -14,7 +16,8 @@ class Waveform : public SerialisableObject{
 
 	public:
   Waveform() : fStartTime(), fSamples(std::vector<T>{}) {serialise=true;}
-  Waveform(double tsin, std::vector<T> samplesin) : fStartTime(tsin), fSamples(samplesin){serialise=true;}
+  // samplesin is taken by value and moved in: pass an rvalue to hand over a sample buffer without copying it
+  Waveform(double tsin, std::vector<T> samplesin) : fStartTime(tsin), fSamples(std::move(samplesin)){serialise=true;}
 
 	inline double GetStartTime() const {return fStartTime;}
 	inline std::vector<T>* GetSamples() {return &fSamples;}
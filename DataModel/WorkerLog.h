@@ -0,0 +1,72 @@
+#ifndef WORKERLOG_H
+#define WORKERLOG_H
+
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * \class WorkerLog
+ *
+ * Messages logged by a tool's worker threads.  The ToolChain's logger is not
+ * thread-safe, so a tool running decoding threads buffers their messages here and
+ * emits them with Log on the ToolChain's thread (in Execute and Finalise).  A
+ * message above the verbosity is dropped when it is added.
+ */
+struct WorkerLogMessage{
+  std::string Message;
+  int Level;
+};
+
+class WorkerLog{
+
+ public:
+
+  //Messages logged from the thread calling this are not buffered
+  void SetToolChainThread(){ fToolChainThread = std::this_thread::get_id(); }
+  bool OnToolChainThread() const { return std::this_thread::get_id() == fToolChainThread; }
+
+  void Add(const std::string& message, int level, int verbosity){
+    if(level > verbosity) return;
+    std::lock_guard<std::mutex> lock(fMutex);
+    fMessages.push_back(WorkerLogMessage{message,level});
+  }
+  //Messages added since the last call, oldest first
+  std::vector<WorkerLogMessage> Take(){
+    std::vector<WorkerLogMessage> messages;
+    std::lock_guard<std::mutex> lock(fMutex);
+    messages.swap(fMessages);
+    return messages;
+  }
+
+ private:
+
+  std::mutex fMutex;
+  std::vector<WorkerLogMessage> fMessages;
+  std::thread::id fToolChainThread;   //default: no thread, everything is buffered
+
+};
+
+/**
+ * \class LogLine
+ *
+ * Builds a log message with stream syntax, for the debug printouts of code that
+ * runs on worker threads: Log(LogLine() << "Card " << CardID, v_debug, verbosity)
+ */
+class LogLine{
+
+ public:
+
+  template<typename T> LogLine& operator<<(const T& value){ fStream << value; return *this; }
+  LogLine& operator<<(std::ios_base& (*manip)(std::ios_base&)){ fStream << manip; return *this; }
+  operator std::string() const { return fStream.str(); }
+
+ private:
+
+  std::ostringstream fStream;
+
+};
+
+#endif
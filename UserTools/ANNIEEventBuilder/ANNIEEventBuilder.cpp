@@ -25,6 +25,7 @@ bool ANNIEEventBuilder::Initialise(std::string configfile, DataModel &data){
   CTCMRDTimeTolerance = 2000000; //ns
   DriftWarningValue = 5000000;   //ns
   pause_threshold = 5*60;        //s
+  PairingMode = "SortedMerge";
 
   /////////////////////////////////////////////////////////////////
   m_variables.Get("verbosity",verbosity);
@@ -42,6 +43,14 @@ bool ANNIEEventBuilder::Initialise(std::string configfile, DataModel &data){
   m_variables.Get("OrphanFileBase",OrphanFileBase);
   m_variables.Get("MaxStreamMatchingTimeSeparation",pause_threshold);
   pause_threshold*=1E9;
+  m_variables.Get("PairingMode",PairingMode);
+  m_variables.Get("BenchmarkPairing",BenchmarkPairing);
+  m_variables.Get("BenchmarkPairingTriggers",BenchmarkPairingTriggers);
+  if(PairingMode != "SortedMerge" && PairingMode != "Legacy"){
+    Log("ANNIEEventBuilder: PairingMode "+PairingMode+" not recognized; using SortedMerge",v_warning,verbosity);
+    PairingMode = "SortedMerge";
+  }
+  UseLegacyPairing = (PairingMode == "Legacy");
 
   if(BuildType == "TankAndMRD" || BuildType == "TankAndMRDAndCTC"){
     std::cout << "BuildANNIEEvent Building Tank and MRD-merged ANNIE events. " <<
@@ -78,6 +87,25 @@ bool ANNIEEventBuilder::Initialise(std::string configfile, DataModel &data){
   
   OrphanStore = new BoostStore(false,2);
 
+  if(BenchmarkPairing) this->RunPairingBenchmark();
+
+  //Pipelined decoding (LoadRawData DecodeMode Pipelined): the decoders hand their
+  //results over through the pipeline's queues, and this tool keeps the maps they
+  //would otherwise have set in the CStore
+  intptr_t DecodePipelinePtr = 0;
+  m_data->CStore.Get("RawDecodePipeline",DecodePipelinePtr);
+  DecodePipeline = RawDecodePipeline::FromCStore(DecodePipelinePtr);
+  if(DecodePipeline){
+    DecodePipeline->Retain();
+    InProgressTankEvents = new std::map<uint64_t, std::map<std::vector<int>, std::vector<uint16_t> > >;
+    m_data->CStore.Set("InProgressTankEvents",InProgressTankEvents);
+    TimeToTriggerWordMap = new std::map<uint64_t,uint32_t>;
+    m_data->CStore.Set("TimeToTriggerWordMap",TimeToTriggerWordMap);
+    NewMRDEvents = &PipelineMRDEvents;
+    BuildStats = PipelineStageStats();
+    Log("ANNIEEventBuilder: Building from the pipelined decoders' output queues",v_message,verbosity);
+  }
+
   return true;
 }
 
@@ -101,9 +129,27 @@ bool ANNIEEventBuilder::Execute(){
     Log("ANNIEEventBuilder: StopLoop or FileCompleted detected, forcing building of any remaining events in the timestream",v_warning,verbosity);
   }
     
+  //With pipelined decoding the other tools return straight away: wait here for the
+  //decoders instead of spinning through the ToolChain.  Paused streams only count
+  //once the others have nothing left to decode, as in DrainDecodePipeline.
+  if(DecodePipeline && !toolchain_stopping){
+    std::vector<RawDecodePipeline::Stream> WaitStreams;
+    std::vector<RawDecodePipeline::Stream> AttachedStreams;
+    for(int s=0; s<RawDecodePipeline::NumStreams; s++){
+      RawDecodePipeline::Stream astream = static_cast<RawDecodePipeline::Stream>(s);
+      if(!DecodePipeline->Attached(astream)) continue;
+      AttachedStreams.push_back(astream);
+      if(!StreamPaused[s] && !DecodePipeline->Starved(astream)) WaitStreams.push_back(astream);
+    }
+    if(WaitStreams.empty()) WaitStreams = AttachedStreams;
+    DecodePipeline->WaitForOutput(WaitStreams,0.1,BuildStats.InputWaitSeconds);
+  }
+
   ExecuteCount+=1;
   if((ExecuteCount<ExecutesPerBuild)&&(!toolchain_stopping)) return true;
 
+  if(DecodePipeline) this->DrainDecodePipeline(toolchain_stopping);
+
   //See if the MRD and Tank are at the same run/subrun for building
   m_data->CStore.Get("RunInfoPostgress",RunInfoPostgress);
   int RunNumber;
@@ -137,19 +183,15 @@ bool ANNIEEventBuilder::Execute(){
     else if(IsNewTankData) this->ProcessNewTankPMTData();
     this->ManageOrphanage();
 
-    std::vector<uint64_t> PMTEventsToDelete;
-    for(std::pair<uint64_t,std::map<std::vector<int>, std::vector<uint16_t>>> apair : FinishedTankEvents){
+    for(auto&& apair : FinishedTankEvents){
       uint64_t PMTCounterTime = apair.first;
-      std::map<std::vector<int>, std::vector<uint16_t>> aWaveMap = apair.second;
       this->BuildANNIEEventRunInfo(RunNumber,SubRunNumber,RunType,StarTime);
-      this->BuildANNIEEventTank(PMTCounterTime, aWaveMap);
+      this->BuildANNIEEventTank(PMTCounterTime, apair.second);
       this->SaveEntryToFile(CurrentRunNum,CurrentSubRunNum);
-      //Erase this entry from the InProgressTankEventsMap
-      if(verbosity>4) std::cout << "Counter time will be erased from InProgressTankEvents: " << PMTCounterTime << std::endl;
-      PMTEventsToDelete.push_back(PMTCounterTime);
+      if(verbosity>4) std::cout << "Counter time will be erased from FinishedTankEvents: " << PMTCounterTime << std::endl;
     }
-    //Update the current InProgressTankEvents map
-    for(unsigned int i=0; i< PMTEventsToDelete.size(); i++) FinishedTankEvents.erase(PMTEventsToDelete.at(i));
+    //Every finished event has been built; their sample buffers were moved into the ANNIEEvent
+    FinishedTankEvents.clear();
   }
   /*
     //Get the current InProgressTankEvents map
@@ -193,10 +235,7 @@ bool ANNIEEventBuilder::Execute(){
       Log("ANNIEEventBuilder:: No new MRD Data.  Not building ANNIEEvent: ",v_message, verbosity);
       return true;
     }
-    m_data->CStore.Get("MRDEvents",myMRDMaps.MRDEvents);
-    m_data->CStore.Get("MRDEventTriggerTypes",myMRDMaps.MRDTriggerTypeMap);
-    m_data->CStore.Get("MRDBeamLoopback",myMRDMaps.MRDBeamLoopbackMap);
-    m_data->CStore.Get("MRDCosmicLoopback",myMRDMaps.MRDCosmicLoopbackMap);
+    this->ProcessNewMRDData();
     int NumMRDTimestamps = myTimeStream.BeamMRDTimestamps.size();
     m_data->CStore.Set("NumMRDTimestamps",NumMRDTimestamps);
     
@@ -219,10 +258,7 @@ bool ANNIEEventBuilder::Execute(){
       myMRDMaps.MRDBeamLoopbackMap.erase(MRDEventsToDelete.at(i));
       myMRDMaps.MRDCosmicLoopbackMap.erase(MRDEventsToDelete.at(i));
     }
-    m_data->CStore.Set("MRDEvents",myMRDMaps.MRDEvents);
-    m_data->CStore.Set("MRDEventTriggerTypes",myMRDMaps.MRDTriggerTypeMap);
-    m_data->CStore.Set("MRDBeamLoopback",myMRDMaps.MRDBeamLoopbackMap);
-    m_data->CStore.Set("MRDCosmicLoopback",myMRDMaps.MRDCosmicLoopbackMap);
+    myTimeStream.BeamMRDTimestamps.clear();
   }
 
   //Built ANNIE events with Tank and MRD data
@@ -233,12 +269,7 @@ bool ANNIEEventBuilder::Execute(){
     this->ManageOrphanage();
 
     //Look through our MRD data for any new timestamps
-    m_data->CStore.Get("MRDEventTriggerTypes",myMRDMaps.MRDTriggerTypeMap);
-    m_data->CStore.Get("NewMRDDataAvailable",IsNewMRDData);
-    m_data->CStore.Get("MRDEvents",myMRDMaps.MRDEvents);
-    m_data->CStore.Get("MRDBeamLoopback",myMRDMaps.MRDBeamLoopbackMap);
-    m_data->CStore.Get("MRDCosmicLoopback",myMRDMaps.MRDCosmicLoopbackMap);
-    if(IsNewMRDData) this->ProcessNewMRDData();
+    this->ProcessNewMRDData();
     
 
     
@@ -253,14 +284,15 @@ bool ANNIEEventBuilder::Execute(){
     //Without it, events get moved to the orphanage that probably shouldn't
     if((MinStamps > (EventsPerPairing*10))||toolchain_stopping){
       this->RemoveCosmics();
-      BeamTankMRDPairs = this->PairTankPMTAndMRDTriggers();
+      if(UseLegacyPairing) BeamTankMRDPairs = this->PairTankPMTAndMRDTriggersLegacy();
+      else BeamTankMRDPairs = this->PairTankPMTAndMRDTriggers();
       this->ManageOrphanage();
 
       std::vector<uint64_t> BuiltTankTimes;
       for(std::pair<uint64_t,uint64_t> cpair : BeamTankMRDPairs){
         uint64_t TankCounterTime = cpair.first;
         if(verbosity>4) std::cout << "TANK EVENT WITH TIMESTAMP " << TankCounterTime << " HAS REQUIRED MINIMUM NUMBER OF WAVES TO BUILD" << std::endl;
-        std::map<std::vector<int>, std::vector<uint16_t>> aWaveMap = FinishedTankEvents.at(TankCounterTime);
+        std::map<std::vector<int>, std::vector<uint16_t>>& aWaveMap = FinishedTankEvents.at(TankCounterTime);
         uint64_t MRDTimeStamp = cpair.second;
         if(verbosity>4) std::cout << "MRD TIMESTAMP: " << MRDTimeStamp << std::endl;
         std::vector<std::pair<unsigned long,int>> MRDHits = myMRDMaps.MRDEvents.at(MRDTimeStamp);
@@ -295,12 +327,7 @@ bool ANNIEEventBuilder::Execute(){
 
     
     //Look through our MRD data for any new timestamps
-    m_data->CStore.Get("MRDEventTriggerTypes",myMRDMaps.MRDTriggerTypeMap);
-    m_data->CStore.Get("MRDEvents",myMRDMaps.MRDEvents);
-    m_data->CStore.Get("MRDBeamLoopback",myMRDMaps.MRDBeamLoopbackMap);
-    m_data->CStore.Get("MRDCosmicLoopback",myMRDMaps.MRDCosmicLoopbackMap);
-    m_data->CStore.Get("NewMRDDataAvailable",IsNewMRDData);
-    if(IsNewMRDData) this->ProcessNewMRDData();
+    this->ProcessNewMRDData();
 
     //Look through CTC data for any new timestamps
     m_data->CStore.Get("TimeToTriggerWordMap",TimeToTriggerWordMap);
@@ -312,13 +339,10 @@ bool ANNIEEventBuilder::Execute(){
     int NumMRDTimestamps = myTimeStream.BeamMRDTimestamps.size();
     int NumTrigs = myTimeStream.CTCTimestamps.size();
     
-    // get get the most recent timestamp from each TimeStream
-    uint64_t most_recent_beam = *std::max_element(myTimeStream.BeamTankTimestamps.begin(),
-                                                  myTimeStream.BeamTankTimestamps.end());
-    uint64_t most_recent_mrd = *std::max_element(myTimeStream.BeamMRDTimestamps.begin(),
-                                                  myTimeStream.BeamMRDTimestamps.end());
-    uint64_t most_recent_ctc = *std::max_element(myTimeStream.CTCTimestamps.begin(),
-                                                  myTimeStream.CTCTimestamps.end());
+    // get get the most recent timestamp from each (sorted) TimeStream
+    uint64_t most_recent_beam = myTimeStream.BeamTankTimestamps.empty() ? 0 : myTimeStream.BeamTankTimestamps.back();
+    uint64_t most_recent_mrd = myTimeStream.BeamMRDTimestamps.empty() ? 0 : myTimeStream.BeamMRDTimestamps.back();
+    uint64_t most_recent_ctc = myTimeStream.CTCTimestamps.empty() ? 0 : myTimeStream.CTCTimestamps.back();
     
     // find which TimeStream is lagging the most, and what time it's currently read up to.
     std::vector<uint64_t> newest_timestamps{most_recent_beam,most_recent_mrd,most_recent_ctc};
@@ -338,11 +362,11 @@ bool ANNIEEventBuilder::Execute(){
     
     // always ensure the slowest stream is unpaused
            if(slowest_stream_timestamp==most_recent_beam){
-      m_data->CStore.Set("PauseTankDecoding",false);
+      this->SetStreamPaused(RawDecodePipeline::Tank,false);
     } else if(slowest_stream_timestamp==most_recent_mrd){
-      m_data->CStore.Set("PauseMRDDecoding",false);
+      this->SetStreamPaused(RawDecodePipeline::MRD,false);
     } else if(slowest_stream_timestamp==most_recent_ctc){
-      m_data->CStore.Set("PauseCTCDecoding",false);
+      this->SetStreamPaused(RawDecodePipeline::CTC,false);
     }
     
     // if any other streams are more than X seconds ahead of the slowest one, pause them...
@@ -350,19 +374,19 @@ bool ANNIEEventBuilder::Execute(){
       // secondly, only pause a stream once we have at least EventsPerPairing timestamps in it,
       // otherwise doing so will prevent building attempts
       if(NumTankTimestamps>EventsPerPairing){
-        m_data->CStore.Set("PauseTankDecoding",true);
+        this->SetStreamPaused(RawDecodePipeline::Tank,true);
         Log("ANNIEEventBuilder: Pausing tank stream",v_debug,verbosity);
       }
     }
     if((static_cast<int64_t>(most_recent_mrd)-static_cast<int64_t>(slowest_stream_timestamp))>pause_threshold){
       if(NumMRDTimestamps>EventsPerPairing){
-        m_data->CStore.Set("PauseMRDDecoding",true);
+        this->SetStreamPaused(RawDecodePipeline::MRD,true);
         Log("ANNIEEventBuilder: Pausing mrd stream",v_debug,verbosity);
       }
     }
     if((static_cast<int64_t>(most_recent_ctc)-static_cast<int64_t>(slowest_stream_timestamp))>pause_threshold){
       if(NumTrigs>EventsPerPairing){
-        m_data->CStore.Set("PauseCTCDecoding",true);
+        this->SetStreamPaused(RawDecodePipeline::CTC,true);
         Log("ANNIEEventBuilder: Pausing ctc stream",v_debug,verbosity);
       }
     }
@@ -382,11 +406,13 @@ bool ANNIEEventBuilder::Execute(){
     // OR if the toolchain is being stopped (reached and of file, for example)
     if((MinStamps>EventsPerPairing)||toolchain_stopping){
       if(verbosity>4) std::cout << "MERGING COSMIC/MRD PAIRS " << std::endl;
-      ThisBuildMap = this->PairCTCCosmicPairs(ThisBuildMap,std::max(most_recent_mrd,most_recent_ctc),toolchain_stopping);
+      if(UseLegacyPairing) ThisBuildMap = this->PairCTCCosmicPairsLegacy(ThisBuildMap,std::max(most_recent_mrd,most_recent_ctc),toolchain_stopping);
+      else this->PairCTCCosmicPairs(ThisBuildMap,std::max(most_recent_mrd,most_recent_ctc),toolchain_stopping);
       this->ManageOrphanage();
 
       if(verbosity>4) std::cout << "BEGINNING STREAM MERGING " << std::endl;
-      ThisBuildMap = this->MergeStreams(ThisBuildMap,slowest_stream_timestamp,toolchain_stopping);
+      if(UseLegacyPairing) ThisBuildMap = this->MergeStreamsLegacy(ThisBuildMap,slowest_stream_timestamp,toolchain_stopping);
+      else this->MergeStreams(ThisBuildMap,slowest_stream_timestamp,toolchain_stopping);
       Log("ANNIEEventBuilder: Calling ManageOrphanage post MergeStreams",v_debug,verbosity);
       this->ManageOrphanage();
       Log("ANNIEEventBuilder: Done managing orphanage",v_debug,verbosity);
@@ -406,8 +432,7 @@ bool ANNIEEventBuilder::Execute(){
           if(label == "TankPMT"){
             uint64_t TankPMTTime = buildset_entries.second;
             if(verbosity>4) std::cout << "TANK EVENT WITH TIMESTAMP " << TankPMTTime << "HAS REQUIRED MINIMUM NUMBER OF WAVES TO BUILD" << std::endl;
-            std::map<std::vector<int>, std::vector<uint16_t>> aWaveMap = FinishedTankEvents.at(TankPMTTime);
-            this->BuildANNIEEventTank(TankPMTTime, aWaveMap);
+            this->BuildANNIEEventTank(TankPMTTime, FinishedTankEvents.at(TankPMTTime));
             FinishedTankEvents.erase(TankPMTTime);
           }
           if(label == "MRD"){
@@ -431,15 +456,6 @@ bool ANNIEEventBuilder::Execute(){
     ThisBuildMap.clear();
   }
 
-  m_data->CStore.Set("MRDEvents",myMRDMaps.MRDEvents);
-  m_data->CStore.Set("MRDEventTriggerTypes",myMRDMaps.MRDTriggerTypeMap);
-  m_data->CStore.Set("MRDBeamLoopback",myMRDMaps.MRDBeamLoopbackMap);
-  m_data->CStore.Set("MRDCosmicLoopback",myMRDMaps.MRDCosmicLoopbackMap);
-  myMRDMaps.MRDEvents.clear();
-  myMRDMaps.MRDTriggerTypeMap.clear();
-  myMRDMaps.MRDBeamLoopbackMap.clear();
-  myMRDMaps.MRDCosmicLoopbackMap.clear();
-
   ExecuteCount = 0;
   return true;
 }
@@ -457,28 +473,129 @@ bool ANNIEEventBuilder::Finalise(){
   OrphanStore->Close();
   OrphanStore->Delete();
   delete OrphanStore;
+  if(DecodePipeline){
+    double WallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now()-BuildStats.Start).count();
+    Log("ANNIEEventBuilder: Pipelined decoding: drained "+to_string(BuildStats.Items)+" decoded entries; the ToolChain waited "+
+        to_string(BuildStats.InputWaitSeconds)+" s of "+to_string(WallSeconds)+" s for decoded data",v_warning,verbosity);
+    Log("ANNIEEventBuilder: Pipelined decoding: paused streams held back in "+to_string(HeldBackBuilds[RawDecodePipeline::Tank])+
+        " (Tank), "+to_string(HeldBackBuilds[RawDecodePipeline::MRD])+" (MRD), "+to_string(HeldBackBuilds[RawDecodePipeline::CTC])+
+        " (CTC) builds",v_warning,verbosity);
+    RawDecodePipeline::Release(DecodePipeline);
+  }
   std::cout << "ANNIEEventBuilder Exitting" << std::endl;
   return true;
 }
 
+void ANNIEEventBuilder::SetStreamPaused(RawDecodePipeline::Stream s, bool paused){
+  //With pipelined decoding a paused stream is simply not drained (see DrainDecodePipeline)
+  if(DecodePipeline) StreamPaused[s] = paused;
+  else if(s == RawDecodePipeline::Tank) m_data->CStore.Set("PauseTankDecoding",paused);
+  else if(s == RawDecodePipeline::MRD) m_data->CStore.Set("PauseMRDDecoding",paused);
+  else m_data->CStore.Set("PauseCTCDecoding",paused);
+}
+
+void ANNIEEventBuilder::DrainDecodePipeline(bool final_drain){
+  //Take everything decoded since the last build off the pipeline's output queues.
+  //A paused stream is left in its queue: once the queue is full its decoder, and
+  //then the reader, stall on it while the other streams catch up.  It is drained
+  //anyway when nothing else is left to decode, so the end of a file is reached.
+  //On the final drain the inputs are closed and every stream is emptied.
+  bool Drain[RawDecodePipeline::NumStreams];
+  bool OthersStarved = true;
+  for(int s=0; s<RawDecodePipeline::NumStreams; s++){
+    RawDecodePipeline::Stream astream = static_cast<RawDecodePipeline::Stream>(s);
+    Drain[s] = DecodePipeline->Attached(astream) && (final_drain || !StreamPaused[s]);
+    if(Drain[s] && !DecodePipeline->Starved(astream)) OthersStarved = false;
+  }
+  for(int s=0; s<RawDecodePipeline::NumStreams; s++){
+    if(Drain[s] || !DecodePipeline->Attached(static_cast<RawDecodePipeline::Stream>(s))) continue;
+    if(OthersStarved) Drain[s] = true;
+    else HeldBackBuilds[s]++;
+  }
+  if(final_drain) DecodePipeline->CloseInputs();
+
+  int NumTankItems = 0;
+  if(Drain[RawDecodePipeline::Tank]){
+    DecodedTankWaves Waves;
+    while(final_drain ? DecodePipeline->PopOutput(Waves,BuildStats.InputWaitSeconds) : DecodePipeline->TryPopOutput(Waves)){
+      for(auto&& apair : Waves){
+        std::map<std::vector<int>, std::vector<uint16_t> >& WaveMap = (*InProgressTankEvents)[apair.first];
+        for(auto&& awave : apair.second){
+          if(WaveMap.count(awave.first) == 0) WaveMap.emplace(awave.first,std::move(awave.second));
+        }
+      }
+      if(!Waves.empty()) NumTankItems++;
+      BuildStats.Items++;
+    }
+  }
+  int NumMRDItems = 0;
+  if(Drain[RawDecodePipeline::MRD]){
+    DecodedMRDEvent anEvent;
+    while(final_drain ? DecodePipeline->PopOutput(anEvent,BuildStats.InputWaitSeconds) : DecodePipeline->TryPopOutput(anEvent)){
+      PipelineMRDEvents.push_back(std::move(anEvent));
+      NumMRDItems++;
+      BuildStats.Items++;
+    }
+  }
+  int NumCTCItems = 0;
+  if(Drain[RawDecodePipeline::CTC]){
+    DecodedCTCTriggers Triggers;
+    while(final_drain ? DecodePipeline->PopOutput(Triggers,BuildStats.InputWaitSeconds) : DecodePipeline->TryPopOutput(Triggers)){
+      if(Triggers.NewRun) TimeToTriggerWordMap->clear();
+      for(auto&& atrigger : Triggers.Triggers) TimeToTriggerWordMap->emplace(atrigger.first,atrigger.second);
+      if(!Triggers.Triggers.empty()) NumCTCItems++;
+      BuildStats.Items++;
+    }
+  }
+  if(verbosity>3) std::cout << "ANNIEEventBuilder: Drained Tank, MRD, CTC entries with new data: " << NumTankItems << "," <<
+      NumMRDItems << "," << NumCTCItems << std::endl;
+  m_data->CStore.Set("NewTankPMTDataAvailable",NumTankItems>0);
+  m_data->CStore.Set("NewMRDDataAvailable",NumMRDItems>0);
+  m_data->CStore.Set("NewCTCDataAvailable",NumCTCItems>0);
+}
+
 void ANNIEEventBuilder::ProcessNewCTCData(){
-  for(std::pair<uint64_t,uint32_t> apair : *TimeToTriggerWordMap){
-    uint64_t CTCTimeStamp = apair.first;
-    uint32_t CTCWord = apair.second;
-    myTimeStream.CTCTimestamps.push_back(CTCTimeStamp);
+  //The CTC stream is decoded in time order, so only entries newer than the last
+  //timestamp taken need to be added to the timestream
+  std::vector<uint64_t> NewCTCTimestamps;
+  for(auto it = TimeToTriggerWordMap->upper_bound(NewestCTCTimestamp); it != TimeToTriggerWordMap->end(); ++it){
+    uint64_t CTCTimeStamp = it->first;
+    uint32_t CTCWord = it->second;
+    NewCTCTimestamps.push_back(CTCTimeStamp);
     if(verbosity>5)std::cout << "CTCTIMESTAMP,WORD" << CTCTimeStamp << "," << CTCWord << std::endl;
   }
-  RemoveDuplicates(myTimeStream.CTCTimestamps);
+  if(NewCTCTimestamps.size()) NewestCTCTimestamp = NewCTCTimestamps.back();
+  this->AddToTimeStream(myTimeStream.CTCTimestamps,NewCTCTimestamps);
   return;
 }
 
 void ANNIEEventBuilder::ProcessNewMRDData(){
-  for(std::pair<uint64_t,std::vector<std::pair<unsigned long,int>>> apair : myMRDMaps.MRDEvents){
-    uint64_t MRDTimeStamp = apair.first;
-    myTimeStream.BeamMRDTimestamps.push_back(MRDTimeStamp);
-    if(verbosity>5)std::cout << "MRDTIMESTAMPTRIGTYPE," << MRDTimeStamp << "," << myMRDMaps.MRDTriggerTypeMap.at(MRDTimeStamp) << std::endl;
+  //Take the MRD triggers decoded since the last build from the MRDDataDecoder's
+  //queue.  Each trigger is moved into the MRD maps once; only timestamps not
+  //already pending are added to the MRD timestream.
+  if(NewMRDEvents == nullptr){
+    intptr_t NewMRDEventsPtr = 0;
+    m_data->CStore.Get("MRDEventQueue",NewMRDEventsPtr);
+    NewMRDEvents = reinterpret_cast<MRDEventQueue*>(NewMRDEventsPtr);
+  }
+  if(NewMRDEvents == nullptr){
+    Log("ANNIEEventBuilder: No MRDEventQueue in CStore.  Is MRDDataDecoder in the toolchain?",v_error,verbosity);
+    return;
+  }
+  std::vector<uint64_t> NewMRDTimestamps;
+  while(!NewMRDEvents->empty()){
+    DecodedMRDEvent& anEvent = NewMRDEvents->front();
+    uint64_t MRDTimeStamp = anEvent.Timestamp;
+    if(myMRDMaps.MRDEvents.emplace(MRDTimeStamp,std::move(anEvent.Hits)).second){
+      myMRDMaps.MRDTriggerTypeMap.emplace(MRDTimeStamp,anEvent.TriggerType);
+      myMRDMaps.MRDBeamLoopbackMap.emplace(MRDTimeStamp,anEvent.BeamLoopbackTDC);
+      myMRDMaps.MRDCosmicLoopbackMap.emplace(MRDTimeStamp,anEvent.CosmicLoopbackTDC);
+      NewMRDTimestamps.push_back(MRDTimeStamp);
+      if(verbosity>5)std::cout << "MRDTIMESTAMPTRIGTYPE," << MRDTimeStamp << "," << anEvent.TriggerType << std::endl;
+    }
+    NewMRDEvents->pop_front();
   }
-  RemoveDuplicates(myTimeStream.BeamMRDTimestamps);
+  this->AddToTimeStream(myTimeStream.BeamMRDTimestamps,NewMRDTimestamps);
   return;
 }
 
@@ -486,14 +603,15 @@ void ANNIEEventBuilder::ProcessNewTankPMTData(){
   //Check if any In-progress tank events now have all waveforms
   m_data->CStore.Get("InProgressTankEvents",InProgressTankEvents);
   std::vector<uint64_t> InProgressTankEventsToDelete;
+  std::vector<uint64_t> NewTankTimestamps;
   std::map<uint64_t,std::string> TankOrphans;
   std::map<uint64_t,std::string> MRDOrphans;
   std::map<uint64_t,std::string> CTCOrphans;
   
   if(verbosity>5) std::cout << "ANNIEEventBuilder Tool: Processing new tank data " << std::endl;
-  for(std::pair<uint64_t,std::map<std::vector<int>, std::vector<uint16_t>>> apair : *InProgressTankEvents){
+  for(auto&& apair : *InProgressTankEvents){
     uint64_t PMTCounterTimeNs = apair.first;
-    std::map<std::vector<int>, std::vector<uint16_t>> aWaveMap = apair.second;
+    std::map<std::vector<int>, std::vector<uint16_t>>& aWaveMap = apair.second;
     if(verbosity>4) std::cout << "Number of waves for this counter: " << aWaveMap.size() << std::endl;
     
     //Push back any new timestamps, then remove duplicates in the end
@@ -505,8 +623,9 @@ void ANNIEEventBuilder::ProcessNewTankPMTData(){
     int NumTankPMTChannels = TankPMTCrateSpaceToChannelNumMap.size();
     int NumAuxChannels = AuxCrateSpaceToChannelNumMap.size();
     if(aWaveMap.size() >= (NumWavesInCompleteSet)){
-      FinishedTankEvents.emplace(PMTCounterTimeNs,aWaveMap);
-      myTimeStream.BeamTankTimestamps.push_back(PMTCounterTimeNs);
+      //The in-progress entry is erased below, so its waveforms are moved rather than copied
+      if(FinishedTankEvents.count(PMTCounterTimeNs)==0) FinishedTankEvents.emplace(PMTCounterTimeNs,std::move(aWaveMap));
+      NewTankTimestamps.push_back(PMTCounterTimeNs);
       //Put PMT timestamp into the timestamp set for this run.
       if(verbosity>4) std::cout << "Finished waveset has clock counter: " << PMTCounterTimeNs << std::endl;
       InProgressTankEventsToDelete.push_back(PMTCounterTimeNs);
@@ -519,7 +638,7 @@ void ANNIEEventBuilder::ProcessNewTankPMTData(){
       TankOrphans.emplace(PMTCounterTimeNs,"incomplete_tank_event");
     }
   }
-  RemoveDuplicates(myTimeStream.BeamTankTimestamps);
+  this->AddToTimeStream(myTimeStream.BeamTankTimestamps,NewTankTimestamps);
   
   // move abandoned in-progress events to the orphanage
   this->MoveToOrphanage(TankOrphans, MRDOrphans, CTCOrphans);
@@ -535,7 +654,246 @@ void ANNIEEventBuilder::ProcessNewTankPMTData(){
   return;
 }
 
-std::map<uint64_t,std::map<std::string,uint64_t>> ANNIEEventBuilder::PairCTCCosmicPairs(std::map<uint64_t,std::map<std::string,uint64_t>> BuildMap, uint64_t max_timestamp, bool force_matching){
+void ANNIEEventBuilder::PairCTCCosmicPairs(std::map<uint64_t,std::map<std::string,uint64_t>>& BuildMap, uint64_t max_timestamp, bool force_matching){
+  //Same pairing as PairCTCCosmicPairsLegacy, done as a single merge of the sorted
+  //cosmic MRD and cosmic CTC timestamps rather than a scan of all CTCs per MRD stamp
+  uint32_t CosmicWord = 36;  //TS_in(35) + 1, where 35 is the MRD_CR_Trigger
+  std::vector<uint64_t> MRDCosmicTimes;
+  std::vector<uint64_t> CTCCosmicTimes;
+  std::map<uint64_t,uint64_t> PairedCTCMRDTimes;
+  std::map<uint64_t,std::string> MRDOrphans;
+  std::map<uint64_t,std::string> TankOrphans;
+  std::map<uint64_t,std::string> CTCOrphans;
+
+  for(auto&& aTS : myTimeStream.BeamMRDTimestamps) {
+    if((aTS>max_timestamp)&&(!force_matching)) break; // don't try to match yet
+    std::map<uint64_t,std::string>::iterator it_type = myMRDMaps.MRDTriggerTypeMap.find(aTS);
+    if(it_type != myMRDMaps.MRDTriggerTypeMap.end() && it_type->second == "Cosmic") MRDCosmicTimes.push_back(aTS);
+  }
+  for(auto&& aCtcTS : myTimeStream.CTCTimestamps){
+    if((aCtcTS>max_timestamp)&&(!force_matching)) break;        // do not try to match just yet
+    if(TimeToTriggerWordMap->at(aCtcTS) == CosmicWord) CTCCosmicTimes.push_back(aCtcTS);
+  }
+
+  //Form CTC-MRD pairs.  Both lists are sorted, so the first CTC stamp not earlier
+  //than the tolerance window only ever moves forward as the MRD stamps increase
+  if(verbosity>3) std::cout << "Finding CTC-MRD pairs..." << std::endl;
+  size_t ctc_index = 0;
+  for(auto&& aMrdTS : MRDCosmicTimes){
+    while(ctc_index < CTCCosmicTimes.size() && 
+          (static_cast<double>(aMrdTS) - static_cast<double>(CTCCosmicTimes[ctc_index])) > CTCMRDTimeTolerance) ctc_index++;
+    if(ctc_index == CTCCosmicTimes.size()) break;  //No later CTC stamps; the rest wait for more data
+    uint64_t aCtcTS = CTCCosmicTimes[ctc_index];
+    double TSDiff =  static_cast<double>(aMrdTS) - static_cast<double>(aCtcTS);
+    if(verbosity>4) std::cout << "CosmicTS - CTCTS in nanoseconds is " << TSDiff << std::endl;
+    if (TSDiff<(-1.*static_cast<double>(CTCMRDTimeTolerance))){ // We've crossed past where a pair would be found
+      if(verbosity>4) std::cout << "NO CTC STAMP FOUND MATCHING COSMIC STAMP... MRD TO ORPHANAGE" << std::endl;
+      MRDOrphans.emplace(aMrdTS,"mrd_cosmic_no_ctc");
+    } else { //We've found a valid CTC-MRD pair!
+      if(verbosity>4) std::cout << "FOUND A MATCHING CTC TIME FOR THIS COSMIC MRD TIMESTAMP. NICE, PAIR EM." << std::endl;
+      PairedCTCMRDTimes.emplace(aCtcTS, aMrdTS);
+    }
+  }
+
+  //Neat.  Now, add timestamps to the buildmap.
+  std::vector<uint64_t> BuiltCTCs;
+  std::vector<uint64_t> BuiltMRDs;
+  for(std::pair<uint64_t, uint64_t> aPair : PairedCTCMRDTimes){
+    uint64_t CTCTimestamp = aPair.first;
+    uint64_t CosmicTimestamp = aPair.second;
+    std::map<std::string,uint64_t> aBuildSet;
+    aBuildSet.emplace("CTC",TimeToTriggerWordMap->at(CTCTimestamp));
+    aBuildSet.emplace("MRD",CosmicTimestamp);
+    if(verbosity>4) std::cout << "BUILDING A CTC/COSMIC BUILD MAP ENTRY. CTC IS " << CTCTimestamp << std::endl;
+    BuildMap.emplace(CTCTimestamp,aBuildSet);
+    BuiltCTCs.push_back(CTCTimestamp);
+    BuiltMRDs.push_back(CosmicTimestamp);
+  }
+
+  //Delete paired timestamps from the timestreams
+  this->RemoveFromTimeStream(myTimeStream.BeamMRDTimestamps,BuiltMRDs);
+  this->RemoveFromTimeStream(myTimeStream.CTCTimestamps,BuiltCTCs);
+
+  //Move MRD timestamps with no pairs to the orphanage
+  this->MoveToOrphanage(TankOrphans, MRDOrphans, CTCOrphans);
+  return;
+}
+
+void ANNIEEventBuilder::MergeStreams(std::map<uint64_t,std::map<std::string,uint64_t>>& BuildMap, uint64_t max_timestamp, bool force_matching){
+  //Same matching as MergeStreamsLegacy.  All three timestreams are sorted, so each
+  //Tank/MRD stamp is matched to its CTC stamp in one forward pass over the CTC stream.
+  std::map<uint64_t,uint64_t> PairedCTCTankTimes; 
+  std::map<uint64_t,uint64_t> PairedCTCMRDTimes;
+  std::map<uint64_t,std::string> MRDOrphans;
+  std::map<uint64_t,std::string> TankOrphans;
+  std::map<uint64_t,std::string> CTCOrphans;
+
+  // only attempt matching on timestamps older than the newest timestamp of the slowest stream
+  std::vector<uint64_t>& CTCs = myTimeStream.CTCTimestamps;
+  size_t NumCTCs = CTCs.size();
+  if(!force_matching) NumCTCs = std::distance(CTCs.begin(),std::upper_bound(CTCs.begin(),CTCs.end(),max_timestamp));
+
+  //Form CTC-MRD pairs
+  uint64_t max_ctc=0;
+  size_t ctc_index = 0;
+  if(verbosity>3) std::cout << "Finding CTC-MRD pairs..." << std::endl;
+  for(auto&& aMrdTS : myTimeStream.BeamMRDTimestamps){
+    if((aMrdTS>max_timestamp)&&(!force_matching)) break;   // don't try to match just yet
+    while(ctc_index < NumCTCs &&
+          (static_cast<double>(aMrdTS) - static_cast<double>(CTCs[ctc_index])) > CTCMRDTimeTolerance) ctc_index++;
+    if(ctc_index == NumCTCs) break;
+    uint64_t aCtcTS = CTCs[ctc_index];
+    double TSDiff =  static_cast<double>(aMrdTS) - static_cast<double>(aCtcTS);
+    if(verbosity>4) std::cout << "MRDTS - CTCTS in nanoseconds is " << TSDiff << std::endl;
+    if (TSDiff<(-1.*static_cast<double>(CTCMRDTimeTolerance))){ //We've crossed past where a pair would be found
+      if(verbosity>4) std::cout << "NO CTC STAMP FOUND MATCHING MRD STAMP... MRD TO ORPHANAGE" << std::endl;
+      MRDOrphans.emplace(aMrdTS,"mrd_beam_no_ctc");
+    } else { //We've found a valid CTC-MRD pair!
+      if(verbosity>4) std::cout << "FOUND A MATCHING CTC TIME FOR THIS MRD TIMESTAMP. NICE, PAIR EM." << std::endl;
+      PairedCTCMRDTimes.emplace(aCtcTS, aMrdTS);
+      max_ctc=aCtcTS;
+    }
+  }
+
+  //Now form CTC-PMT pairs
+  ctc_index = 0;
+  if(verbosity>3) std::cout << "Finding CTC-Tank pairs..." << std::endl;
+  for(auto&& aTankTS : myTimeStream.BeamTankTimestamps){
+    if((aTankTS>max_timestamp)&&(!force_matching)) break; // don't try to match just yet
+    while(ctc_index < NumCTCs &&
+          (static_cast<double>(aTankTS) - static_cast<double>(CTCs[ctc_index])) > CTCTankTimeTolerance) ctc_index++;
+    if(ctc_index == NumCTCs) break;
+    uint64_t aCtcTS = CTCs[ctc_index];
+    double TSDiff =  static_cast<double>(aTankTS) - static_cast<double>(aCtcTS);
+    if(verbosity>4) std::cout << "TankTS - CTCTS in nanoseconds is " << TSDiff << std::endl;
+    if (TSDiff<(-1.*static_cast<double>(CTCTankTimeTolerance))){ //We've crossed past where a pair would be found
+      if(verbosity>4) std::cout << "NO CTC STAMP FOUND MATCHING TANK STAMP... TANK TO ORPHANAGE" << std::endl;
+      TankOrphans.emplace(aTankTS,"tank_no_ctc");
+    } else { //We've found a valid CTC-Tank pair!
+      if(verbosity>4) std::cout << "FOUND A MATCHING CTC TIME FOR THIS TANK TIMESTAMP. NICE, PAIR EM." << std::endl;
+      PairedCTCTankTimes.emplace(aCtcTS, aTankTS);
+      if(aCtcTS>max_ctc) max_ctc=aCtcTS;
+    }
+  }
+  int LargestCTCIndex = std::distance(CTCs.begin(),std::lower_bound(CTCs.begin(),CTCs.end(),max_ctc));
+  if(max_ctc==0) LargestCTCIndex=0;
+  if(verbosity>4) std::cout << "LARGEST CTC INDEX WAS " << LargestCTCIndex << std::endl;
+  if(verbosity>4) std::cout << "AND CTCTIMESTAMPS SIZE IS " << CTCs.size() << std::endl;
+  
+  //Neat.  Now, add timestamps to the buildmap.
+  //CTCs below LargestCTCIndex-1 are resolved here, as in MergeStreamsLegacy
+  std::vector<uint64_t> BuiltCTCs;
+  std::vector<uint64_t> BuiltTanks;
+  std::vector<uint64_t> BuiltMRDs;
+  for(int i=0; i<(LargestCTCIndex-1); i++){
+    uint64_t CTCKey = CTCs.at(i);
+    if(verbosity>4) std::cout << "TRYING TO BUILD A SET WITH CTCTIMESTAMP INDEX " << i << std::endl;
+
+    std::map<uint64_t, uint64_t>::iterator it_tank = PairedCTCTankTimes.find(CTCKey);
+    bool have_tankmatch = (it_tank != PairedCTCTankTimes.end());
+    std::map<uint64_t, uint64_t>::iterator it_mrd = PairedCTCMRDTimes.find(CTCKey);
+    bool have_mrdmatch = (it_mrd != PairedCTCMRDTimes.end());
+    if(have_tankmatch){
+      std::map<std::string,uint64_t> aBuildSet;
+      aBuildSet.emplace("CTC",TimeToTriggerWordMap->at(CTCKey));
+      aBuildSet.emplace("TankPMT",it_tank->second);
+      BuiltTanks.push_back(it_tank->second);
+      if(have_mrdmatch){
+        aBuildSet.emplace("MRD",it_mrd->second);
+        BuiltMRDs.push_back(it_mrd->second);
+        if(verbosity>4) std::cout << "BUILDING A BUILD MAP ENTRY. CTC IS " << CTCKey << std::endl;
+      } else if(verbosity>4) std::cout << "BUILDING A PMT ONLY BUILD MAP ENTRY. CTC IS " << CTCKey << std::endl;
+      BuildMap.emplace(CTCKey,aBuildSet);
+      BuiltCTCs.push_back(CTCKey);
+    } else if (!have_mrdmatch){
+      if(verbosity>4) std::cout << "NO MRD OR TANK TIMESTAMP FOR THIS CTC TIME... ORPHAN THE CTC" << std::endl;
+      CTCOrphans.emplace(CTCKey,"ctc_no_mrd_or_tank");
+    } else {
+      // beam ctc and mrd match, but no tank
+      CTCOrphans.emplace(CTCKey,"ctc_mrd_no_tank");
+      MRDOrphans.emplace(it_mrd->second,"ctc_mrd_no_tank");
+      if(verbosity>4) std::cout << "CTC TIMESTAMP " << CTCKey << " PAIRS WITH EITHER A PMT OR MRD..."  << std::endl;
+    }
+  }
+
+  //Delete built timestamps from the timestreams
+  this->RemoveFromTimeStream(myTimeStream.BeamTankTimestamps,BuiltTanks);
+  this->RemoveFromTimeStream(myTimeStream.BeamMRDTimestamps,BuiltMRDs);
+  this->RemoveFromTimeStream(CTCs,BuiltCTCs);
+
+  //Move timestamps with no pairs to the orphanage
+  this->MoveToOrphanage(TankOrphans, MRDOrphans, CTCOrphans);
+  Log("ANNIEEventBuilder: Returning from Merging the Streams",v_debug,verbosity);
+
+  return;
+}
+
+std::map<uint64_t,uint64_t> ANNIEEventBuilder::PairTankPMTAndMRDTriggers(){
+  //Same pairing as PairTankPMTAndMRDTriggersLegacy.  Orphans and pairs are both taken
+  //from the front of the sorted streams, so the consumed stamps are erased as one prefix.
+  if(verbosity>4) std::cout << "ANNIEEventBuilder Tool: Beginning to pair events" << std::endl;
+
+  std::map<uint64_t,uint64_t> TankMRDTimePairs;
+  std::vector<double> ThisPairingTSDiffs;
+  std::map<uint64_t,std::string> MRDOrphans;
+  std::map<uint64_t,std::string> TankOrphans;
+  std::map<uint64_t,std::string> CTCOrphans;
+
+  std::vector<uint64_t>& TankStamps = myTimeStream.BeamTankTimestamps;
+  std::vector<uint64_t>& MRDStamps = myTimeStream.BeamMRDTimestamps;
+  size_t tank_index = 0;
+  size_t mrd_index = 0;
+  int NumOrphans = 0;
+
+  //Pair PMT and MRD timestamps and calculate how much PMTTime - MRDTime has drifted 
+  if(verbosity>4) std::cout << "MEAN OF PMT-MRD TIME DIFFERENCE LAST LOOP: " << CurrentDriftMean << std::endl;
+  for (int i=0;i<EventsPerPairing; i++) {
+    if(tank_index>=TankStamps.size() || mrd_index>=MRDStamps.size()) break;
+    double TSDiff = static_cast<double>(TankStamps[tank_index]) - 
+                    static_cast<double>(MRDStamps[mrd_index]);
+    if(verbosity>4){
+      std::cout << "PAIRED TANK TIMESTAMP: " << TankStamps[tank_index] << std::endl;
+      std::cout << "PAIRED MRD TIMESTAMP: " << MRDStamps[mrd_index] << std::endl;
+      std::cout << "DIFFERENCE BETWEEN PMT AND MRD TIMESTAMP (ns): " << TSDiff << std::endl;
+    }
+    if(std::abs(TSDiff-CurrentDriftMean) > MRDTankTimeTolerance){ // PMT/MRD timestamps farther apart than set tolerance
+      if(verbosity>3) std::cout << "DEVIATION OF " << MRDTankTimeTolerance << " ms DETECTED IN STREAMS" << std::endl;
+      if(TSDiff > 0) {
+        if(verbosity>3) std::cout << "MOVING MRD TIMESTAMP TO ORPHANAGE" << std::endl;
+        MRDOrphans.emplace(MRDStamps[mrd_index++],"mrd_beam_no_tank");
+      } else {
+        if(verbosity>3) std::cout << "MOVING TANK TIMESTAMP TO ORPHANAGE" << std::endl;
+        TankOrphans.emplace(TankStamps[tank_index++],"tank_no_mrd");
+      }
+      NumOrphans +=1;
+    } else {  //PMT/MRD timestamp times within tolerance; pair them
+      ThisPairingTSDiffs.push_back(TSDiff);
+      TankMRDTimePairs.emplace(TankStamps[tank_index++],MRDStamps[mrd_index++]);
+    }
+  }
+
+  //With the last set of pairs calculate what the mean drift is
+  double ThisPairingMean, ThisPairingVariance;
+  if(ThisPairingTSDiffs.size()>2){
+    ComputeMeanAndVariance(ThisPairingTSDiffs,ThisPairingMean,ThisPairingVariance);
+    if((std::abs(CurrentDriftMean-ThisPairingMean)>DriftWarningValue) && (verbosity>=v_warning)){
+      std::cout << "ANNIEEventBuilder tool: WARNING! Shift in drift greater than " << DriftWarningValue << " since last pairings." << std::endl;
+    }
+    if((NumOrphans > OrphanWarningValue) && (verbosity>=v_warning)){
+      std::cout << "ANNIEEventBuilder tool: WARNING! High orphan rate detected.  More than " << OrphanWarningValue << " this pairing sequence." << std::endl;
+    }
+    CurrentDriftMean = ThisPairingMean;
+    CurrentDriftVariance = ThisPairingVariance;
+  }
+
+  if(verbosity>4) std::cout << "DELETE PAIRED TIMESTAMPS FROM THE TIMESTAMP STREAMS " << std::endl;
+  TankStamps.erase(TankStamps.begin(),TankStamps.begin()+tank_index);
+  MRDStamps.erase(MRDStamps.begin(),MRDStamps.begin()+mrd_index);
+  this->MoveToOrphanage(TankOrphans, MRDOrphans, CTCOrphans);
+  return TankMRDTimePairs;
+}
+
+std::map<uint64_t,std::map<std::string,uint64_t>> ANNIEEventBuilder::PairCTCCosmicPairsLegacy(std::map<uint64_t,std::map<std::string,uint64_t>> BuildMap, uint64_t max_timestamp, bool force_matching){
   uint32_t CosmicWord = 36;  //TS_in(35) + 1, where 35 is the MRD_CR_Trigger
   std::vector<uint64_t> MRDCosmicTimes;
   std::vector<uint64_t> MRDStampsToDelete;
@@ -625,10 +983,8 @@ void ANNIEEventBuilder::RemoveCosmics(){
       }
     }
   }
+  this->RemoveFromTimeStream(myTimeStream.BeamMRDTimestamps,MRDStampsToDelete);
   for (int j=0; j<MRDStampsToDelete.size(); j++){
-    myTimeStream.BeamMRDTimestamps.erase(std::remove(myTimeStream.BeamMRDTimestamps.begin(),
-        myTimeStream.BeamMRDTimestamps.end(),MRDStampsToDelete.at(j)), 
-        myTimeStream.BeamMRDTimestamps.end());
     myMRDMaps.MRDEvents.erase(MRDStampsToDelete.at(j));
     myMRDMaps.MRDTriggerTypeMap.erase(MRDStampsToDelete.at(j));
     myMRDMaps.MRDBeamLoopbackMap.erase(MRDStampsToDelete.at(j));
@@ -638,7 +994,7 @@ void ANNIEEventBuilder::RemoveCosmics(){
 }
 
 
-std::map<uint64_t,std::map<std::string,uint64_t>> ANNIEEventBuilder::MergeStreams(std::map<uint64_t,std::map<std::string,uint64_t>> BuildMap, uint64_t max_timestamp, bool force_matching){
+std::map<uint64_t,std::map<std::string,uint64_t>> ANNIEEventBuilder::MergeStreamsLegacy(std::map<uint64_t,std::map<std::string,uint64_t>> BuildMap, uint64_t max_timestamp, bool force_matching){
   //This method takes timestamps from the BeamMRDTimestamps, BeamTankTimestamps, and
   //CTCTimestamps vectors (acquired as the building continues) and builds maps 
   //stored in the BuildMap and used to build ANNIEEvents.
@@ -780,6 +1136,8 @@ void ANNIEEventBuilder::MoveToOrphanage(std::map<uint64_t, std::string> TankOrph
                                         std::map<uint64_t, std::string> MRDOrphans,
                                         std::map<uint64_t, std::string> CTCOrphans){
   if(verbosity>3) std::cout << "MOVING TIMESTAMPS WITH NO FAMILY TO ORPHANAGE" << std::endl;
+  //Orphaned timestamps are removed from their timestreams in one pass per stream
+  std::vector<uint64_t> OrphanStamps;
   //Finally, we need to move data associated with our orphaned timestamps to the orphange
   for(auto&& nextorphan : CTCOrphans){
     uint64_t CTCOrphanStamp = nextorphan.first;
@@ -792,11 +1150,11 @@ void ANNIEEventBuilder::MoveToOrphanage(std::map<uint64_t, std::string> TankOrph
     // move to orphanage
     myOrphanage.OrphanCTCTimestamps.emplace(CTCOrphanStamp,orphaninfo);
     
-    // remove the orphan from the timestream
-    myTimeStream.CTCTimestamps.erase(std::remove(myTimeStream.CTCTimestamps.begin(),
-         myTimeStream.CTCTimestamps.end(),CTCOrphanStamp), 
-         myTimeStream.CTCTimestamps.end());
+    OrphanStamps.push_back(CTCOrphanStamp);
   }
+  // remove the orphans from the timestream
+  this->RemoveFromTimeStream(myTimeStream.CTCTimestamps,OrphanStamps);
+  OrphanStamps.clear();
   
   for(auto&& nextorphan : TankOrphans){
     uint64_t TankOrphanStamp = nextorphan.first;
@@ -808,11 +1166,10 @@ void ANNIEEventBuilder::MoveToOrphanage(std::map<uint64_t, std::string> TankOrph
     // move to orphanage
     myOrphanage.OrphanTankTimestamps.emplace(TankOrphanStamp,orphaninfo);
     
-    // remove the orphan from the timestream
-    myTimeStream.BeamTankTimestamps.erase(std::remove(myTimeStream.BeamTankTimestamps.begin(),
-               myTimeStream.BeamTankTimestamps.end(),TankOrphanStamp), 
-               myTimeStream.BeamTankTimestamps.end());
+    OrphanStamps.push_back(TankOrphanStamp);
   }
+  this->RemoveFromTimeStream(myTimeStream.BeamTankTimestamps,OrphanStamps);
+  OrphanStamps.clear();
   
   for(auto&& nextorphan : MRDOrphans){
     uint64_t MrdOrphanStamp = nextorphan.first;
@@ -824,11 +1181,9 @@ void ANNIEEventBuilder::MoveToOrphanage(std::map<uint64_t, std::string> TankOrph
     // move to orphanage
     myOrphanage.OrphanMRDTimestamps.emplace(MrdOrphanStamp,orphaninfo);
     
-    // remove the orphan from the timestream
-    myTimeStream.BeamMRDTimestamps.erase(std::remove(myTimeStream.BeamMRDTimestamps.begin(),
-               myTimeStream.BeamMRDTimestamps.end(),MrdOrphanStamp), 
-               myTimeStream.BeamMRDTimestamps.end());
+    OrphanStamps.push_back(MrdOrphanStamp);
   }
+  this->RemoveFromTimeStream(myTimeStream.BeamMRDTimestamps,OrphanStamps);
   if(verbosity>3) std::cout << "ORPHAN MOVEMENT COMPLETE" << std::endl;
   return;
 }
@@ -904,7 +1259,7 @@ void ANNIEEventBuilder::ManageOrphanage(){
   return;
 }
 
-std::map<uint64_t,uint64_t> ANNIEEventBuilder::PairTankPMTAndMRDTriggers(){
+std::map<uint64_t,uint64_t> ANNIEEventBuilder::PairTankPMTAndMRDTriggersLegacy(){
   if(verbosity>4) std::cout << "ANNIEEventBuilder Tool: Beginning to pair events" << std::endl;
 
   std::map<uint64_t,uint64_t> TankMRDTimePairs; //Pairs of beam-triggered Tank PMT/MRD counters ready to be built if all PMT waveforms are ready (TankAndMRD mode only)
@@ -1048,33 +1403,37 @@ void ANNIEEventBuilder::BuildANNIEEventCTC(uint64_t CTCTime, uint32_t CTCWord)
 }
 
 void ANNIEEventBuilder::BuildANNIEEventTank(uint64_t ClockTime, 
-        std::map<std::vector<int>, std::vector<uint16_t>> WaveMap)
+        std::map<std::vector<int>, std::vector<uint16_t>>& WaveMap)
 {
   if(verbosity>v_message)std::cout << "Building an ANNIE Event" << std::endl;
 
   ///////////////LOAD RAW PMT DATA INTO ANNIEEVENT///////////////
-  std::map<unsigned long, std::vector<Waveform<uint16_t>> > RawADCData;
-  std::map<unsigned long, std::vector<Waveform<uint16_t>> > RawADCAuxData;
-  for(std::pair<std::vector<int>, std::vector<uint16_t>> apair : WaveMap){
+  //Sample buffers are moved from the decoder's wave map into the Waveforms, and the maps
+  //are handed to the ANNIEEvent as pointers (as TDCData is): a Set by value serialises
+  //every sample into the store there and then, and each Get deserialises them again.
+  //With the pointer the maps are only serialised when the ANNIEEvent is saved.
+  std::map<unsigned long, std::vector<Waveform<uint16_t>> >* RawADCData = new std::map<unsigned long, std::vector<Waveform<uint16_t>> >;
+  std::map<unsigned long, std::vector<Waveform<uint16_t>> >* RawADCAuxData = new std::map<unsigned long, std::vector<Waveform<uint16_t>> >;
+  //Each wave's decoder buffer, checked against the buffer the ANNIEEvent ends up with
+  //to count the buffers that were copied or reallocated on the way
+  std::vector<std::pair<const std::vector<Waveform<uint16_t>>*, const uint16_t*> > SourceBuffers;
+  for(auto&& apair : WaveMap){
     int CardID = apair.first.at(0);
     int ChannelID = apair.first.at(1);
     int CrateNum=-1;
     int SlotNum=-1;
     this->CardIDToElectronicsSpace(CardID, CrateNum, SlotNum);
-    std::vector<uint16_t> TheWaveform = apair.second;
-    Waveform<uint16_t> TheWave(ClockTime, TheWaveform);
-    //Placing waveform in a vector in case we want a hefty-mode minibuffer storage eventually
-    std::vector<Waveform<uint16_t>> WaveVec{TheWave};
     
     std::vector<int> CrateSpace{CrateNum,SlotNum,ChannelID};
+    std::map<unsigned long, std::vector<Waveform<uint16_t>> >* DestinationMap = nullptr;
     unsigned long ChannelKey;
     if(TankPMTCrateSpaceToChannelNumMap.count(CrateSpace)>0){
       ChannelKey = TankPMTCrateSpaceToChannelNumMap.at(CrateSpace);
-      RawADCData.emplace(ChannelKey,WaveVec);
+      DestinationMap = RawADCData;
     }
     else if (AuxCrateSpaceToChannelNumMap.count(CrateSpace)>0){
       ChannelKey = AuxCrateSpaceToChannelNumMap.at(CrateSpace);
-      RawADCAuxData.emplace(ChannelKey,WaveVec);
+      DestinationMap = RawADCAuxData;
     } else{
       Log("ANNIEEventBuilder:: Cannot find channel key for crate space entry: ",v_error, verbosity);
       Log("ANNIEEventBuilder::CrateNum "+to_string(CrateNum),v_error, verbosity);
@@ -1083,13 +1442,33 @@ void ANNIEEventBuilder::BuildANNIEEventTank(uint64_t ClockTime,
       Log("ANNIEEventBuilder:: Passing over the wave; PMT DATA LOST",v_error, verbosity);
       continue;
     }
+    //Placing waveform in a vector in case we want a hefty-mode minibuffer storage eventually
+    std::pair<std::map<unsigned long, std::vector<Waveform<uint16_t>> >::iterator,bool> inserted =
+        DestinationMap->emplace(ChannelKey,std::vector<Waveform<uint16_t>>());
+    if(!inserted.second) continue;
+    SourceBuffers.emplace_back(&inserted.first->second, apair.second.data());
+    inserted.first->second.emplace_back(ClockTime, std::move(apair.second));
+  }
+  int NumBuffersMoved = 0;
+  int NumBufferCopies = 0;
+  size_t NumSamplesCopied = 0;
+  for(auto&& source : SourceBuffers){
+    const std::vector<uint16_t>& Samples = source.first->back().Samples();
+    if(Samples.empty() || Samples.data() == source.second) NumBuffersMoved++;
+    else {
+      NumBufferCopies++;
+      NumSamplesCopied += Samples.size();
+    }
   }
-  if(RawADCData.size() == 0){
+  Log("ANNIEEventBuilder: Tank event "+to_string(ClockTime)+": "+to_string(RawADCData->size())+" PMT and "+
+      to_string(RawADCAuxData->size())+" auxiliary waveforms; "+to_string(NumBuffersMoved)+" sample buffers moved, "+
+      to_string(NumBufferCopies)+" copied ("+to_string(NumSamplesCopied)+" samples)",v_debug,verbosity);
+  if(RawADCData->size() == 0){
     std::cout << "No Raw ADC Data in entry.  Not putting to ANNIEEvent." << std::endl;
   }
   std::cout << "Setting ANNIE Event information" << std::endl;
-  ANNIEEvent->Set("RawADCData",RawADCData);
-  ANNIEEvent->Set("RawADCAuxData",RawADCAuxData);
+  ANNIEEvent->Set("RawADCData",RawADCData,true);
+  ANNIEEvent->Set("RawADCAuxData",RawADCAuxData,true);
   ANNIEEvent->Set("EventTimeTank",ClockTime);
   if(verbosity>v_debug) std::cout << "ANNIEEventBuilder: ANNIE Event "+
       to_string(ANNIEEventNum)+" built." << std::endl;
@@ -1135,3 +1514,161 @@ void ANNIEEventBuilder::OpenNewANNIEEvent(int RunNum, int SubRunNum,uint64_t Sta
   CurrentStarTime = StarT;
   if((CurrentRunNum != RunNum)) CurrentDriftMean = 0;
 }
+
+void ANNIEEventBuilder::AddToTimeStream(std::vector<uint64_t>& Stream, std::vector<uint64_t>& NewTimestamps){
+  if(NewTimestamps.empty()) return;
+  std::sort(NewTimestamps.begin(),NewTimestamps.end());
+  NewTimestamps.erase(std::unique(NewTimestamps.begin(),NewTimestamps.end()),NewTimestamps.end());
+  //Data normally arrives in time order, in which case the new stamps are just appended
+  if(Stream.empty() || NewTimestamps.front() > Stream.back()){
+    Stream.insert(Stream.end(),NewTimestamps.begin(),NewTimestamps.end());
+    return;
+  }
+  size_t OldSize = Stream.size();
+  Stream.insert(Stream.end(),NewTimestamps.begin(),NewTimestamps.end());
+  std::inplace_merge(Stream.begin(),Stream.begin()+OldSize,Stream.end());
+  Stream.erase(std::unique(Stream.begin(),Stream.end()),Stream.end());
+  return;
+}
+
+void ANNIEEventBuilder::RemoveFromTimeStream(std::vector<uint64_t>& Stream, std::vector<uint64_t>& Timestamps){
+  if(Timestamps.empty() || Stream.empty()) return;
+  if(!std::is_sorted(Timestamps.begin(),Timestamps.end())) std::sort(Timestamps.begin(),Timestamps.end());
+  Stream.erase(std::remove_if(Stream.begin(),Stream.end(),
+      [&Timestamps](uint64_t aTS){ return std::binary_search(Timestamps.begin(),Timestamps.end(),aTS); }),
+      Stream.end());
+  return;
+}
+
+void ANNIEEventBuilder::RunPairingBenchmark(){
+  //Build synthetic CTC/Tank/MRD timestreams, feed them to both pairing implementations
+  //in Execute-sized chunks and compare the timing and the resulting pairs and orphans.
+  Log("ANNIEEventBuilder: Running pairing benchmark with "+std::to_string(BenchmarkPairingTriggers)+" synthetic triggers",v_message,verbosity);
+  int PairingChunk = (EventsPerPairing>0) ? EventsPerPairing : 1;
+
+  std::mt19937_64 generator(12345);
+  std::uniform_real_distribution<double> uniform(0.,1.);
+  std::map<uint64_t,uint32_t> BenchCTCWords;
+  std::vector<std::vector<uint64_t>> ChunkCTC, ChunkTank, ChunkMRD, ChunkBeamMRD;
+  std::map<uint64_t,std::string> BenchMRDTypes;
+  uint64_t ctc_time = 1600000000000000000ULL;
+  int NumChunks = BenchmarkPairingTriggers/(2*PairingChunk) + 1;
+  ChunkCTC.resize(NumChunks); ChunkTank.resize(NumChunks); ChunkMRD.resize(NumChunks); ChunkBeamMRD.resize(NumChunks);
+  for(int i=0; i<BenchmarkPairingTriggers; i++){
+    int chunk = i/(2*PairingChunk);
+    ctc_time += 50000000 + static_cast<uint64_t>(uniform(generator)*40000000.);
+    bool is_cosmic = (uniform(generator) < 0.2);
+    BenchCTCWords.emplace(ctc_time,is_cosmic ? 36 : 5);
+    ChunkCTC.at(chunk).push_back(ctc_time);
+    //MRD stamps have ms precision and a small offset relative to the CTC
+    uint64_t mrd_time = (ctc_time/1000000)*1000000 + ((uniform(generator)<0.5) ? 1000000 : 0);
+    if(uniform(generator) < 0.02) mrd_time += 3*static_cast<uint64_t>(CTCMRDTimeTolerance);
+    if(is_cosmic){
+      if(uniform(generator) < 0.95){
+        ChunkMRD.at(chunk).push_back(mrd_time);
+        BenchMRDTypes[mrd_time] = "Cosmic";
+      }
+      continue;
+    }
+    if(uniform(generator) < 0.97){
+      uint64_t tank_time = ctc_time + static_cast<uint64_t>(uniform(generator)*80.);
+      if(uniform(generator) < 0.01) tank_time += 3*static_cast<uint64_t>(CTCTankTimeTolerance);
+      ChunkTank.at(chunk).push_back(tank_time);
+      //Beam MRD stamps for TankAndMRD pairing track the tank stamps with a small jitter
+      if(uniform(generator) < 0.98) ChunkBeamMRD.at(chunk).push_back(tank_time + static_cast<uint64_t>(uniform(generator)*1000.));
+    }
+    if(uniform(generator) < 0.95){
+      ChunkMRD.at(chunk).push_back(mrd_time);
+      BenchMRDTypes[mrd_time] = "Beam";
+    }
+  }
+
+  //Keep the real state aside while the benchmark runs
+  TimeStream SavedTimeStream = myTimeStream;
+  MRDEventMaps SavedMRDMaps = myMRDMaps;
+  Orphanage SavedOrphanage = myOrphanage;
+  std::map<uint64_t,uint32_t>* SavedTriggerWordMap = TimeToTriggerWordMap;
+  double SavedDriftMean = CurrentDriftMean;
+  double SavedDriftVariance = CurrentDriftVariance;
+  int SavedVerbosity = verbosity;
+  verbosity = v_warning;
+  TimeToTriggerWordMap = &BenchCTCWords;
+
+  std::map<uint64_t,std::map<std::string,uint64_t>> BuildMaps[2];
+  std::map<uint64_t,uint64_t> TankMRDPairs[2];
+  Orphanage BenchOrphans[2];
+  double Seconds[2] = {0.,0.};
+  double TankMRDSeconds[2] = {0.,0.};
+  for(int legacy=0; legacy<2; legacy++){
+    //CTC matching (TankAndMRDAndCTC mode)
+    myTimeStream = TimeStream();
+    myMRDMaps = MRDEventMaps();
+    myOrphanage = Orphanage();
+    myMRDMaps.MRDTriggerTypeMap = BenchMRDTypes;
+    for(int chunk=0; chunk<NumChunks; chunk++){
+      this->AddToTimeStream(myTimeStream.CTCTimestamps,ChunkCTC.at(chunk));
+      this->AddToTimeStream(myTimeStream.BeamTankTimestamps,ChunkTank.at(chunk));
+      this->AddToTimeStream(myTimeStream.BeamMRDTimestamps,ChunkMRD.at(chunk));
+      bool last_chunk = (chunk == NumChunks-1);
+      uint64_t most_recent_beam = myTimeStream.BeamTankTimestamps.empty() ? 0 : myTimeStream.BeamTankTimestamps.back();
+      uint64_t most_recent_mrd = myTimeStream.BeamMRDTimestamps.empty() ? 0 : myTimeStream.BeamMRDTimestamps.back();
+      uint64_t most_recent_ctc = myTimeStream.CTCTimestamps.empty() ? 0 : myTimeStream.CTCTimestamps.back();
+      uint64_t slowest_stream_timestamp = std::min(most_recent_beam,std::min(most_recent_mrd,most_recent_ctc));
+      size_t MinStamps = std::min(myTimeStream.BeamTankTimestamps.size(),
+          std::min(myTimeStream.BeamMRDTimestamps.size(),myTimeStream.CTCTimestamps.size()));
+      if((MinStamps<=static_cast<size_t>(EventsPerPairing)) && !last_chunk) continue;
+      std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+      if(legacy){
+        BuildMaps[legacy] = this->PairCTCCosmicPairsLegacy(BuildMaps[legacy],std::max(most_recent_mrd,most_recent_ctc),last_chunk);
+        BuildMaps[legacy] = this->MergeStreamsLegacy(BuildMaps[legacy],slowest_stream_timestamp,last_chunk);
+      } else {
+        this->PairCTCCosmicPairs(BuildMaps[legacy],std::max(most_recent_mrd,most_recent_ctc),last_chunk);
+        this->MergeStreams(BuildMaps[legacy],slowest_stream_timestamp,last_chunk);
+      }
+      Seconds[legacy] += std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count();
+      BenchOrphans[legacy].OrphanTankTimestamps.insert(myOrphanage.OrphanTankTimestamps.begin(),myOrphanage.OrphanTankTimestamps.end());
+      BenchOrphans[legacy].OrphanMRDTimestamps.insert(myOrphanage.OrphanMRDTimestamps.begin(),myOrphanage.OrphanMRDTimestamps.end());
+      BenchOrphans[legacy].OrphanCTCTimestamps.insert(myOrphanage.OrphanCTCTimestamps.begin(),myOrphanage.OrphanCTCTimestamps.end());
+      myOrphanage = Orphanage();
+    }
+
+    //Tank/MRD drift pairing (TankAndMRD mode)
+    myTimeStream = TimeStream();
+    CurrentDriftMean = 0;
+    CurrentDriftVariance = 0;
+    for(int chunk=0; chunk<NumChunks; chunk++){
+      this->AddToTimeStream(myTimeStream.BeamTankTimestamps,ChunkTank.at(chunk));
+      this->AddToTimeStream(myTimeStream.BeamMRDTimestamps,ChunkBeamMRD.at(chunk));
+      size_t MinStamps = std::min(myTimeStream.BeamTankTimestamps.size(),myTimeStream.BeamMRDTimestamps.size());
+      if(MinStamps<=static_cast<size_t>(EventsPerPairing*10)) continue;
+      std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+      std::map<uint64_t,uint64_t> ThesePairs = legacy ? this->PairTankPMTAndMRDTriggersLegacy() : this->PairTankPMTAndMRDTriggers();
+      TankMRDSeconds[legacy] += std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count();
+      TankMRDPairs[legacy].insert(ThesePairs.begin(),ThesePairs.end());
+      BenchOrphans[legacy].OrphanTankTimestamps.insert(myOrphanage.OrphanTankTimestamps.begin(),myOrphanage.OrphanTankTimestamps.end());
+      BenchOrphans[legacy].OrphanMRDTimestamps.insert(myOrphanage.OrphanMRDTimestamps.begin(),myOrphanage.OrphanMRDTimestamps.end());
+      myOrphanage = Orphanage();
+    }
+  }
+
+  bool results_match = (BuildMaps[0] == BuildMaps[1]) && (TankMRDPairs[0] == TankMRDPairs[1]) &&
+      (BenchOrphans[0].OrphanTankTimestamps == BenchOrphans[1].OrphanTankTimestamps) &&
+      (BenchOrphans[0].OrphanMRDTimestamps == BenchOrphans[1].OrphanMRDTimestamps) &&
+      (BenchOrphans[0].OrphanCTCTimestamps == BenchOrphans[1].OrphanCTCTimestamps);
+
+  myTimeStream = SavedTimeStream;
+  myMRDMaps = SavedMRDMaps;
+  myOrphanage = SavedOrphanage;
+  TimeToTriggerWordMap = SavedTriggerWordMap;
+  CurrentDriftMean = SavedDriftMean;
+  CurrentDriftVariance = SavedDriftVariance;
+  verbosity = SavedVerbosity;
+
+  Log("ANNIEEventBuilder: Pairing benchmark built "+std::to_string(BuildMaps[0].size())+" CTC sets and "+
+      std::to_string(TankMRDPairs[0].size())+" Tank/MRD pairs",v_message,verbosity);
+  Log("ANNIEEventBuilder: CTC matching: Legacy "+std::to_string(Seconds[1])+" s, SortedMerge "+std::to_string(Seconds[0])+" s",v_message,verbosity);
+  Log("ANNIEEventBuilder: Tank/MRD pairing: Legacy "+std::to_string(TankMRDSeconds[1])+" s, SortedMerge "+std::to_string(TankMRDSeconds[0])+" s",v_message,verbosity);
+  if(results_match) Log("ANNIEEventBuilder: Pairing benchmark results identical for both implementations",v_message,verbosity);
+  else Log("ANNIEEventBuilder: WARNING! Pairing benchmark results differ between Legacy and SortedMerge",v_error,verbosity);
+  return;
+}
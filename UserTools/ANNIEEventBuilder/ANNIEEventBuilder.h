@@ -5,12 +5,16 @@
 #include <iostream>
 #include <set>
 #include <unordered_set>
+#include <chrono>
+#include <random>
 
 #include "Tool.h"
 #include "TimeClass.h"
 #include "TriggerClass.h"
 #include "Waveform.h"
 #include "ANNIEalgorithms.h"
+#include "MRDEventQueue.h"
+#include "RawDecodePipeline.h"
 /**
 * \class ANNIEEventBuilder
 *
@@ -38,6 +42,8 @@ struct Orphanage{
 };
 
 //########## TIMESTAMP STREAMS USED WHEN PAIRING DATA TO BUILD ANNIE EVENTS ########
+//Each stream is kept sorted and free of duplicates (see AddToTimeStream), which the
+//sorted-merge pairing methods rely on.
 struct TimeStream{
   std::vector<uint64_t> BeamTankTimestamps;  //Contains beam timestamps for all PMT events that haven't been paired to an MRD or CTC TS (keys in FinishedTankEvents)
   std::vector<uint64_t> BeamMRDTimestamps;  //Contains beam timestamps for all MRD events that haven't been paired to a PMT or CTC TS (keys in MRDEvents) - name is a misnomer, this is not just beam but also MRD cosmic triggers
@@ -60,7 +66,7 @@ class ANNIEEventBuilder: public Tool {
 
   //Methods to add info from different data streams to ANNIEEvent booststore
   void BuildANNIEEventRunInfo(int RunNum, int SubRunNum, int RunType, uint64_t RunStartTime);  //Loads run level information, as well as the entry number
-  void BuildANNIEEventTank(uint64_t CounterTime, std::map<std::vector<int>, std::vector<uint16_t>> WaveMap);
+  void BuildANNIEEventTank(uint64_t CounterTime, std::map<std::vector<int>, std::vector<uint16_t>>& WaveMap); ///< Sample buffers are moved out of WaveMap into the ANNIEEvent
   void BuildANNIEEventCTC(uint64_t CTCTime, uint32_t TriggerWord);
   void BuildANNIEEventMRD(std::vector<std::pair<unsigned long,int>> MRDHits, 
   uint64_t MRDTimeStamp, std::string MRDTriggerType, int beam_tdc, int cosmic_tdc);
@@ -73,10 +79,28 @@ class ANNIEEventBuilder: public Tool {
   void ProcessNewMRDData();
   void ProcessNewCTCData();
 
-  //Methods used to merge CTC/PMT/MRD streams
+  //Pipelined decoding (LoadRawData DecodeMode Pipelined)
+  void DrainDecodePipeline(bool final_drain); ///< Merge the decoders' output queues into the maps above; paused streams are held back
+  void SetStreamPaused(RawDecodePipeline::Stream s, bool paused); ///< Pause or resume a stream: CStore Pause*Decoding flag, or back-pressure when pipelined
+
+  //Methods used to merge CTC/PMT/MRD streams.  These walk the sorted timestreams
+  //once with a merge, and remove paired/orphaned timestamps in one pass per stream.
   std::map<uint64_t,uint64_t> PairTankPMTAndMRDTriggers();  // Return pairs of Tank and PMT timestamps
-  std::map<uint64_t,std::map<std::string,uint64_t>> PairCTCCosmicPairs(std::map<uint64_t,std::map<std::string,uint64_t>> BuildMap, uint64_t max_timestamp, bool force_matching=false); //Pair Cosmics with Cosmic muon trigger words
-  std::map<uint64_t,std::map<std::string,uint64_t>> MergeStreams(std::map<uint64_t,std::map<std::string,uint64_t>> BuildMap, uint64_t max_timestamp, bool force_matching=false);       // TankAndMRDAndCTC pairing mode;
+  void PairCTCCosmicPairs(std::map<uint64_t,std::map<std::string,uint64_t>>& BuildMap, uint64_t max_timestamp, bool force_matching=false); //Pair Cosmics with Cosmic muon trigger words
+  void MergeStreams(std::map<uint64_t,std::map<std::string,uint64_t>>& BuildMap, uint64_t max_timestamp, bool force_matching=false);       // TankAndMRDAndCTC pairing mode;
+
+  //Original pairing methods (PairingMode Legacy).  Kept as the reference the
+  //sorted-merge methods are checked against by the pairing benchmark.
+  std::map<uint64_t,uint64_t> PairTankPMTAndMRDTriggersLegacy();
+  std::map<uint64_t,std::map<std::string,uint64_t>> PairCTCCosmicPairsLegacy(std::map<uint64_t,std::map<std::string,uint64_t>> BuildMap, uint64_t max_timestamp, bool force_matching=false);
+  std::map<uint64_t,std::map<std::string,uint64_t>> MergeStreamsLegacy(std::map<uint64_t,std::map<std::string,uint64_t>> BuildMap, uint64_t max_timestamp, bool force_matching=false);
+
+  //Timestream helpers
+  void AddToTimeStream(std::vector<uint64_t>& Stream, std::vector<uint64_t>& NewTimestamps); ///< Insert new timestamps, keeping the stream sorted and unique
+  void RemoveFromTimeStream(std::vector<uint64_t>& Stream, std::vector<uint64_t>& Timestamps); ///< Remove a batch of timestamps in one pass
+
+  //Synthetic-stream benchmark of the Legacy and SortedMerge pairing (BenchmarkPairing config variable)
+  void RunPairingBenchmark();
   void ManageOrphanage();
   void MoveToOrphanage(std::map<uint64_t,std::string> TankOrphans,
                        std::map<uint64_t,std::string> MRDOrphans,
@@ -108,12 +132,25 @@ class ANNIEEventBuilder: public Tool {
   std::map<uint64_t, std::map<std::vector<int>, std::vector<uint16_t> > >* InProgressTankEvents;  //Key: {MTCTime}, value: map of in-progress PMT trigger decoding from WaveBank
   std::map<uint64_t, std::map<std::vector<int>, std::vector<uint16_t> > > FinishedTankEvents;  //Key: {MTCTime}, value: map of fully-built waveforms from WaveBank
   std::map<uint64_t,uint32_t>* TimeToTriggerWordMap;  // Key: CTCTimestamp, value: Trigger Mask ID;
+  MRDEventQueue* NewMRDEvents = nullptr;  //Decoded MRD triggers handed over by the MRDDataDecoder; drained into myMRDMaps
   MRDEventMaps myMRDMaps;
 
+  //####### PIPELINED DECODING (LoadRawData DecodeMode Pipelined) #########
+  RawDecodePipeline* DecodePipeline = nullptr;
+  MRDEventQueue PipelineMRDEvents;  //Decoded MRD triggers drained from the pipeline, used as NewMRDEvents
+  bool StreamPaused[RawDecodePipeline::NumStreams] = {false,false,false};
+  int HeldBackBuilds[RawDecodePipeline::NumStreams] = {0,0,0};  //Builds where a paused stream was left in its queue
+  PipelineStageStats BuildStats;
+
 
   //######### MAPS THAT HOLD PAIRED TANK/MRD/CTC TIMESTAMPS ########
   int EventsPerPairing;  //Determines how many Tank, MRD, and CTC events are paired per event building cycle (10* this number needed to do pairing)
   TimeStream myTimeStream;
+  uint64_t NewestCTCTimestamp = 0;  //Newest CTC timestamp already added to the CTC timestream
+  std::string PairingMode;  //SortedMerge or Legacy
+  bool UseLegacyPairing = false;
+  bool BenchmarkPairing = false;
+  int BenchmarkPairingTriggers = 20000;   //Number of synthetic CTC triggers in the pairing benchmark
   int64_t pause_threshold; // maximum difference between the most recent timestamps from each stream before we start throttling event reading - e.g. if one stream has much more frequent events than the others, don't read new events from it until the others catch up
   
   //######### INFORMATION USED FOR TRACKING ORPHAN DATA (EVENTS FROM STREAMS THAT HAVE NO OTHER PAIRS) ############
@@ -38,6 +38,8 @@ bool BeamChecker::Initialise(std::string config_filename, DataModel& data)
   // Assign a transient data pointer
   m_data = &data;
 
+  load_cut_settings();
+
   return initialise_beam_db();
 }
 
@@ -114,8 +116,7 @@ bool BeamChecker::Execute() {
     return false;
   }
 
-  // Build the vector of beam statuses (with one for each minibuffer)
-  std::vector<BeamStatus> beam_statuses;
+  std::vector<uint64_t> mb_ns_since_epoch;
 
   for (size_t mb = 0; mb < num_minibuffers; ++mb) {
 
@@ -123,9 +124,20 @@ bool BeamChecker::Execute() {
     if (hefty_mode) ns_since_epoch = hefty_info.time(mb);
     else ns_since_epoch = mb_timestamps.at(mb).GetNs();
 
-    const auto& mb_label = minibuffer_labels.at(mb);
+    mb_ns_since_epoch.push_back( ns_since_epoch );
+  }
+
+  // Build the vector of beam statuses (with one for each minibuffer)
+  auto lookup_start = std::chrono::steady_clock::now();
+
+  std::vector<BeamStatus> beam_statuses = get_beam_statuses(
+    mb_ns_since_epoch, minibuffer_labels);
+
+  lookup_time_ms_ += std::chrono::duration<double, std::milli>(
+    std::chrono::steady_clock::now() - lookup_start).count();
+  num_lookups_ += num_minibuffers;
 
-    auto temp_beam_status = get_beam_status(ns_since_epoch, mb_label);
+  for (const auto& temp_beam_status : beam_statuses) {
 
     std::stringstream temp_ss;
     temp_ss << std::scientific << std::setprecision(4);
@@ -133,8 +145,6 @@ bool BeamChecker::Execute() {
 
     Log(make_beam_condition_string( temp_beam_status.condition() )
       + " minibuffer had " + temp_ss.str() + " POT", 2, verbosity_);
-
-    beam_statuses.push_back( temp_beam_status );
   }
 
   annie_event->Set("BeamStatuses", beam_statuses);
@@ -145,9 +155,42 @@ bool BeamChecker::Execute() {
 
 bool BeamChecker::Finalise() {
 
+  if (num_lookups_ > 0) {
+    Log("BeamChecker: found beam statuses for "
+      + std::to_string(num_lookups_) + " minibuffers in "
+      + std::to_string(lookup_time_ms_) + " ms ("
+      + std::to_string(1000. * lookup_time_ms_ / num_lookups_)
+      + " us per minibuffer)", 1, verbosity_);
+  }
+
   return true;
 }
 
+void BeamChecker::load_cut_settings() {
+
+  // The "first toroid" should be the one farther upstream from the target
+  // (E:TOR860 in the current configuration)
+  m_variables.Get("FirstToroid", first_toroid_);
+  m_variables.Get("SecondToroid", second_toroid_);
+  m_variables.Get("HornCurrentDevice", horn_current_device_);
+
+  pot_min_ = BOGUS_DOUBLE;
+  pot_max_ = BOGUS_DOUBLE;
+  m_variables.Get("CutPOTMax", pot_max_);
+  m_variables.Get("CutPOTMin", pot_min_);
+
+  horn_current_min_ = BOGUS_DOUBLE;
+  horn_current_max_ = BOGUS_DOUBLE;
+  m_variables.Get("CutPeakHornCurrentMax", horn_current_max_);
+  m_variables.Get("CutPeakHornCurrentMin", horn_current_min_);
+
+  toroid_tol_ = BOGUS_DOUBLE;
+  m_variables.Get("CutToroidAgreement", toroid_tol_);
+
+  t_tol_ = BOGUS_INT;
+  m_variables.Get("CutTimestampAgreement", t_tol_);
+}
+
 bool BeamChecker::initialise_beam_db() {
 
   m_variables.Get("verbose", verbosity_);
@@ -171,6 +214,25 @@ bool BeamChecker::initialise_beam_db() {
   }
   dummy_in_file.close();
 
+  // Columnar beam database files are memory-mapped rather than loaded
+  // into the BoostStore
+  if ( BeamDBFile::IsBeamDBFile(db_filename) ) {
+    if ( !beam_db_file_.Open(db_filename) ) {
+      Log("Error: " + beam_db_file_.error_message(), 0, verbosity_);
+      return false;
+    }
+    columnar_db_ = true;
+    start_ms_since_epoch_ = beam_db_file_.start_ms();
+    end_ms_since_epoch_ = beam_db_file_.end_ms();
+
+    Log("Loaded columnar beam database with "
+      + std::to_string(beam_db_file_.num_chunks()) + " chunks for times"
+      " between " + make_time_string(start_ms_since_epoch_) + " and "
+      + make_time_string(end_ms_since_epoch_), 1, verbosity_);
+
+    return true;
+  }
+
   beam_db_store_.Initialise( db_filename );
 
   bool got_index = beam_db_store_.Header->Get("BeamDBIndex", beam_db_index_);
@@ -227,33 +289,6 @@ BeamStatus BeamChecker::get_beam_status(uint64_t ns_since_epoch,
       BeamCondition::NonBeamMinibuffer);
   }
 
-  // Retrieve device names needed for beam quality checks from the
-  // configuration file
-  //
-  // The "first toroid" should be the one farther upstream from the target
-  // (E:TOR860 in the current configuration)
-  std::string first_toroid;
-  m_variables.Get("FirstToroid", first_toroid);
-
-  std::string second_toroid;
-  m_variables.Get("SecondToroid", second_toroid);
-
-  std::string horn_current_device;
-  m_variables.Get("HornCurrentDevice", horn_current_device);
-
-  // TODO: consider making the static variables used here into members of
-  // the BeamChecker class instead
-  static std::map<std::string, std::map<uint64_t, BeamDataPoint> >
-    beam_data;
-  static int current_beam_db_entry = 0;
-  static bool got_first_beam_entry = false;
-
-  if ( !got_first_beam_entry ) {
-    beam_db_store_.GetEntry(current_beam_db_entry);
-    beam_db_store_.Get("BeamDB", beam_data);
-    got_first_beam_entry = true;
-  }
-
   // The beam database uses timestamps with ms precision
   uint64_t ms_since_epoch = ns_since_epoch / MILLION;
 
@@ -285,26 +320,32 @@ BeamStatus BeamChecker::get_beam_status(uint64_t ns_since_epoch,
 
   // If we need to load a new entry from the beam database, do so.
   // Avoid loading a new entry if you don't have to (the maps stored in
-  // each entry are fairly large)
+  // each entry are fairly large). The previously loaded entry is kept, so
+  // minibuffers near the boundary of two entries don't reload them in turn.
   int new_entry_number = iter->first;
-  if ( new_entry_number != current_beam_db_entry ) {
+  if ( new_entry_number != current_beam_db_entry_ ) {
+
+    std::swap(beam_data_, previous_beam_data_);
+    std::swap(current_beam_db_entry_, previous_beam_db_entry_);
 
-    beam_db_store_.GetEntry(new_entry_number);
-    beam_db_store_.Get("BeamDB", beam_data);
+    if ( new_entry_number != current_beam_db_entry_ ) {
+      beam_data_.clear();
+      beam_db_store_.GetEntry(new_entry_number);
+      beam_db_store_.Get("BeamDB", beam_data_);
 
-    current_beam_db_entry = new_entry_number;
+      current_beam_db_entry_ = new_entry_number;
+    }
   }
 
   // Temporary storage for this function's return value
   BeamStatus beam_status;
 
-  // Retrieve the beam monitoring measurements for the current event, and
-  // calculate a POT value
+  // Retrieve the beam monitoring measurements for the current event
   try {
 
     // Retrieve a measurement for each of the monitoring devices included
     // in the bundle from the Intensity Frontier beam database
-    for (const auto& device_pair : beam_data) {
+    for (const auto& device_pair : beam_data_) {
 
       const std::string& device_name = device_pair.first;
 
@@ -346,6 +387,93 @@ BeamStatus BeamChecker::get_beam_status(uint64_t ns_since_epoch,
         }
       }
     }
+  }
+
+  catch (const std::exception& e) {
+    Log("WARNING: problem encountered while querying IF beam"
+      " database: " + std::string( e.what() ), 0, verbosity_);
+
+    return BeamStatus( TimeClass(ns_since_epoch), 0., BeamCondition::Missing );
+  }
+
+  return evaluate_beam_status(beam_status, ns_since_epoch);
+}
+
+std::vector<BeamStatus> BeamChecker::get_beam_statuses(
+  const std::vector<uint64_t>& ns_since_epoch,
+  const std::vector<MinibufferLabel>& mb_labels)
+{
+  std::vector<BeamStatus> beam_statuses;
+
+  if ( !columnar_db_ ) {
+    for (size_t mb = 0; mb < ns_since_epoch.size(); ++mb) {
+      beam_statuses.push_back( get_beam_status(ns_since_epoch.at(mb),
+        mb_labels.at(mb)) );
+    }
+    return beam_statuses;
+  }
+
+  // Only beam minibuffers are looked up (see get_beam_status). Sort them
+  // by time for the merge pass over the beam database.
+  std::vector<size_t> beam_mbs;
+  for (size_t mb = 0; mb < ns_since_epoch.size(); ++mb) {
+    beam_statuses.push_back( BeamStatus(TimeClass( ns_since_epoch.at(mb) ),
+      0., BeamCondition::NonBeamMinibuffer) );
+    if ( mb_labels.at(mb) == MinibufferLabel::Beam ) beam_mbs.push_back(mb);
+  }
+
+  std::stable_sort(beam_mbs.begin(), beam_mbs.end(),
+    [&ns_since_epoch](size_t a, size_t b) -> bool {
+      return ns_since_epoch[a] < ns_since_epoch[b];
+    }
+  );
+
+  // The beam database uses timestamps with ms precision
+  std::vector<uint64_t> ms_since_epoch;
+  for (size_t mb : beam_mbs) {
+    ms_since_epoch.push_back( ns_since_epoch[mb] / MILLION );
+  }
+
+  std::vector<int> chunks;
+  std::vector<std::vector<BeamDBMeasurement> > measurements;
+  beam_db_file_.Lookup(ms_since_epoch, chunks, measurements);
+
+  for (size_t i = 0; i < beam_mbs.size(); ++i) {
+
+    size_t mb = beam_mbs[i];
+
+    Log("Finding beam status information for "
+      + make_time_string(ms_since_epoch[i]), 2, verbosity_);
+
+    if ( chunks[i] < 0 ) {
+      Log("WARNING: unable to find a suitable entry for "
+        + make_time_string(ms_since_epoch[i]) + " ("
+        + std::to_string(ms_since_epoch[i])
+        + " ms since the Unix epoch) in the beam database file", 0,
+        verbosity_);
+      beam_statuses[mb] = BeamStatus( TimeClass(ns_since_epoch[mb]), 0.,
+        BeamCondition::Missing );
+      continue;
+    }
+
+    BeamStatus beam_status;
+    for (const auto& measurement : measurements[i]) {
+      beam_status.add_measurement(beam_db_file_.device_name(measurement.device),
+        measurement.ms_since_epoch, BeamDataPoint(measurement.value,
+        beam_db_file_.device_unit(measurement.device)));
+    }
+
+    beam_statuses[mb] = evaluate_beam_status(beam_status, ns_since_epoch[mb]);
+  }
+
+  return beam_statuses;
+}
+
+BeamStatus BeamChecker::evaluate_beam_status(BeamStatus& beam_status,
+  uint64_t ns_since_epoch)
+{
+  // Calculate a POT value from the retrieved measurements
+  try {
 
     if ( verbosity_ >= 4 ) {
       Log("Beam monitoring measurements", 4, verbosity_);
@@ -361,16 +489,16 @@ BeamStatus BeamChecker::get_beam_status(uint64_t ns_since_epoch,
 
     // We're catching exceptions, so if one of the required devices doesn't
     // exist, things will be handled properly.
-    const auto& first_toroid_pair = beam_status.data().at(first_toroid);
+    const auto& first_toroid_pair = beam_status.data().at(first_toroid_);
     double pot_first_toroid = first_toroid_pair.second.value;
     int64_t ms_since_epoch_first_toroid = first_toroid_pair.first;
 
-    const auto& second_toroid_pair = beam_status.data().at(second_toroid);
+    const auto& second_toroid_pair = beam_status.data().at(second_toroid_);
     double pot_second_toroid = second_toroid_pair.second.value;
     int64_t ms_since_epoch_second_toroid = second_toroid_pair.first;
 
     // Get the horn current measurement
-    const auto& horn_pair = beam_status.data().at(horn_current_device);
+    const auto& horn_pair = beam_status.data().at(horn_current_device_);
     double peak_horn_current = horn_pair.second.value; // kA
     int64_t ms_since_epoch_horn = horn_pair.first;
 
@@ -381,56 +509,39 @@ BeamStatus BeamChecker::get_beam_status(uint64_t ns_since_epoch,
 
     // Wait to set the beam condition until we've applied quality cuts
 
-    // Get beam quality cut parameters
-    double pot_min = BOGUS_DOUBLE;
-    double pot_max = BOGUS_DOUBLE;
-    m_variables.Get("CutPOTMax", pot_max);
-    m_variables.Get("CutPOTMin", pot_min);
-
-    double horn_current_min = BOGUS_DOUBLE;
-    double horn_current_max = BOGUS_DOUBLE;
-    m_variables.Get("CutPeakHornCurrentMax", horn_current_max);
-    m_variables.Get("CutPeakHornCurrentMin", horn_current_min);
-
-    double toroid_tol = BOGUS_DOUBLE;
-    m_variables.Get("CutToroidAgreement", toroid_tol);
-
-    int64_t t_tol = BOGUS_INT;
-    m_variables.Get("CutTimestampAgreement", t_tol);
-
     // TODO: add beam targeting efficiency cut
 
     BeamCondition bc = BeamCondition::Ok;
 
     // POT cut
-    beam_status.add_cut("POT in range", (beam_status.pot() >= pot_min)
-      && (beam_status.pot() <= pot_max));
+    beam_status.add_cut("POT in range", (beam_status.pot() >= pot_min_)
+      && (beam_status.pot() <= pot_max_));
 
     // Peak horn current cut
     beam_status.add_cut("peak horn current in range",
-      (peak_horn_current >= horn_current_min)
-      && (peak_horn_current <= horn_current_max));
+      (peak_horn_current >= horn_current_min_)
+      && (peak_horn_current <= horn_current_max_));
 
     // Toroid disagreement cut
     double tor_diff_frac = 2.*std::abs( pot_second_toroid - pot_first_toroid )
       / ( pot_second_toroid + pot_first_toroid );
-    beam_status.add_cut("toroids agree", tor_diff_frac <= toroid_tol);
+    beam_status.add_cut("toroids agree", tor_diff_frac <= toroid_tol_);
 
     // Timestamp cut. Make sure measurements within the timing tolerance
     // were available for all required devices
     int64_t ms_since_epoch = static_cast<int64_t>( ns_since_epoch / MILLION );
     beam_status.add_cut("timestamps agree",
-      ( std::abs(ms_since_epoch_horn - ms_since_epoch) <= t_tol )
-      &&  ( std::abs(ms_since_epoch_first_toroid - ms_since_epoch) <= t_tol )
-      &&  ( std::abs(ms_since_epoch_second_toroid - ms_since_epoch) <= t_tol ));
+      ( std::abs(ms_since_epoch_horn - ms_since_epoch) <= t_tol_ )
+      &&  ( std::abs(ms_since_epoch_first_toroid - ms_since_epoch) <= t_tol_ )
+      &&  ( std::abs(ms_since_epoch_second_toroid - ms_since_epoch) <= t_tol_ ));
 
     Log("ANNIE DAQ ms since epoch = " + std::to_string(ms_since_epoch), 4,
       verbosity_);
-    Log(horn_current_device + " ms since epoch = "
+    Log(horn_current_device_ + " ms since epoch = "
       + std::to_string(ms_since_epoch_horn), 4, verbosity_);
-    Log(first_toroid + " ms since epoch = "
+    Log(first_toroid_ + " ms since epoch = "
       + std::to_string(ms_since_epoch_first_toroid), 4, verbosity_);
-    Log(second_toroid + " ms since epoch = "
+    Log(second_toroid_ + " ms since epoch = "
       + std::to_string(ms_since_epoch_second_toroid), 4, verbosity_);
 
     // Flag the beam spill as "bad" if it failed any of the cuts above
@@ -8,9 +8,11 @@
 #define BEAMCHECKER_H
 
 // standard library includes
+#include <chrono>
 #include <map>
 #include <memory>
 #include <string>
+#include <vector>
 
 // ToolAnalysis includes
 #include "BeamStatus.h"
@@ -18,6 +20,7 @@
 #include "MinibufferLabel.h"
 #include "ANNIEconstants.h"
 #include "BeamDataPoint.h"
+#include "BeamDBFile.h"
 #include "BeamStatus.h"
 #include "HeftyInfo.h"
 #include "TimeClass.h"
@@ -44,6 +47,21 @@ class BeamChecker: public Tool {
     BeamStatus get_beam_status(uint64_t ns_since_epoch,
       MinibufferLabel mb_label);
 
+    /// @brief Get the beam status for every minibuffer of an event
+    /// @details With a columnar beam database file, all beam minibuffers
+    /// are resolved in a single BeamDBFile::Lookup call
+    std::vector<BeamStatus> get_beam_statuses(
+      const std::vector<uint64_t>& ns_since_epoch,
+      const std::vector<MinibufferLabel>& mb_labels);
+
+    /// @brief Compute the POT value and apply the beam quality cuts to a
+    /// BeamStatus that has been filled with device measurements
+    BeamStatus evaluate_beam_status(BeamStatus& beam_status,
+      uint64_t ns_since_epoch);
+
+    /// @brief Read the device names and cut values from the configuration
+    void load_cut_settings();
+
     /// @brief Transient BoostStore used to read previously-saved information
     /// from the beam database
     BoostStore beam_db_store_;
@@ -56,6 +74,38 @@ class BeamChecker: public Tool {
     std::map<int, std::pair<uint64_t, uint64_t> >
       beam_db_index_;
 
+    /// @brief Memory-mapped columnar beam database, used instead of the
+    /// BoostStore when BeamDBFile points to a file written with the
+    /// BeamFetcher's Columnar output format
+    BeamDBFile beam_db_file_;
+    bool columnar_db_ = false;
+
+    /// @brief Device measurements from the currently loaded BoostStore
+    /// entry, and from the entry loaded before it. Keeping the previous
+    /// entry avoids reloading both repeatedly for minibuffers that
+    /// alternate between two overlapping entries.
+    std::map<std::string, std::map<uint64_t, BeamDataPoint> > beam_data_;
+    std::map<std::string, std::map<uint64_t, BeamDataPoint> >
+      previous_beam_data_;
+    int current_beam_db_entry_ = -1;
+    int previous_beam_db_entry_ = -1;
+
+    /// @brief Device names and cut values used for the beam quality checks
+    /// (see the README for their meaning)
+    std::string first_toroid_;
+    std::string second_toroid_;
+    std::string horn_current_device_;
+    double pot_min_;
+    double pot_max_;
+    double horn_current_min_;
+    double horn_current_max_;
+    double toroid_tol_;
+    int64_t t_tol_;
+
+    /// @brief Time spent looking up beam statuses, reported in Finalise
+    double lookup_time_ms_ = 0.;
+    long num_lookups_ = 0;
+
     /// @brief The verbosity to use when printing logging messages
     /// @details A larger value corresponds to more verbose output
     int verbosity_;
@@ -5,6 +5,7 @@
 // ToolAnalysis includes
 #include "BeamFetcher.h"
 #include "IFBeamDBInterface.h"
+#include "BeamDBFile.h"
 
 namespace {
   constexpr uint64_t TWO_HOURS = 7200000ull; // ms
@@ -43,12 +44,27 @@ bool BeamFetcher::Initialise(std::string config_filename, DataModel& data)
   }
   dummy_in_file.close();
 
+  output_format_ = "BoostStore";
+  m_variables.Get("OutputFormat", output_format_);
+
+  if ( output_format_ != "BoostStore" && output_format_ != "Columnar" ) {
+    Log("Error: Unknown OutputFormat \"" + output_format_ + "\" in the"
+      " configuration for the BeamFetcher tool", 0, verbosity_);
+    return false;
+  }
 
   return true;
 }
 
 bool BeamFetcher::Execute() {
 
+  // Convert a previously downloaded beam database instead of querying the
+  // IF beam database again
+  std::string input_filename;
+  if ( m_variables.Get("ConvertBeamDBFile", input_filename) ) {
+    return convert_beam_db(input_filename);
+  }
+
   uint64_t start_ms_since_epoch;
   bool got_start_ms = m_variables.Get("StartMillisecondsSinceEpoch",
     start_ms_since_epoch);
@@ -116,6 +132,14 @@ bool BeamFetcher::fetch_beam_data(uint64_t start_ms_since_epoch,
 
   int current_entry = 0;
 
+  bool columnar = ( output_format_ == "Columnar" );
+  BeamDBFileWriter db_writer;
+  if ( columnar && !db_writer.Open(db_filename_) ) {
+    Log("Error: Could not open the BeamFetcher output file \"" + db_filename_
+      + '\"', 0, verbosity_);
+    return false;
+  }
+
   while (current_time >= start_ms_since_epoch) {
 
     if (current_entry > 0) current_time -= chunk_step_ms;
@@ -146,13 +170,34 @@ bool BeamFetcher::fetch_beam_data(uint64_t start_ms_since_epoch,
     beam_db_index[current_entry] = std::pair<uint64_t,
       uint64_t>(start_ms, end_ms);
 
-    beam_db_store_.Set("BeamDB", beam_data);
-    beam_db_store_.Save(db_filename_);
-    beam_db_store_.Delete();
+    if (columnar) {
+      if ( !db_writer.AddChunk(beam_data, start_ms, end_ms) ) {
+        Log("Error: Failed to write beam database entry "
+          + std::to_string(current_entry) + " to the BeamFetcher output file \""
+          + db_filename_ + '\"', 0, verbosity_);
+        return false;
+      }
+    }
+    else {
+      beam_db_store_.Set("BeamDB", beam_data);
+      beam_db_store_.Save(db_filename_);
+      beam_db_store_.Delete();
+    }
 
     ++current_entry;
   }
 
+  // The columnar format keeps its own interval index
+  if (columnar) {
+    if ( !db_writer.Close() ) {
+      Log("Error: Failed to write the BeamFetcher output file \""
+        + db_filename_ + '\"', 0, verbosity_);
+      return false;
+    }
+    Log("Retrieval of beam status data complete.", 1, verbosity_);
+    return true;
+  }
+
   beam_db_store_.Header->Set("BeamDBIndex", beam_db_index);
 
   // Find the range of times covered by the entire downloaded database
@@ -176,3 +221,57 @@ bool BeamFetcher::fetch_beam_data(uint64_t start_ms_since_epoch,
 
   return true;
 }
+
+bool BeamFetcher::convert_beam_db(const std::string& input_filename)
+{
+  std::ifstream dummy_in_file(input_filename);
+  if ( !dummy_in_file.good() ) {
+    Log("Error: Could not open the beam database file \"" + input_filename
+     + '\"', 0, verbosity_);
+    return false;
+  }
+  dummy_in_file.close();
+
+  BoostStore input_store(false, BOOST_STORE_MULTIEVENT_FORMAT);
+  input_store.Initialise(input_filename);
+
+  std::map<int, std::pair<uint64_t, uint64_t> > beam_db_index;
+  if ( !input_store.Header->Get("BeamDBIndex", beam_db_index) ) {
+    Log("Error: Could not find the BeamDBIndex entry in the beam database"
+      " BoostStore header stored in the file \"" + input_filename + '\"', 0,
+      verbosity_);
+    return false;
+  }
+
+  BeamDBFileWriter db_writer;
+  if ( !db_writer.Open(db_filename_) ) {
+    Log("Error: Could not open the BeamFetcher output file \"" + db_filename_
+      + '\"', 0, verbosity_);
+    return false;
+  }
+
+  std::map<std::string, std::map<uint64_t, BeamDataPoint> > beam_data;
+  for (const auto& pair : beam_db_index) {
+    beam_data.clear();
+    input_store.GetEntry(pair.first);
+    input_store.Get("BeamDB", beam_data);
+    if ( !db_writer.AddChunk(beam_data, pair.second.first,
+      pair.second.second) ) {
+      Log("Error: Failed to write beam database entry "
+        + std::to_string(pair.first) + " to the BeamFetcher output file \""
+        + db_filename_ + '\"', 0, verbosity_);
+      return false;
+    }
+  }
+
+  if ( !db_writer.Close() ) {
+    Log("Error: Failed to write the BeamFetcher output file \""
+      + db_filename_ + '\"', 0, verbosity_);
+    return false;
+  }
+
+  Log("Converted " + std::to_string(beam_db_index.size()) + " beam database"
+    " entries from " + input_filename + " to " + db_filename_, 1, verbosity_);
+
+  return true;
+}
@@ -36,7 +36,15 @@ class BeamFetcher: public Tool {
     bool fetch_beam_data(uint64_t start_ms_since_epoch,
       uint64_t end_ms_since_epoch, uint64_t chunk_step_ms);
 
+    /// @brief Helper function that copies the entries of a beam database
+    /// BoostStore file into a columnar beam database file
+    bool convert_beam_db(const std::string& input_filename);
+
     /// @brief Name of the output file in which the beam database information
     /// will be saved
     std::string db_filename_;
+
+    /// @brief Format of the output file: "BoostStore" (default) or
+    /// "Columnar" (a BeamDBFile that the BeamChecker can memory-map)
+    std::string output_format_;
 };
@@ -18,10 +18,18 @@ bool CNNImage::Initialise(std::string configfile, DataModel &data){
   m_variables.Get("Dimension",dimension);
   m_variables.Get("OutputFile",cnn_outpath);
   m_variables.Get("DetectorConf",detector_config);
+  output_format = "CSV";
+  chunk_events = 100;
+  m_variables.Get("OutputFormat",output_format);
+  m_variables.Get("ChunkEvents",chunk_events);
 
 
   if (mode != "Charge" && mode != "Time") mode = "Charge";
   if (verbosity > 2) std::cout <<"Mode: "<<mode<<std::endl;
+  if (output_format != "CSV" && output_format != "Binary" && output_format != "Both") output_format = "CSV";
+  write_csv = (output_format != "Binary");
+  write_binary = (output_format != "CSV");
+  if (verbosity > 2) std::cout <<"OutputFormat: "<<output_format<<std::endl;
 
   //get geometry		
 
@@ -65,15 +73,30 @@ bool CNNImage::Initialise(std::string configfile, DataModel &data){
 	  
   }
 
+  BuildPixelMap();
+
   //define root and csv files to save histograms (root-files temporarily, for cross-checks)
 
   std::string str_root = ".root";
   std::string str_csv = ".csv";
+  std::string str_npy = ".npy";
   std::string rootfile_name = cnn_outpath + str_root;
   std::string csvfile_name = cnn_outpath + str_csv;
+  std::string npyfile_name = cnn_outpath + str_npy;
+
+  if (write_csv){
+    file = new TFile(rootfile_name.c_str(),"RECREATE");
+    outfile.open(csvfile_name.c_str());
+  }
 
-  file = new TFile(rootfile_name.c_str(),"RECREATE");
-  outfile.open(csvfile_name.c_str());
+  //binary tensor file: shape (events, 2, dimension, dimension), channel 0 = charge, channel 1 = time
+  if (write_binary){
+    image.assign(2*dimension*dimension,0.);
+    if (!tensor_writer.Open(npyfile_name,{2,dimension,dimension},chunk_events)){
+      std::cout <<"CNNImage tool: Could not open tensor file "<<npyfile_name<<std::endl;
+      return false;
+    }
+  }
 
   return true;
 }
@@ -148,7 +171,7 @@ bool CNNImage::Execute(){
   int vectsize = MCHits->size();
   if (verbosity > 1) std::cout <<"Tool CNNImage: MCHits size: "<<vectsize<<std::endl; 
   total_hits_pmts=0;
-  for(std::pair<unsigned long, std::vector<MCHit>>&& apair : *MCHits){
+  for(std::pair<const unsigned long, std::vector<MCHit>>& apair : *MCHits){
     unsigned long chankey = apair.first;
     if (verbosity > 3) std::cout <<"chankey: "<<chankey<<std::endl;
     Detector* thistube = geom->ChannelToDetector(chankey);
@@ -191,6 +214,85 @@ bool CNNImage::Execute(){
   //-------------- Create CNN images ------------------------------
   //---------------------------------------------------------------
 	
+  if (maximum_pmts < 0.001) maximum_pmts = 1.;
+  if (fabs(max_time_pmts) < 0.001) max_time_pmts = 1.;
+
+  //save the image of selected events
+  //(1 line / 1 tensor entry corresponds to 1 event)
+
+  if (bool_primary && bool_geometry && bool_nhits) {
+    n_images++;
+    if (write_csv) WriteCSVImage();
+    if (write_binary) WriteBinaryImage();
+  }
+
+  return true;
+}
+
+
+bool CNNImage::Finalise(){
+  
+  if (verbosity >=2 ) std::cout <<"Finalising tool: CNNImage..."<<std::endl;
+  if (write_csv){
+    csv_bytes = outfile.tellp();
+    file->Close();
+    outfile.close();
+  }
+  if (write_binary) tensor_writer.Close();
+
+  if (verbosity >= 1 && n_images > 0){
+    std::cout <<"CNNImage tool: wrote "<<n_images<<" images"<<std::endl;
+    if (write_csv && csv_time > 0.) std::cout <<"  csv:    "<<n_images/(csv_time/1000.)<<" images/s, "<<csv_bytes/n_images<<" bytes/image"<<std::endl;
+    if (write_binary && binary_time > 0.) std::cout <<"  binary: "<<n_images/(binary_time/1000.)<<" images/s, "<<tensor_writer.GetItemSize()*sizeof(float)<<" bytes/image"<<std::endl;
+  }
+
+  return true;
+}
+
+
+void CNNImage::BuildPixelMap(){
+
+  //the bin of each side PMT only depends on the geometry: find it once instead of every event
+
+  TAxis xaxis(dimension,0.5-TMath::Pi()*size_top_drawing,0.5+TMath::Pi()*size_top_drawing);
+  TAxis yaxis(dimension,0.5+min_y/tank_radius*size_top_drawing, 0.5+max_y/tank_radius*size_top_drawing);
+
+  pmt_binx.assign(n_tank_pmts,-1);
+  pmt_biny.assign(n_tank_pmts,-1);
+  pmt_pixel.assign(n_tank_pmts,-1);
+
+  for (int i_pmt=0;i_pmt<n_tank_pmts;i_pmt++){
+    unsigned long detkey = pmt_detkeys[i_pmt];
+    double x,y;
+    if ((fabs(y_pmt[detkey]-max_y)<0.01) || fabs(y_pmt[detkey]-min_y)<0.01 || fabs(y_pmt[detkey]+1.30912)<0.01) continue; //top/bottom PMTs
+    double phi;
+    if (x_pmt[detkey]>0 && z_pmt[detkey]>0) phi = atan(z_pmt[detkey]/x_pmt[detkey])+TMath::Pi()/2;
+    else if (x_pmt[detkey]>0 && z_pmt[detkey]<0) phi = atan(x_pmt[detkey]/-z_pmt[detkey]);
+    else if (x_pmt[detkey]<0 && z_pmt[detkey]<0) phi = 3*TMath::Pi()/2+atan(z_pmt[detkey]/x_pmt[detkey]);
+    else if (x_pmt[detkey]<0 && z_pmt[detkey]>0) phi = TMath::Pi()+atan(-x_pmt[detkey]/z_pmt[detkey]);
+    else phi = 0.;
+    if (phi>2*TMath::Pi()) phi-=(2*TMath::Pi());
+    phi-=TMath::Pi();
+    if (phi < - TMath::Pi()) phi = -TMath::Pi();
+    if (phi<-TMath::Pi() || phi>TMath::Pi())  std::cout <<"Drawing Event: Phi out of bounds! "<<", x= "<<x_pmt[detkey]<<", y="<<y_pmt[detkey]<<", z="<<z_pmt[detkey]<<std::endl;
+    x=0.5+phi*size_top_drawing;
+    y=0.5+y_pmt[detkey]/tank_height*tank_height/tank_radius*size_top_drawing;
+    pmt_binx[i_pmt] = xaxis.FindBin(x);
+    pmt_biny[i_pmt] = yaxis.FindBin(y);
+    //under- and overflow bins are not part of the image
+    if (pmt_binx[i_pmt]>=1 && pmt_binx[i_pmt]<=dimension && pmt_biny[i_pmt]>=1 && pmt_biny[i_pmt]<=dimension){
+      pmt_pixel[i_pmt] = (pmt_biny[i_pmt]-1)*dimension + (pmt_binx[i_pmt]-1);
+    }
+    if (verbosity > 2) std::cout <<"detkey "<<detkey<<": binx: "<<pmt_binx[i_pmt]<<", biny: "<<pmt_biny[i_pmt]<<std::endl;
+  }
+
+}
+
+
+void CNNImage::WriteCSVImage(){
+
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
   //define histogram as an intermediate step to the CNN
   std::stringstream ss_cnn, ss_title_cnn;
   ss_cnn<<"hist_cnn"<<evnum;
@@ -200,64 +302,56 @@ bool CNNImage::Execute(){
   //fill the events into the histogram
 
   for (int i_pmt=0;i_pmt<n_tank_pmts;i_pmt++){
+    if (pmt_binx[i_pmt] < 0) continue; //top/bottom PMTs
     unsigned long detkey = pmt_detkeys[i_pmt];
-    double x,y;
-    if ((fabs(y_pmt[detkey]-max_y)<0.01) || fabs(y_pmt[detkey]-min_y)<0.01 || fabs(y_pmt[detkey]+1.30912)<0.01) continue; //top/bottom PMTs
-    else {
-      double phi;
-      if (x_pmt[detkey]>0 && z_pmt[detkey]>0) phi = atan(z_pmt[detkey]/x_pmt[detkey])+TMath::Pi()/2;
-      else if (x_pmt[detkey]>0 && z_pmt[detkey]<0) phi = atan(x_pmt[detkey]/-z_pmt[detkey]);
-      else if (x_pmt[detkey]<0 && z_pmt[detkey]<0) phi = 3*TMath::Pi()/2+atan(z_pmt[detkey]/x_pmt[detkey]);
-      else if (x_pmt[detkey]<0 && z_pmt[detkey]>0) phi = TMath::Pi()+atan(-x_pmt[detkey]/z_pmt[detkey]);
-      else phi = 0.;
-      if (phi>2*TMath::Pi()) phi-=(2*TMath::Pi());
-      phi-=TMath::Pi();
-      if (phi < - TMath::Pi()) phi = -TMath::Pi();
-      if (phi<-TMath::Pi() || phi>TMath::Pi())  std::cout <<"Drawing Event: Phi out of bounds! "<<", x= "<<x_pmt[detkey]<<", y="<<y_pmt[detkey]<<", z="<<z_pmt[detkey]<<std::endl;
-      x=0.5+phi*size_top_drawing;
-      y=0.5+y_pmt[detkey]/tank_height*tank_height/tank_radius*size_top_drawing;
-      int binx = hist_cnn->GetXaxis()->FindBin(x);
-      int biny = hist_cnn->GetYaxis()->FindBin(y);
-      if (verbosity > 2) std::cout <<"binx: "<<binx<<", biny: "<<biny<<", charge fill: "<<charge[detkey]<<", time fill: "<<time[detkey]<<std::endl;
-
-      if (maximum_pmts < 0.001) maximum_pmts = 1.;
-      if (fabs(max_time_pmts) < 0.001) max_time_pmts = 1.;
-
-      if (mode == "Charge"){
-        double charge_fill = charge[detkey]/maximum_pmts;
-	hist_cnn->SetBinContent(binx,biny,hist_cnn->GetBinContent(binx,biny)+charge_fill);
-      }
-      if (mode == "Time"){
-	double time_fill = time[detkey]/max_time_pmts;
-	hist_cnn->SetBinContent(binx,biny,hist_cnn->GetBinContent(binx,biny)+time_fill);
-      }
+    int binx = pmt_binx[i_pmt];
+    int biny = pmt_biny[i_pmt];
+    if (verbosity > 2) std::cout <<"binx: "<<binx<<", biny: "<<biny<<", charge fill: "<<charge[detkey]<<", time fill: "<<time[detkey]<<std::endl;
+
+    if (mode == "Charge"){
+      double charge_fill = charge[detkey]/maximum_pmts;
+      hist_cnn->SetBinContent(binx,biny,hist_cnn->GetBinContent(binx,biny)+charge_fill);
+    }
+    if (mode == "Time"){
+      double time_fill = time[detkey]/max_time_pmts;
+      hist_cnn->SetBinContent(binx,biny,hist_cnn->GetBinContent(binx,biny)+time_fill);
     }
   }
 
   //save information from histogram to csv file
-  //(1 line corresponds to 1 event, histogram entries flattened out to a 1D array)
+  //(histogram entries flattened out to a 1D array)
 
-  if (bool_primary && bool_geometry && bool_nhits) {
-
-    hist_cnn->Write();
-    for (int i_binY=0; i_binY < hist_cnn->GetNbinsY();i_binY++){
-      for (int i_binX=0; i_binX < hist_cnn->GetNbinsX();i_binX++){
-        outfile << hist_cnn->GetBinContent(i_binX+1,i_binY+1);
-        if (i_binX != hist_cnn->GetNbinsX()-1 || i_binY!=hist_cnn->GetNbinsY()-1) outfile<<",";
-      }
+  hist_cnn->Write();
+  for (int i_binY=0; i_binY < hist_cnn->GetNbinsY();i_binY++){
+    for (int i_binX=0; i_binX < hist_cnn->GetNbinsX();i_binX++){
+      outfile << hist_cnn->GetBinContent(i_binX+1,i_binY+1);
+      if (i_binX != hist_cnn->GetNbinsX()-1 || i_binY!=hist_cnn->GetNbinsY()-1) outfile<<",";
     }
-    outfile << std::endl;
   }
+  outfile << std::endl;
+  delete hist_cnn;
+
+  csv_time += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now()-start).count();
 
-  return true;
 }
 
 
-bool CNNImage::Finalise(){
-  
-  if (verbosity >=2 ) std::cout <<"Finalising tool: CNNImage..."<<std::endl;
-  file->Close();
-  outfile.close();
+void CNNImage::WriteBinaryImage(){
+
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+  //same pixels and normalisation as the csv images, charge and time channel in one entry
+  int n_pixels = dimension*dimension;
+  std::fill(image.begin(),image.end(),0.);
+  for (int i_pmt=0;i_pmt<n_tank_pmts;i_pmt++){
+    int pixel = pmt_pixel[i_pmt];
+    if (pixel < 0) continue;
+    unsigned long detkey = pmt_detkeys[i_pmt];
+    image[pixel] += charge[detkey]/maximum_pmts;
+    image[n_pixels+pixel] += time[detkey]/max_time_pmts;
+  }
+  tensor_writer.Append(image.data());
+
+  binary_time += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now()-start).count();
 
-  return true;
 }
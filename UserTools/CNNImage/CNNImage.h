@@ -4,18 +4,22 @@
 
 #include <string>
 #include <fstream>
+#include <chrono>
 
 #include "TH2F.h"
+#include "TAxis.h"
 #include "TMath.h"
 #include "TFile.h"
 
 #include "Tool.h"
+#include "NpyTensorWriter.h"
 
 
 /**
  * \class CNNImage
  *
  * The tool CNNImage is supposed to create custom csv input files for CNN classification processes. The framework relies on the EventDisplay tool and basically feeds that geometric information of the hit pattern into a matrix format
+* With OutputFormat Binary the images (charge and time channel) are instead appended to a .npy tensor file that can be memory-mapped from python
 *
 * $Author: M.Nieslony $
 * $Date: 2019/08/09 10:44:00 $
@@ -33,6 +37,9 @@ class CNNImage: public Tool {
   bool Finalise(); ///< Finalise function used to clean up resources.
 
   void draw_cnn_image(); ///< Fill the hit pattern information in a TH2
+  void BuildPixelMap(); ///< Precompute the image bins of all tank PMTs
+  void WriteCSVImage(); ///< Fill the TH2 for the configured mode and write it as a csv row
+  void WriteBinaryImage(); ///< Fill the charge and time channels and append them to the tensor file
 
  private:
 
@@ -40,6 +47,10 @@ class CNNImage: public Tool {
   std::string detector_config;
   int verbosity;
   std::string mode;     //Charge, Time
+  std::string output_format;    //CSV, Binary, Both
+  bool write_csv;
+  bool write_binary;
+  int chunk_events;     //number of images written to the tensor file at once
   int dimension;        //dimension of the CNN image (e.g. 32, 64)
   int runnumber;
   int subrunnumber;
@@ -82,6 +93,16 @@ class CNNImage: public Tool {
   std::vector<unsigned long> pmt_detkeys;
   std::vector<unsigned long> hitpmt_detkeys;
 
+  std::vector<int> pmt_binx, pmt_biny;   //histogram bins of each entry in pmt_detkeys, -1 for top/bottom PMTs
+  std::vector<int> pmt_pixel;            //flattened pixel (biny-1)*dimension+(binx-1), -1 if not drawn
+  std::vector<float> image;              //binary image buffer, [channel][y][x]
+  NpyTensorWriter tensor_writer;
+
+  int n_images = 0;
+  double csv_time = 0.;    //time spent filling and writing csv images, in ms
+  double binary_time = 0.;
+  long csv_bytes = 0;
+
 };
 
 
@@ -0,0 +1,75 @@
+#include "NpyTensorWriter.h"
+
+#include <cstring>
+#include <sstream>
+#include <stdint.h>
+
+bool NpyTensorWriter::Open(std::string filename, std::vector<int> item_shape, int chunk_items_in){
+
+  Close();
+  shape = item_shape;
+  item_size = 1;
+  for (int dim : shape) item_size *= dim;
+  chunk_items = (chunk_items_in > 0) ? chunk_items_in : 1;
+  chunk.assign(chunk_items*item_size, 0.);
+  chunk_fill = 0;
+  nitems = 0;
+
+  file.open(filename.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+  if (!file.is_open()) return false;
+  WriteHeader();
+  return file.good();
+}
+
+void NpyTensorWriter::Append(const float* item){
+
+  if (!file.is_open()) return;
+  std::memcpy(&chunk[chunk_fill*item_size], item, item_size*sizeof(float));
+  chunk_fill++;
+  nitems++;
+  if (chunk_fill == chunk_items) FlushChunk();
+}
+
+bool NpyTensorWriter::Close(){
+
+  if (!file.is_open()) return true;
+  FlushChunk();
+  file.seekp(0);
+  WriteHeader();
+  bool ok = file.good();
+  file.close();
+  return ok;
+}
+
+void NpyTensorWriter::FlushChunk(){
+
+  if (chunk_fill > 0) file.write(reinterpret_cast<const char*>(chunk.data()), chunk_fill*item_size*sizeof(float));
+  chunk_fill = 0;
+}
+
+void NpyTensorWriter::WriteHeader(){
+
+  // .npy version 1.0: "\x93NUMPY", 1, 0, little-endian uint16 header length, then
+  // a python dict literal padded with spaces and ended with '\n', so that the
+  // data start at a multiple of 64 bytes
+  uint16_t one = 1;
+  bool little_endian = (*reinterpret_cast<char*>(&one) == 1);
+
+  std::stringstream ss_dict;
+  ss_dict << "{'descr': '" << (little_endian ? "<" : ">") << "f4', 'fortran_order': False, 'shape': (" << nitems << ",";
+  for (size_t i_dim = 0; i_dim < shape.size(); i_dim++) {
+    ss_dict << " " << shape[i_dim];
+    if (i_dim + 1 < shape.size()) ss_dict << ",";
+  }
+  ss_dict << "), }";
+  std::string dict = ss_dict.str();
+  const int preamble = 10;
+  dict.resize(header_size - preamble - 1, ' ');
+  dict += '\n';
+
+  uint16_t dict_len = dict.size();
+  char magic[preamble] = {'\x93', 'N', 'U', 'M', 'P', 'Y', 1, 0,
+                          static_cast<char>(dict_len & 0xff), static_cast<char>(dict_len >> 8)};
+  file.write(magic, preamble);
+  file.write(dict.data(), dict.size());
+}
@@ -0,0 +1,50 @@
+#ifndef NPYTENSORWRITER_H
+#define NPYTENSORWRITER_H
+
+#include <string>
+#include <vector>
+#include <fstream>
+
+/**
+ * \class NpyTensorWriter
+ *
+ * Appends fixed-shape float32 items (e.g. one CNN image per event) to a file in
+ * the numpy .npy format, so that python can open the whole data set with
+ * numpy.load(filename, mmap_mode='r'). The file has shape (nitems, item_shape...).
+ *
+ * Items are collected in memory and written in chunks of chunk_items. The header
+ * is written with a fixed size when the file is opened and rewritten with the
+ * final number of items on Close(); a file that was not closed reports 0 items.
+ * Data are written in the byte order of the host ('<f4' on x86).
+*/
+class NpyTensorWriter {
+
+ public:
+  NpyTensorWriter(){}
+  ~NpyTensorWriter(){ Close(); }
+
+  bool Open(std::string filename, std::vector<int> item_shape, int chunk_items=100);
+  void Append(const float* item);       // copies item_size floats
+  bool Close();
+
+  bool IsOpen() const { return file.is_open(); }
+  long GetNItems() const { return nitems; }
+  long GetItemSize() const { return item_size; }
+  long GetBytesWritten() const { return header_size + nitems*item_size*sizeof(float); }
+
+ private:
+  void WriteHeader();
+  void FlushChunk();
+
+  std::ofstream file;
+  std::vector<int> shape;
+  std::vector<float> chunk;
+  long item_size = 0;
+  long nitems = 0;
+  int chunk_items = 100;
+  int chunk_fill = 0;
+
+  static const int header_size = 256;   // magic + version + header length + header dict
+};
+
+#endif
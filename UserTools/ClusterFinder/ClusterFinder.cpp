@@ -27,6 +27,12 @@ bool ClusterFinder::Initialise(std::string configfile, DataModel &data){
   m_variables.Get("Plots2D",draw_2D);
   m_variables.Get("verbosity",verbose);
   m_variables.Get("end_of_window_time_cut",end_of_window_time_cut);
+  m_variables.Get("ClusteringMode",ClusteringMode);
+  m_variables.Get("BenchmarkClustering",benchmark_clustering);
+  if (ClusteringMode != "SlidingWindow" && ClusteringMode != "Legacy"){
+    Log("ClusterFinder: Unknown ClusteringMode "+ClusteringMode+", using SlidingWindow",v_warning,verbose);
+    ClusteringMode = "SlidingWindow";
+  }
 
   //----------------------------------------------------------------------------
   //---------------Get basic geometry properties -------------------------------
@@ -150,12 +156,8 @@ bool ClusterFinder::Execute(){
   std::map<unsigned long, std::vector<std::vector<ADCPulse>>> RecoADCHits;
 
   // Some initialization
-  v_hittimes.clear();
-  v_hittimes_sorted.clear();
-  v_mini_hits.clear();
-  m_time_Nhits.clear();
+  v_cluster_hits.clear();
   v_clusters.clear();
-  v_local_cluster_times.clear();
   m_all_clusters->clear();
   m_all_clusters_MC->clear();
   m_all_clusters_detkey->clear();
@@ -196,56 +198,260 @@ bool ClusterFinder::Execute(){
     PMT_ishit[detkey] = 0;
   }
 
+  // Flatten the tank hits into one time-sorted array (time, charge, detkey, hit)
   if(HitStoreName=="MCHits"){
-    int vectsize = MCHits->size();
-    if (verbose > 3) std::cout <<"ClusterFinder tool: MCHits size: "<<vectsize<<std::endl;
-    for(std::pair<unsigned long, std::vector<MCHit>>&& apair : *MCHits){
-      unsigned long chankey = apair.first;
-      Detector* thistube = geom->ChannelToDetector(chankey);
-      int detectorkey = thistube->GetDetectorID();
-      if (thistube->GetDetectorElement()=="Tank"){
-        std::vector<MCHit>& ThisPMTHits = apair.second;
-        PMT_ishit[detectorkey] = 1;
-        for (MCHit &ahit : ThisPMTHits){
-          //std::cout <<"Key: "<<detectorkey<<", charge "<<ahit.GetCharge()<<", time "<<ahit.GetTime()<<std::endl;
-          if (ahit.GetTime() < end_of_window_time_cut*AcqTimeWindow) v_hittimes.push_back(ahit.GetTime()); // fill a vector with all hit times (unsorted)
-        }
-      }
+    if (verbose > 3) std::cout <<"ClusterFinder tool: MCHits size: "<<MCHits->size()<<std::endl;
+    this->FillClusterHits(MCHits);
+  }
+  if(HitStoreName=="Hits"){
+    if (verbose > 0) std::cout <<"Hits size: "<<Hits->size()<<std::endl;
+    this->FillClusterHits(Hits);
+  }
+
+  // Hits before the end-of-window cut are the ones used to seed clusters
+  double time_cut = end_of_window_time_cut*AcqTimeWindow;
+  int n_seed_hits = 0;
+  while (n_seed_hits < int(v_cluster_hits.size()) && v_cluster_hits.at(n_seed_hits).time < time_cut) n_seed_hits++;
+
+  if (n_seed_hits == 0) {
+    if (verbose > 1) cout << "No hits, event is skipped..." << endl;
+      if (HitStoreName == "Hits") m_data->CStore.Set("ClusterMap",m_all_clusters);
+      else if (HitStoreName == "MCHits") m_data->CStore.Set("ClusterMapMC",m_all_clusters_MC);
+      m_data->CStore.Set("ClusterMapDetkey",m_all_clusters_detkey);
+      return true;
+  }
+
+  if (verbose > 2) {
+    for (int i_hit = 0; i_hit < n_seed_hits; i_hit++) {
+      cout << "Hit time (sorted) -> " << v_cluster_hits.at(i_hit).time << endl;
     }
   }
 
-  if(HitStoreName=="Hits"){
-    int vectsize = Hits->size();
-    if (verbose > 0) std::cout <<"Hits size: "<<vectsize<<std::endl;
-    for(std::pair<unsigned long, std::vector<Hit>>&& apair : *Hits){
+  if (benchmark_clustering) this->BenchmarkClustering(n_seed_hits);
+
+  v_clusters.clear();
+  if (ClusteringMode == "Legacy") this->FindClustersLegacy(n_seed_hits);
+  else this->FindClustersSlidingWindow(n_seed_hits);
+
+  // Now get info about those local maxima, cluster per cluster, from the sorted hit array
+  double first_cluster = (v_clusters.empty()) ? 0. : *std::min_element(v_clusters.begin(),v_clusters.end());
+  for (std::vector<double>::iterator it = v_clusters.begin(); it != v_clusters.end(); ++it) {
+    // all tank hits in [cluster start, cluster start + ClusterFindingWindow]
+    int first_hit = this->FirstHitAtOrAfter(*it);
+    int last_hit = first_hit;
+    double local_cluster_charge = 0;
+    double local_cluster_time = 0;
+    while (last_hit < int(v_cluster_hits.size()) && v_cluster_hits.at(last_hit).time <= *it + ClusterFindingWindow){
+      local_cluster_charge += v_cluster_hits.at(last_hit).charge;
+      local_cluster_time += v_cluster_hits.at(last_hit).time;
+      if (verbose > 2) cout << "Local cluster at " << *it << " and hit is " << v_cluster_hits.at(last_hit).time << endl;
+      last_hit++;
+    }
+    int n_cluster_hits = last_hit - first_hit;
+    local_cluster_time /= n_cluster_hits;
+    if (verbose > 0) cout << "Local cluster at " << local_cluster_time << " ns with a total charge of " << local_cluster_charge << " (" << n_cluster_hits << " hits)" << endl;
+    h_Cluster_times->Fill(local_cluster_time);
+    h_Cluster_charges->Fill(local_cluster_charge);
+    if (draw_2D) h_Cluster_charge_time->Fill(local_cluster_time,local_cluster_charge);
+    if (v_clusters.size() > 1) {
+      h_Cluster_deltaT->Fill(local_cluster_time - first_cluster);
+      if (draw_2D) h_Cluster_charge_deltaT->Fill(local_cluster_time - first_cluster,local_cluster_charge);
+    }
+    if (verbose > 2) cout << "Next cluster ..." << endl;
+
+    // Fills the map of clusters (to be passed through CStore)
+    if (HitStoreName == "Hits") this->FillClusterMap(m_all_clusters, local_cluster_time, first_hit, last_hit);
+    else if (HitStoreName == "MCHits") this->FillClusterMap(m_all_clusters_MC, local_cluster_time, first_hit, last_hit);
+  }
+
+  // Load the cluster map in a CStore for use by a subsequent tool
+  if (HitStoreName == "Hits") m_data->CStore.Set("ClusterMap",m_all_clusters);
+  else if (HitStoreName == "MCHits") m_data->CStore.Set("ClusterMapMC",m_all_clusters_MC);
+  m_data->CStore.Set("ClusterMapDetkey",m_all_clusters_detkey);
+
+  //check whether PMT_ishit is filled correctly
+  for (int i_pmt = 0; i_pmt < n_tank_pmts ; i_pmt++){
+    unsigned long detkey = pmt_detkeys[i_pmt];
+    if (verbose > 2) std::cout <<"PMT "<<i_pmt<<" is hit: "<<PMT_ishit[detkey]<<std::endl;
+  }    
+
+  //----------------------------------------------------------------------------
+  //---------------Read out RecoADCHits properties of PMTs----------------------
+  //----------------------------------------------------------------------------
+
+  if (got_recoadc){
+
+    int recoadcsize = RecoADCHits.size();
+    int adc_loop = 0;
+    if (verbose > 0) std::cout <<"RecoADCHits size: "<<recoadcsize<<std::endl;
+    for (std::pair<unsigned long, std::vector<std::vector<ADCPulse>>> apair : RecoADCHits){
       unsigned long chankey = apair.first;
-      Detector* thistube = geom->ChannelToDetector(chankey);
+      Detector *thistube = geom->ChannelToDetector(chankey);
       int detectorkey = thistube->GetDetectorID();
       if (thistube->GetDetectorElement()=="Tank"){
-        std::vector<Hit>& ThisPMTHits = apair.second;
-        PMT_ishit[detectorkey] = 1;
-        for (Hit &ahit : ThisPMTHits){
-          if (verbose > 2) std::cout << "Key: " << detectorkey << ", charge "<<ahit.GetCharge()<<", time "<<ahit.GetTime()<<std::endl;
-          if (ahit.GetTime() < end_of_window_time_cut*AcqTimeWindow) v_hittimes.push_back(ahit.GetTime()); // fill a vector with all hit times (unsorted)
+        std::vector<std::vector<ADCPulse>> pulses = apair.second;
+        for (int i_minibuffer = 0; i_minibuffer < int(pulses.size()); i_minibuffer++){
+          std::vector<ADCPulse> apulsevector = pulses.at(i_minibuffer);
+          for (int i_pulse=0; i_pulse < int(apulsevector.size()); i_pulse++){
+            ADCPulse apulse = apulsevector.at(i_pulse);
+            double start_time = apulse.start_time();
+            double peak_time = apulse.peak_time();
+            double baseline = apulse.baseline();
+            double sigma_baseline = apulse.sigma_baseline();
+            double raw_amplitude = apulse.raw_amplitude();
+            double amplitude = apulse.amplitude();
+            double raw_area = apulse.raw_area();
+          }
         }
+      }else {
+        if (verbose > 0) std::cout <<"ClusterFinder: RecoADCHit does not belong to a tank PMT and is ommited. Detector key/element = "<<detectorkey<<" / "<<thistube->GetDetectorElement()<<std::endl;
       }
+      adc_loop++;    
     }
+
+  } else {
+
+    std::cout <<"ClusterFinder: RecoADCHits Store does not exist and is not read out"<<std::endl;
   }
 
+  return true;
+}
+
+
+bool ClusterFinder::Finalise(){
+
+  f_output->cd();
+  /*canvas_Cluster = new TCanvas("canvas_Cluster","canvas_Cluster",1200,1200);
+  canvas_Cluster->Divide(2,2);
+  canvas_Cluster->cd(1);
+  h_Cluster_times->Draw();
+  canvas_Cluster->cd(2);
+  h_Cluster_charges->Draw();
+  canvas_Cluster->cd(3);
+  h_Cluster_deltaT->Draw();
+  canvas_Cluster->SaveAs("Cluster.jpg"); 
+  canvas_Cluster->Write();*/
   
-  if (v_hittimes.size() == 0) {
-    if (verbose > 1) cout << "No hits, event is skipped..." << endl;
-      if (HitStoreName == "Hits") m_data->CStore.Set("ClusterMap",m_all_clusters);
-      else if (HitStoreName == "MCHits") m_data->CStore.Set("ClusterMapMC",m_all_clusters_MC);
-      m_data->CStore.Set("ClusterMapDetkey",m_all_clusters_detkey);
-      return true;
+  h_Cluster_times->Write();
+  h_Cluster_charges->Write();
+  h_Cluster_deltaT->Write();
+  if (draw_2D){
+    h_Cluster_charge_time->Write();
+    h_Cluster_charge_deltaT->Write();
+  }
+  f_output->Close();
+  
+  if (benchmark_clustering && benchmark_events > 0){
+    Log("ClusterFinder benchmark: "+std::to_string(benchmark_events)+" events, legacy "+std::to_string(benchmark_legacy_ms/benchmark_events)+" ms/event, sliding window "+std::to_string(benchmark_window_ms/benchmark_events)+" ms/event, "+std::to_string(benchmark_mismatches)+" events with different clusters",v_message,verbose);
   }
 
-  if (verbose > 2) {
-    for (std::vector<double>::iterator it = v_hittimes.begin(); it != v_hittimes.end(); ++it) {
-      cout << "Hit time -> " << *it << endl;
+  Log("ClusterFinder exiting...",v_message,verbose);
+
+  return true;
+}
+
+template<typename HitType>
+void ClusterFinder::FillClusterHits(std::map<unsigned long, std::vector<HitType>>* hitmap){
+
+  // One channel lookup per channel; the per-cluster passes then only touch this array
+  v_cluster_hits.clear();
+  for(std::pair<const unsigned long, std::vector<HitType>>& apair : *hitmap){
+    unsigned long chankey = apair.first;
+    const ChannelLookup* thechannel = geom->LookupChannel(chankey);
+    if (thechannel == nullptr) continue;
+    unsigned long detectorkey = thechannel->detectorkey;
+    if (thechannel->element==detectorelement::TANK){
+      std::vector<HitType>& ThisPMTHits = apair.second;
+      PMT_ishit[detectorkey] = 1;
+      for (HitType &ahit : ThisPMTHits){
+        if (verbose > 2) std::cout << "Key: " << detectorkey << ", charge "<<ahit.GetCharge()<<", time "<<ahit.GetTime()<<std::endl;
+        v_cluster_hits.push_back(ClusterHit{ahit.GetTime(), ahit.GetCharge(), detectorkey, &ahit});
+      }
+    }
+  }
+  // stable, so hits with equal times keep the channel order of the hit map
+  std::stable_sort(v_cluster_hits.begin(),v_cluster_hits.end(),
+    [](const ClusterHit& a, const ClusterHit& b){ return a.time < b.time; });
+}
+
+template<typename HitType>
+void ClusterFinder::FillClusterMap(std::map<double,std::vector<HitType>>* cluster_map, double cluster_time, int first_hit, int last_hit){
+
+  std::vector<HitType>& cluster_hits = (*cluster_map)[cluster_time];
+  std::vector<unsigned long>& cluster_detkeys = (*m_all_clusters_detkey)[cluster_time];
+  for (int i_hit = first_hit; i_hit < last_hit; i_hit++){
+    cluster_hits.push_back(*static_cast<HitType*>(v_cluster_hits.at(i_hit).hit));
+    cluster_detkeys.push_back(v_cluster_hits.at(i_hit).detkey);
+  }
+}
+
+int ClusterFinder::FirstHitAtOrAfter(double time){
+
+  return std::lower_bound(v_cluster_hits.begin(),v_cluster_hits.end(),time,
+    [](const ClusterHit& a, double t){ return a.time < t; }) - v_cluster_hits.begin();
+}
+
+void ClusterFinder::FindClustersSlidingWindow(int n_seed_hits){
+
+  // Every distinct seed hit time t opens a window [t, t+ClusterFindingWindow); the
+  // end of each window is found with a second pointer moving along the sorted array.
+  v_window_start.clear();
+  v_window_first.clear();
+  v_window_end.clear();
+  int window_end = 0;
+  for (int i_hit = 0; i_hit < n_seed_hits; i_hit++){
+    double start = v_cluster_hits.at(i_hit).time;
+    if (start + ClusterFindingWindow > AcqTimeWindow) {
+      if (verbose > 2) cout << "Cluster Finding loop: Reaching the end of the acquisition time window.." << endl;
+      break;
     }
+    if (i_hit > 0 && start == v_cluster_hits.at(i_hit-1).time) continue;
+    while (window_end < n_seed_hits && v_cluster_hits.at(window_end).time < start + ClusterFindingWindow) window_end++;
+    v_window_start.push_back(start);
+    v_window_first.push_back(i_hit);
+    v_window_end.push_back(window_end);
   }
+  if (verbose > 1) cout << "Found " << v_window_start.size() << " cluster windows..." << endl;
+
+  // Pick the window with the most remaining hits, remove the hits within
+  // [start, start+ClusterFindingWindow] and repeat while windows have enough hits left
+  v_hit_used.assign(n_seed_hits,0);
+  v_used_before.assign(n_seed_hits+1,0);
+  do {
+    for (int i_hit = 0; i_hit < n_seed_hits; i_hit++) v_used_before.at(i_hit+1) = v_used_before.at(i_hit) + v_hit_used.at(i_hit);
+    max_Nhits = 0;
+    int i_max_window = -1;
+    for (int i_window = 0; i_window < int(v_window_start.size()); i_window++){
+      int first = v_window_first.at(i_window);
+      int end = v_window_end.at(i_window);
+      int nhits = (end - first) - (v_used_before.at(end) - v_used_before.at(first));
+      if (nhits > max_Nhits) {
+        max_Nhits = nhits;
+        i_max_window = i_window;
+      }
+    }
+    if (i_max_window < 0 || max_Nhits < MinHitsPerCluster) {
+      if (verbose > 1 ) cout << "No more clusters with > " << MinHitsPerCluster<< " hits" << endl; 
+      break;
+    }
+    local_cluster = v_window_start.at(i_max_window);
+    if (verbose > 0) cout << "Cluster found at " << local_cluster << " ns with " << max_Nhits << " hits" << endl;
+    v_clusters.push_back(local_cluster);
+    for (int i_hit = v_window_first.at(i_max_window); i_hit < n_seed_hits && v_cluster_hits.at(i_hit).time <= local_cluster + ClusterFindingWindow; i_hit++){
+      v_hit_used.at(i_hit) = 1;
+    }
+  } while (true);
+}
+
+void ClusterFinder::FindClustersLegacy(int n_seed_hits){
+
+  // Original implementation: selection-sorted hit times, windows stepped through in
+  // 2 ns increments (only hits exactly on that grid are counted), clusters taken from
+  // a map of window start -> hit times
+  v_hittimes.clear();
+  v_hittimes_sorted.clear();
+  m_time_Nhits.clear();
+  for (int i_hit = 0; i_hit < n_seed_hits; i_hit++) v_hittimes.push_back(v_cluster_hits.at(i_hit).time);
 
   // Now sort the hit time array, fill the highest time in a new array until the old array is empty
   do {
@@ -261,12 +467,6 @@ bool ClusterFinder::Execute(){
     v_hittimes.erase(v_hittimes.begin() + i_max_time);
   } while (v_hittimes.size() != 0);
   
-  if (verbose > 2) {
-    for (std::vector<double>::iterator it = v_hittimes_sorted.begin(); it != v_hittimes_sorted.end(); ++it) {
-      cout << "Hit time (sorted) -> " << *it << endl;
-    }
-  }
-
   // Move a time window within the array and look for the window with the highest number of hits
   for (std::vector<double>::iterator it = v_hittimes_sorted.begin(); it != v_hittimes_sorted.end(); ++it) {
     if (*it + ClusterFindingWindow > AcqTimeWindow || *it > end_of_window_time_cut*AcqTimeWindow) {
@@ -347,186 +547,24 @@ bool ClusterFinder::Execute(){
     }
   } while (true); 
   m_time_Nhits.clear();
-
-  // Now loop on the hit map again to get info about those local maxima, cluster per cluster
-  for (std::vector<double>::iterator it = v_clusters.begin(); it != v_clusters.end(); ++it) {
-    double local_cluster_charge = 0;
-    double local_cluster_time = 0;
-    v_local_cluster_times.clear();
-    if (HitStoreName == "Hits"){
-      for(std::pair<unsigned long, std::vector<Hit>>&& apair : *Hits){
-        unsigned long chankey = apair.first;
-        Detector* thistube = geom->ChannelToDetector(chankey);
-        int detectorkey = thistube->GetDetectorID();
-        if (thistube->GetDetectorElement()=="Tank"){
-          std::vector<Hit>& ThisPMTHits = apair.second;
-          PMT_ishit[detectorkey] = 1;
-          for (Hit &ahit : ThisPMTHits){
-            if (ahit.GetTime() >= *it && ahit.GetTime() <= *it + ClusterFindingWindow) {
-              local_cluster_charge += ahit.GetCharge();
-              v_local_cluster_times.push_back(ahit.GetTime());
-              if (verbose > 2) cout << "Local cluster at " << *it << " and hit is " << ahit.GetTime() << endl;
-            }
-          }
-        }
-      }
-    } else if (HitStoreName == "MCHits"){
-      for(std::pair<unsigned long, std::vector<MCHit>>&& apair : *MCHits){
-        unsigned long chankey = apair.first;
-        Detector* thistube = geom->ChannelToDetector(chankey);
-        int detectorkey = thistube->GetDetectorID();
-        if (thistube->GetDetectorElement()=="Tank"){
-          std::vector<MCHit>& ThisPMTHits = apair.second;
-          PMT_ishit[detectorkey] = 1;
-          for (MCHit &ahit : ThisPMTHits){
-            if (ahit.GetTime() >= *it && ahit.GetTime() <= *it + ClusterFindingWindow) {
-              local_cluster_charge += ahit.GetCharge();
-              v_local_cluster_times.push_back(ahit.GetTime());
-              if (verbose > 2) cout << "Local cluster at " << *it << " and hit is " << ahit.GetTime() << endl;
-            }
-          }
-        }
-      }
-    }
-    
-    for (std::vector<double>::iterator itt = v_local_cluster_times.begin(); itt != v_local_cluster_times.end(); ++itt) {
-     local_cluster_time += *itt;
-    }
-    local_cluster_time /= v_local_cluster_times.size();
-    if (verbose > 0) cout << "Local cluster at " << local_cluster_time << " ns with a total charge of " << local_cluster_charge << " (" << v_local_cluster_times.size() << " hits)" << endl;
-    h_Cluster_times->Fill(local_cluster_time);
-    h_Cluster_charges->Fill(local_cluster_charge);
-    if (draw_2D) h_Cluster_charge_time->Fill(local_cluster_time,local_cluster_charge);
-    if (v_clusters.size() > 1) {
-      h_Cluster_deltaT->Fill(local_cluster_time - *std::min_element(v_clusters.begin(),v_clusters.end()));
-      if (draw_2D) h_Cluster_charge_deltaT->Fill(local_cluster_time - *std::min_element(v_clusters.begin(),v_clusters.end()),local_cluster_charge);
-    }
-    if (verbose > 2) cout << "Next cluster ..." << endl;
-
-    // Fills the map of clusters (to be passed through CStore)
-    if (HitStoreName == "Hits"){
-      for(std::pair<unsigned long, std::vector<Hit>>&& apair : *Hits) {   
-        unsigned long chankey = apair.first;
-        Detector* thistube = geom->ChannelToDetector(chankey);
-        unsigned long detectorkey = thistube->GetDetectorID();
-        if (thistube->GetDetectorElement()=="Tank"){
-          std::vector<Hit>& ThisPMTHits = apair.second;
-          PMT_ishit[detectorkey] = 1;
-          for (Hit &ahit : ThisPMTHits){
-            if (ahit.GetTime() >= *it && ahit.GetTime() <= *it + ClusterFindingWindow) { 
-              if(m_all_clusters->count(local_cluster_time)==0) {
-                m_all_clusters->emplace(local_cluster_time, std::vector<Hit>{ahit});
-                m_all_clusters_detkey->emplace(local_cluster_time, std::vector<unsigned long>{detectorkey});
-              } else { 
-                m_all_clusters->at(local_cluster_time).push_back(ahit);
-                m_all_clusters_detkey->at(local_cluster_time).push_back(detectorkey);
-              }
-            }
-          }  
-        }
-      }
-    } else if (HitStoreName == "MCHits"){
-      for(std::pair<unsigned long, std::vector<MCHit>>&& apair : *MCHits) {   
-        unsigned long chankey = apair.first;
-        Detector* thistube = geom->ChannelToDetector(chankey);
-        unsigned long detectorkey = thistube->GetDetectorID();
-        if (thistube->GetDetectorElement()=="Tank"){
-          std::vector<MCHit>& ThisPMTHits = apair.second;
-          PMT_ishit[detectorkey] = 1;
-          for (MCHit &ahit : ThisPMTHits){
-            if (ahit.GetTime() >= *it && ahit.GetTime() <= *it + ClusterFindingWindow) { 
-              if(m_all_clusters_MC->count(local_cluster_time)==0) {
-                m_all_clusters_MC->emplace(local_cluster_time, std::vector<MCHit>{ahit});
-                m_all_clusters_detkey->emplace(local_cluster_time, std::vector<unsigned long>{detectorkey});
-              } else { 
-                m_all_clusters_MC->at(local_cluster_time).push_back(ahit);
-                m_all_clusters_detkey->at(local_cluster_time).push_back(detectorkey);
-              }
-            }
-          }  
-        }
-      }
-    }
-  }
-
-  // Load the cluster map in a CStore for use by a subsequent tool
-  if (HitStoreName == "Hits") m_data->CStore.Set("ClusterMap",m_all_clusters);
-  else if (HitStoreName == "MCHits") m_data->CStore.Set("ClusterMapMC",m_all_clusters_MC);
-  m_data->CStore.Set("ClusterMapDetkey",m_all_clusters_detkey);
-
-  //check whether PMT_ishit is filled correctly
-  for (int i_pmt = 0; i_pmt < n_tank_pmts ; i_pmt++){
-    unsigned long detkey = pmt_detkeys[i_pmt];
-    if (verbose > 2) std::cout <<"PMT "<<i_pmt<<" is hit: "<<PMT_ishit[detkey]<<std::endl;
-  }    
-
-  //----------------------------------------------------------------------------
-  //---------------Read out RecoADCHits properties of PMTs----------------------
-  //----------------------------------------------------------------------------
-
-  if (got_recoadc){
-
-    int recoadcsize = RecoADCHits.size();
-    int adc_loop = 0;
-    if (verbose > 0) std::cout <<"RecoADCHits size: "<<recoadcsize<<std::endl;
-    for (std::pair<unsigned long, std::vector<std::vector<ADCPulse>>> apair : RecoADCHits){
-      unsigned long chankey = apair.first;
-      Detector *thistube = geom->ChannelToDetector(chankey);
-      int detectorkey = thistube->GetDetectorID();
-      if (thistube->GetDetectorElement()=="Tank"){
-        std::vector<std::vector<ADCPulse>> pulses = apair.second;
-        for (int i_minibuffer = 0; i_minibuffer < int(pulses.size()); i_minibuffer++){
-          std::vector<ADCPulse> apulsevector = pulses.at(i_minibuffer);
-          for (int i_pulse=0; i_pulse < int(apulsevector.size()); i_pulse++){
-            ADCPulse apulse = apulsevector.at(i_pulse);
-            double start_time = apulse.start_time();
-            double peak_time = apulse.peak_time();
-            double baseline = apulse.baseline();
-            double sigma_baseline = apulse.sigma_baseline();
-            double raw_amplitude = apulse.raw_amplitude();
-            double amplitude = apulse.amplitude();
-            double raw_area = apulse.raw_area();
-          }
-        }
-      }else {
-        if (verbose > 0) std::cout <<"ClusterFinder: RecoADCHit does not belong to a tank PMT and is ommited. Detector key/element = "<<detectorkey<<" / "<<thistube->GetDetectorElement()<<std::endl;
-      }
-      adc_loop++;    
-    }
-
-  } else {
-
-    std::cout <<"ClusterFinder: RecoADCHits Store does not exist and is not read out"<<std::endl;
-  }
-
-  return true;
 }
 
+void ClusterFinder::BenchmarkClustering(int n_seed_hits){
 
-bool ClusterFinder::Finalise(){
-
-  f_output->cd();
-  /*canvas_Cluster = new TCanvas("canvas_Cluster","canvas_Cluster",1200,1200);
-  canvas_Cluster->Divide(2,2);
-  canvas_Cluster->cd(1);
-  h_Cluster_times->Draw();
-  canvas_Cluster->cd(2);
-  h_Cluster_charges->Draw();
-  canvas_Cluster->cd(3);
-  h_Cluster_deltaT->Draw();
-  canvas_Cluster->SaveAs("Cluster.jpg"); 
-  canvas_Cluster->Write();*/
-  
-  h_Cluster_times->Write();
-  h_Cluster_charges->Write();
-  h_Cluster_deltaT->Write();
-  if (draw_2D){
-    h_Cluster_charge_time->Write();
-    h_Cluster_charge_deltaT->Write();
-  }
-  f_output->Close();
-  
-  Log("ClusterFinder exiting...",v_message,verbose);
-
-  return true;
+  // Time both cluster finders on this event and check that they agree
+  auto start = std::chrono::steady_clock::now();
+  v_clusters.clear();
+  this->FindClustersLegacy(n_seed_hits);
+  std::vector<double> legacy_clusters = v_clusters;
+  auto mid = std::chrono::steady_clock::now();
+  v_clusters.clear();
+  this->FindClustersSlidingWindow(n_seed_hits);
+  auto stop = std::chrono::steady_clock::now();
+  double legacy_ms = std::chrono::duration<double,std::milli>(mid-start).count();
+  double window_ms = std::chrono::duration<double,std::milli>(stop-mid).count();
+  benchmark_legacy_ms += legacy_ms;
+  benchmark_window_ms += window_ms;
+  benchmark_events++;
+  if (legacy_clusters != v_clusters) benchmark_mismatches++;
+  Log("ClusterFinder benchmark: "+std::to_string(n_seed_hits)+" hits, legacy "+std::to_string(legacy_ms)+" ms ("+std::to_string(legacy_clusters.size())+" clusters), sliding window "+std::to_string(window_ms)+" ms ("+std::to_string(v_clusters.size())+" clusters)",v_message,verbose);
 }
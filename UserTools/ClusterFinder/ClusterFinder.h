@@ -6,6 +6,7 @@
 #include <algorithm>
 #include <cmath>
 #include <fstream>
+#include <chrono>
 
 #include "TObjectTable.h"
 
@@ -52,6 +53,21 @@ class ClusterFinder: public Tool {
 
  private:
 
+  /// A tank hit in the time-sorted hit array used for clustering
+  struct ClusterHit {
+    double time;
+    double charge;
+    unsigned long detkey;
+    Hit* hit;            ///< points into the Hits/MCHits map of the current event
+  };
+
+  template<typename HitType> void FillClusterHits(std::map<unsigned long, std::vector<HitType>>* hitmap); ///< Fill v_cluster_hits with the tank hits, sorted by time
+  template<typename HitType> void FillClusterMap(std::map<double,std::vector<HitType>>* cluster_map, double cluster_time, int first_hit, int last_hit); ///< Add hits [first_hit,last_hit) of v_cluster_hits to a cluster
+  int FirstHitAtOrAfter(double time); ///< Index of the first hit in v_cluster_hits with a time >= time
+  void FindClustersSlidingWindow(int n_seed_hits); ///< Fill v_clusters using a sliding window over the first n_seed_hits sorted hits
+  void FindClustersLegacy(int n_seed_hits); ///< Fill v_clusters with the original 2 ns stepping algorithm
+  void BenchmarkClustering(int n_seed_hits); ///< Time both cluster finders on the current event
+
   //define input variables
   std::string HitStoreName = "MCHits";
   std::string outputfile;
@@ -67,6 +83,8 @@ class ClusterFinder: public Tool {
   int MinHitsPerCluster;
   bool draw_2D = false;
   double end_of_window_time_cut;
+  std::string ClusteringMode = "SlidingWindow";
+  bool benchmark_clustering = false;
 
   // define ANNIEEvent variables
   int evnum;
@@ -116,7 +134,12 @@ class ClusterFinder: public Tool {
   std::vector<double> v_mini_hits;
   std::map<double, std::vector<double>> m_time_Nhits;
   std::vector<double> v_clusters;
-  std::vector<double> v_local_cluster_times;
+  std::vector<ClusterHit> v_cluster_hits; // tank hits of the event, sorted by time
+  std::vector<double> v_window_start;     // sliding window start times
+  std::vector<int> v_window_first;        // first hit index in each window
+  std::vector<int> v_window_end;          // one past the last hit index in each window
+  std::vector<int> v_hit_used;            // hits already assigned to a cluster
+  std::vector<int> v_used_before;         // running count of v_hit_used
   std::map<double,std::vector<Hit>>* m_all_clusters;  
   std::map<double,std::vector<MCHit>>* m_all_clusters_MC;  
   std::map<double,std::vector<unsigned long>>* m_all_clusters_detkey; 
@@ -126,6 +149,12 @@ class ClusterFinder: public Tool {
   double local_cluster = 0;
   int thiswindow_Nhits =0;
   int dummy_hittime_value = -9999; 
+
+  // Benchmark totals
+  int benchmark_events = 0;
+  int benchmark_mismatches = 0;
+  double benchmark_legacy_ms = 0;
+  double benchmark_window_ms = 0;
   
   //define file to save data
   TFile *file_out = nullptr;
@@ -240,7 +240,7 @@ bool DigitBuilder::BuildMCPMTRecoDigit() {
       pos_reco.SetY(pos_sim.Y()+yshift);
       pos_reco.SetZ(pos_sim.Z()+zshift);
 	
-      if(det->GetDetectorElement()=="Tank"){
+      if(fGeometry->ChannelToDetectorElement(chankey)==detectorelement::TANK){
         std::vector<MCHit>& hits = apair.second;
         if(fParametricModel){
           if(verbosity>2) std::cout << "Using parametric model to build PMT hits" << std::endl;
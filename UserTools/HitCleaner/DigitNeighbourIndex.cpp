@@ -0,0 +1,122 @@
+#include "DigitNeighbourIndex.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+  // Cell coordinates are packed into 21 bits each
+  const int64_t kCellBits = 21;
+  const int64_t kMaxCells = (int64_t(1) << kCellBits) - 2;
+}
+
+void DigitNeighbourIndex::Build(const std::vector<RecoDigit*>& digits, double cellsize)
+{
+  fDigits.resize(digits.size());
+  fCells.clear();
+
+  double xmin = 0., ymin = 0., zmin = 0., extent = 0.;
+  bool first = true;
+  for (size_t idigit = 0; idigit < digits.size(); idigit++) {
+    RecoDigit* digit = digits[idigit];
+    IndexedDigit& entry = fDigits[idigit];
+    entry.x = digit->GetPosition().X();
+    entry.y = digit->GetPosition().Y();
+    entry.z = digit->GetPosition().Z();
+    entry.t = digit->GetCalTime();
+    int digitType = digit->GetDigitType();
+    entry.type = (digitType == RecoDigit::PMT8inch || digitType == RecoDigit::lappd_v0) ? digitType : -1;
+    // a digit with an undefined position or time can't pass the distance cuts
+    if (!std::isfinite(entry.x) || !std::isfinite(entry.y) || !std::isfinite(entry.z)
+        || !std::isfinite(entry.t)) entry.type = -1;
+    if (entry.type < 0) continue;
+    if (first) {
+      xmin = entry.x; ymin = entry.y; zmin = entry.z;
+      first = false;
+    }
+    xmin = std::min(xmin, entry.x);
+    ymin = std::min(ymin, entry.y);
+    zmin = std::min(zmin, entry.z);
+  }
+  for (const IndexedDigit& entry : fDigits) {
+    if (entry.type < 0) continue;
+    extent = std::max(extent, std::max(entry.x - xmin, std::max(entry.y - ymin, entry.z - zmin)));
+  }
+
+  // Cells smaller than the query radius only cost extra lookups; keep the
+  // number of cells along an axis within the packed key range. The small margin
+  // keeps two digits closer than the radius in adjacent cells despite rounding.
+  fCellSize = std::fabs(cellsize) * (1. + 1e-9);
+  if (!(fCellSize > extent / (kMaxCells / 2))) fCellSize = extent / (kMaxCells / 2);
+  if (!(fCellSize > 0.) || !std::isfinite(fCellSize)) fCellSize = 1.;
+  // one empty cell below the smallest coordinate, so neighbouring cells are never negative
+  fOriginX = xmin - fCellSize;
+  fOriginY = ymin - fCellSize;
+  fOriginZ = zmin - fCellSize;
+
+  for (size_t idigit = 0; idigit < fDigits.size(); idigit++) {
+    const IndexedDigit& entry = fDigits[idigit];
+    if (entry.type < 0) continue;
+    CellEntry cellentry;
+    cellentry.cell = CellKey(CellCoordinate(entry.x, fOriginX), CellCoordinate(entry.y, fOriginY),
+        CellCoordinate(entry.z, fOriginZ));
+    cellentry.t = entry.t;
+    cellentry.idigit = idigit;
+    fCells.push_back(cellentry);
+  }
+  std::sort(fCells.begin(), fCells.end());
+}
+
+void DigitNeighbourIndex::Query(int idigit, double radius, double window, std::vector<int>& neighbours) const
+{
+  neighbours.clear();
+  const IndexedDigit& digit1 = fDigits[idigit];
+  if (digit1.type < 0 || !(window > 0.)) return;
+
+  int64_t ix = CellCoordinate(digit1.x, fOriginX);
+  int64_t iy = CellCoordinate(digit1.y, fOriginY);
+  int64_t iz = CellCoordinate(digit1.z, fOriginZ);
+  double radiussq = radius*radius;
+  int64_t reach = static_cast<int64_t>(std::ceil(std::fabs(radius) / fCellSize));
+  reach = std::min(reach, kMaxCells);
+
+  for (int64_t jx = std::max<int64_t>(ix - reach, 0); jx <= std::min(ix + reach, kMaxCells + 1); jx++) {
+    for (int64_t jy = std::max<int64_t>(iy - reach, 0); jy <= std::min(iy + reach, kMaxCells + 1); jy++) {
+      for (int64_t jz = std::max<int64_t>(iz - reach, 0); jz <= std::min(iz + reach, kMaxCells + 1); jz++) {
+        // digits in a cell are sorted by time: start at the beginning of the time window
+        CellEntry first;
+        first.cell = CellKey(jx, jy, jz);
+        first.t = digit1.t - window;
+        first.idigit = -1;
+        auto it = std::lower_bound(fCells.begin(), fCells.end(), first);
+        // lower_bound uses t2 >= t1 - window, which can differ from |t1 - t2| < window
+        // in the last bit: step back over any earlier digits that still pass
+        while (it != fCells.begin() && (it - 1)->cell == first.cell
+               && std::fabs(digit1.t - (it - 1)->t) < window) --it;
+        for (; it != fCells.end() && it->cell == first.cell; ++it) {
+          double dt = digit1.t - it->t;
+          if (!(std::fabs(dt) < window)) {
+            if (it->t > digit1.t) break;
+            continue;
+          }
+          const IndexedDigit& digit2 = fDigits[it->idigit];
+          double dx = digit1.x - digit2.x;
+          double dy = digit1.y - digit2.y;
+          double dz = digit1.z - digit2.z;
+          double drsq = dx*dx + dy*dy + dz*dz;
+          if (drsq > 0.0 && drsq < radiussq) neighbours.push_back(it->idigit);
+        }
+      }
+    }
+  }
+  std::sort(neighbours.begin(), neighbours.end());
+}
+
+int64_t DigitNeighbourIndex::CellKey(int64_t ix, int64_t iy, int64_t iz) const
+{
+  return (ix << (2*kCellBits)) | (iy << kCellBits) | iz;
+}
+
+int64_t DigitNeighbourIndex::CellCoordinate(double x, double origin) const
+{
+  return static_cast<int64_t>(std::floor((x - origin) / fCellSize));
+}
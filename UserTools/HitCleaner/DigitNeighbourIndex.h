@@ -0,0 +1,64 @@
+#ifndef DIGITNEIGHBOURINDEX_H
+#define DIGITNEIGHBOURINDEX_H
+
+#include <vector>
+#include <stdint.h>
+
+#include "RecoDigit.h"
+
+/**
+ * \class DigitNeighbourIndex
+ *
+ * Space-time index over a list of RecoDigits, used by the HitCleaner to find the
+ * neighbours of each digit without comparing every pair. Digits are binned on a
+ * uniform spatial grid and kept sorted by time inside each cell, so a query only
+ * looks at the surrounding cells and, within them, at the digits inside the time
+ * window.
+ *
+ * A query returns the same digits as the pairwise loops in HitCleaner: any other
+ * PMT or LAPPD digit with 0 < dr^2 < radius^2 and |dt| < window, ordered by its
+ * position in the input list. Digits of any other type are never returned.
+ * All storage is kept between events.
+*/
+class DigitNeighbourIndex {
+
+ public:
+  DigitNeighbourIndex(){}
+
+  // Index 'digits'. cellsize should be the largest radius that will be queried.
+  void Build(const std::vector<RecoDigit*>& digits, double cellsize);
+
+  // Fill 'neighbours' with the input positions of the neighbours of digit 'idigit'
+  void Query(int idigit, double radius, double window, std::vector<int>& neighbours) const;
+
+  // Small integer type of a digit: RecoDigit::PMT8inch, RecoDigit::lappd_v0 or -1
+  int GetType(int idigit) const { return fDigits[idigit].type; }
+  int GetNDigits() const { return fDigits.size(); }
+
+ private:
+  struct IndexedDigit {
+    double x, y, z, t;
+    int8_t type;
+  };
+
+  struct CellEntry {
+    int64_t cell;
+    double t;
+    int idigit;
+    bool operator<(const CellEntry& other) const {
+      if (cell != other.cell) return cell < other.cell;
+      if (t != other.t) return t < other.t;
+      return idigit < other.idigit;
+    }
+  };
+
+  int64_t CellKey(int64_t ix, int64_t iy, int64_t iz) const;
+  int64_t CellCoordinate(double x, double origin) const;
+
+  std::vector<IndexedDigit> fDigits;
+  std::vector<CellEntry> fCells;
+  double fCellSize = 0.;
+  double fOriginX = 0., fOriginY = 0., fOriginZ = 0.;
+};
+
+#endif
@@ -74,6 +74,7 @@ bool HitCleaner::Initialise(std::string configfile, DataModel &data){
   m_variables.Get("LappdMinHitsPerCluster", fLappdMinHitsPerCluster );
   m_variables.Get("MinClusterDigits", fMinClusterDigits );
   m_variables.Get("SinglePEGains",singlePEgains);
+  m_variables.Get("NeighbourSearch",fNeighbourSearch);
 
   /// Fill map with settings of HitCleaner
   fHitCleaningParam = new std::map<std::string,double>;
@@ -97,6 +98,11 @@ bool HitCleaner::Initialise(std::string configfile, DataModel &data){
     fConfig = HitCleaner::kPulseHeightAndClusters;
   }
 
+  if (fNeighbourSearch != "Index" && fNeighbourSearch != "Legacy"){
+    Log("HitCleaner tool: NeighbourSearch <"+fNeighbourSearch+"> not recognized. Using Index",v_error,verbosity);
+    fNeighbourSearch = "Index";
+  }
+
   if (!fisMC){
     ifstream file_singlepe(singlePEgains.c_str());
     unsigned long temp_chankey;
@@ -207,6 +213,11 @@ bool HitCleaner::Finalise(){
   delete fFilterByClusters; fFilterByClusters = 0;
   //delete fHitCleaningClusters; fHitCleaningClusters = 0;    //Will be deleted by the store, don't manually delete
   delete fClusterList; fClusterList = 0;
+  for(int i=0; i<int(vClusterDigitPool.size()); i++ ){
+    delete vClusterDigitPool.at(i);
+  }
+  vClusterDigitPool.clear();
+  vClusterDigitList.clear();
   // for test
   delete fFilterByTruthInfo; fFilterByTruthInfo = 0;
   return true;
@@ -424,70 +435,27 @@ std::vector<RecoDigit*>* HitCleaner::FilterByNeighbours(std::vector<RecoDigit*>*
     return fFilterByNeighbours;
   }
 
-  int* numNeighbours = new int[Ndigits];
-
-  for( int idigit=0; idigit<Ndigits; idigit++ ){
-    numNeighbours[idigit] = 0;
-  }
+  std::vector<int>& numNeighbours = vNumNeighbours;
+  numNeighbours.assign(Ndigits, 0);
 
   // count number of neighbours
   // ==========================
-  for(int idigit1=0; idigit1<int(myDigitList->size()); idigit1++ ){
-  	RecoDigit* fdigit1 = (RecoDigit*)(myDigitList->at(idigit1));
-  	TString digit1Type = fdigit1->GetDigitType();
-    for(int idigit2=idigit1+1; idigit2<int(myDigitList->size()); idigit2++ ){
-      RecoDigit* fdigit2 = (RecoDigit*)(myDigitList->at(idigit2));
-      TString digit2Type = fdigit2->GetDigitType();
-
-      double dx = fdigit1->GetPosition().X() - fdigit2->GetPosition().X();
-      double dy = fdigit1->GetPosition().Y() - fdigit2->GetPosition().Y();
-      double dz = fdigit1->GetPosition().Z() - fdigit2->GetPosition().Z();
-      double dt = fdigit1->GetCalTime() - fdigit2->GetCalTime();
-      double drsq = dx*dx + dy*dy + dz*dz;
-      
-      if(digit1Type == RecoDigit::PMT8inch && digit2Type == RecoDigit::PMT8inch) {
-        if( drsq>0.0
-         && drsq<fPmtNeighbourRadius*fPmtNeighbourRadius
-         && fabs(dt)<fPmtTimeWindowN ){
-          numNeighbours[idigit1]++;
-          numNeighbours[idigit2]++;
-        }	
-      }
-      
-      if(digit1Type == RecoDigit::lappd_v0 && digit2Type == RecoDigit::lappd_v0) {
-        if( drsq>0.0
-         && drsq<fLappdNeighbourRadius*fLappdNeighbourRadius
-         && fabs(dt)<fLappdTimeWindowN ){
-          numNeighbours[idigit1]++;
-          numNeighbours[idigit2]++;
-        }	
-      }
-      
-      if(digit1Type == RecoDigit::PMT8inch && digit2Type == RecoDigit::lappd_v0) {
-        if( drsq>0.0
-            && drsq<fPmtNeighbourRadius*fPmtNeighbourRadius
-            && fabs(dt)<fPmtTimeWindowN ){
-          numNeighbours[idigit1]++;
-        }	
-        if( drsq>0.0
-            && drsq<fLappdNeighbourRadius*fLappdNeighbourRadius
-            && fabs(dt)<fLappdTimeWindowN ){
-          numNeighbours[idigit2]++;
-        }	   
+  // each digit counts the digits within its own type's radius and time window
+  if( fNeighbourSearch=="Legacy" ){
+    this->CountNeighboursLegacy(myDigitList, numNeighbours);
+  }
+  else {
+    fNeighbourIndex.Build(*myDigitList, std::max(fabs(fPmtNeighbourRadius), fabs(fLappdNeighbourRadius)));
+    for(int idigit=0; idigit<Ndigits; idigit++ ){
+      int digitType = fNeighbourIndex.GetType(idigit);
+      if(digitType == RecoDigit::PMT8inch) {
+        fNeighbourIndex.Query(idigit, fPmtNeighbourRadius, fPmtTimeWindowN, vNeighbours);
       }
-
-      if(digit1Type == RecoDigit::lappd_v0 && digit2Type == RecoDigit::PMT8inch) {
-        if( drsq>0.0
-            && drsq<fLappdNeighbourRadius*fLappdNeighbourRadius
-            && fabs(dt)<fLappdTimeWindowN ){
-          numNeighbours[idigit1]++;
-        }	
-        if( drsq>0.0
-            && drsq<fPmtNeighbourRadius*fPmtNeighbourRadius
-            && fabs(dt)<fPmtTimeWindowN ){
-          numNeighbours[idigit2]++;
-        }	   
+      else if(digitType == RecoDigit::lappd_v0) {
+        fNeighbourIndex.Query(idigit, fLappdNeighbourRadius, fLappdTimeWindowN, vNeighbours);
       }
+      else continue;
+      numNeighbours[idigit] = vNeighbours.size();
     }
   }
 
@@ -501,10 +469,6 @@ std::vector<RecoDigit*>* HitCleaner::FilterByNeighbours(std::vector<RecoDigit*>*
     }
   }
 
-  // delete array of neighbours
-  // ==========================
-  delete [] numNeighbours;
-
   // return vector of filtered digits
   // ================================
   if(verbosity>v_message) std::cout << name << "  filter by neighbours: " << fFilterByNeighbours->size() << std::endl;
@@ -546,11 +510,8 @@ std::vector<RecoDigit*>* HitCleaner::FilterByClusters(std::vector<RecoDigit*>* m
 std::vector<RecoCluster*>* HitCleaner::RecoClusters(std::vector<RecoDigit*>* myDigitList)
 {  
 
-  // delete cluster digits
-  // =====================
-  for(int i=0; i<int(vClusterDigitList.size()); i++ ){
-    delete (RecoClusterDigit*)(vClusterDigitList.at(i));
-  }
+  // reset cluster digits
+  // ====================
   vClusterDigitList.clear();
 
   // clear vector clusters
@@ -561,69 +522,36 @@ std::vector<RecoCluster*>* HitCleaner::RecoClusters(std::vector<RecoDigit*>* myD
   // ===================
   for(int idigit=0; idigit<int(myDigitList->size()); idigit++ ){
     RecoDigit* recoDigit = (RecoDigit*)(myDigitList->at(idigit));
-    RecoClusterDigit* clusterDigit = new RecoClusterDigit(recoDigit);
-    vClusterDigitList.push_back(clusterDigit);
+    if( idigit<int(vClusterDigitPool.size()) ){
+      vClusterDigitPool.at(idigit)->Reset(recoDigit);
+    }
+    else {
+      vClusterDigitPool.push_back(new RecoClusterDigit(recoDigit));
+    }
+    vClusterDigitList.push_back(vClusterDigitPool.at(idigit));
   }
 
   // run clustering algorithm
   // ========================
-  for(int idigit1=0; idigit1<int(vClusterDigitList.size()); idigit1++){
-  	RecoClusterDigit* fdigit1 = (RecoClusterDigit*)(vClusterDigitList.at(idigit1));
-  	int digit1Type = fdigit1->GetDigitType();
-    for(int idigit2=idigit1+1; idigit2<int(vClusterDigitList.size()); idigit2++ ){
-
-      RecoClusterDigit* fdigit2 = (RecoClusterDigit*)(vClusterDigitList.at(idigit2));
-      int digit2Type = fdigit2->GetDigitType();
-
-      double dx = fdigit1->GetX() - fdigit2->GetX();
-      double dy = fdigit1->GetY() - fdigit2->GetY();
-      double dz = fdigit1->GetZ() - fdigit2->GetZ();
-      double dt = fdigit1->GetTime() - fdigit2->GetTime();
-      double drsq = dx*dx + dy*dy + dz*dz;
-      if(digit1Type == RecoDigit::PMT8inch && digit2Type == RecoDigit::PMT8inch) {
-        if( drsq>0.0
-         && drsq<fPmtClusterRadius*fPmtClusterRadius
-         && fabs(dt)<fPmtTimeWindowC ){
-          fdigit1->AddClusterDigit(fdigit2);
-          fdigit2->AddClusterDigit(fdigit1);
-        }	
-      }
-      
-      if(digit1Type == RecoDigit::lappd_v0 && digit2Type == RecoDigit::lappd_v0) {
-        if( drsq>0.0
-         && drsq<fLappdClusterRadius*fLappdClusterRadius
-         && fabs(dt)<fLappdTimeWindowC ){
-          fdigit1->AddClusterDigit(fdigit2);
-          fdigit2->AddClusterDigit(fdigit1);
-        }	
+  // neighbours are added in digit order, as in the pairwise loop
+  if( fNeighbourSearch=="Legacy" ){
+    this->LinkClusterDigitsLegacy();
+  }
+  else {
+    fNeighbourIndex.Build(*myDigitList, std::max(fabs(fPmtClusterRadius), fabs(fLappdClusterRadius)));
+    for(int idigit1=0; idigit1<int(vClusterDigitList.size()); idigit1++){
+      int digit1Type = fNeighbourIndex.GetType(idigit1);
+      if(digit1Type == RecoDigit::PMT8inch) {
+        fNeighbourIndex.Query(idigit1, fPmtClusterRadius, fPmtTimeWindowC, vNeighbours);
       }
-      
-      if(digit1Type == RecoDigit::PMT8inch && digit2Type == RecoDigit::lappd_v0) {
-        if( drsq>0.0
-         && drsq<fPmtClusterRadius*fPmtClusterRadius
-         && fabs(dt)<fPmtTimeWindowC ){
-          fdigit1->AddClusterDigit(fdigit2);
-        }	
-        if( drsq>0.0
-         && drsq<fLappdClusterRadius*fLappdClusterRadius
-         && fabs(dt)<fLappdTimeWindowC ){
-          fdigit2->AddClusterDigit(fdigit1);
-        }
+      else if(digit1Type == RecoDigit::lappd_v0) {
+        fNeighbourIndex.Query(idigit1, fLappdClusterRadius, fLappdTimeWindowC, vNeighbours);
       }
-      
-      if(digit1Type == RecoDigit::lappd_v0 && digit2Type == RecoDigit::PMT8inch) {
-        if( drsq>0.0
-         && drsq<fLappdClusterRadius*fLappdClusterRadius
-         && fabs(dt)<fLappdTimeWindowC ){
-          fdigit1->AddClusterDigit(fdigit2);
-        }	
-        if( drsq>0.0
-         && drsq<fPmtClusterRadius*fPmtClusterRadius
-         && fabs(dt)<fPmtTimeWindowC ){
-          fdigit2->AddClusterDigit(fdigit1);
-        }	
+      else continue;
+      RecoClusterDigit* fdigit1 = vClusterDigitList.at(idigit1);
+      for(int ineighbour=0; ineighbour<int(vNeighbours.size()); ineighbour++){
+        fdigit1->AddClusterDigit(vClusterDigitList.at(vNeighbours.at(ineighbour)));
       }
-      
     }
   }
   
@@ -645,9 +573,7 @@ std::vector<RecoCluster*>* HitCleaner::RecoClusters(std::vector<RecoDigit*>* myD
         for(int jdigit=0; jdigit<int(vClusterDigitCollection.size()); jdigit++ ){
 	  //std::cout <<"jdigit = "<<jdigit<<", vClusterDigitCollection.size() = "<<vClusterDigitCollection.size()<<std::endl;
           RecoClusterDigit* cdigit = (RecoClusterDigit*)(vClusterDigitCollection.at(jdigit));
-          TString digitType = cdigit->GetDigitType();
-	        double nDigits = cdigit->GetNClusterDigits();
-	        vNdigitsCluster.push_back(nDigits);	 
+          int digitType = cdigit->GetDigitType();
 	               
 	        if (digitType==RecoDigit::PMT8inch && cdigit->GetNClusterDigits() > fPmtMinHitsPerCluster) {
              if( cdigit->IsAllClustered()==0 ){
@@ -697,6 +623,131 @@ std::vector<RecoCluster*>* HitCleaner::RecoClusters(std::vector<RecoDigit*>* myD
   return fClusterList;
 }
 
+void HitCleaner::CountNeighboursLegacy(std::vector<RecoDigit*>* myDigitList, std::vector<int>& numNeighbours)
+{
+  for(int idigit1=0; idigit1<int(myDigitList->size()); idigit1++ ){
+  	RecoDigit* fdigit1 = (RecoDigit*)(myDigitList->at(idigit1));
+  	int digit1Type = fdigit1->GetDigitType();
+    for(int idigit2=idigit1+1; idigit2<int(myDigitList->size()); idigit2++ ){
+      RecoDigit* fdigit2 = (RecoDigit*)(myDigitList->at(idigit2));
+      int digit2Type = fdigit2->GetDigitType();
+
+      double dx = fdigit1->GetPosition().X() - fdigit2->GetPosition().X();
+      double dy = fdigit1->GetPosition().Y() - fdigit2->GetPosition().Y();
+      double dz = fdigit1->GetPosition().Z() - fdigit2->GetPosition().Z();
+      double dt = fdigit1->GetCalTime() - fdigit2->GetCalTime();
+      double drsq = dx*dx + dy*dy + dz*dz;
+      
+      if(digit1Type == RecoDigit::PMT8inch && digit2Type == RecoDigit::PMT8inch) {
+        if( drsq>0.0
+         && drsq<fPmtNeighbourRadius*fPmtNeighbourRadius
+         && fabs(dt)<fPmtTimeWindowN ){
+          numNeighbours[idigit1]++;
+          numNeighbours[idigit2]++;
+        }	
+      }
+      
+      if(digit1Type == RecoDigit::lappd_v0 && digit2Type == RecoDigit::lappd_v0) {
+        if( drsq>0.0
+         && drsq<fLappdNeighbourRadius*fLappdNeighbourRadius
+         && fabs(dt)<fLappdTimeWindowN ){
+          numNeighbours[idigit1]++;
+          numNeighbours[idigit2]++;
+        }	
+      }
+      
+      if(digit1Type == RecoDigit::PMT8inch && digit2Type == RecoDigit::lappd_v0) {
+        if( drsq>0.0
+            && drsq<fPmtNeighbourRadius*fPmtNeighbourRadius
+            && fabs(dt)<fPmtTimeWindowN ){
+          numNeighbours[idigit1]++;
+        }	
+        if( drsq>0.0
+            && drsq<fLappdNeighbourRadius*fLappdNeighbourRadius
+            && fabs(dt)<fLappdTimeWindowN ){
+          numNeighbours[idigit2]++;
+        }	   
+      }
+
+      if(digit1Type == RecoDigit::lappd_v0 && digit2Type == RecoDigit::PMT8inch) {
+        if( drsq>0.0
+            && drsq<fLappdNeighbourRadius*fLappdNeighbourRadius
+            && fabs(dt)<fLappdTimeWindowN ){
+          numNeighbours[idigit1]++;
+        }	
+        if( drsq>0.0
+            && drsq<fPmtNeighbourRadius*fPmtNeighbourRadius
+            && fabs(dt)<fPmtTimeWindowN ){
+          numNeighbours[idigit2]++;
+        }	   
+      }
+    }
+  }
+}
+
+void HitCleaner::LinkClusterDigitsLegacy()
+{
+  for(int idigit1=0; idigit1<int(vClusterDigitList.size()); idigit1++){
+  	RecoClusterDigit* fdigit1 = (RecoClusterDigit*)(vClusterDigitList.at(idigit1));
+  	int digit1Type = fdigit1->GetDigitType();
+    for(int idigit2=idigit1+1; idigit2<int(vClusterDigitList.size()); idigit2++ ){
+
+      RecoClusterDigit* fdigit2 = (RecoClusterDigit*)(vClusterDigitList.at(idigit2));
+      int digit2Type = fdigit2->GetDigitType();
+
+      double dx = fdigit1->GetX() - fdigit2->GetX();
+      double dy = fdigit1->GetY() - fdigit2->GetY();
+      double dz = fdigit1->GetZ() - fdigit2->GetZ();
+      double dt = fdigit1->GetTime() - fdigit2->GetTime();
+      double drsq = dx*dx + dy*dy + dz*dz;
+      if(digit1Type == RecoDigit::PMT8inch && digit2Type == RecoDigit::PMT8inch) {
+        if( drsq>0.0
+         && drsq<fPmtClusterRadius*fPmtClusterRadius
+         && fabs(dt)<fPmtTimeWindowC ){
+          fdigit1->AddClusterDigit(fdigit2);
+          fdigit2->AddClusterDigit(fdigit1);
+        }	
+      }
+      
+      if(digit1Type == RecoDigit::lappd_v0 && digit2Type == RecoDigit::lappd_v0) {
+        if( drsq>0.0
+         && drsq<fLappdClusterRadius*fLappdClusterRadius
+         && fabs(dt)<fLappdTimeWindowC ){
+          fdigit1->AddClusterDigit(fdigit2);
+          fdigit2->AddClusterDigit(fdigit1);
+        }	
+      }
+      
+      if(digit1Type == RecoDigit::PMT8inch && digit2Type == RecoDigit::lappd_v0) {
+        if( drsq>0.0
+         && drsq<fPmtClusterRadius*fPmtClusterRadius
+         && fabs(dt)<fPmtTimeWindowC ){
+          fdigit1->AddClusterDigit(fdigit2);
+        }	
+        if( drsq>0.0
+         && drsq<fLappdClusterRadius*fLappdClusterRadius
+         && fabs(dt)<fLappdTimeWindowC ){
+          fdigit2->AddClusterDigit(fdigit1);
+        }
+      }
+      
+      if(digit1Type == RecoDigit::lappd_v0 && digit2Type == RecoDigit::PMT8inch) {
+        if( drsq>0.0
+         && drsq<fLappdClusterRadius*fLappdClusterRadius
+         && fabs(dt)<fLappdTimeWindowC ){
+          fdigit1->AddClusterDigit(fdigit2);
+        }	
+        if( drsq>0.0
+         && drsq<fPmtClusterRadius*fPmtClusterRadius
+         && fabs(dt)<fPmtTimeWindowC ){
+          fdigit2->AddClusterDigit(fdigit1);
+        }	
+      }
+      
+    }
+  }
+}
+
 std::vector<RecoDigit*>* HitCleaner::FilterByTruthInfo(std::vector<RecoDigit*>* DigitList)
 {
 	std::string name = " HitCleaner::FilterByTruthInfo(() ";
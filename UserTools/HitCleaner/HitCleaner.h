@@ -8,6 +8,7 @@
 #include "Tool.h"
 #include "RecoCluster.h"
 #include "RecoClusterDigit.h"
+#include "DigitNeighbourIndex.h"
 #include "TString.h"
 
 class HitCleaner: public Tool {
@@ -69,6 +70,11 @@ class HitCleaner: public Tool {
   std::vector<RecoDigit*>* FilterByTruthInfo(std::vector<RecoDigit*>* digitlist); //use truth information. Only for testing the code
   std::vector<RecoCluster*>* RecoClusters(std::vector<RecoDigit*>* digitlist);
 
+  // Original pairwise versions of the neighbour counting and cluster linking,
+  // selected with NeighbourSearch Legacy
+  void CountNeighboursLegacy(std::vector<RecoDigit*>* digitlist, std::vector<int>& numNeighbours);
+  void LinkClusterDigitsLegacy();
+
 
  private:
   void Reset();
@@ -97,6 +103,9 @@ class HitCleaner: public Tool {
   int    fMinClusterDigits;
   bool   fisMC;
 
+  // neighbour search: "Index" (space-time index) or "Legacy" (all digit pairs)
+  std::string fNeighbourSearch = "Index";
+
   // p.e. conversion parameters
   std::map<int,unsigned long> pmt_tubeid_to_channelkey;
   std::map<unsigned long, double> pmt_gains;
@@ -106,9 +115,13 @@ class HitCleaner: public Tool {
   std::map<std::string, double>* fHitCleaningParam = nullptr;
 
   // internal containers
-  std::vector<Double_t> vNdigitsCluster;  
   std::vector<RecoClusterDigit*> vClusterDigitList;
   std::vector<RecoClusterDigit*> vClusterDigitCollection;
+  // cluster digits are reused between events; vClusterDigitList points into the pool
+  std::vector<RecoClusterDigit*> vClusterDigitPool;
+  DigitNeighbourIndex fNeighbourIndex;
+  std::vector<int> vNeighbours;
+  std::vector<int> vNumNeighbours;
 
   // vectors of filtered digitss
   std::vector<RecoDigit*>* fFilterAll;
@@ -1,7 +1,7 @@
 #include "LAPPDSim.h"
 #include <unistd.h>
 
-LAPPDSim::LAPPDSim():Tool(),myTR(nullptr),_tf(nullptr),_event_counter(0),_file_number(0),_display_config(0),_is_artificial(false),_display(nullptr),_geom(nullptr),LAPPDWaveforms(nullptr)
+LAPPDSim::LAPPDSim():Tool(),myTR(nullptr),_tf(nullptr),_event_counter(0),_file_number(0),_display_config(0),_is_artificial(false),_display(nullptr),_geom(nullptr),LAPPDWaveforms(nullptr),_response_tables(nullptr),_table_response(nullptr),_n_photons(0),_response_time(0.)
 {
 }
 
@@ -16,12 +16,18 @@ bool LAPPDSim::Initialise(std::string configfile, DataModel &data)
 
 	//Get the config parameters and print them
 
-	//File path to pulsecharacteristics.root
-  std::string pulsecharacteristicsFile;
+	//File path to pulsecharacteristics.root (by default the copy in the tool directory)
+	std::string pulsecharacteristicsFile = "./UserTools/LAPPDSim/pulsecharacteristics.root";
 	m_variables.Get("PathToPulsecharacteristics", pulsecharacteristicsFile);
 	std::cout << "Path to pulsecharacteristics.root: " << pulsecharacteristicsFile << std::endl;
 	const char * pulsecharacteristicsFileChar = pulsecharacteristicsFile.c_str();
 
+	//Table (default): response from tables loaded once; Histogram: the original ROOT histogram based response
+	_response_mode = "Table";
+	m_variables.Get("ResponseMode", _response_mode);
+	if (_response_mode != "Table" && _response_mode != "Histogram") _response_mode = "Table";
+	std::cout << "ResponseMode " << _response_mode << std::endl;
+
 	//Config number for the displaying
 	m_variables.Get("EventDisplay", _display_config);
 	std::cout << "DisplayNumber " << _display_config << std::endl;
@@ -60,6 +66,23 @@ bool LAPPDSim::Initialise(std::string configfile, DataModel &data)
 	// initialize the ROOT random number generator
 	myTR = new TRandom3();
 	_tf = new TFile(pulsecharacteristicsFileChar, "READ");
+	if (_tf->IsZombie())
+	{
+		std::cerr << "LAPPDSim Tool: Could not open " << pulsecharacteristicsFile << std::endl;
+		return false;
+	}
+
+	if (_response_mode == "Table")
+	{
+		_response_tables = new LAPPDResponseTables();
+		if (!_response_tables->Load(_tf))
+		{
+			std::cerr << "LAPPDSim Tool: Could not read the pulse characteristics from " << pulsecharacteristicsFile << std::endl;
+			return false;
+		}
+		_table_response = new LAPPDresponse();
+		_table_response->Initialise(_response_tables, myTR);
+	}
 
 	if (_display_config > 0)
 	{
@@ -199,7 +222,7 @@ bool LAPPDSim::Execute()
 			unsigned long actualTubeNo = thelappd->GetDetectorID();
 
 			//Get the Hits on the LAPPD
-			vector<MCLAPPDHit> mchits = itr->second;
+			vector<MCLAPPDHit>& mchits = itr->second;
 
 			//If display is active, draw histograms showing the MC hits on the LAPPDs
 			if (_display_config > 0)
@@ -207,9 +230,14 @@ bool LAPPDSim::Execute()
 				_display->MCTruthDrawing(_event_counter, actualTubeNo, mchits);
 			}
 
+			std::chrono::steady_clock::time_point responsestart = std::chrono::steady_clock::now();
+
 			//Create an object of the LAPPDresponse class, which is used for the electronics simulation
-			LAPPDresponse response;
-			response.Initialise(_tf);
+			//(or reuse the table based one)
+			LAPPDresponse histogramresponse;
+			if (_table_response) _table_response->Reset();
+			else histogramresponse.Initialise(_tf);
+			LAPPDresponse& response = (_table_response) ? *_table_response : histogramresponse;
 
 			//loop over the hits on each lappd
 			for (int j = 0; j < mchits.size(); j++)
@@ -239,6 +267,8 @@ bool LAPPDSim::Execute()
 				Waveform<double> awav = response.GetTrace(i, 0.0, 100, 256, 1.0);
 				Vwavs.push_back(awav);
 			}
+			_n_photons += mchits.size();
+			_response_time += std::chrono::duration<double>(std::chrono::steady_clock::now() - responsestart).count();
 
 			//Get the channels of each LAPPD
 			std::map<unsigned long, Channel>* lappdchannel = thelappd->GetChannels();
@@ -301,6 +331,14 @@ bool LAPPDSim::Execute()
 
 bool LAPPDSim::Finalise()
 {
+	if (_n_photons > 0)
+	{
+		std::cout << "LAPPDSim: simulated " << _n_photons << " photons in " << _response_time << " s with the " << _response_mode << " response";
+		if (_response_time > 0.) std::cout << " (" << _n_photons / _response_time << " photons/s)";
+		std::cout << std::endl;
+	}
+	delete _table_response;
+	delete _response_tables;
 	_tf->Close();
 	_display->~LAPPDDisplay();
 	return true;
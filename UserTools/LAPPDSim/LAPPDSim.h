@@ -3,6 +3,7 @@
 
 #include <string>
 #include <iostream>
+#include <chrono>
 
 #include "Geometry.h"
 #include "Detector.h"
@@ -41,6 +42,13 @@ class LAPPDSim: public Tool {
    LAPPDDisplay* _display;
    Geometry* _geom;
    std::map<unsigned long, Waveform<double> >* LAPPDWaveforms;
+   // ResponseMode Table: the response tables are loaded once and a single
+   // LAPPDresponse is reused for all LAPPDs (Histogram: one per LAPPD, as before)
+   std::string _response_mode;
+   LAPPDResponseTables* _response_tables;
+   LAPPDresponse* _table_response;
+   long _n_photons;
+   double _response_time;   // time spent simulating the LAPPD response, in s
 
 };
 
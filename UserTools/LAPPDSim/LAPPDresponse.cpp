@@ -7,11 +7,12 @@
 #include <vector>
 #include <iostream>
 #include <cmath>
+#include <algorithm>
 
 
 //ClassImp(LAPPDresponse)
 
-LAPPDresponse::LAPPDresponse()
+LAPPDresponse::LAPPDresponse():_templatepulse(nullptr),_PHD(nullptr),_pulsewidth(nullptr),_tables(nullptr),mrand(nullptr),_ownsrand(false)
 {
 /************************************************************************************************************************
   Had to move this part to an own function because otherwise the constructor opens the TFile for every WCSim event.
@@ -41,7 +42,7 @@ LAPPDresponse::LAPPDresponse()
 }
 LAPPDresponse::~LAPPDresponse()
 {
-
+  if(_ownsrand) delete mrand;
 }
 
 void LAPPDresponse::Initialise(TFile* tf){
@@ -60,13 +61,26 @@ void LAPPDresponse::Initialise(TFile* tf){
   //_pulseCluster = new LAPPDpulseCluster()  This is no longer needed, kept for reference for now
 
   // random numbers for generating noise
+  if(_ownsrand) delete mrand;
   mrand = new TRandom3();
+  _ownsrand = true;
+}
+
+void LAPPDresponse::Initialise(const LAPPDResponseTables* tables, TRandom3* rand){
+  _tables = tables;
+  if(_ownsrand) delete mrand;
+  _ownsrand = (rand==nullptr);
+  mrand = (rand) ? rand : new TRandom3();
+}
+
+void LAPPDresponse::Reset(){
+  LAPPDPulseCluster.clear();
 }
 
 void LAPPDresponse::AddSinglePhotonTrace(double trans, double para, double time)
 {
   // Draw a random value for the peak signal peak
-  double peak = (_PHD->GetRandom())/10.;
+  double peak = (_tables) ? (_tables->PHD.Sample(mrand->Rndm()))/10. : (_PHD->GetRandom())/10.;
 
   // find nearest strip
   int neareststripnum = this->FindStripNumber(trans);
@@ -77,20 +91,24 @@ void LAPPDresponse::AddSinglePhotonTrace(double trans, double para, double time)
   //std::cout<<"THE PEAK "<<peak<<std::endl;
 
   // width of the charge sharing
-  double thesigma =  _pulsewidth->Interpolate(offcenter);
+  double thesigma = (_tables) ? _tables->pulsewidth.Interpolate(offcenter) : _pulsewidth->Interpolate(offcenter);
 
   //std::cout << "/* message */" << '\n';std::cout<<"nearest stripnum: "<<neareststripnum<<" off center: "<<offcenter<<" thesigma "<<thesigma<<std::endl;
 
-  TF1* theChargeSpread = new TF1("theChargeSpread","gaus",-100,100);
-  theChargeSpread->SetParameter(0,peak);
-  theChargeSpread->SetParameter(1,0.0);
-  theChargeSpread->SetParameter(2,thesigma);
+  // with the tables the gaussian is evaluated directly
+  TF1* theChargeSpread = nullptr;
+  if(!_tables){
+    theChargeSpread = new TF1("theChargeSpread","gaus",-100,100);
+    theChargeSpread->SetParameter(0,peak);
+    theChargeSpread->SetParameter(1,0.0);
+    theChargeSpread->SetParameter(2,thesigma);
+  }
 
   // calculate distances and times in the parallel direction
   double leftdistance = fabs(-114.554 - para); // annode is 229.108 mm in parallel direction
   double rightdistance = fabs(114.554 - para);
 
-  if(leftdistance+rightdistance!=229.108) std::cout<<"WHAT!? "<<(leftdistance+rightdistance)<<std::endl;;
+  if(fabs(leftdistance+rightdistance-229.108)>1e-6) std::cout<<"WHAT!? "<<(leftdistance+rightdistance)<<std::endl;;
 
   double lefttime = leftdistance/(0.53*(0.299792458)); // 53% speed of light (picoseconds per mm) on transmission lines
   double righttime = rightdistance/(0.53*(0.299792458)); // 53% speed of light (picoseconds per mm) on transmission lines
@@ -102,7 +120,8 @@ void LAPPDresponse::AddSinglePhotonTrace(double trans, double para, double time)
 
     int wstrip = (neareststripnum-2)+i;
     double wtrans = this->StripCoordinate(wstrip);
-    double wspeak = theChargeSpread->Eval(trans-wtrans);
+    double dtrans = trans-wtrans;
+    double wspeak = (theChargeSpread) ? theChargeSpread->Eval(dtrans) : peak*exp(-0.5*(dtrans/thesigma)*(dtrans/thesigma));
 
     //signal has to be larger than 0.5 mV
     if( (wspeak>0.5) && (wstrip>0) && (wstrip<31) ) {
@@ -115,35 +134,12 @@ void LAPPDresponse::AddSinglePhotonTrace(double trans, double para, double time)
 
 
       LAPPDPulse pulse(tubeid, wstrip, (time + righttime)/1000., charge, wspeak, low, hi);  //SD
-      if(LAPPDPulseCluster.count(wstrip)==1){
-        std::vector<LAPPDPulse> tempVector;
-        tempVector = LAPPDPulseCluster.at(wstrip);
-        tempVector.push_back (pulse);
-        LAPPDPulseCluster.at(wstrip)=tempVector;
-        //add pulse to already existing vector at key  SD
-      }
-      else{
-        std::vector<LAPPDPulse> PulseVector ;
-        PulseVector.push_back (pulse);
-        LAPPDPulseCluster.insert (std::pair<int,vector<LAPPDPulse>>(wstrip,PulseVector) );//SD
-        //create vector at key and add pulse into that vector SD
-      }
+      //add pulse to the vector at key (created if needed)  SD
+      LAPPDPulseCluster[wstrip].push_back(pulse);
 
       pulse.SetChannelID(-1.0*wstrip); //SD
       pulse.SetTime((time +lefttime)/1000.); //SD
-      if(LAPPDPulseCluster.count(-wstrip)==1){
-        std::vector<LAPPDPulse> tempVector;
-        tempVector = LAPPDPulseCluster.at(-wstrip);
-        tempVector.push_back (pulse);
-        LAPPDPulseCluster.at(-wstrip)=tempVector;
-        //add pulse to already existing vector at key  SD
-      }
-      else{
-        std::vector<LAPPDPulse> PulseVector ;
-        PulseVector.push_back (pulse);
-        LAPPDPulseCluster.insert (std::pair<int,vector<LAPPDPulse>>(-wstrip,PulseVector) );   //SD
-        //create vector at key and add pulse into that vector SD
-      }
+      LAPPDPulseCluster[-wstrip].push_back(pulse);
     }
   }
 
@@ -154,6 +150,7 @@ void LAPPDresponse::AddSinglePhotonTrace(double trans, double para, double time)
 
 Waveform<double> LAPPDresponse::GetTrace(int CHnumber, double starttime, double samplesize, int numsamples, double thenoise)
 {
+  if(_tables) return GetTraceFromTables(CHnumber, starttime, samplesize, numsamples, thenoise);
 
   // parameters for the histogram of the scope trace
   double lowend = (starttime-(samplesize/2.));
@@ -244,6 +241,115 @@ Waveform<double> LAPPDresponse::GetTrace(int CHnumber, double starttime, double
 }
 
 
+Waveform<double> LAPPDresponse::GetTraceFromTables(int CHnumber, double starttime, double samplesize, int numsamples, double thenoise)
+{
+  // same sampling as the histogram in GetTrace: sample j is taken at the
+  // center of bin j+1 of (starttime-samplesize/2, ...)
+  double lowend = (starttime-(samplesize/2.));
+  double upend = lowend + samplesize*((double)numsamples);
+  double binwidth = (upend-lowend)/numsamples;
+
+  // white noise, added once per sample
+  std::vector<double> samples(numsamples);
+  for(int j=0; j<numsamples; j++) samples[j] = thenoise*(mrand->Rndm()-0.5);
+
+  std::map<int, vector<LAPPDPulse> >::iterator strippulses = LAPPDPulseCluster.find(CHnumber);
+  if(strippulses!=LAPPDPulseCluster.end()){
+    for(LAPPDPulse& apulse : strippulses->second){
+      double peakv = apulse.GetPeak();
+      double tottime = apulse.GetTime()*1000.;
+
+      // only the samples in the 3 ns after the pulse arrival get a contribution
+      double jfirst = std::min((double)numsamples, std::max(0., std::floor((tottime-lowend)/binwidth - 0.5)));
+      double jlast = std::max(-1., std::min((double)numsamples-1., std::ceil((tottime+3000-lowend)/binwidth - 0.5)));
+      for(int j=(int)jfirst; j<=(int)jlast; j++){
+        double bcent = lowend + (j+0.5)*binwidth;
+        if( (bcent > tottime) && (bcent< tottime+3000) ) samples[j] += peakv*_tables->templatepulse.Interpolate(bcent-tottime);
+      }
+    }
+  }
+
+  return Waveform<double>(0., std::move(samples));
+}
+
+
+bool LAPPDResponseTable::Load(TH1* hist)
+{
+  if(!hist || hist->GetNbinsX()<1) return false;
+  int nbins = hist->GetNbinsX();
+  _centers.resize(nbins);
+  _contents.resize(nbins);
+  for(int i=0; i<nbins; i++){
+    _centers[i] = hist->GetBinCenter(i+1);
+    _contents[i] = hist->GetBinContent(i+1);
+  }
+  _firstcenter = _centers[0];
+  _binwidth = (nbins>1) ? (_centers[nbins-1]-_centers[0])/(nbins-1) : 1.;
+  _uniform = true;
+  for(int i=1; i<nbins; i++){
+    if(fabs((_centers[i]-_centers[i-1])-_binwidth) > 1e-9*fabs(_binwidth)) _uniform = false;
+  }
+  return true;
+}
+
+double LAPPDResponseTable::Interpolate(double x) const
+{
+  // constant outside the first and last bin centers
+  if(x<=_centers.front()) return _contents.front();
+  if(x>=_centers.back()) return _contents.back();
+
+  // bin i such that _centers[i] <= x < _centers[i+1]
+  size_t i;
+  if(_uniform){
+    i = (size_t)((x-_firstcenter)/_binwidth);
+    if(i>_centers.size()-2) i = _centers.size()-2;
+    if(x<_centers[i]) i--;
+    else if(x>=_centers[i+1]) i++;
+  }
+  else i = std::upper_bound(_centers.begin(), _centers.end(), x) - _centers.begin() - 1;
+
+  return _contents[i] + (x-_centers[i])*((_contents[i+1]-_contents[i])/(_centers[i+1]-_centers[i]));
+}
+
+
+bool LAPPDResponseCDF::Load(TH1* hist)
+{
+  if(!hist || hist->GetNbinsX()<1) return false;
+  int nbins = hist->GetNbinsX();
+  _edges.resize(nbins+1);
+  _integral.resize(nbins+1);
+  _integral[0] = 0.;
+  for(int i=0; i<nbins; i++){
+    _edges[i] = hist->GetBinLowEdge(i+1);
+    _integral[i+1] = _integral[i] + hist->GetBinContent(i+1);
+  }
+  _edges[nbins] = hist->GetBinLowEdge(nbins) + hist->GetBinWidth(nbins);
+  if(!(_integral[nbins]>0.)) return false;
+  for(double& value : _integral) value /= _integral[nbins];
+  return true;
+}
+
+double LAPPDResponseCDF::Sample(double r) const
+{
+  // last bin whose cumulative integral is <= r
+  size_t i = std::upper_bound(_integral.begin(), _integral.end(), r) - _integral.begin();
+  i = (i>0) ? i-1 : 0;
+  if(i>_edges.size()-2) i = _edges.size()-2;
+  double x = _edges[i];
+  if(r>_integral[i] && _integral[i+1]>_integral[i]) x += (_edges[i+1]-_edges[i])*(r-_integral[i])/(_integral[i+1]-_integral[i]);
+  return x;
+}
+
+
+bool LAPPDResponseTables::Load(TFile* tf)
+{
+  if(!tf || tf->IsZombie()) return false;
+  return templatepulse.Load((TH1*) tf->Get("templatepulse"))
+      && PHD.Load((TH1*) tf->Get("PHD"))
+      && pulsewidth.Load((TH1*) tf->Get("pulsewidth"));
+}
+
+
 int LAPPDresponse::FindStripNumber(double trans){
 
   double newtrans = trans + 101.6;
@@ -7,10 +7,59 @@
 #include "TH1.h"
 #include "TRandom3.h"
 #include <map>
+#include <vector>
 #include "Tool.h"
 #include "LAPPDPulse.h"
 #include "Waveform.h"
 #include "TFile.h"
+
+// A TH1 as a plain piecewise linear function through its bin centers,
+// giving the same values as TH1::Interpolate
+class LAPPDResponseTable {
+
+ public:
+
+  bool Load(TH1* hist);
+  double Interpolate(double x) const;
+
+ private:
+
+  std::vector<double> _centers;
+  std::vector<double> _contents;
+  bool _uniform = false;   // fixed bin width: find the bin without a search
+  double _firstcenter = 0.;
+  double _binwidth = 1.;
+
+};
+
+// A TH1 as a cumulative distribution, sampled by inverse-CDF lookup in the
+// same way as TH1::GetRandom (linear within a bin)
+class LAPPDResponseCDF {
+
+ public:
+
+  bool Load(TH1* hist);
+  double Sample(double r) const;   // r uniform in [0,1)
+
+ private:
+
+  std::vector<double> _edges;
+  std::vector<double> _integral;   // normalised, _integral[0]=0
+
+};
+
+// Template pulse, pulse height distribution and charge spread width from
+// pulsecharacteristics.root, read once and shared by all LAPPDresponse objects
+struct LAPPDResponseTables {
+
+  bool Load(TFile* tf);
+
+  LAPPDResponseTable templatepulse;
+  LAPPDResponseCDF PHD;
+  LAPPDResponseTable pulsewidth;
+
+};
+
 //class LAPPDresponse : public TObject {
 class LAPPDresponse {
 
@@ -22,6 +71,14 @@ class LAPPDresponse {
 
   void Initialise(TFile* tf);
 
+  // Use tables loaded once instead of the histograms: no ROOT objects are
+  // created per photon or per trace. rand is used for all random numbers
+  // (a new TRandom3 if none is given).
+  void Initialise(const LAPPDResponseTables* tables, TRandom3* rand=nullptr);
+
+  // Remove all pulses, e.g. before simulating the next LAPPD
+  void Reset();
+
   void AddSinglePhotonTrace(double trans, double para, double time);
 
   Waveform<double> GetTrace(int CHnumber, double starttime, double samplesize, int numsamples, double thenoise);
@@ -52,12 +109,17 @@ class LAPPDresponse {
 
   //  LAPPDpulseCluster* _pulseCluster;
 
+  //tables used instead of the histograms above, if set
+  const LAPPDResponseTables* _tables;
+
   //randomizer
   TRandom3* mrand;
+  bool _ownsrand;
 
   //useful functions
   int FindNearestStrip(double trans);
   double TransStripCenter(int CHnum);
+  Waveform<double> GetTraceFromTables(int CHnumber, double starttime, double samplesize, int numsamples, double thenoise);
 
   //  ClassDef(LAPPDresponse,0)
 
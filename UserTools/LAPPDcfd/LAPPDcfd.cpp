@@ -18,6 +18,17 @@ bool LAPPDcfd::Initialise(std::string configfile, DataModel &data){
   // Get the CFD threshold from the config file
   m_variables.Get("Fraction_CFD", Fraction_CFD);
   //std::cout<<"Fraction_CFD="<<Fraction_CFD<<std::endl;
+  m_variables.Get("CFDEngine", CFDEngine);
+  m_variables.Get("CFDInterpolation", CFDInterpolation);
+  m_variables.Get("BenchmarkCFD", BenchmarkCFD);
+  if(CFDEngine!="Samples" && CFDEngine!="Legacy"){
+    std::cout<<"LAPPDcfd: CFDEngine "<<CFDEngine<<" not recognized, using Samples"<<std::endl;
+    CFDEngine = "Samples";
+  }
+  if(CFDInterpolation!="linear" && CFDInterpolation!="cubic"){
+    std::cout<<"LAPPDcfd: CFDInterpolation "<<CFDInterpolation<<" not recognized, using linear"<<std::endl;
+    CFDInterpolation = "linear";
+  }
 
   isSim=false;
   // Check in the Boost Store whether this is a simulated event or not
@@ -49,6 +60,12 @@ bool LAPPDcfd::Execute(){
   // Place to store the reconstructed pulses
   std::map<int,vector<LAPPDPulse>> CFDRecoLAPPDPulses;
 
+  if(CFDEngine=="Samples"){
+    CFDBatch(rawlappddata,SimpleRecoLAPPDPulses,CFDRecoLAPPDPulses);
+    m_data->Stores["ANNIEEvent"]->Set("CFDRecoLAPPDPulses",CFDRecoLAPPDPulses);
+    return true;
+  }
+
   // Loop over all channels
   map <int, vector<Waveform<double>>> :: iterator itr;
   for (itr = rawlappddata.begin(); itr != rawlappddata.end(); ++itr){
@@ -118,10 +135,126 @@ bool LAPPDcfd::Execute(){
 
 bool LAPPDcfd::Finalise(){
 
+  if(BenchmarkCFD && bench_pulses>0){
+    std::cout<<"LAPPDcfd benchmark: "<<bench_pulses<<" pulses, TH1D engine "
+      <<bench_pulses/bench_legacy_s<<" pulses/s, sample engine ("<<CFDInterpolation<<") "
+      <<bench_pulses/bench_samples_s<<" pulses/s"<<std::endl;
+    std::cout<<"LAPPDcfd benchmark: "<<bench_mismatches<<" pulses with different CFD times, max |dt| = "
+      <<bench_maxdiff<<" ps"<<std::endl;
+  }
   return true;
 }
 
 
+void LAPPDcfd::CFDBatch(const std::map<int,vector<Waveform<double>>>& lappddata,
+  std::map<int,vector<LAPPDPulse>>& pulses, std::map<int,vector<LAPPDPulse>>& cfdpulses){
+
+  for(auto itr = lappddata.begin(); itr != lappddata.end(); ++itr){
+    int channelno = itr->first;
+    const vector<Waveform<double>>& Vwavs = itr->second;
+    std::vector<LAPPDPulse> thepulses;
+
+    // the pulses found on this channel by LAPPDFindPeak
+    auto p = pulses.find(channelno);
+    if(p != pulses.end()){
+      vector<LAPPDPulse>& Vpulses = p->second;
+      thepulses.reserve(Vwavs.size()*Vpulses.size());
+
+      for(size_t i=0; i<Vwavs.size(); i++){
+        const std::vector<double>& samples = Vwavs.at(i).Samples();
+        cfd_samples.resize(samples.size());
+        for(size_t k=0; k<samples.size(); k++) cfd_samples[k] = -samples[k];
+
+        for(size_t j=0; j<Vpulses.size(); j++){
+          LAPPDPulse& pulse = Vpulses.at(j);
+          double cfdtime;
+          if(!BenchmarkCFD){
+            cfdtime = CFD_Samples(pulse);
+          } else {
+            std::vector<double> trace(samples);
+            auto start = std::chrono::steady_clock::now();
+            double legacytime = CFD_Discriminator1(&trace,pulse);
+            auto mid = std::chrono::steady_clock::now();
+            cfdtime = CFD_Samples(pulse);
+            auto stop = std::chrono::steady_clock::now();
+            bench_legacy_s += std::chrono::duration<double>(mid-start).count();
+            bench_samples_s += std::chrono::duration<double>(stop-mid).count();
+            bench_pulses++;
+            double diff = fabs(cfdtime-legacytime);
+            if(diff>0.) bench_mismatches++;
+            if(diff>bench_maxdiff) bench_maxdiff = diff;
+          }
+          thepulses.emplace_back(0,channelno,(cfdtime/1000.),pulse.GetCharge(),pulse.GetPeak(),pulse.GetLowRange(),pulse.GetHiRange());
+        }
+      }
+    }
+    cfdpulses.emplace(channelno,std::move(thepulses));
+  }
+}
+
+
+double LAPPDcfd::CFD_Samples(LAPPDPulse& pulse){
+
+  if(cfd_samples.empty()) return 0.;
+
+  // same search as CFD_Discriminator1: bisect the fit window for the point
+  // where the inverted trace crosses the fraction of the peak amplitude
+  double th = Fraction_CFD * pulse.GetPeak();
+  double eps = 1e-2;
+  double xlow = (pulse.GetLowRange()-5)*100.;
+  double xhigh = (pulse.GetHiRange()+5)*100.;
+  double xmid;
+  bool cubic = (CFDInterpolation=="cubic");
+
+  while ((xhigh-xlow) >= eps ){
+    xmid = (xlow + xhigh)/2.;
+    if ((InterpolateSamples(xmid,cubic)-th) > 0)
+    xhigh = xmid;
+    else
+    xlow = xmid;
+  }
+
+  return xlow;
+}
+
+
+double LAPPDcfd::InterpolateSamples(double x, bool cubic) const {
+
+  // bin layout of the TH1D in CFD_Discriminator1, so the linear interpolation
+  // gives the same values as TH1::Interpolate
+  int nbins = cfd_samples.size();
+  double xmin = 0.;
+  double xmax = xmin + ((double)nbins)*100.;
+  double binwidth = (xmax-xmin)/double(nbins);
+  double firstcentre = xmin + 0.5*binwidth;
+  double lastcentre = xmin + (nbins-1)*binwidth + 0.5*binwidth;
+
+  if(x <= firstcentre) return cfd_samples[0];
+  if(x >= lastcentre) return cfd_samples[nbins-1];
+
+  // lower of the two samples around x (0-based)
+  int xbin = 1 + int(nbins*(x-xmin)/(xmax-xmin));
+  int k = xbin-1;
+  double xk = xmin + k*binwidth + 0.5*binwidth;
+  if(x <= xk){
+    k--;
+    xk = xmin + k*binwidth + 0.5*binwidth;
+  }
+  double xk1 = xmin + (k+1)*binwidth + 0.5*binwidth;
+  double y0 = cfd_samples[k];
+  double y1 = cfd_samples[k+1];
+
+  if(cubic){
+    // Catmull-Rom spline through the neighbouring samples
+    double ym = (k>0) ? cfd_samples[k-1] : y0;
+    double y2 = (k+2<nbins) ? cfd_samples[k+2] : y1;
+    double u = (x-xk)/(xk1-xk);
+    return 0.5*((2.*y0) + (-ym+y1)*u + (2.*ym-5.*y0+4.*y1-y2)*u*u + (-ym+3.*y0-3.*y1+y2)*u*u*u);
+  }
+  return y0 + (x-xk)*((y1-y0)/(xk1-xk));
+}
+
+
 double	LAPPDcfd::CFD_Discriminator1(std::vector<double>* trace, LAPPDPulse pulse) {
 
   double amp = pulse.GetPeak();
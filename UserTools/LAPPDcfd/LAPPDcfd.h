@@ -3,6 +3,7 @@
 
 #include <string>
 #include <iostream>
+#include <chrono>
 #include "TSplineFit.h"
 #include "TPoly3.h"
 #include "LAPPDPulse.h"
@@ -24,12 +25,40 @@ class LAPPDcfd: public Tool {
   double CFD_Discriminator1(std::vector<double>* trace, LAPPDPulse pulse);
   double CFD_Discriminator2(std::vector<double>* trace, LAPPDPulse pulse);
 
+  // CFD_Discriminator1 on a plain array of samples, without ROOT histograms.
+  // The inverted trace must already be in cfd_samples (see CFDBatch).
+  double CFD_Samples(LAPPDPulse& pulse);
+
+  // Find the CFD time of every pulse on every waveform of all channels
+  void CFDBatch(const std::map<int,vector<Waveform<double>>>& lappddata,
+    std::map<int,vector<LAPPDPulse>>& pulses, std::map<int,vector<LAPPDPulse>>& cfdpulses);
+
 
  private:
+   // Value of the inverted trace at time x (ps): the samples sit at the bin centres
+   // of a histogram with 100 ps bins starting at 0, as in CFD_Discriminator1
+   double InterpolateSamples(double x, bool cubic) const;
+
    bool isSim;
    double Fraction_CFD;
    string CFDInputWavLabel;
 
+   // "Samples" (default) or "Legacy" (TH1D per pulse)
+   string CFDEngine = "Samples";
+   // "linear" (default, same times as the TH1D engine) or "cubic" (Catmull-Rom)
+   string CFDInterpolation = "linear";
+   // time both engines on every pulse and compare the times
+   bool BenchmarkCFD = false;
+
+   // inverted samples of the waveform being processed, reused between waveforms
+   std::vector<double> cfd_samples;
+
+   long bench_pulses = 0;
+   long bench_mismatches = 0;
+   double bench_maxdiff = 0.;
+   double bench_legacy_s = 0.;
+   double bench_samples_s = 0.;
+
 
 };
 
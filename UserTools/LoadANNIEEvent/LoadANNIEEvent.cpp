@@ -1,5 +1,6 @@
 // standard library includes
 #include <fstream>
+#include <sstream>
 
 // ToolAnalysis includes
 #include "LoadANNIEEvent.h"
@@ -18,6 +19,25 @@ bool LoadANNIEEvent::Initialise(std::string config_filename, DataModel &data) {
   m_variables.Get("verbose", verbosity_);
   m_variables.Get("EventOffset", offset_evnum);
 
+  // Keys of the block files to load with every entry (comma-separated), "All"
+  // by default
+  std::string prefetch_keys = "All";
+  m_variables.Get("PrefetchKeys", prefetch_keys);
+  prefetch_all_keys_ = (prefetch_keys == "All");
+  if ( !prefetch_all_keys_ ) {
+    std::stringstream key_stream(prefetch_keys);
+    std::string key;
+    while ( std::getline(key_stream, key, ',') ) {
+      if ( !key.empty() ) prefetch_keys_.push_back(key);
+    }
+  }
+  load_seconds_ = 0.;
+  entries_loaded_ = 0u;
+  // The block file is not serialisable: pass its address, as for the other
+  // shared objects in the CStore. It is owned by this tool.
+  intptr_t block_file_ptr = reinterpret_cast<intptr_t>(&block_file_);
+  m_data->CStore.Set("ANNIEEventBlockFile", block_file_ptr);
+
   std::string input_list_filename;
   bool got_input_file_list = m_variables.Get("FileForListOfInputs",
     input_list_filename);
@@ -105,6 +125,25 @@ bool LoadANNIEEvent::Execute() {
     // get the number of entries
     m_data->Stores.at("ANNIEEvent")->Header->Get("TotalEntries",
       total_entries_in_file_);
+
+    // Open the block file of the bulky keys, if the file has one
+    std::string block_filename
+      = ANNIEEventBlockFile::BlockFileName(input_filename);
+    if ( std::ifstream(block_filename).good() ) {
+      if ( !block_file_.Open(block_filename) ) {
+        Log("Error: " + block_file_.error_message(), v_error, verbosity_);
+        return false;
+      }
+      if ( block_file_.num_entries() != total_entries_in_file_ ) {
+        Log("Error: " + block_filename + " has " + std::to_string(
+          block_file_.num_entries()) + " entries, the ANNIEEvent store has "
+          + std::to_string(total_entries_in_file_), v_error, verbosity_);
+        return false;
+      }
+      Log("Loading the keys of " + block_filename + " with the entries",
+        v_message, verbosity_);
+    }
+    else block_file_.Close();
     
 /*
     // same for Orphan Store
@@ -133,7 +172,24 @@ bool LoadANNIEEvent::Execute() {
  
   if (current_entry_ != offset_evnum) m_data->Stores["ANNIEEvent"]->Delete();	//ensures that we can access pointers without problems
 
+  auto load_start = std::chrono::steady_clock::now();
   m_data->Stores["ANNIEEvent"]->GetEntry(current_entry_);  
+  if ( block_file_.num_entries() > 0 ) {
+    block_file_.SetEntry(current_entry_);
+    const std::vector<std::string>& keys = prefetch_all_keys_
+      ? block_file_.keys() : prefetch_keys_;
+    for (const auto& key : keys) {
+      if ( block_file_.Has(key)
+        && !block_file_.Load(key, *m_data->Stores["ANNIEEvent"]) )
+      {
+        Log("Error: could not decode " + key + " from the block file for"
+          " entry " + std::to_string(current_entry_), v_error, verbosity_);
+      }
+    }
+  }
+  load_seconds_ += std::chrono::duration<double>(
+    std::chrono::steady_clock::now() - load_start).count();
+  ++entries_loaded_;
   ++current_entry_;
   
   if ( current_entry_ >= total_entries_in_file_ ) {
@@ -153,5 +209,13 @@ bool LoadANNIEEvent::Execute() {
 
 
 bool LoadANNIEEvent::Finalise() {
+  if ( entries_loaded_ > 0 && load_seconds_ > 0. ) {
+    Log("LoadANNIEEvent: loaded " + std::to_string(entries_loaded_)
+      + " entries in " + std::to_string(load_seconds_) + " s ("
+      + std::to_string(entries_loaded_ / load_seconds_) + " events/s), "
+      + std::to_string(block_file_.bytes_read() / 1024) + " kB read from"
+      " block files", v_warning, verbosity_);
+  }
+  block_file_.Close();
   return true;
 }
@@ -1,11 +1,13 @@
 #pragma once
 
 // standard library includes
+#include <chrono>
 #include <string>
 #include <vector>
 
 // ToolAnalysis includes
 #include "Tool.h"
+#include "ANNIEEventBlockFile.h"
 
 class LoadANNIEEvent: public Tool {
 
@@ -48,5 +50,19 @@ class LoadANNIEEvent: public Tool {
     /// @brief Flag indicating whether we need to load a new file
     bool need_new_file_;
 
+    /// @brief Keys kept in a separate block file next to the input file
+    /// (written by SaveANNIEEvent with BlockKeys), read only when requested
+    ANNIEEventBlockFile block_file_;
+
+    /// @brief Keys of the block file loaded with every entry. Other block keys
+    /// are loaded by the tools that need them through the block file pointer in
+    /// the CStore ("ANNIEEventBlockFile").
+    std::vector<std::string> prefetch_keys_;
+    bool prefetch_all_keys_;
+
+    /// @brief Time spent loading entries, for the events/second report
+    double load_seconds_;
+    size_t entries_loaded_;
+
     std::stringstream logmessage;
 };
@@ -24,6 +24,7 @@ bool LoadGeometry::Initialise(std::string configfile, DataModel &data){
   m_variables.Get("LAPPDGeoFile", fLAPPDGeoFile);
   m_variables.Get("DetectorGeoFile", fDetectorGeoFile);
   m_variables.Get("LAPPDChannelCount", LAPPD_channel_count);
+  m_variables.Get("BenchmarkChannelLookup", fBenchmarkLookups);
 
   //Check files exist
   if(!this->FileExists(fDetectorGeoFile)){
@@ -100,6 +101,13 @@ bool LoadGeometry::Initialise(std::string configfile, DataModel &data){
   m_data->CStore.Set("LAPPDCrateSpaceToChannelNumMap",LAPPDCrateSpaceToChannelNumMap);
    //AnnieGeometry->GetChannel(0); // trigger InitChannelMap
 
+  if(fBenchmarkLookups>0){
+    double maprate, tablerate;
+    AnnieGeometry->BenchmarkChannelLookup(fBenchmarkLookups, maprate, tablerate);
+    Log("LoadGeometry Tool: channel lookups per second: ChannelMap "+std::to_string(maprate)
+        +", LookupChannel "+std::to_string(tablerate),v_message,verbosity);
+  }
+
   return true;
 }
 
@@ -103,6 +103,9 @@ class LoadGeometry: public Tool {
   std::vector<std::string> AuxChannelIntegerValues{"channel_num","signal_crate","signal_slot","signal_channel"};
   std::vector<std::string> AuxChannelStringValues{"channel_type","notes"};
 
+  //Number of channel lookups to time after loading (0: no benchmark)
+  long fBenchmarkLookups=0;
+
   //verbosity levels: if 'verbosity' < this level, the message type will be logged.
   int verbosity=1;
   int v_error=0;
@@ -11,12 +11,20 @@ bool LoadRawData::Initialise(std::string configfile, DataModel &data){
 
   verbosity = 0;
   DummyRunInfo = false;
+  DecodeMode = "Sequential";
+  PipelineQueueSize = 100;
 
   m_variables.Get("verbosity",verbosity);
   m_variables.Get("BuildType",BuildType);
   m_variables.Get("Mode",Mode);
   m_variables.Get("InputFile",InputFile);
   m_variables.Get("DummyRunInfo",DummyRunInfo);
+  m_variables.Get("DecodeMode",DecodeMode);
+  m_variables.Get("PipelineQueueSize",PipelineQueueSize);
+  m_variables.Get("TimeWindowStart",TimeWindowStart);
+  m_variables.Get("TimeWindowEnd",TimeWindowEnd);
+  UseTimeWindow = (TimeWindowEnd > 0);
+  StartTime = std::chrono::steady_clock::now();
 
   m_data= &data; //assigning transient data pointer
   
@@ -28,6 +36,8 @@ bool LoadRawData::Initialise(std::string configfile, DataModel &data){
     }
     OrganizedFileList = this->OrganizeRunParts(InputFile);
     Log("LoadRawData tool: files to load have been organized.",v_message,verbosity);
+    //Used by the PMTDataDecoder to decode the part files in parallel (PartFileWorkers)
+    m_data->CStore.Set("RawDataFileList",OrganizedFileList);
   }
 
   //RawDataObjects
@@ -52,11 +62,31 @@ bool LoadRawData::Initialise(std::string configfile, DataModel &data){
   TrigEntriesCompleted = false;
 
   m_data->CStore.Set("FileProcessingComplete",false);
+
+  //Pipelined decoding: the decoder tools find the pipeline in the CStore in their
+  //Initialise, so LoadRawData must come before them in the ToolChain
+  if(DecodeMode == "Pipelined" && Mode != "SingleFile" && Mode != "FileList"){
+    Log("LoadRawData Tool: DecodeMode Pipelined is only available in SingleFile and FileList modes. Using Sequential decoding.",v_warning,verbosity);
+    DecodeMode = "Sequential";
+  }
+  if(DecodeMode == "Pipelined"){
+    if(PipelineQueueSize < 1) PipelineQueueSize = 100;
+    DecodePipeline = new RawDecodePipeline(PipelineQueueSize);
+    intptr_t DecodePipelinePtr = reinterpret_cast<intptr_t>(DecodePipeline);
+    m_data->CStore.Set("RawDecodePipeline",DecodePipelinePtr);
+    ReaderStats = PipelineStageStats();
+    Log("LoadRawData Tool: Pipelined decoding with queues of "+std::to_string(PipelineQueueSize)+" entries",v_message,verbosity);
+  } else if(DecodeMode != "Sequential"){
+    Log("LoadRawData Tool: DecodeMode "+DecodeMode+" not recognized. Using Sequential decoding.",v_warning,verbosity);
+    DecodeMode = "Sequential";
+  }
   return true;
 }
 
 
 bool LoadRawData::Execute(){
+  if(DecodePipeline) return this->ExecutePipelined();
+
   m_data->CStore.Set("NewRawDataEntryAccessed",false);
   m_data->CStore.Set("NewRawDataFileAccessed",false);
 
@@ -82,9 +112,15 @@ bool LoadRawData::Execute(){
     } else if (TankEntryNum==0 && MRDEntryNum == 0 && TrigEntryNum == 0){
       Log("LoadRawData Tool: Loading Raw Data file as BoostStore",v_message,verbosity); 
       RawData->Initialise(InputFile.c_str());
+      m_data->CStore.Set("RawDataFileName",InputFile);
+      //No entry of the new file has been loaded yet
+      m_data->CStore.Set("TankEntryNum",-1);
+      m_data->CStore.Set("MRDEntryNum",-1);
+      m_data->CStore.Set("TrigEntryNum",-1);
       if(verbosity>4) RawData->Print(false);
       this->LoadPMTMRDData();
       this->LoadTriggerData();
+      this->ApplyTimeWindow(InputFile);
       this->LoadRunInformation();
     } else {
       Log("LoadRawData Tool: Continuing Raw Data file processing",v_message,verbosity); 
@@ -103,9 +139,15 @@ bool LoadRawData::Execute(){
       Log("LoadRawData Tool: LoadingRaw Data file as BoostStore",v_debug,verbosity); 
       RawData->Initialise(CurrentFile.c_str());
       m_data->CStore.Set("NewRawDataFileAccessed",true);
+      m_data->CStore.Set("RawDataFileName",CurrentFile);
+      //No entry of the new file has been loaded yet
+      m_data->CStore.Set("TankEntryNum",-1);
+      m_data->CStore.Set("MRDEntryNum",-1);
+      m_data->CStore.Set("TrigEntryNum",-1);
       if(verbosity>4) RawData->Print(false);
       this->LoadPMTMRDData();
       this->LoadTriggerData();
+      this->ApplyTimeWindow(CurrentFile);
       this->LoadRunInformation();
     } else {
      if(verbosity>v_message) std::cout << "LoadRawDataTool: continuing file " << OrganizedFileList.at(FileNum) << std::endl;
@@ -173,14 +215,11 @@ bool LoadRawData::Execute(){
         }
       }
       // MRDData:
-      std::map<uint64_t, std::string>  MRDTriggerTypeMap;
-      get_ok = m_data->CStore.Get("MRDEventTriggerTypes",MRDTriggerTypeMap);
+      uint64_t MRDTimeStamp = 0;
+      get_ok = m_data->CStore.Get("MRDLatestTimestamp",MRDTimeStamp);
       TimeClass mm;
-      if(get_ok){
-        if(MRDTriggerTypeMap.size()){
-          uint64_t MRDTimeStamp = MRDTriggerTypeMap.rbegin()->first;
-          mm = TimeClass (MRDTimeStamp);
-        }
+      if(get_ok && MRDTimeStamp){
+        mm = TimeClass (MRDTimeStamp);
       }
       std::cout<<"Lates times are:\nTANK: "<<tt.AsString()<<"\nMRD:  "<<mm.AsString()
                <<"\nCTC:  "<<cc.AsString()<<std::endl;
@@ -231,6 +270,22 @@ bool LoadRawData::Execute(){
 
 
 bool LoadRawData::Finalise(){
+  if(DecodePipeline){
+    this->StopReader();
+    Log("LoadRawData Tool: Pipelined reader: "+ReaderStats.Summary(),v_warning,verbosity);
+    //Stop the decoder workers; the decoders join them in their Finalise and the
+    //last tool to release the pipeline deletes it
+    DecodePipeline->Shutdown(RawDecodePipeline::Tank);
+    DecodePipeline->Shutdown(RawDecodePipeline::MRD);
+    DecodePipeline->Shutdown(RawDecodePipeline::CTC);
+    RawDecodePipeline::Release(DecodePipeline);
+  }
+  if(UseTimeWindow){
+    double WallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now()-StartTime).count();
+    std::cout << "LoadRawData Tool: Time window " << TimeWindowStart << "-" << TimeWindowEnd << " ns: loaded " <<
+        WindowEntries[0] << "/" << WindowTotalEntries[0] << " PMT, " << WindowEntries[1] << "/" << WindowTotalEntries[1] <<
+        " MRD and " << WindowEntries[2] << "/" << WindowTotalEntries[2] << " trigger entries in " << WallSeconds << " s" << std::endl;
+  }
   RawData->Close();
   RawData->Delete();
   delete RawData;
@@ -403,18 +458,71 @@ bool LoadRawData::InitializeNewFile(){
   return EndOfProcessing;
 }
 
+void LoadRawData::ApplyTimeWindow(std::string RawFile){
+  //With a time window, only the entries of each stream overlapping it (and, for PMT
+  //data, the earlier entries holding the start of the waves they finish) are loaded,
+  //using the timestamp index written next to the raw file by the RawDataIndexer tool
+  TankFirstEntry = 0;
+  MRDFirstEntry = 0;
+  TrigFirstEntry = 0;
+  if(!UseTimeWindow) return;
+  RawTimeIndex Index;
+  bool HaveIndex = Index.Read(RawTimeIndex::SidecarName(RawFile));
+  if(!HaveIndex){
+    Log("LoadRawData Tool: WARNING no valid timestamp index "+RawTimeIndex::SidecarName(RawFile)+
+        ".  Loading all entries of the file.",v_warning,verbosity);
+  }
+  bool Loaded[3] = {BuildType == "Tank" || BuildType == "TankAndMRD" || BuildType == "TankAndMRDAndCTC",
+      BuildType == "MRD" || BuildType == "TankAndMRD" || BuildType == "TankAndMRDAndCTC",
+      BuildType == "TankAndMRDAndCTC"};
+  int* EntryNums[3] = {&TankEntryNum, &MRDEntryNum, &TrigEntryNum};
+  int* TotalEntries[3] = {&tanktotalentries, &mrdtotalentries, &trigtotalentries};
+  int* FirstEntries[3] = {&TankFirstEntry, &MRDFirstEntry, &TrigFirstEntry};
+  for(int stream=0; stream<3; stream++){
+    if(!Loaded[stream]) continue;
+    WindowTotalEntries[stream] += *TotalEntries[stream];
+    if(!HaveIndex){
+      WindowEntries[stream] += *TotalEntries[stream];
+      continue;
+    }
+    if(int(Index.Entries(stream).size()) != *TotalEntries[stream]){
+      Log("LoadRawData Tool: WARNING timestamp index of "+RawFile+" does not match stream "+std::to_string(stream)+
+          ".  Loading all of its entries.",v_warning,verbosity);
+      WindowEntries[stream] += *TotalEntries[stream];
+      continue;
+    }
+    int first, last;
+    if(!Index.EntryRange(stream, TimeWindowStart, TimeWindowEnd, first, last)) first = last = *TotalEntries[stream];
+    else last += 1;
+    *EntryNums[stream] = first;
+    *FirstEntries[stream] = first;
+    *TotalEntries[stream] = last;
+    WindowEntries[stream] += last - first;
+  }
+  Log("LoadRawData Tool: Time window entries of "+RawFile+": PMT "+std::to_string(TankEntryNum)+"-"+std::to_string(tanktotalentries)+
+      ", MRD "+std::to_string(MRDEntryNum)+"-"+std::to_string(mrdtotalentries)+", trigger "+std::to_string(TrigEntryNum)+
+      "-"+std::to_string(trigtotalentries),v_message,verbosity);
+}
+
 void LoadRawData::GetNextDataEntries(){
   //Get next PMTData Entry
   if(BuildType == "Tank" || BuildType == "TankAndMRD" || BuildType == "TankAndMRDAndCTC"){
     if(!TankPaused && !TankEntriesCompleted){
       Log("LoadRawData Tool: Procesing PMTData Entry "+to_string(TankEntryNum)+"/"+to_string(tanktotalentries),v_debug, verbosity);
-      PMTData->GetEntry(TankEntryNum);
-      Log("LoadRawData Tool: Getting the PMT card data entry",v_debug, verbosity);
-      PMTData->Get("CardData",*Cdata);
-      Log("LoadRawData Tool: Setting PMT card data entry into CStore",v_debug, verbosity);
-      m_data->CStore.Set("CardData",Cdata);
+      //The PMTDataDecoder may already have decoded this entry from its own copy of
+      //the part file; then only the entry position is passed on
+      bool PartFileDecoding = false;
+      m_data->CStore.Get("PMTPartFileDecoding",PartFileDecoding);
+      if(!PartFileDecoding){
+        PMTData->GetEntry(TankEntryNum);
+        Log("LoadRawData Tool: Getting the PMT card data entry",v_debug, verbosity);
+        PMTData->Get("CardData",*Cdata);
+        Log("LoadRawData Tool: Setting PMT card data entry into CStore",v_debug, verbosity);
+        m_data->CStore.Set("CardData",Cdata);
+      }
       Log("LoadRawData Tool: Setting Tank Entry Num CStore",v_debug, verbosity);
       m_data->CStore.Set("TankEntryNum",TankEntryNum);
+      m_data->CStore.Set("RawDataFileNum",FileNum);
       TankEntryNum+=1;
     }
   }
@@ -426,6 +534,7 @@ void LoadRawData::GetNextDataEntries(){
       MRDData->GetEntry(MRDEntryNum);
       MRDData->Get("Data",*Mdata);
       m_data->CStore.Set("MRDData",Mdata,true);
+      m_data->CStore.Set("MRDEntryNum",MRDEntryNum);
       MRDEntryNum+=1;
     }
   }
@@ -436,7 +545,149 @@ void LoadRawData::GetNextDataEntries(){
     TrigData->GetEntry(TrigEntryNum);
     TrigData->Get("TrigData",*Tdata);
     m_data->CStore.Set("TrigData",Tdata);
+    m_data->CStore.Set("TrigEntryNum",TrigEntryNum);
     TrigEntryNum+=1;
   }
   return;
 }
+
+bool LoadRawData::ExecutePipelined(){
+  //Entries are read by the reader thread and decoded in the decoder tools' threads.
+  //Here, the ToolChain loop only moves on to the next file once the reader is done.
+  m_data->CStore.Set("NewRawDataEntryAccessed",true);
+  m_data->CStore.Set("NewRawDataFileAccessed",false);
+  if(AllFilesRead) return true;
+
+  if(ReaderThread.joinable()){
+    if(!ReaderDone) return true;
+    ReaderThread.join();
+    Log("LoadRawData Tool: All entries of "+CurrentFile+" read",v_message,verbosity);
+    FileCompleted = true;
+    m_data->CStore.Set("FileCompleted",FileCompleted);
+  }
+
+  if(FileCompleted && this->InitializeNewFile()){
+    Log("LoadRawData Tool: All files have been processed.",v_message,verbosity);
+    //The decoders finish the entries already queued, then the event builder drains them
+    DecodePipeline->CloseInputs();
+    AllFilesRead = true;
+    m_data->CStore.Set("FileProcessingComplete",true);
+    return true;
+  }
+
+  if(Mode == "SingleFile") CurrentFile = InputFile;
+  else {
+    if(OrganizedFileList.size()==0){
+      std::cout << "LoadRawData tool ERROR: no files in file list to parse!" << std::endl;
+      return false;
+    }
+    CurrentFile = OrganizedFileList.at(FileNum);
+  }
+  if(verbosity>v_warning) std::cout << "LoadRawData tool: Next file to load: " << CurrentFile << std::endl;
+  RawData->Initialise(CurrentFile.c_str());
+  m_data->CStore.Set("NewRawDataFileAccessed",true);
+  m_data->CStore.Set("RawDataFileName",CurrentFile);
+  if(verbosity>4) RawData->Print(false);
+  this->LoadPMTMRDData();
+  this->LoadTriggerData();
+  this->ApplyTimeWindow(CurrentFile);
+  this->LoadRunInformation();
+  FileCompleted = false;
+
+  //Each entry carries the run information, so the decoders see run changes at the
+  //right entry even while they are behind the reader
+  Store RunInfoPostgress;
+  m_data->CStore.Get("RunInfoPostgress",RunInfoPostgress);
+  RunInfoPostgress.Get("RunNumber",ReaderRunNumber);
+  RunInfoPostgress.Get("SubRunNumber",ReaderSubRunNumber);
+
+  ReaderDone = false;
+  ReaderThread = std::thread(&LoadRawData::ReadEntries, this);
+  return true;
+}
+
+void LoadRawData::ReadEntries(){
+  //Runs on the reader thread: reads the entries of the current file from each
+  //stream in turn, skipping a stream while its decoder's input queue is full, and
+  //waits only when every stream left to read is full.  Streams are read only if
+  //the BuildType uses them and their decoder tool is in the ToolChain.
+  bool ReadTank = (BuildType == "Tank" || BuildType == "TankAndMRD" || BuildType == "TankAndMRDAndCTC") &&
+      DecodePipeline->Attached(RawDecodePipeline::Tank);
+  bool ReadMRD = (BuildType == "MRD" || BuildType == "TankAndMRD" || BuildType == "TankAndMRDAndCTC") &&
+      DecodePipeline->Attached(RawDecodePipeline::MRD);
+  bool ReadCTC = (BuildType == "TankAndMRDAndCTC") && DecodePipeline->Attached(RawDecodePipeline::CTC);
+  DecodePipeline->SetExhausted(RawDecodePipeline::Tank, !ReadTank || TankEntryNum >= tanktotalentries);
+  DecodePipeline->SetExhausted(RawDecodePipeline::MRD, !ReadMRD || MRDEntryNum >= mrdtotalentries);
+  DecodePipeline->SetExhausted(RawDecodePipeline::CTC, !ReadCTC || TrigEntryNum >= trigtotalentries);
+
+  bool InputsOpen = true;
+  while(InputsOpen){
+    auto start = std::chrono::steady_clock::now();
+    std::vector<RawDecodePipeline::Stream> FullStreams;
+    int StreamsLeft = 0;
+
+    if(ReadTank && TankEntryNum < tanktotalentries){
+      StreamsLeft++;
+      if(DecodePipeline->InputFull(RawDecodePipeline::Tank)) FullStreams.push_back(RawDecodePipeline::Tank);
+      else {
+        RawPMTEntry entry;
+        entry.RunNumber = ReaderRunNumber;
+        entry.SubRunNumber = ReaderSubRunNumber;
+        entry.NewFile = (TankEntryNum == TankFirstEntry);
+        PMTData->GetEntry(TankEntryNum);
+        PMTData->Get("CardData",entry.Data);
+        InputsOpen = DecodePipeline->PushInput(std::move(entry));
+        TankEntryNum+=1;
+        ReaderStats.Items++;
+        if(TankEntryNum == tanktotalentries) DecodePipeline->SetExhausted(RawDecodePipeline::Tank,true);
+      }
+    }
+
+    if(InputsOpen && ReadMRD && MRDEntryNum < mrdtotalentries){
+      StreamsLeft++;
+      if(DecodePipeline->InputFull(RawDecodePipeline::MRD)) FullStreams.push_back(RawDecodePipeline::MRD);
+      else {
+        RawMRDEntry entry;
+        entry.RunNumber = ReaderRunNumber;
+        entry.SubRunNumber = ReaderSubRunNumber;
+        entry.NewFile = (MRDEntryNum == MRDFirstEntry);
+        MRDData->GetEntry(MRDEntryNum);
+        MRDData->Get("Data",entry.Data);
+        InputsOpen = DecodePipeline->PushInput(std::move(entry));
+        MRDEntryNum+=1;
+        ReaderStats.Items++;
+        if(MRDEntryNum == mrdtotalentries) DecodePipeline->SetExhausted(RawDecodePipeline::MRD,true);
+      }
+    }
+
+    if(InputsOpen && ReadCTC && TrigEntryNum < trigtotalentries){
+      StreamsLeft++;
+      if(DecodePipeline->InputFull(RawDecodePipeline::CTC)) FullStreams.push_back(RawDecodePipeline::CTC);
+      else {
+        RawCTCEntry entry;
+        entry.RunNumber = ReaderRunNumber;
+        entry.SubRunNumber = ReaderSubRunNumber;
+        entry.NewFile = (TrigEntryNum == TrigFirstEntry);
+        TrigData->GetEntry(TrigEntryNum);
+        TrigData->Get("TrigData",entry.Data);
+        InputsOpen = DecodePipeline->PushInput(std::move(entry));
+        TrigEntryNum+=1;
+        ReaderStats.Items++;
+        if(TrigEntryNum == trigtotalentries) DecodePipeline->SetExhausted(RawDecodePipeline::CTC,true);
+      }
+    }
+    ReaderStats.BusySeconds += std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count();
+
+    if(StreamsLeft == 0) break;
+    if(InputsOpen && int(FullStreams.size()) == StreamsLeft){
+      InputsOpen = DecodePipeline->WaitForInputSpace(FullStreams,ReaderStats.OutputWaitSeconds);
+    }
+  }
+  ReaderDone = true;
+}
+
+void LoadRawData::StopReader(){
+  //Closing the inputs makes the reader stop at its next entry
+  DecodePipeline->CloseInputs();
+  if(ReaderThread.joinable()) ReaderThread.join();
+}
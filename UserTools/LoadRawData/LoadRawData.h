@@ -3,12 +3,17 @@
 
 #include <string>
 #include <iostream>
+#include <thread>
+#include <atomic>
+#include <chrono>
 
 #include "Tool.h"
 #include "CardData.h"
 #include "TriggerData.h"
 #include "BoostStore.h"
 #include "Store.h"
+#include "RawDecodePipeline.h"
+#include "RawTimeIndex.h"
 
 /**
  * \class LoadRawData
@@ -33,6 +38,9 @@ class LoadRawData: public Tool {
   void LoadRunInformation();
   void GetNextDataEntries();
   bool InitializeNewFile(); 
+  bool ExecutePipelined(); ///< Execute in DecodeMode Pipelined: open each file and start the reader thread on it
+  void ReadEntries(); ///< Reader thread: push the entries of the current file to the decoders' input queues
+  void StopReader();
 
  private:
 
@@ -71,6 +79,32 @@ class LoadRawData: public Tool {
   TriggerData* Tdata = nullptr;
   MRDOut* Mdata = nullptr;
 
+  //Pipelined decoding (DecodeMode Pipelined): a reader thread reads the entries of
+  //each file into the RawDecodePipeline queues, and the decoder tools decode them in
+  //their own threads.  The reader owns the raw data BoostStores while it runs.
+  std::string DecodeMode;
+  int PipelineQueueSize;
+  RawDecodePipeline* DecodePipeline = nullptr;
+  std::thread ReaderThread;
+  std::atomic<bool> ReaderDone{false};
+  bool AllFilesRead = false;
+  int ReaderRunNumber = -1;
+  int ReaderSubRunNumber = -1;
+  PipelineStageStats ReaderStats;
+
+  //Time window mode (TimeWindowStart/TimeWindowEnd, UTC ns): only the entries listed
+  //for the window in each file's timestamp index (RawTimeIndex) are loaded
+  void ApplyTimeWindow(std::string RawFile);
+  bool UseTimeWindow = false;
+  uint64_t TimeWindowStart = 0;
+  uint64_t TimeWindowEnd = 0;
+  int TankFirstEntry = 0;
+  int MRDFirstEntry = 0;
+  int TrigFirstEntry = 0;
+  long WindowEntries[3] = {0,0,0};
+  long WindowTotalEntries[3] = {0,0,0};
+  std::chrono::steady_clock::time_point StartTime;
+
   int verbosity;
   int v_error=0;
   int v_warning=1;
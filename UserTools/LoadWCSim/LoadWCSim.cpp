@@ -65,6 +65,24 @@ bool LoadWCSim::Initialise(std::string configfile, DataModel &data){
 	}
 	MCEventNum=0;
 	get_ok = m_variables.Get("FileStartOffset",MCEventNum);
+	get_ok = m_variables.Get("PrefetchEntries",PrefetchEntries);
+	if(not get_ok) PrefetchEntries=0;
+	std::string collections;
+	get_ok = m_variables.Get("LoadCollections",collections);
+	if(get_ok){
+		// comma-separated list of the detector collections to put in the ANNIEEvent
+		load_tank=false;
+		load_mrd=false;
+		load_facc=false;
+		std::stringstream collectionstream(collections);
+		std::string acollection;
+		while(std::getline(collectionstream,acollection,',')){
+			if(acollection=="Tank") load_tank=true;
+			else if(acollection=="MRD") load_mrd=true;
+			else if(acollection=="FACC") load_facc=true;
+			else Log("LoadWCSim Tool: Unknown collection "+acollection+" in LoadCollections. Options are Tank, MRD and FACC",v_warning,verbosity);
+		}
+	}
 	
 	// put version in the CStore for downstream tools
 	m_data->CStore.Set("WCSimVersion", WCSimVersion);
@@ -100,7 +118,18 @@ bool LoadWCSim::Initialise(std::string configfile, DataModel &data){
 //	file= new TFile(MCFile.c_str(),"READ");
 //	wcsimtree= (TTree*) file->Get("wcsimT");
 //	WCSimEntry= new wcsimT(wcsimtree);
+	if(PrefetchEntries>0){
+		Log("LoadWCSim Tool: Reading "+to_string(PrefetchEntries)+" entries ahead on a background thread",v_message,verbosity);
+		ROOT::EnableThreadSafety();
+		// one more buffer than read ahead: Execute holds the current entry
+		for(int ibuffer=0; ibuffer<PrefetchEntries+1; ibuffer++){
+			prefetch_buffers.emplace_back(new EntryBuffer);
+			free_buffers.push_back(prefetch_buffers.back().get());
+		}
+	}
 	WCSimEntry= new wcsimT(MCFile.c_str(),verbosity);
+	// MRD and FACC branches that are not needed are not read from file
+	WCSimEntry->SetDetectorBranches(load_mrd,load_facc);
 	
 	gROOT->cd();
 	wcsimrootgeom = WCSimEntry->wcsimrootgeom;
@@ -170,7 +199,8 @@ bool LoadWCSim::Initialise(std::string configfile, DataModel &data){
 	EventNumber=0;
 	MCTriggernum=0;
 	// pull the first entry to get the MCFile
-	int nbytesread = WCSimEntry->GetEntry(MCEventNum);  // <0 if out of file
+	loop_start = std::chrono::steady_clock::now();
+	int nbytesread = LoadEntry(MCEventNum);  // <0 if out of file
 	if(nbytesread<=0){
 		logmessage = "LoadWCSim Tool had no entry "+to_string(MCEventNum);
 		if(nbytesread==-4){
@@ -181,10 +211,11 @@ bool LoadWCSim::Initialise(std::string configfile, DataModel &data){
 		Log(logmessage,v_error,verbosity);
 		cerr<<"############################"<<endl;
 		m_data->vars.Set("StopLoop",1);
+		StopPrefetch();
 		return false;
 	}
 	
-	MCFile = WCSimEntry->GetCurrentFile()->GetName();
+	MCFile = current_entry->MCFile;
 	m_data->Stores.at("ANNIEEvent")->Set("MCFile",MCFile);
 	
 	// use nominal beam values TODO
@@ -253,7 +284,7 @@ bool LoadWCSim::Execute(){
 			std::cout<<"LoadWCSim Tool: Reached max entries specified in config file, terminating ToolChain"<<endl;
 			m_data->vars.Set("StopLoop",1);
 		} else {
-			int nbytesread = WCSimEntry->GetEntry(MCEventNum);  // <0 if out of file
+			int nbytesread = LoadEntry(MCEventNum);  // <0 if out of file
 			if (verbosity > v_debug) std::cout <<"LoadWCSim tool: Trying to get next event, MCEventNum: "<<MCEventNum<<", nbytesread: "<<nbytesread<<std::endl;
 			if(nbytesread<=0){
 				Log("LoadWCSim Tool: Reached last entry of WCSim input file, terminating ToolChain",v_warning,verbosity);
@@ -274,390 +305,67 @@ bool LoadWCSim::Execute(){
 		Log("WARNING: STOPLOOP HAS BEEN SET. RETURNING",v_error,verbosity);
 		return 0;
 	}
-	MCFile = WCSimEntry->GetCurrentFile()->GetName();
+	MCFile = current_entry->MCFile;
 	
-	MCHits->clear();
-	TDCData->clear();
-	mrd_firstlayer=false;
-	mrd_lastlayer=false;	
-
-	triggers_event = WCSimEntry->wcsimrootevent->GetNumberOfEvents();
-	
-	//for(int MCTriggernum=0; MCTriggernum<WCSimEntry->wcsimrootevent->GetNumberOfEvents(); MCTriggernum++){
-		if(verbosity>1) cout<<"getting triggers"<<endl;
-		// cherenkovhit(times) are all in first trig
-		firsttrigt=WCSimEntry->wcsimrootevent->GetTrigger(0);
-		firsttrigm=WCSimEntry->wcsimrootevent_mrd->GetTrigger(0);
-		firsttrigv=WCSimEntry->wcsimrootevent_facc->GetTrigger(0);
-		atrigt = WCSimEntry->wcsimrootevent->GetTrigger(MCTriggernum);
-		if(MCTriggernum<(WCSimEntry->wcsimrootevent_mrd->GetNumberOfEvents())){
-			atrigm = WCSimEntry->wcsimrootevent_mrd->GetTrigger(MCTriggernum);
-		} else { atrigm=nullptr; }
-		if(MCTriggernum<(WCSimEntry->wcsimrootevent_facc->GetNumberOfEvents())){
-			atrigv = WCSimEntry->wcsimrootevent_facc->GetTrigger(MCTriggernum);
-		} else { atrigv=nullptr; }
-		if(verbosity>2) cout<<"wcsimrootevent="<<WCSimEntry->wcsimrootevent<<endl;
-		if(verbosity>2) cout<<"wcsimrootevent_mrd="<<WCSimEntry->wcsimrootevent_mrd<<endl;
-		if(verbosity>2) cout<<"wcsimrootevent_facc="<<WCSimEntry->wcsimrootevent_facc<<endl;
-		if(verbosity>2) cout<<"atrigt="<<atrigt<<", atrigm="<<atrigm<<", atrigv="<<atrigv<<endl;
-		
-		if(verbosity>1) cout<<"getting event date"<<endl;
-		RunNumber = atrigt->GetHeader()->GetRun();
-		SubrunNumber = 0;
-		EventTimeNs = atrigt->GetHeader()->GetDate();
-		EventTime->SetNs(EventTimeNs);
-		if(verbosity>2) cout<<"EventTime is "<<EventTimeNs<<"ns"<<endl;
-		
-		// Load ALL MC particles (for all delayed MC triggers) only on MCTrigger 0
-		if(MCTriggernum==0){
-			MCParticles->clear();
-			trackid_to_mcparticleindex->clear();
-			primarymuonindex=-1;
-			
-			std::string geniefilename = firsttrigt->GetHeader()->GetGenieFileName().Data();
-			int genieentry = firsttrigt->GetHeader()->GetGenieEntryNum();
-			/*if(verbosity>3)*/ cout<<"Genie file is "<<geniefilename<<", genie event num was "<<genieentry<<endl;
-			m_data->CStore.Set("GenieFile",geniefilename);
-			m_data->CStore.Set("GenieEntry",genieentry);
-			
-			for(int trigi=0; trigi<WCSimEntry->wcsimrootevent->GetNumberOfEvents(); trigi++){
-				
-				WCSimRootTrigger* atrigtt = WCSimEntry->wcsimrootevent->GetTrigger(trigi);
-				if(verbosity>1) cout<<"getting "<<atrigtt->GetNtrack()<<" tracks from trigger "<<trigi<<endl;
-				for(int tracki=0; tracki<atrigtt->GetNtrack(); tracki++){
-					if(verbosity>2) cout<<"getting track "<<tracki<<endl;
-					WCSimRootTrack* nextrack = (WCSimRootTrack*)atrigtt->GetTracks()->At(tracki);
-					/* a WCSimRootTrack has methods:
-					Int_t     GetIpnu()             pdg
-					Int_t     GetFlag()             -1: neutrino primary, -2: neutrino target, 0: other
-					Float_t   GetM()                mass
-					Float_t   GetP()                momentum magnitude
-					Float_t   GetE()                energy (inc rest mass^2)
-					Float_t   GetEndE()             energy on stopping of particle tracking
-					Float_t   GetEndP()             momentum on stopping of particle tracking
-					Int_t     GetStartvol()         starting volume: 10 is tank, 20 is facc, 30 is mrd
-					Int_t     GetStopvol()          stopping volume: but these may not be set.
-					Float_t   GetDir(Int_t i=0)     momentum unit vector
-					Float_t   GetPdir(Int_t i=0)    momentum vector
-					Float_t   GetPdirEnd(Int_t i=0) direction vector on stop tracking
-					Float_t   GetStop(Int_t i=0)    stopping vertex x,y,z for i=0-2, in cm
-					Float_t   GetStart(Int_t i=0)   starting vertex x,y,z for i=0-2, in cm
-					Int_t     GetParenttype()       parent pdg, 0 for primary.
-					Float_t   GetTime()             trj->GetGlobalTime(); starting time of particle
-					Float_t   GetStopTime()
-					Int_t     GetId()               wcsim trackid
-					*/
-					
-					tracktype startstoptype = tracktype::UNDEFINED;
-					//MC particle times are relative to the trigger time
-					if(nextrack->GetFlag()!=0) {
-						if (nextrack->GetFlag()==-1){
-							MCParticle neutrino(
-							nextrack->GetIpnu(), nextrack->GetE(), nextrack->GetEndE(),
-							Position(nextrack->GetStart(0) / 100.,
-									 nextrack->GetStart(1) / 100.,
-									 nextrack->GetStart(2) / 100.),
-							Position(nextrack->GetStop(0) / 100.,
-									 nextrack->GetStop(1) / 100.,
-									 nextrack->GetStop(2) / 100.),
-							//MC particle times now stored relative to the trigger time
-							(static_cast<double>(nextrack->GetTime()-EventTimeNs)),
-							(static_cast<double>(nextrack->GetStopTime()-EventTimeNs)),
-							Direction(nextrack->GetDir(0), nextrack->GetDir(1), nextrack->GetDir(2)),
-							(sqrt(pow(nextrack->GetStop(0)-nextrack->GetStart(0),2.)+
-								 pow(nextrack->GetStop(1)-nextrack->GetStart(1),2.)+
-								 pow(nextrack->GetStop(2)-nextrack->GetStart(2),2.))) / 100.,
-							startstoptype,
-							nextrack->GetId(),
-							nextrack->GetParenttype(),
-							nextrack->GetFlag(),
-							trigi);
-
-							//Set the neutrino as its own particle
-							m_data->Stores["ANNIEEvent"]->Set("NeutrinoParticle",neutrino);
-							
-							continue; // flag 0 only is normal particles: excludes neutrino
-						}
-					}
-					MCParticle thisparticle(
-						nextrack->GetIpnu(), nextrack->GetE(), nextrack->GetEndE(),
-						Position(nextrack->GetStart(0) / 100.,
-								 nextrack->GetStart(1) / 100.,
-								 nextrack->GetStart(2) / 100.),
-						Position(nextrack->GetStop(0) / 100.,
-								 nextrack->GetStop(1) / 100.,
-								 nextrack->GetStop(2) / 100.),
-						//MC particle times now stored relative to the trigger time
-						(static_cast<double>(nextrack->GetTime()-EventTimeNs)),
-						(static_cast<double>(nextrack->GetStopTime()-EventTimeNs)),
-						Direction(nextrack->GetDir(0), nextrack->GetDir(1), nextrack->GetDir(2)),
-						(sqrt(pow(nextrack->GetStop(0)-nextrack->GetStart(0),2.)+
-							 pow(nextrack->GetStop(1)-nextrack->GetStart(1),2.)+
-							 pow(nextrack->GetStop(2)-nextrack->GetStart(2),2.))) / 100.,
-						startstoptype,
-						nextrack->GetId(),
-						nextrack->GetParenttype(),
-						nextrack->GetFlag(),
-						trigi);
-					// not currently in constructor call, but we now have it in latest WCSim files
-					// XXX this will fall over with older WCSim files, whose WCSimLib doesn't have this method!
-					thisparticle.SetTankExitPoint(Position(nextrack->GetTankExitPoint(0)/ 100.,
-														   nextrack->GetTankExitPoint(1)/ 100.,
-														   nextrack->GetTankExitPoint(2)/ 100.));
-					if( (nextrack->GetIpnu()==13) &&
-						(nextrack->GetParenttype()==0) &&
-						(nextrack->GetFlag()==0) &&
-						(primarymuonindex<0) ){
-							// call this the primary muon. If we have more than one, use the first
-							primarymuonindex = MCParticles->size();
-					}
-					if((abs(nextrack->GetIpnu())==13)||
-					   (abs(nextrack->GetIpnu())==211)||
-					   (nextrack->GetIpnu()==111)){
-							if (verbosity > 0) {
-								std::cout<<"Found "<<nextrack->GetIpnu()<<" with parent pdg "
-								<<nextrack->GetParenttype()<<", flag "<<nextrack->GetFlag()
-								<<" track id "<<nextrack->GetId()
-								<< ", start vertex (" + to_string(nextrack->GetStart(0)/100.)
-								<< ", " + to_string(nextrack->GetStart(1)/100.)
-								<< ", " + to_string(nextrack->GetStart(2)/100.)
-								<< "), and end vertex (" + to_string(nextrack->GetStop(0)/100.)
-								<< ", " + to_string(nextrack->GetStop(1)/100.)
-								<< ", " + to_string(nextrack->GetStop(2)/100.)
-								<< ")"
-								<<std::endl;
-							}
-					}
-/*
-					// Print primary muons or the first track
-					if(((nextrack->GetIpnu()==13) && (nextrack->GetParenttype()==0))||
-					   (MCParticles->size()==0)){
-						if (verbosity) std::cout<<"Found "<<nextrack->GetIpnu()<<" with parent pdg "
-								<<nextrack->GetParenttype()<<", flag "<<nextrack->GetFlag()
-								<<" track id "<<nextrack->GetId()
-								<<" at position "<<MCParticles->size()<<std::endl;
-					}
-					// print pions
-					if((abs(nextrack->GetIpnu())==211)||
-					   (nextrack->GetIpnu()==111)){
-						if (verbosity) std::cout<<"Found "<<nextrack->GetIpnu()<<" with parent pdg "
-								<<nextrack->GetParenttype()<<", flag "<<nextrack->GetFlag()
-								<<" track id "<<nextrack->GetId()
-								<< ", start vertex (" + to_string(nextrack->GetStart(0)/100.)
-								<< ", " + to_string(nextrack->GetStart(1)/100.)
-								<< ", " + to_string(nextrack->GetStart(2)/100.)
-								<< "), and end vertex (" + to_string(nextrack->GetStop(0)/100.)
-								<< ", " + to_string(nextrack->GetStop(1)/100.)
-								<< ", " + to_string(nextrack->GetStop(2)/100.)
-								<< ")"
-								<<std::endl;
-					}
-					// print muons or gammas from pion decays
-					if(((abs(nextrack->GetIpnu())==13)||(nextrack->GetIpnu()==22)) &&
-					   ((abs(nextrack->GetParenttype())==211)||(nextrack->GetParenttype()==111))){
-						if (verbosity) std::cout<<"Found "<<nextrack->GetIpnu()<<" with parent pdg "
-								<<nextrack->GetParenttype()<<", flag "<<nextrack->GetFlag()
-								<<" track id "<<nextrack->GetId()
-								<<" at position "<<MCParticles->size()<<std::endl;
-					}
-*/
-					if(nextrack->GetIpnu()==13){
-						logmessage = "Muon found with flag: "+to_string(nextrack->GetFlag())
-							+ ", parent type " + to_string(nextrack->GetParenttype())
-							+ ", Id " + to_string(nextrack->GetId())
-							+ ", start vertex (" + to_string(nextrack->GetStart(0)/100.)
-							+ ", " + to_string(nextrack->GetStart(1)/100.)
-							+ ", " + to_string(nextrack->GetStart(2)/100.)
-							+ "), and end vertex (" + to_string(nextrack->GetStop(0)/100.)
-							+ ", " + to_string(nextrack->GetStop(1)/100.)
-							+ ", " + to_string(nextrack->GetStop(2)/100.)
-							+ ")";
-						Log(logmessage,v_debug,verbosity);
-					}
-					
-					trackid_to_mcparticleindex->emplace(nextrack->GetId(),MCParticles->size());
-					MCParticles->push_back(thisparticle);
-				}
-				if(verbosity>2) cout<<"MCParticles has "<<MCParticles->size()<<" entries"<<endl;
-				
-			}  // loop over loading particles from all MC triggers on first MC trigger
-		} else { 
-			// if MCTrigger>0, since particle times are relative to the trigger time,
-			// we need to update all the particle times
-			double timediff = EventTimeNs - firsttrigt->GetHeader()->GetDate();
-			for(MCParticle& aparticle : *MCParticles){
-				aparticle.SetStartTime(aparticle.GetStartTime()-timediff);
-				aparticle.SetStopTime (aparticle.GetStopTime() -timediff);
-			}
-		} // end updating particle times
-		
-		int numtankdigits = atrigt ? atrigt->GetCherenkovDigiHits()->GetEntries() : 0;
-		if(verbosity>1) cout<<"looping over "<<numtankdigits<<" tank digits"<<endl;
-		for(int digiti=0; digiti<numtankdigits; digiti++){
-			if(verbosity>2) cout<<"getting digit "<<digiti<<endl;
-			WCSimRootCherenkovDigiHit* digihit =
-				(WCSimRootCherenkovDigiHit*)atrigt->GetCherenkovDigiHits()->At(digiti);
-			//WCSimRootChernkovDigiHit has methods GetTubeId(), GetT(), GetQ(), GetPhotonIds()
-			if(verbosity>2) cout<<"next digihit at "<<digihit<<endl;
-			int tubeid = digihit->GetTubeId();  // geometry TubeID->channelkey map is made INCLUDING offset of 1
-			if(verbosity>2) cout<<"tubeid="<<tubeid<<endl;
-			if(pmt_tubeid_to_channelkey.count(tubeid)==0){
-				cerr<<"LoadWCSim ERROR: tank PMT with no associated ChannelKey!"<<endl;
-				return false;
-			}
-			unsigned long key = pmt_tubeid_to_channelkey.at(tubeid);
-			if(verbosity>2) cout<<"ChannelKey="<<key<<endl;
-			double digittime;
-			if(use_smeared_digit_time){
-				digittime = static_cast<double>(digihit->GetT()-HistoricTriggeroffset); // relative to trigger
-			} else {
-				// instead take the true time of the first photon
-				std::vector<int> photonids = digihit->GetPhotonIds();   // indices of the digit's photons
-				double earliestphotontruetime=999999999999;
-				for(int& aphotonindex : photonids){
-					WCSimRootCherenkovHitTime* thehittimeobject =
-						 (WCSimRootCherenkovHitTime*)firsttrigt->GetCherenkovHitTimes()->At(aphotonindex);
-					if(thehittimeobject==nullptr){
-						cerr<<"LoadWCSim Tool: ERROR! Retrieval of photon from digit returned nullptr!"<<endl;
-						continue;
-					}
-					double aphotontime = static_cast<double>(thehittimeobject->GetTruetime());
-					if(aphotontime<earliestphotontruetime){ earliestphotontruetime = aphotontime; }
-				}
-				digittime = earliestphotontruetime;
-			}
-			if(verbosity>2){ cout<<"digittime is "<<digittime<<" [ns] from Trigger"<<endl; }
-			float digiq = digihit->GetQ();
-			if(verbosity>2) cout<<"digit Q is "<<digiq<<endl;
-			// Get hit parent information
-			std::vector<int> parents = GetHitParentIds(digihit, firsttrigt);
-			
-			MCHit nexthit(key, digittime, digiq, parents);
-			if(MCHits->count(key)==0) MCHits->emplace(key, std::vector<MCHit>{nexthit});
-			else MCHits->at(key).push_back(nexthit);
-			if(verbosity>2) cout<<"digit added"<<endl;
-		}
-		if(verbosity>2) cout<<"done with tank digits"<<endl;
-		
-		//MRD Hits
-		int nummrddigits = atrigm ? atrigm->GetCherenkovDigiHits()->GetEntries() : 0;
-		if(verbosity>1) cout<<"adding "<<nummrddigits<<" mrd digits"<<endl;
-		for(int digiti=0; digiti<nummrddigits; digiti++){
-			if(verbosity>2) cout<<"getting digit "<<digiti<<endl;
-			WCSimRootCherenkovDigiHit* digihit =
-				(WCSimRootCherenkovDigiHit*)atrigm->GetCherenkovDigiHits()->At(digiti);
-			if(verbosity>2) cout<<"next digihit at "<<digihit<<endl;
-			int tubeid = digihit->GetTubeId();
-			if(verbosity>2) cout<<"tubeid="<<tubeid<<endl;
-			if(mrd_tubeid_to_channelkey.count(tubeid)==0){
-				cerr<<"LoadWCSim ERROR: MRD PMT with no associated ChannelKey!"<<endl;
-				return false;
-			}
-			unsigned long key = mrd_tubeid_to_channelkey.at(tubeid);
-			double digittime;
-			if(use_smeared_digit_time){
-				digittime = static_cast<double>(digihit->GetT()-HistoricTriggeroffset); // relative to trigger
-			} else {
-				// instead take the true time of the first photon
-				std::vector<int> photonids = digihit->GetPhotonIds();   // indices of the digit's photons
-				double earliestphotontruetime=999999999999;
-				for(int& aphotonindex : photonids){
-					WCSimRootCherenkovHitTime* thehittimeobject =
-						 (WCSimRootCherenkovHitTime*)firsttrigm->GetCherenkovHitTimes()->At(aphotonindex);
-					if(thehittimeobject==nullptr){
-						cerr<<"LoadWCSim Tool: ERROR! Retrieval of photon from digit returned nullptr!"<<endl;
-						continue;
-					}
-					double aphotontime = static_cast<double>(thehittimeobject->GetTruetime());
-					if(aphotontime<earliestphotontruetime){ earliestphotontruetime = aphotontime; }
-				}
-				digittime = earliestphotontruetime;
-			}
-			if(verbosity>2){ cout<<"digittime is "<<digittime<<" [ns] from Trigger"<<endl; }
-			float digiq = digihit->GetQ();
-			if(verbosity>2) cout<<"digit Q is "<<digiq<<endl;
-			// Get hit parent information
-			std::vector<int> parents = GetHitParentIds(digihit, firsttrigm);
-			
-			MCHit nexthit(key, digittime, digiq, parents);
-			if(TDCData->count(key)==0) {TDCData->emplace(key, std::vector<MCHit>{nexthit}); if (Mrd_Chankey_Layer.at(key)==0) mrd_firstlayer=true; if (Mrd_Chankey_Layer.at(key)==10) mrd_lastlayer=true;}
-			else TDCData->at(key).push_back(nexthit);
-			if(verbosity>2) cout<<"digit added"<<endl;
-		}
-		if(verbosity>2) cout<<"done with mrd digits"<<endl;
+	triggers_event = current_entry->numtriggers;
+	if(MCTriggernum>=triggers_event){
+		Log("LoadWCSim Tool: ERROR: MC entry "+to_string(MCEventNum)+" has no trigger "+to_string(MCTriggernum),v_error,verbosity);
+		return false;
+	}
+	// the entry was read and unpacked in LoadEntry, possibly by the read-ahead thread.
+	// Swap the unpacked trigger into the objects held by the ANNIEEvent
+	TriggerBuffer& thetrigger = current_entry->triggers.at(MCTriggernum);
+	if(not thetrigger.error.empty()){
+		cerr<<thetrigger.error<<endl;
+		return false;
+	}
+	
+	if(verbosity>1) cout<<"getting event date"<<endl;
+	RunNumber = thetrigger.RunNumber;
+	SubrunNumber = 0;
+	EventTimeNs = thetrigger.EventTimeNs;
+	EventTime->SetNs(EventTimeNs);
+	if(verbosity>2) cout<<"EventTime is "<<EventTimeNs<<"ns"<<endl;
+	
+	// ALL MC particles (for all delayed MC triggers) are loaded with the first trigger of the entry
+	if(not current_entry->particles_used){
+		MCParticles->swap(current_entry->MCParticles);
+		trackid_to_mcparticleindex->swap(current_entry->trackid_to_mcparticleindex);
+		primarymuonindex = current_entry->primarymuonindex;
+		current_entry->particles_used = true;
 		
-		// Veto Hits
-		int numvetodigits = atrigv ? atrigv->GetCherenkovDigiHits()->GetEntries() : 0;
-		if(verbosity>1) cout<<"adding "<<numvetodigits<<" veto digits"<<endl;
-		for(int digiti=0; digiti<numvetodigits; digiti++){
-			if(verbosity>2) cout<<"getting digit "<<digiti<<endl;
-			WCSimRootCherenkovDigiHit* digihit =
-				(WCSimRootCherenkovDigiHit*)atrigv->GetCherenkovDigiHits()->At(digiti);
-			if(verbosity>2) cout<<"next digihit at "<<digihit<<endl;
-			int tubeid = digihit->GetTubeId();
-			if(verbosity>2) cout<<"tubeid="<<tubeid<<endl;
-			if(facc_tubeid_to_channelkey.count(tubeid)==0){
-				cerr<<"LoadWCSim ERROR: FACC PMT with no associated ChannelKey!"<<endl;
-				return false;
-			}
-			unsigned int key = facc_tubeid_to_channelkey.at(tubeid);
-			double digittime;
-			if(use_smeared_digit_time){
-				digittime = static_cast<double>(digihit->GetT()-HistoricTriggeroffset); // relative to trigger
-			} else {
-				// instead take the true time of the first photon
-				std::vector<int> photonids = digihit->GetPhotonIds();   // indices of the digit's photons
-				double earliestphotontruetime=999999999999;
-				for(int& aphotonindex : photonids){
-					WCSimRootCherenkovHitTime* thehittimeobject =
-						 (WCSimRootCherenkovHitTime*)firsttrigv->GetCherenkovHitTimes()->At(aphotonindex);
-					if(thehittimeobject==nullptr){
-						cerr<<"LoadWCSim Tool: ERROR! Retrieval of photon from digit returned nullptr!"<<endl;
-						continue;
-					}
-					double aphotontime = static_cast<double>(thehittimeobject->GetTruetime());
-					if(aphotontime<earliestphotontruetime){ earliestphotontruetime = aphotontime; }
-				}
-				digittime = earliestphotontruetime;
-			}
-			if(verbosity>2){ cout<<"digittime is "<<digittime<<" [ns] from Trigger"<<endl; }
-			float digiq = digihit->GetQ();
-			if(verbosity>2) cout<<"digit Q is "<<digiq<<endl;
-			// Get hit parent information
-			std::vector<int> parents = GetHitParentIds(digihit, firsttrigv);
-			
-			MCHit nexthit(key, digittime, digiq, parents);
-			if(TDCData->count(key)==0) TDCData->emplace(key, std::vector<MCHit>{nexthit});
-			else TDCData->at(key).push_back(nexthit);
-			if(verbosity>2) cout<<"digit added"<<endl;
+		/*if(verbosity>3)*/ cout<<"Genie file is "<<current_entry->GenieFile<<", genie event num was "<<current_entry->GenieEntry<<endl;
+		m_data->CStore.Set("GenieFile",current_entry->GenieFile);
+		m_data->CStore.Set("GenieEntry",current_entry->GenieEntry);
+		//Set the neutrino as its own particle
+		if(current_entry->has_neutrino) m_data->Stores["ANNIEEvent"]->Set("NeutrinoParticle",current_entry->neutrino);
+		if(verbosity>2) cout<<"MCParticles has "<<MCParticles->size()<<" entries"<<endl;
+	}
+	if(MCTriggernum>0){
+		// if MCTrigger>0, since particle times are relative to the trigger time,
+		// we need to update all the particle times
+		double timediff = EventTimeNs - current_entry->triggers.at(0).EventTimeNs;
+		for(MCParticle& aparticle : *MCParticles){
+			aparticle.SetStartTime(aparticle.GetStartTime()-timediff);
+			aparticle.SetStopTime (aparticle.GetStopTime() -timediff);
 		}
-		if(verbosity>2) cout<<"done with veto digits"<<endl;
-		
-		if(verbosity>2) cout<<"setting triggerdata time to "<<EventTimeNs<<"ns"<<endl;
-		TriggerData->front().SetTime(EventTimeNs);
-		
-		// update the information about tracks and which tank/mrd/veto PMTs they hit
-		// this needs updating with each MC trigger, as digits are grouped into MC trigger
-		// so these maps will then only contain the digits respective particles create
-		// in the active trigger
-		// 
-		// ParticleId_to_TankTubeIds is a std::map<ParticleId,std::map<ChannelKey,TotalCharge>>
-		// where TotalCharge is the total charge from that particle on that tube
-		// (in the event that the particle generated several hits on the tube)
-		// ParticleId_to_TankCharge is a std::map<ParticleId,TotalCharge> 
-		// where TotalCharge is summed over all digits, on all pmts, which contained
-		// light from that particle
-		ParticleId_to_TankTubeIds->clear();
-		ParticleId_to_MrdTubeIds->clear();
-		ParticleId_to_VetoTubeIds->clear();
-		ParticleId_to_TankCharge->clear();
-		ParticleId_to_MrdCharge->clear();
-		ParticleId_to_VetoCharge->clear();
-		MakeParticleToPmtMap(atrigt, firsttrigt, ParticleId_to_TankTubeIds, ParticleId_to_TankCharge, pmt_tubeid_to_channelkey);
-		MakeParticleToPmtMap(atrigm, firsttrigm, ParticleId_to_MrdTubeIds, ParticleId_to_MrdCharge, mrd_tubeid_to_channelkey);
-		MakeParticleToPmtMap(atrigv, firsttrigv, ParticleId_to_VetoTubeIds, ParticleId_to_VetoCharge, facc_tubeid_to_channelkey);
-		
-	//}
+	} // end updating particle times
+	
+	MCHits->swap(thetrigger.MCHits);
+	TDCData->swap(thetrigger.TDCData);
+	mrd_firstlayer = thetrigger.mrd_firstlayer;
+	mrd_lastlayer = thetrigger.mrd_lastlayer;
+	
+	if(verbosity>2) cout<<"setting triggerdata time to "<<EventTimeNs<<"ns"<<endl;
+	TriggerData->front().SetTime(EventTimeNs);
+	
+	// information about tracks and which tank/mrd/veto PMTs they hit in this MC trigger
+	ParticleId_to_TankTubeIds->swap(thetrigger.ParticleId_to_TankTubeIds);
+	ParticleId_to_MrdTubeIds->swap(thetrigger.ParticleId_to_MrdTubeIds);
+	ParticleId_to_VetoTubeIds->swap(thetrigger.ParticleId_to_VetoTubeIds);
+	ParticleId_to_TankCharge->swap(thetrigger.ParticleId_to_TankCharge);
+	ParticleId_to_MrdCharge->swap(thetrigger.ParticleId_to_MrdCharge);
+	ParticleId_to_VetoCharge->swap(thetrigger.ParticleId_to_VetoCharge);
 	
 	//int mrdentries;
 	//m_data->Stores.at("TDCData")->Get("TotalEntries",mrdentries); // ??
@@ -697,7 +405,7 @@ bool LoadWCSim::Execute(){
 	m_data->Stores.at("ANNIEEvent")->Set("MCFile",MCFile);
 	m_data->Stores.at("ANNIEEvent")->Set("MCFlag",true);                   // constant
 	m_data->Stores.at("ANNIEEvent")->Set("BeamStatus",BeamStatus,true);
-	m_data->CStore.Set("NumTriggersThisMCEvt",WCSimEntry->wcsimrootevent->GetNumberOfEvents());
+	m_data->CStore.Set("NumTriggersThisMCEvt",triggers_event);
 	// auxilliary information about MC Truth particles
 	m_data->Stores.at("ANNIEEvent")->Set("ParticleId_to_TankTubeIds", ParticleId_to_TankTubeIds, false);
 	m_data->Stores.at("ANNIEEvent")->Set("ParticleId_to_TankCharge", ParticleId_to_TankCharge, false);
@@ -723,13 +431,13 @@ bool LoadWCSim::Execute(){
 	MCTriggernum++;
 	if(verbosity>2) cout<<"checking if we're done on trigs in this event"<<endl;
 	bool newentry=false;
-	if(MCTriggernum==WCSimEntry->wcsimrootevent->GetNumberOfEvents()){
+	if(MCTriggernum==triggers_event){
 		MCTriggernum=0;
 		MCEventNum++;
 		newentry=true;
 		if(verbosity>2) cout<<"this is the last trigger in the event: next loop will process a new event"<<endl;
 	} else {
-		if(verbosity>2) cout<<"there are further triggers in this event: next loop will process the trigger "<<MCTriggernum<<"/"<<WCSimEntry->wcsimrootevent->GetNumberOfEvents()<<endl;
+		if(verbosity>2) cout<<"there are further triggers in this event: next loop will process the trigger "<<MCTriggernum<<"/"<<triggers_event<<endl;
 	}
 	
 	// Pre-load next entry so we can stop the loop if it this was the last one in the chain
@@ -738,7 +446,7 @@ bool LoadWCSim::Execute(){
 			cout<<"LoadWCSim Tool: Reached max entries specified in config file, terminating ToolChain"<<endl;
 			m_data->vars.Set("StopLoop",1);
 		} else {
-			int nbytesread = WCSimEntry->GetEntry(MCEventNum);  // <0 if out of file
+			int nbytesread = LoadEntry(MCEventNum);  // <0 if out of file
 			std::cout <<"Trying to get next event, MCEventNum: "<<MCEventNum<<", nbytesread: "<<nbytesread<<std::endl;
 			if(nbytesread<=0){
 				Log("LoadWCSim Tool: Reached last entry of WCSim input file, terminating ToolChain",v_warning,verbosity);
@@ -752,6 +460,17 @@ bool LoadWCSim::Execute(){
 }
 
 bool LoadWCSim::Finalise(){
+	StopPrefetch();
+	
+	double looptime = std::chrono::duration<double>(std::chrono::steady_clock::now()-loop_start).count();
+	if(entries_loaded>0 && looptime>0.){
+		logmessage = "LoadWCSim Tool: Loaded "+to_string(entries_loaded)+" MC entries ("+to_string(EventNumber)
+			+" triggers) in "+to_string(looptime)+" s: "+to_string(entries_loaded/looptime)+" entries/s, "
+			+to_string(EventNumber/looptime)+" triggers/s. "+to_string(100.*load_wait_time/looptime)+"% of the time was spent "
+			+((PrefetchEntries>0) ? "waiting for the read-ahead thread" : "reading and unpacking entries");
+		Log(logmessage,v_warning,verbosity);
+	}
+	
 	WCSimEntry->GetCurrentFile()->Close();
 	delete WCSimEntry;
 	
@@ -1214,13 +933,462 @@ Geometry* LoadWCSim::ConstructToolChainGeometry(){
 	return anniegeom;
 }
 
-void LoadWCSim::MakeParticleToPmtMap(WCSimRootTrigger* thistrig, WCSimRootTrigger* firstTrig, std::map<int,std::map<unsigned long,double>>* ParticleId_to_TubeIds, std::map<int,double>* ParticleId_to_Charge, std::map<int,unsigned long> tubeid_to_channelkey){
+int LoadWCSim::LoadEntry(uint64_t entry){
+	// returns the bytes read, as wcsimT::GetEntry: <=0 if there is no such entry
+	auto waitstart = std::chrono::steady_clock::now();
+	int nbytesread = 0;
+	if(PrefetchEntries<=0){
+		ReadEntry(entry, sync_buffer);
+		current_entry = &sync_buffer;
+		nbytesread = sync_buffer.nbytesread;
+	} else {
+		std::unique_lock<std::mutex> lock(prefetch_mutex);
+		// hand the previous entry back to the read-ahead thread
+		if(current_entry){
+			free_buffers.push_back(current_entry);
+			current_entry = nullptr;
+			prefetch_cv.notify_all();
+		}
+		if(not prefetch_thread.joinable() || entry!=prefetch_next_entry){
+			// first call or a user-selected event: read ahead from this entry
+			lock.unlock();
+			StopPrefetch();
+			StartPrefetch(entry);
+			lock.lock();
+		}
+		prefetch_cv.wait(lock, [this]{ return !ready_buffers.empty() || !prefetch_running; });
+		if(not ready_buffers.empty()){
+			current_entry = ready_buffers.front();
+			ready_buffers.pop_front();
+			prefetch_next_entry = entry+1;
+			nbytesread = current_entry->nbytesread;
+			prefetch_cv.notify_all();
+		}
+	}
+	load_wait_time += std::chrono::duration<double>(std::chrono::steady_clock::now()-waitstart).count();
+	if(nbytesread>0) entries_loaded++;
+	return nbytesread;
+}
+
+void LoadWCSim::StartPrefetch(uint64_t firstentry){
+	std::lock_guard<std::mutex> lock(prefetch_mutex);
+	prefetch_stop = false;
+	prefetch_running = true;
+	prefetch_next_entry = firstentry;
+	prefetch_thread = std::thread(&LoadWCSim::PrefetchLoop, this, firstentry);
+}
+
+void LoadWCSim::StopPrefetch(){
+	{
+		std::lock_guard<std::mutex> lock(prefetch_mutex);
+		prefetch_stop = true;
+	}
+	prefetch_cv.notify_all();
+	if(prefetch_thread.joinable()) prefetch_thread.join();
+	// entries read ahead but not used are dropped
+	std::lock_guard<std::mutex> lock(prefetch_mutex);
+	for(EntryBuffer* abuffer : ready_buffers) free_buffers.push_back(abuffer);
+	ready_buffers.clear();
+	prefetch_running = false;
+}
+
+void LoadWCSim::PrefetchLoop(uint64_t firstentry){
+	// runs on the read-ahead thread: reads entries in order into free buffers,
+	// until the input or MaxEntries is reached or StopPrefetch is called
+	uint64_t entry = firstentry;
+	while(true){
+		EntryBuffer* buffer = nullptr;
+		{
+			std::unique_lock<std::mutex> lock(prefetch_mutex);
+			prefetch_cv.wait(lock, [this]{ return prefetch_stop || !free_buffers.empty(); });
+			if(prefetch_stop) break;
+			// Execute stops the ToolChain at MaxEntries without asking for the entry
+			if(MaxEntries>0 && entry>=static_cast<uint64_t>(MaxEntries)) break;
+			buffer = free_buffers.back();
+			free_buffers.pop_back();
+		}
+		bool gotentry = ReadEntry(entry, *buffer);
+		{
+			std::lock_guard<std::mutex> lock(prefetch_mutex);
+			ready_buffers.push_back(buffer);
+		}
+		prefetch_cv.notify_all();
+		if(not gotentry) break;   // the empty entry tells Execute that the input has ended
+		entry++;
+	}
+	{
+		std::lock_guard<std::mutex> lock(prefetch_mutex);
+		prefetch_running = false;
+	}
+	prefetch_cv.notify_all();
+}
+
+bool LoadWCSim::ReadEntry(uint64_t entry, EntryBuffer& buffer){
+	// Reads a WCSim entry and unpacks all of its MC triggers into 'buffer'.
+	// Called from Execute or from the read-ahead thread, so this must only use WCSimEntry,
+	// the buffer and the maps filled in Initialise.
+	buffer.entry = entry;
+	buffer.MCParticles.clear();
+	buffer.trackid_to_mcparticleindex.clear();
+	buffer.primarymuonindex = -1;
+	buffer.has_neutrino = false;
+	buffer.particles_used = false;
+	buffer.numtriggers = 0;
+	buffer.timeArrayOffsetMap.clear();
+	
+	buffer.nbytesread = WCSimEntry->GetEntry(entry);
+	if(buffer.nbytesread<=0) return false;
+	buffer.MCFile = WCSimEntry->GetCurrentFile()->GetName();
+	
+	WCSimRootEvent* tankevent = WCSimEntry->wcsimrootevent;
+	buffer.numtriggers = tankevent->GetNumberOfEvents();
+	if(static_cast<int>(buffer.triggers.size())<buffer.numtriggers) buffer.triggers.resize(buffer.numtriggers);
+	
+	// cherenkovhit(times) and the genie information are all in first trig
+	WCSimRootTrigger* firsttrig = tankevent->GetTrigger(0);
+	buffer.GenieFile = firsttrig->GetHeader()->GetGenieFileName().Data();
+	buffer.GenieEntry = firsttrig->GetHeader()->GetGenieEntryNum();
+	
+	// Load ALL MC particles (for all delayed MC triggers), with times relative to the first trigger
+	uint64_t firsttriggertime = firsttrig->GetHeader()->GetDate();
+	for(int trigi=0; trigi<buffer.numtriggers; trigi++){
+		
+		WCSimRootTrigger* atrigtt = tankevent->GetTrigger(trigi);
+		if(verbosity>1) cout<<"getting "<<atrigtt->GetNtrack()<<" tracks from trigger "<<trigi<<endl;
+		for(int tracki=0; tracki<atrigtt->GetNtrack(); tracki++){
+			if(verbosity>2) cout<<"getting track "<<tracki<<endl;
+			WCSimRootTrack* nextrack = (WCSimRootTrack*)atrigtt->GetTracks()->At(tracki);
+			/* a WCSimRootTrack has methods:
+			Int_t     GetIpnu()             pdg
+			Int_t     GetFlag()             -1: neutrino primary, -2: neutrino target, 0: other
+			Float_t   GetM()                mass
+			Float_t   GetP()                momentum magnitude
+			Float_t   GetE()                energy (inc rest mass^2)
+			Float_t   GetEndE()             energy on stopping of particle tracking
+			Float_t   GetEndP()             momentum on stopping of particle tracking
+			Int_t     GetStartvol()         starting volume: 10 is tank, 20 is facc, 30 is mrd
+			Int_t     GetStopvol()          stopping volume: but these may not be set.
+			Float_t   GetDir(Int_t i=0)     momentum unit vector
+			Float_t   GetPdir(Int_t i=0)    momentum vector
+			Float_t   GetPdirEnd(Int_t i=0) direction vector on stop tracking
+			Float_t   GetStop(Int_t i=0)    stopping vertex x,y,z for i=0-2, in cm
+			Float_t   GetStart(Int_t i=0)   starting vertex x,y,z for i=0-2, in cm
+			Int_t     GetParenttype()       parent pdg, 0 for primary.
+			Float_t   GetTime()             trj->GetGlobalTime(); starting time of particle
+			Float_t   GetStopTime()
+			Int_t     GetId()               wcsim trackid
+			*/
+			
+			tracktype startstoptype = tracktype::UNDEFINED;
+			//MC particle times are relative to the trigger time
+			if(nextrack->GetFlag()!=0) {
+				if (nextrack->GetFlag()==-1){
+					MCParticle neutrino(
+					nextrack->GetIpnu(), nextrack->GetE(), nextrack->GetEndE(),
+					Position(nextrack->GetStart(0) / 100.,
+							 nextrack->GetStart(1) / 100.,
+							 nextrack->GetStart(2) / 100.),
+					Position(nextrack->GetStop(0) / 100.,
+							 nextrack->GetStop(1) / 100.,
+							 nextrack->GetStop(2) / 100.),
+					//MC particle times now stored relative to the trigger time
+					(static_cast<double>(nextrack->GetTime()-firsttriggertime)),
+					(static_cast<double>(nextrack->GetStopTime()-firsttriggertime)),
+					Direction(nextrack->GetDir(0), nextrack->GetDir(1), nextrack->GetDir(2)),
+					(sqrt(pow(nextrack->GetStop(0)-nextrack->GetStart(0),2.)+
+						 pow(nextrack->GetStop(1)-nextrack->GetStart(1),2.)+
+						 pow(nextrack->GetStop(2)-nextrack->GetStart(2),2.))) / 100.,
+					startstoptype,
+					nextrack->GetId(),
+					nextrack->GetParenttype(),
+					nextrack->GetFlag(),
+					trigi);
+
+					//Set the neutrino as its own particle
+					buffer.neutrino = neutrino;
+					buffer.has_neutrino = true;
+					
+					continue; // flag 0 only is normal particles: excludes neutrino
+				}
+			}
+			MCParticle thisparticle(
+				nextrack->GetIpnu(), nextrack->GetE(), nextrack->GetEndE(),
+				Position(nextrack->GetStart(0) / 100.,
+						 nextrack->GetStart(1) / 100.,
+						 nextrack->GetStart(2) / 100.),
+				Position(nextrack->GetStop(0) / 100.,
+						 nextrack->GetStop(1) / 100.,
+						 nextrack->GetStop(2) / 100.),
+				//MC particle times now stored relative to the trigger time
+				(static_cast<double>(nextrack->GetTime()-firsttriggertime)),
+				(static_cast<double>(nextrack->GetStopTime()-firsttriggertime)),
+				Direction(nextrack->GetDir(0), nextrack->GetDir(1), nextrack->GetDir(2)),
+				(sqrt(pow(nextrack->GetStop(0)-nextrack->GetStart(0),2.)+
+					 pow(nextrack->GetStop(1)-nextrack->GetStart(1),2.)+
+					 pow(nextrack->GetStop(2)-nextrack->GetStart(2),2.))) / 100.,
+				startstoptype,
+				nextrack->GetId(),
+				nextrack->GetParenttype(),
+				nextrack->GetFlag(),
+				trigi);
+			// not currently in constructor call, but we now have it in latest WCSim files
+			// XXX this will fall over with older WCSim files, whose WCSimLib doesn't have this method!
+			thisparticle.SetTankExitPoint(Position(nextrack->GetTankExitPoint(0)/ 100.,
+												   nextrack->GetTankExitPoint(1)/ 100.,
+												   nextrack->GetTankExitPoint(2)/ 100.));
+			if( (nextrack->GetIpnu()==13) &&
+				(nextrack->GetParenttype()==0) &&
+				(nextrack->GetFlag()==0) &&
+				(buffer.primarymuonindex<0) ){
+					// call this the primary muon. If we have more than one, use the first
+					buffer.primarymuonindex = buffer.MCParticles.size();
+			}
+			if((abs(nextrack->GetIpnu())==13)||
+			   (abs(nextrack->GetIpnu())==211)||
+			   (nextrack->GetIpnu()==111)){
+					if (verbosity > 0) {
+						std::cout<<"Found "<<nextrack->GetIpnu()<<" with parent pdg "
+						<<nextrack->GetParenttype()<<", flag "<<nextrack->GetFlag()
+						<<" track id "<<nextrack->GetId()
+						<< ", start vertex (" + to_string(nextrack->GetStart(0)/100.)
+						<< ", " + to_string(nextrack->GetStart(1)/100.)
+						<< ", " + to_string(nextrack->GetStart(2)/100.)
+						<< "), and end vertex (" + to_string(nextrack->GetStop(0)/100.)
+						<< ", " + to_string(nextrack->GetStop(1)/100.)
+						<< ", " + to_string(nextrack->GetStop(2)/100.)
+						<< ")"
+						<<std::endl;
+					}
+			}
+/*
+			// Print primary muons or the first track
+			if(((nextrack->GetIpnu()==13) && (nextrack->GetParenttype()==0))||
+			   (MCParticles->size()==0)){
+				if (verbosity) std::cout<<"Found "<<nextrack->GetIpnu()<<" with parent pdg "
+						<<nextrack->GetParenttype()<<", flag "<<nextrack->GetFlag()
+						<<" track id "<<nextrack->GetId()
+						<<" at position "<<MCParticles->size()<<std::endl;
+			}
+			// print pions
+			if((abs(nextrack->GetIpnu())==211)||
+			   (nextrack->GetIpnu()==111)){
+				if (verbosity) std::cout<<"Found "<<nextrack->GetIpnu()<<" with parent pdg "
+						<<nextrack->GetParenttype()<<", flag "<<nextrack->GetFlag()
+						<<" track id "<<nextrack->GetId()
+						<< ", start vertex (" + to_string(nextrack->GetStart(0)/100.)
+						<< ", " + to_string(nextrack->GetStart(1)/100.)
+						<< ", " + to_string(nextrack->GetStart(2)/100.)
+						<< "), and end vertex (" + to_string(nextrack->GetStop(0)/100.)
+						<< ", " + to_string(nextrack->GetStop(1)/100.)
+						<< ", " + to_string(nextrack->GetStop(2)/100.)
+						<< ")"
+						<<std::endl;
+			}
+			// print muons or gammas from pion decays
+			if(((abs(nextrack->GetIpnu())==13)||(nextrack->GetIpnu()==22)) &&
+			   ((abs(nextrack->GetParenttype())==211)||(nextrack->GetParenttype()==111))){
+				if (verbosity) std::cout<<"Found "<<nextrack->GetIpnu()<<" with parent pdg "
+						<<nextrack->GetParenttype()<<", flag "<<nextrack->GetFlag()
+						<<" track id "<<nextrack->GetId()
+						<<" at position "<<MCParticles->size()<<std::endl;
+			}
+*/
+			if(nextrack->GetIpnu()==13){
+				std::string muonmessage = "Muon found with flag: "+to_string(nextrack->GetFlag())
+					+ ", parent type " + to_string(nextrack->GetParenttype())
+					+ ", Id " + to_string(nextrack->GetId())
+					+ ", start vertex (" + to_string(nextrack->GetStart(0)/100.)
+					+ ", " + to_string(nextrack->GetStart(1)/100.)
+					+ ", " + to_string(nextrack->GetStart(2)/100.)
+					+ "), and end vertex (" + to_string(nextrack->GetStop(0)/100.)
+					+ ", " + to_string(nextrack->GetStop(1)/100.)
+					+ ", " + to_string(nextrack->GetStop(2)/100.)
+					+ ")";
+				if(verbosity>=v_debug) cout<<muonmessage<<endl;
+			}
+			
+			buffer.trackid_to_mcparticleindex.emplace(nextrack->GetId(),buffer.MCParticles.size());
+			buffer.MCParticles.push_back(thisparticle);
+		}
+		if(verbosity>2) cout<<"MCParticles has "<<buffer.MCParticles.size()<<" entries"<<endl;
+		
+	}  // loop over loading particles from all MC triggers
+	
+	for(int trigi=0; trigi<buffer.numtriggers; trigi++){
+		UnpackTrigger(trigi, buffer);
+	}
+	return true;
+}
+
+bool LoadWCSim::UnpackTrigger(int trignum, EntryBuffer& buffer){
+	// Fills buffer.triggers[trignum] with the digits of this MC trigger,
+	// for the collections selected with LoadCollections
+	TriggerBuffer& thetrigger = buffer.triggers.at(trignum);
+	thetrigger.MCHits.clear();
+	thetrigger.TDCData.clear();
+	thetrigger.mrd_firstlayer=false;
+	thetrigger.mrd_lastlayer=false;
+	thetrigger.ParticleId_to_TankTubeIds.clear();
+	thetrigger.ParticleId_to_MrdTubeIds.clear();
+	thetrigger.ParticleId_to_VetoTubeIds.clear();
+	thetrigger.ParticleId_to_TankCharge.clear();
+	thetrigger.ParticleId_to_MrdCharge.clear();
+	thetrigger.ParticleId_to_VetoCharge.clear();
+	thetrigger.error.clear();
+	
+	if(verbosity>1) cout<<"getting triggers"<<endl;
+	WCSimRootEvent* tankevent = WCSimEntry->wcsimrootevent;
+	WCSimRootEvent* mrdevent = (load_mrd) ? WCSimEntry->wcsimrootevent_mrd : nullptr;
+	WCSimRootEvent* vetoevent = (load_facc) ? WCSimEntry->wcsimrootevent_facc : nullptr;
+	// cherenkovhit(times) are all in first trig
+	WCSimRootTrigger* firsttrigt = tankevent->GetTrigger(0);
+	WCSimRootTrigger* firsttrigm = (mrdevent) ? mrdevent->GetTrigger(0) : nullptr;
+	WCSimRootTrigger* firsttrigv = (vetoevent) ? vetoevent->GetTrigger(0) : nullptr;
+	WCSimRootTrigger* atrigt = tankevent->GetTrigger(trignum);
+	WCSimRootTrigger* atrigm = (mrdevent && trignum<mrdevent->GetNumberOfEvents()) ? mrdevent->GetTrigger(trignum) : nullptr;
+	WCSimRootTrigger* atrigv = (vetoevent && trignum<vetoevent->GetNumberOfEvents()) ? vetoevent->GetTrigger(trignum) : nullptr;
+	if(verbosity>2) cout<<"atrigt="<<atrigt<<", atrigm="<<atrigm<<", atrigv="<<atrigv<<endl;
+	
+	thetrigger.RunNumber = atrigt->GetHeader()->GetRun();
+	thetrigger.EventTimeNs = atrigt->GetHeader()->GetDate();
+	
+	int numtankdigits = (load_tank && atrigt) ? atrigt->GetCherenkovDigiHits()->GetEntries() : 0;
+	if(verbosity>1) cout<<"looping over "<<numtankdigits<<" tank digits"<<endl;
+	for(int digiti=0; digiti<numtankdigits; digiti++){
+		if(verbosity>2) cout<<"getting digit "<<digiti<<endl;
+		WCSimRootCherenkovDigiHit* digihit =
+			(WCSimRootCherenkovDigiHit*)atrigt->GetCherenkovDigiHits()->At(digiti);
+		//WCSimRootChernkovDigiHit has methods GetTubeId(), GetT(), GetQ(), GetPhotonIds()
+		if(verbosity>2) cout<<"next digihit at "<<digihit<<endl;
+		int tubeid = digihit->GetTubeId();  // geometry TubeID->channelkey map is made INCLUDING offset of 1
+		if(verbosity>2) cout<<"tubeid="<<tubeid<<endl;
+		if(pmt_tubeid_to_channelkey.count(tubeid)==0){
+			thetrigger.error = "LoadWCSim ERROR: tank PMT with no associated ChannelKey!";
+			return false;
+		}
+		unsigned long key = pmt_tubeid_to_channelkey.at(tubeid);
+		if(verbosity>2) cout<<"ChannelKey="<<key<<endl;
+		double digittime = GetDigitTime(digihit, firsttrigt);
+		if(verbosity>2){ cout<<"digittime is "<<digittime<<" [ns] from Trigger"<<endl; }
+		float digiq = digihit->GetQ();
+		if(verbosity>2) cout<<"digit Q is "<<digiq<<endl;
+		// Get hit parent information
+		std::vector<int> parents = GetHitParentIds(digihit, firsttrigt, buffer);
+		
+		MCHit nexthit(key, digittime, digiq, parents);
+		if(thetrigger.MCHits.count(key)==0) thetrigger.MCHits.emplace(key, std::vector<MCHit>{nexthit});
+		else thetrigger.MCHits.at(key).push_back(nexthit);
+		if(verbosity>2) cout<<"digit added"<<endl;
+	}
+	if(verbosity>2) cout<<"done with tank digits"<<endl;
+	
+	//MRD Hits
+	int nummrddigits = atrigm ? atrigm->GetCherenkovDigiHits()->GetEntries() : 0;
+	if(verbosity>1) cout<<"adding "<<nummrddigits<<" mrd digits"<<endl;
+	for(int digiti=0; digiti<nummrddigits; digiti++){
+		if(verbosity>2) cout<<"getting digit "<<digiti<<endl;
+		WCSimRootCherenkovDigiHit* digihit =
+			(WCSimRootCherenkovDigiHit*)atrigm->GetCherenkovDigiHits()->At(digiti);
+		if(verbosity>2) cout<<"next digihit at "<<digihit<<endl;
+		int tubeid = digihit->GetTubeId();
+		if(verbosity>2) cout<<"tubeid="<<tubeid<<endl;
+		if(mrd_tubeid_to_channelkey.count(tubeid)==0){
+			thetrigger.error = "LoadWCSim ERROR: MRD PMT with no associated ChannelKey!";
+			return false;
+		}
+		unsigned long key = mrd_tubeid_to_channelkey.at(tubeid);
+		double digittime = GetDigitTime(digihit, firsttrigm);
+		if(verbosity>2){ cout<<"digittime is "<<digittime<<" [ns] from Trigger"<<endl; }
+		float digiq = digihit->GetQ();
+		if(verbosity>2) cout<<"digit Q is "<<digiq<<endl;
+		// Get hit parent information
+		std::vector<int> parents = GetHitParentIds(digihit, firsttrigm, buffer);
+		
+		MCHit nexthit(key, digittime, digiq, parents);
+		if(thetrigger.TDCData.count(key)==0){
+			thetrigger.TDCData.emplace(key, std::vector<MCHit>{nexthit});
+			if (Mrd_Chankey_Layer.at(key)==0) thetrigger.mrd_firstlayer=true;
+			if (Mrd_Chankey_Layer.at(key)==10) thetrigger.mrd_lastlayer=true;
+		}
+		else thetrigger.TDCData.at(key).push_back(nexthit);
+		if(verbosity>2) cout<<"digit added"<<endl;
+	}
+	if(verbosity>2) cout<<"done with mrd digits"<<endl;
+	
+	// Veto Hits
+	int numvetodigits = atrigv ? atrigv->GetCherenkovDigiHits()->GetEntries() : 0;
+	if(verbosity>1) cout<<"adding "<<numvetodigits<<" veto digits"<<endl;
+	for(int digiti=0; digiti<numvetodigits; digiti++){
+		if(verbosity>2) cout<<"getting digit "<<digiti<<endl;
+		WCSimRootCherenkovDigiHit* digihit =
+			(WCSimRootCherenkovDigiHit*)atrigv->GetCherenkovDigiHits()->At(digiti);
+		if(verbosity>2) cout<<"next digihit at "<<digihit<<endl;
+		int tubeid = digihit->GetTubeId();
+		if(verbosity>2) cout<<"tubeid="<<tubeid<<endl;
+		if(facc_tubeid_to_channelkey.count(tubeid)==0){
+			thetrigger.error = "LoadWCSim ERROR: FACC PMT with no associated ChannelKey!";
+			return false;
+		}
+		unsigned int key = facc_tubeid_to_channelkey.at(tubeid);
+		double digittime = GetDigitTime(digihit, firsttrigv);
+		if(verbosity>2){ cout<<"digittime is "<<digittime<<" [ns] from Trigger"<<endl; }
+		float digiq = digihit->GetQ();
+		if(verbosity>2) cout<<"digit Q is "<<digiq<<endl;
+		// Get hit parent information
+		std::vector<int> parents = GetHitParentIds(digihit, firsttrigv, buffer);
+		
+		MCHit nexthit(key, digittime, digiq, parents);
+		if(thetrigger.TDCData.count(key)==0) thetrigger.TDCData.emplace(key, std::vector<MCHit>{nexthit});
+		else thetrigger.TDCData.at(key).push_back(nexthit);
+		if(verbosity>2) cout<<"digit added"<<endl;
+	}
+	if(verbosity>2) cout<<"done with veto digits"<<endl;
+	
+	// update the information about tracks and which tank/mrd/veto PMTs they hit
+	// this needs updating with each MC trigger, as digits are grouped into MC trigger
+	// so these maps will then only contain the digits respective particles create
+	// in the active trigger
+	// 
+	// ParticleId_to_TankTubeIds is a std::map<ParticleId,std::map<ChannelKey,TotalCharge>>
+	// where TotalCharge is the total charge from that particle on that tube
+	// (in the event that the particle generated several hits on the tube)
+	// ParticleId_to_TankCharge is a std::map<ParticleId,TotalCharge> 
+	// where TotalCharge is summed over all digits, on all pmts, which contained
+	// light from that particle
+	MakeParticleToPmtMap((load_tank) ? atrigt : nullptr, firsttrigt, &thetrigger.ParticleId_to_TankTubeIds, &thetrigger.ParticleId_to_TankCharge, pmt_tubeid_to_channelkey, buffer.timeArrayOffsetMap);
+	MakeParticleToPmtMap(atrigm, firsttrigm, &thetrigger.ParticleId_to_MrdTubeIds, &thetrigger.ParticleId_to_MrdCharge, mrd_tubeid_to_channelkey, buffer.timeArrayOffsetMap);
+	MakeParticleToPmtMap(atrigv, firsttrigv, &thetrigger.ParticleId_to_VetoTubeIds, &thetrigger.ParticleId_to_VetoCharge, facc_tubeid_to_channelkey, buffer.timeArrayOffsetMap);
+	
+	return true;
+}
+
+double LoadWCSim::GetDigitTime(WCSimRootCherenkovDigiHit* digihit, WCSimRootTrigger* firstTrig){
+	if(use_smeared_digit_time){
+		return static_cast<double>(digihit->GetT()-HistoricTriggeroffset); // relative to trigger
+	}
+	// instead take the true time of the first photon
+	std::vector<int> photonids = digihit->GetPhotonIds();   // indices of the digit's photons
+	double earliestphotontruetime=999999999999;
+	for(int& aphotonindex : photonids){
+		WCSimRootCherenkovHitTime* thehittimeobject =
+			 (WCSimRootCherenkovHitTime*)firstTrig->GetCherenkovHitTimes()->At(aphotonindex);
+		if(thehittimeobject==nullptr){
+			cerr<<"LoadWCSim Tool: ERROR! Retrieval of photon from digit returned nullptr!"<<endl;
+			continue;
+		}
+		double aphotontime = static_cast<double>(thehittimeobject->GetTruetime());
+		if(aphotontime<earliestphotontruetime){ earliestphotontruetime = aphotontime; }
+	}
+	return earliestphotontruetime;
+}
+
+void LoadWCSim::MakeParticleToPmtMap(WCSimRootTrigger* thistrig, WCSimRootTrigger* firstTrig, std::map<int,std::map<unsigned long,double>>* ParticleId_to_TubeIds, std::map<int,double>* ParticleId_to_Charge, const std::map<int,unsigned long>& tubeid_to_channelkey, std::map<int,int>& timeArrayOffsetMap){
 	if(thistrig==nullptr) return;
 	ParticleId_to_TubeIds->clear();
 	ParticleId_to_Charge->clear();
 	// scan through the parents IDs of the photons contributing to each digit
 	// make note of which parent contributes to which digit, and which digits are associated with each parent
-	Log("Making Particle to PMT Map",v_message,verbosity);
+	if(verbosity>1) cout<<"Making Particle to PMT Map"<<endl;
 	// technically the charge will be a lower limit as this sums the charge from all digits
 	// that a given particle contributed to, but not all this digit's charge may have been
 	// from this particle.
@@ -1241,7 +1409,7 @@ void LoadWCSim::MakeParticleToPmtMap(WCSimRootTrigger* thistrig, WCSimRootTrigge
 			int thephotonsid = truephotonindices.at(truephoton);
 			// get the index of the photon CherenkovHit object in the TClonesArray
 			if(WCSimVersion<2){
-				if(timeArrayOffsetMap.size()==0) BuildTimeArrayOffsetMap(firstTrig);
+				if(timeArrayOffsetMap.size()==0) BuildTimeArrayOffsetMap(firstTrig, timeArrayOffsetMap);
 				thephotonsid+=timeArrayOffsetMap.at(tubeid);
 			}
 			// Get the CherenkovHitTime object that records the photon's Parent ID
@@ -1292,7 +1460,7 @@ void LoadWCSim::MakeParticleToPmtMap(WCSimRootTrigger* thistrig, WCSimRootTrigge
 	}  // end loop over digits
 }
 
-std::vector<int> LoadWCSim::GetHitParentIds(WCSimRootCherenkovDigiHit* digihit, WCSimRootTrigger* firstTrig){
+std::vector<int> LoadWCSim::GetHitParentIds(WCSimRootCherenkovDigiHit* digihit, WCSimRootTrigger* firstTrig, EntryBuffer& buffer){
 	/* Get the ID of the MCParticle(s) that produced this digit */
 	std::vector<int> parentids; // a hit could technically have more than one contrbuting particle
 	
@@ -1302,8 +1470,8 @@ std::vector<int> LoadWCSim::GetHitParentIds(WCSimRootCherenkovDigiHit* digihit,
 		int thephotonsid = truephotonindices.at(truephoton);
 		// get the indices of the digit's photon CherenkovHitTime objects
 		if(WCSimVersion<2){
-			if(timeArrayOffsetMap.size()==0) BuildTimeArrayOffsetMap(firstTrig);
-			thephotonsid+=timeArrayOffsetMap.at(digihit->GetTubeId());
+			if(buffer.timeArrayOffsetMap.size()==0) BuildTimeArrayOffsetMap(firstTrig, buffer.timeArrayOffsetMap);
+			thephotonsid+=buffer.timeArrayOffsetMap.at(digihit->GetTubeId());
 		}
 		// get the CherenkovHitTime objects themselves, which contain the photon parent IDs
 		WCSimRootCherenkovHitTime *thehittimeobject = 
@@ -1312,15 +1480,15 @@ std::vector<int> LoadWCSim::GetHitParentIds(WCSimRootCherenkovDigiHit* digihit,
 		else {
 			int theparenttrackid = thehittimeobject->GetParentID();
 			// check if this parent track was saved. Not all particles are saved.
-			if(trackid_to_mcparticleindex->count(theparenttrackid)){
-				parentids.push_back(trackid_to_mcparticleindex->at(theparenttrackid));
+			if(buffer.trackid_to_mcparticleindex.count(theparenttrackid)){
+				parentids.push_back(buffer.trackid_to_mcparticleindex.at(theparenttrackid));
 			} // else this photon may have come from e.g. an electron or gamma that wasn't recorded
 		}
 	}
 	return parentids;
 }
 
-void LoadWCSim::BuildTimeArrayOffsetMap(WCSimRootTrigger* firstTrig){
+void LoadWCSim::BuildTimeArrayOffsetMap(WCSimRootTrigger* firstTrig, std::map<int,int>& timeArrayOffsetMap){
 	if(WCSimVersion<2){
 		// The CherenkovHitTimes is a flattened array (over PMTs) of arrays (over photons)
 		// For WCSimVersion<2, the PhotonIds available from a digit are the indices 
@@ -1341,6 +1509,6 @@ void LoadWCSim::BuildTimeArrayOffsetMap(WCSimRootTrigger* firstTrig){
 			timeArrayOffsetMap.emplace(tubeNumber,timeArrayOffset);
 		}
 	} else {
-		Log("LoadWCSim Tool: BuildTimeArrayOffsetMap called with WCSimVersion<2: This is not needed!?",v_error,verbosity);
+		cerr<<"LoadWCSim Tool: BuildTimeArrayOffsetMap called with WCSimVersion>=2: This is not needed!?"<<endl;
 	}
 }
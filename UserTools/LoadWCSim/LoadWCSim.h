@@ -4,6 +4,15 @@
 
 #include <string>
 #include <iostream>
+#include <vector>
+#include <map>
+#include <deque>
+#include <sstream>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
 //#include <boost/algorithm/string.hpp>  // for boost::algorithm::to_lower(string)
 
 #include "Tool.h"
@@ -55,6 +64,41 @@ class LoadWCSim: public Tool {
 	
 	private:
 	
+	// One MC trigger, unpacked from the WCSim entry into the types put in the ANNIEEvent
+	struct TriggerBuffer {
+		uint32_t RunNumber=0;
+		uint64_t EventTimeNs=0;
+		std::map<unsigned long,std::vector<MCHit>> MCHits;
+		std::map<unsigned long,std::vector<MCHit>> TDCData;
+		bool mrd_firstlayer=false;
+		bool mrd_lastlayer=false;
+		std::map<int,std::map<unsigned long,double>> ParticleId_to_TankTubeIds;
+		std::map<int,std::map<unsigned long,double>> ParticleId_to_MrdTubeIds;
+		std::map<int,std::map<unsigned long,double>> ParticleId_to_VetoTubeIds;
+		std::map<int,double> ParticleId_to_TankCharge;
+		std::map<int,double> ParticleId_to_MrdCharge;
+		std::map<int,double> ParticleId_to_VetoCharge;
+		std::string error;   // set if the trigger could not be unpacked
+	};
+	// One WCSim entry with all its MC triggers. Buffers are reused from entry to entry:
+	// the contents are swapped into the objects held by the ANNIEEvent.
+	struct EntryBuffer {
+		uint64_t entry=0;
+		int nbytesread=0;    // as returned by wcsimT::GetEntry: <=0 if there was no entry
+		std::string MCFile;
+		std::string GenieFile;
+		int GenieEntry=0;
+		std::vector<MCParticle> MCParticles;
+		std::map<int,int> trackid_to_mcparticleindex;
+		int primarymuonindex=-1;
+		bool has_neutrino=false;
+		MCParticle neutrino;
+		bool particles_used=false;   // MCParticles have been handed to the ANNIEEvent
+		int numtriggers=0;
+		std::vector<TriggerBuffer> triggers;   // only grows; the first numtriggers are valid
+		std::map<int,int> timeArrayOffsetMap;
+	};
+	
 	// variables from config file
 	/////////////////////////////
 	int verbosity=1;
@@ -63,14 +107,16 @@ class LoadWCSim: public Tool {
 	int LappdNumStrips;           // number of Channels per LAPPD
 	double LappdStripLength;      // [mm] for calculating relative x position for dual-ended readout
 	double LappdStripSeparation;  // [mm] for calculating relative y position of each stripline
+	int PrefetchEntries=0;        // entries read and unpacked ahead by a background thread. 0: read in Execute
+	bool load_tank=true;          // unpack tank PMT digits (LoadCollections)
+	bool load_mrd=true;           // read and unpack the MRD branch
+	bool load_facc=true;          // read and unpack the FACC branch
 	
 	// WCSim variables
 	//////////////////
 	//TFile* file;
 	//TTree* wcsimtree;
 	wcsimT* WCSimEntry; // from makeclass
-	WCSimRootTrigger* atrigt, *atrigm, *atrigv;
-	WCSimRootTrigger* firsttrigt, *firsttrigm, *firsttrigv;
 	WCSimRootGeom* wcsimrootgeom;
 	WCSimRootOptions* wcsimrootopts;
 	int WCSimVersion;   // WCSim version
@@ -99,10 +145,37 @@ class LoadWCSim: public Tool {
 	// alternatively? Better? Save the parentage in each MCHit. Each MCHit will contain
 	// the index of it's parent MCParticle in the MCParticles vector
 	std::map<int,int>* trackid_to_mcparticleindex=nullptr;
-	std::vector<int> GetHitParentIds(WCSimRootCherenkovDigiHit* digihit, WCSimRootTrigger* firstTrig);
-	std::map<int,int> timeArrayOffsetMap;
-	void BuildTimeArrayOffsetMap(WCSimRootTrigger* firstTrig);
+	std::vector<int> GetHitParentIds(WCSimRootCherenkovDigiHit* digihit, WCSimRootTrigger* firstTrig, EntryBuffer& buffer);
+	void BuildTimeArrayOffsetMap(WCSimRootTrigger* firstTrig, std::map<int,int>& timeArrayOffsetMap);
 	int triggers_event;	
+	
+	// Reading and unpacking WCSim entries
+	//////////////////////////////////////
+	bool ReadEntry(uint64_t entry, EntryBuffer& buffer);   // GetEntry and unpack all triggers
+	bool UnpackTrigger(int trignum, EntryBuffer& buffer);
+	double GetDigitTime(WCSimRootCherenkovDigiHit* digihit, WCSimRootTrigger* firstTrig);
+	int LoadEntry(uint64_t entry);   // make current_entry hold 'entry'; returns bytes read, <=0 at the end of the input
+	EntryBuffer sync_buffer;         // used when entries are read in Execute
+	EntryBuffer* current_entry=nullptr;
+	
+	// read-ahead thread: owns WCSimEntry while it runs
+	void PrefetchLoop(uint64_t firstentry);
+	void StartPrefetch(uint64_t firstentry);
+	void StopPrefetch();
+	std::thread prefetch_thread;
+	std::mutex prefetch_mutex;
+	std::condition_variable prefetch_cv;
+	std::vector<std::unique_ptr<EntryBuffer>> prefetch_buffers;
+	std::vector<EntryBuffer*> free_buffers;
+	std::deque<EntryBuffer*> ready_buffers;   // unpacked entries, in entry order
+	bool prefetch_running=false;
+	bool prefetch_stop=false;
+	uint64_t prefetch_next_entry=0;           // entry expected at the front of ready_buffers
+	
+	// throughput report
+	std::chrono::steady_clock::time_point loop_start;
+	double load_wait_time=0.;   // [s] spent in Execute reading entries, or waiting for the read-ahead thread
+	long entries_loaded=0;
 
 	// FIXME temporary!! remove me when we have a better way to get FACC paddle origins
 	std::vector<double> facc_paddle_yorigins{-198.699875000, -167.999875000, -137.299875000, -106.599875000, -75.899875000, -45.199875000, -14.499875000, 16.200125000, 46.900125000, 77.600125000, 108.300125000, 139.000125000, 169.700125000, -198.064875000, -167.364875000, -136.664875000, -105.964875000, -75.264875000, -44.564875000, -13.864875000, 16.835125000, 47.535125000, 78.235125000, 108.935125000, 139.635125000, 170.335125000}; // taken from geofile.txt
@@ -132,7 +205,7 @@ class LoadWCSim: public Tool {
 	int primarymuonindex;
 	
 	// additional info
-	void MakeParticleToPmtMap(WCSimRootTrigger* thisTrig, WCSimRootTrigger* firstTrig, std::map<int,std::map<unsigned long,double>>* ParticleId_to_DigitIds, std::map<int,double>* ChargeFromParticleId, std::map<int,unsigned long> tubeid_to_channelkey);
+	void MakeParticleToPmtMap(WCSimRootTrigger* thisTrig, WCSimRootTrigger* firstTrig, std::map<int,std::map<unsigned long,double>>* ParticleId_to_DigitIds, std::map<int,double>* ChargeFromParticleId, const std::map<int,unsigned long>& tubeid_to_channelkey, std::map<int,int>& timeArrayOffsetMap);
 	std::map<int,std::map<unsigned long,double>>* ParticleId_to_TankTubeIds = nullptr;
 	std::map<int,std::map<unsigned long,double>>* ParticleId_to_MrdTubeIds = nullptr;
 	std::map<int,std::map<unsigned long,double>>* ParticleId_to_VetoTubeIds = nullptr;
@@ -74,6 +74,7 @@ public :
    virtual void     Show(Long64_t entry = -1);
    virtual TFile*   GetCurrentFile();
    virtual ULong64_t GetEntries();
+   virtual void     SetDetectorBranches(bool mrd, bool facc);
 };
 
 #endif
@@ -266,6 +267,14 @@ ULong64_t wcsimT::GetEntries(){
    return std::numeric_limits<ULong64_t>::max(); // THIS CRASHES WITH TCHAINS ON PNFS!
 }
 
+void wcsimT::SetDetectorBranches(bool mrd, bool facc){
+   // disabled branches are not read by GetEntry; the tank branch is always read,
+   // it holds the event header and the MC tracks
+   if(!fChain) return;
+   fChain->SetBranchStatus("wcsimrootevent_mrd*",mrd);
+   fChain->SetBranchStatus("wcsimrootevent_facc*",facc);
+}
+
 Bool_t wcsimT::Notify()
 {
    // The Notify() function is called when a new file is opened. This
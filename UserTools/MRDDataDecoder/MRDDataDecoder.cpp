@@ -21,10 +21,32 @@ bool MRDDataDecoder::Initialise(std::string configfile, DataModel &data){
   TimeZoneShift = 21600000;
   if(DaylightSavings) TimeZoneShift = 18000000;
 
+  m_variables.Get("BenchmarkHandoff",DoHandoffBenchmark);
+  m_variables.Get("HandoffReportInterval",HandoffReportInterval);
+  if (HandoffReportInterval < 1) HandoffReportInterval = 1000;
+
   m_data->CStore.Get("MRDCrateSpaceToChannelNumMap",MRDCrateSpaceToChannelNumMap);
   m_data->CStore.Set("NewMRDDataAvailable",false);
 
+  //The queue is not serialisable: its address goes in the CStore, and this tool deletes it in Finalise
+  DecodedMRDEvents = new MRDEventQueue;
+  intptr_t DecodedMRDEventsPtr = reinterpret_cast<intptr_t>(DecodedMRDEvents);
+  m_data->CStore.Set("MRDEventQueue",DecodedMRDEventsPtr);
+
   m_data->CStore.Set("PauseMRDDecoding",false);
+
+  //Pipelined decoding (LoadRawData DecodeMode Pipelined): entries are decoded in a
+  //worker thread, and the triggers go to the event builder through the pipeline
+  intptr_t DecodePipelinePtr = 0;
+  m_data->CStore.Get("RawDecodePipeline",DecodePipelinePtr);
+  DecodePipeline = RawDecodePipeline::FromCStore(DecodePipelinePtr);
+  if (DecodePipeline){
+    DecodePipeline->Retain();
+    DecodePipeline->Attach(RawDecodePipeline::MRD);
+    DecodeStats = PipelineStageStats();
+    DecodeThread = std::thread(&MRDDataDecoder::DecodeLoop,this);
+    Log("MRDDataDecoder Tool: Decoding MRD entries in a worker thread",v_message,verbosity);
+  }
   Log("MRDDataDecoder Tool: Initialized successfully",v_message,verbosity);
   return true;
 }
@@ -32,6 +54,7 @@ bool MRDDataDecoder::Initialise(std::string configfile, DataModel &data){
 
 bool MRDDataDecoder::Execute(){
   m_data->CStore.Set("NewMRDDataAvailable",false);
+  if (DecodePipeline) return true;  //entries are decoded by DecodeLoop
 
   bool NewEntryAvailable;
   m_data->CStore.Get("NewRawDataEntryAccessed",NewEntryAvailable);
@@ -52,87 +75,134 @@ bool MRDDataDecoder::Execute(){
   /////////////////// getting MRD Data ////////////////////
   Log("MRDDataDecoder Tool: Accessing MRDData from CStore",v_message,verbosity); 
   m_data->CStore.Get("MRDData",mrddata);
-  std::string mrdTriggertype = "No Loopback";
-  std::vector<unsigned long> chankeys;
-  uint64_t timestamp = static_cast<uint64_t>(mrddata->TimeStamp);    //in ms since 1970/1/1
+  DecodedMRDEvent anEvent;
+  this->DecodeMRDEntry(*mrddata, anEvent);
+  uint64_t timestamp = anEvent.Timestamp;
+
+  //Hand the trigger to the ANNIEEventBuilder through the MRDEventQueue.  Only this
+  //trigger is added; the pending triggers already in the queue are not touched.
+  Log("MRDDataDecoder Tool: Appending decoded MRD trigger to MRDEventQueue.",v_debug, verbosity);
+  auto handoff_start = std::chrono::steady_clock::now();
+  if (DoHandoffBenchmark){
+    DecodedMRDEvent EventCopy = anEvent;
+    DecodedMRDEvents->push_back(std::move(anEvent));
+    double QueueSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now()-handoff_start).count();
+    this->BenchmarkHandoff(EventCopy, QueueSeconds);
+  } else {
+    DecodedMRDEvents->push_back(std::move(anEvent));
+  }
+  m_data->CStore.Set("MRDLatestTimestamp",timestamp);
+  m_data->CStore.Set("NewMRDDataAvailable",true);
+
+  Log("MRDDataDecoder Tool: Size of MRDEventQueue (# MRD Triggers waiting to be built):" + 
+          to_string(DecodedMRDEvents->size()),v_debug, verbosity);
+
+  ////////////// END EXECUTE LOOP ///////////////
+  return true;
+}
+
+
+bool MRDDataDecoder::Finalise(){
+  if (DecodePipeline){
+    DecodePipeline->Shutdown(RawDecodePipeline::MRD);
+    if (DecodeThread.joinable()) DecodeThread.join();
+    Log("MRDDataDecoder Tool: Pipelined decoding: "+DecodeStats.Summary(),v_warning,verbosity);
+    Log("MRDDataDecoder Tool: Pipelined decoding: "+DecodePipeline->QueueSummary(RawDecodePipeline::MRD),v_warning,verbosity);
+    RawDecodePipeline::Release(DecodePipeline);
+  }
+  if (DoHandoffBenchmark && HandoffEntries > 0){
+    Log("MRDDataDecoder Tool: Hand-off cost per MRD entry over last " + to_string(HandoffEntries) +
+            " entries: queue " + to_string(QueueHandoffSeconds/HandoffEntries*1.0e6) + " us, full-map CStore round trip " +
+            to_string(LegacyHandoffSeconds/HandoffEntries*1.0e6) + " us",v_warning,verbosity);
+  }
+  delete DecodedMRDEvents;
+  DecodedMRDEvents = nullptr;
+  Log("MRDDataDecoder tool exitting",v_message,verbosity);
+  return true;
+}
+
+void MRDDataDecoder::DecodeMRDEntry(const MRDOut& Entry, DecodedMRDEvent& anEvent)
+{
+  uint64_t timestamp = static_cast<uint64_t>(Entry.TimeStamp);    //in ms since 1970/1/1
   // before anything else convert it to UTC ns
   timestamp = (timestamp+TimeZoneShift)*1E6;
-  std::vector<std::pair<unsigned long, int>> ChankeyTimePairs;
-  MRDEvents.emplace(timestamp,ChankeyTimePairs);
+  anEvent = DecodedMRDEvent();
+  anEvent.Timestamp = timestamp;
+  anEvent.Hits.reserve(Entry.Crate.size());
   
   bool cosmic_loopback = false;
   bool beam_loopback = false;
-  int cosmic_tdc = -1;
-  int beam_tdc = -1;
   std::vector<int> CrateSlotChannel_Beam{7,11,15};
   std::vector<int> CrateSlotChannel_Cosmic{7,11,14};
     
   //For each entry, loop over all crates and get data
-  for (unsigned int i_data = 0; i_data < mrddata->Crate.size(); i_data++){
-    int crate = mrddata->Crate.at(i_data);
-    int slot = mrddata->Slot.at(i_data);
-    int channel = mrddata->Channel.at(i_data);
-    int hittimevalue = mrddata->Value.at(i_data);
+  for (unsigned int i_data = 0; i_data < Entry.Crate.size(); i_data++){
+    int crate = Entry.Crate.at(i_data);
+    int slot = Entry.Slot.at(i_data);
+    int channel = Entry.Channel.at(i_data);
+    int hittimevalue = Entry.Value.at(i_data);
     std::vector<int> CrateSlotChannel{crate,slot,channel};
     unsigned long chankey = MRDCrateSpaceToChannelNumMap[CrateSlotChannel];
     if (CrateSlotChannel != CrateSlotChannel_Beam && CrateSlotChannel != CrateSlotChannel_Cosmic){
       std::pair <unsigned long,int> keytimepair(chankey,hittimevalue);  //chankey will be 0 when looking at loopback channels that don't have an entry in the mapping-->skip
-      MRDEvents[timestamp].push_back(keytimepair);
+      anEvent.Hits.push_back(keytimepair);
     }
-    if (crate == 7 && slot == 11 && channel == 14) {cosmic_loopback=true; cosmic_tdc = hittimevalue;}   //FIXME: don't hard-code the trigger channels?
-    if (crate == 7 && slot == 11 && channel == 15) {beam_loopback=true; beam_tdc = hittimevalue;}     //FIXME: don't hard-code the trigger channels?
+    if (crate == 7 && slot == 11 && channel == 14) {cosmic_loopback=true; anEvent.CosmicLoopbackTDC = hittimevalue;}   //FIXME: don't hard-code the trigger channels?
+    if (crate == 7 && slot == 11 && channel == 15) {beam_loopback=true; anEvent.BeamLoopbackTDC = hittimevalue;}     //FIXME: don't hard-code the trigger channels?
   }
   
-  if (beam_loopback) mrdTriggertype = "Beam";
-  if (cosmic_loopback) mrdTriggertype = "Cosmic";      //prefer cosmic loopback over beam loopback (cosmic event will always also have a beam loopback entry)
-
-  CosmicLoopbackMap.emplace(timestamp,cosmic_tdc);
-  BeamLoopbackMap.emplace(timestamp,beam_tdc);
-
-  //Entry processing done.  Label the trigger type and increment index
-  TriggerTypeMap.emplace(timestamp,mrdTriggertype);
-
-  //MRD Data file fully processed.   
-  //Push the map of TriggerTypeMap and FinishedMRDHits 
-  //to the CStore for ANNIEEvent to start Building ANNIEEvents. 
-  Log("MRDDataDecoder Tool: Saving Finished MRD Data into CStore.",v_debug, verbosity);
-  //FIXME: add a check for if there is or is not an entry in the CStore
-  m_data->CStore.Get("MRDEvents",CStoreMRDEvents);
-  CStoreMRDEvents.insert(MRDEvents.begin(),MRDEvents.end());
-  m_data->CStore.Set("MRDEvents",CStoreMRDEvents);
-
-  m_data->CStore.Get("MRDEventTriggerTypes",CStoreTriggerTypeMap);
-  CStoreTriggerTypeMap.insert(TriggerTypeMap.begin(),TriggerTypeMap.end());
-  m_data->CStore.Set("MRDEventTriggerTypes",CStoreTriggerTypeMap);
- 
-  m_data->CStore.Get("MRDBeamLoopback",CStoreBeamLoopbackMap);
-  CStoreBeamLoopbackMap.insert(BeamLoopbackMap.begin(),BeamLoopbackMap.end());
-  m_data->CStore.Set("MRDBeamLoopback",CStoreBeamLoopbackMap);
- 
-  m_data->CStore.Get("MRDCosmicLoopback",CStoreCosmicLoopbackMap);
-  CStoreCosmicLoopbackMap.insert(CosmicLoopbackMap.begin(),CosmicLoopbackMap.end());
-  m_data->CStore.Set("MRDCosmicLoopback",CStoreCosmicLoopbackMap);
-  
-  m_data->CStore.Set("NewMRDDataAvailable",true);
-
-  //Check the size of the WaveBank to see if things are bloating
-  Log("MRDDataDecoder Tool: Size of MRDEvents in CStore (# MRD Triggers processed):" + 
-          to_string(CStoreMRDEvents.size()),v_debug, verbosity);
-  Log("MRDDataDecoder Tool: Size of TriggerTypeMap in CStore:" + 
-          to_string(CStoreTriggerTypeMap.size()),v_debug, verbosity);
-
-  std::cout << "MRD EVENT CSTORE ENTRIES SET SUCCESSFULLY.  Clearing MRDEvent vector in MRDDataDecoder tool." << std::endl;
-  MRDEvents.clear();
-  TriggerTypeMap.clear();
-  BeamLoopbackMap.clear();
-  CosmicLoopbackMap.clear();
-
-  ////////////// END EXECUTE LOOP ///////////////
-  return true;
+  //Entry processing done.  Label the trigger type
+  if (beam_loopback) anEvent.TriggerType = "Beam";
+  if (cosmic_loopback) anEvent.TriggerType = "Cosmic";      //prefer cosmic loopback over beam loopback (cosmic event will always also have a beam loopback entry)
 }
 
+void MRDDataDecoder::DecodeLoop()
+{
+  //Runs on the worker thread in pipelined mode: decodes the MRD entries read by
+  //LoadRawData and hands each trigger to the ANNIEEventBuilder
+  RawMRDEntry entry;
+  while (DecodePipeline->PopInput(entry,DecodeStats)){
+    auto start = std::chrono::steady_clock::now();
+    DecodedMRDEvent anEvent;
+    this->DecodeMRDEntry(entry.Data, anEvent);
+    DecodeStats.Items++;
+    DecodeStats.BusySeconds += std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count();
+    if (!DecodePipeline->PushOutput(std::move(anEvent),DecodeStats)) break;
+  }
+  DecodePipeline->CloseOutput(RawDecodePipeline::MRD);
+}
 
-bool MRDDataDecoder::Finalise(){
-  Log("MRDDataDecoder tool exitting",v_message,verbosity);
-  return true;
+void MRDDataDecoder::BenchmarkHandoff(const DecodedMRDEvent& anEvent, double QueueSeconds)
+{
+  //Replay the hand-off this tool used to do for every entry: Get every accumulated
+  //map from the CStore, insert this trigger, and Set them all back.  Nothing is
+  //drained from these maps, so their size grows with the part file like the CStore
+  //maps did when the event builder fell behind.
+  auto start = std::chrono::steady_clock::now();
+  LegacyHandoffStore.Get("MRDEvents",LegacyMRDEvents);
+  LegacyMRDEvents.emplace(anEvent.Timestamp,anEvent.Hits);
+  LegacyHandoffStore.Set("MRDEvents",LegacyMRDEvents);
+  LegacyHandoffStore.Get("MRDEventTriggerTypes",LegacyTriggerTypeMap);
+  LegacyTriggerTypeMap.emplace(anEvent.Timestamp,anEvent.TriggerType);
+  LegacyHandoffStore.Set("MRDEventTriggerTypes",LegacyTriggerTypeMap);
+  LegacyHandoffStore.Get("MRDBeamLoopback",LegacyBeamLoopbackMap);
+  LegacyBeamLoopbackMap.emplace(anEvent.Timestamp,anEvent.BeamLoopbackTDC);
+  LegacyHandoffStore.Set("MRDBeamLoopback",LegacyBeamLoopbackMap);
+  LegacyHandoffStore.Get("MRDCosmicLoopback",LegacyCosmicLoopbackMap);
+  LegacyCosmicLoopbackMap.emplace(anEvent.Timestamp,anEvent.CosmicLoopbackTDC);
+  LegacyHandoffStore.Set("MRDCosmicLoopback",LegacyCosmicLoopbackMap);
+  LegacyHandoffSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count();
+  QueueHandoffSeconds += QueueSeconds;
+  HandoffEntries++;
+
+  //Report the mean cost per entry for each block of entries, so the trend across
+  //the part file is visible
+  if (HandoffEntries == HandoffReportInterval){
+    Log("MRDDataDecoder Tool: Hand-off cost per MRD entry with " + to_string(LegacyMRDEvents.size()) +
+            " triggers accumulated: queue " + to_string(QueueHandoffSeconds/HandoffEntries*1.0e6) + 
+            " us, full-map CStore round trip " + to_string(LegacyHandoffSeconds/HandoffEntries*1.0e6) + " us",v_warning,verbosity);
+    HandoffEntries = 0;
+    QueueHandoffSeconds = 0.;
+    LegacyHandoffSeconds = 0.;
+  }
 }
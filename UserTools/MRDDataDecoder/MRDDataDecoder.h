@@ -5,12 +5,16 @@
 #include <iostream>
 #include <bitset>
 #include <deque>
+#include <chrono>
+#include <thread>
 
 #include "Tool.h"
 #include "CardData.h"
 #include "TriggerData.h"
 #include "BoostStore.h"
 #include "Store.h"
+#include "MRDEventQueue.h"
+#include "RawDecodePipeline.h"
 
 /**
  * \class MRDDataDecoder
@@ -34,6 +38,9 @@ class MRDDataDecoder: public Tool {
   bool Initialise(std::string configfile,DataModel &data); ///< Initialise Function for setting up Tool resources. @param configfile The path and name of the dynamic configuration file to read in. @param data A reference to the transient data class used to pass information between Tools.
   bool Execute(); ///< Execute function used to perform Tool purpose.
   bool Finalise(); ///< Finalise function used to clean up resources.
+  void BenchmarkHandoff(const DecodedMRDEvent& anEvent, double QueueSeconds); ///< Time the legacy full-map CStore round trip for the same trigger
+  void DecodeMRDEntry(const MRDOut& Entry, DecodedMRDEvent& anEvent); ///< Decode the hits and loopbacks of one MRDData entry
+  void DecodeLoop(); ///< Worker thread of the pipelined decoding
 
  private:
 
@@ -41,15 +48,29 @@ class MRDDataDecoder: public Tool {
   //Map used to relate MRD Crate Space value to channel key
   std::map<std::vector<int>,int> MRDCrateSpaceToChannelNumMap;
 
-  //Maps that store completed waveforms from cards
-  std::map<uint64_t, std::vector<std::pair<unsigned long, int> > > MRDEvents;  //Key: {MTCTime}, value: "WaveMap" with key (CardID,ChannelID), value FinishedWaveform
-  std::map<uint64_t, std::vector<std::pair<unsigned long, int> > > CStoreMRDEvents;  //Key: {MTCTime}, value: "WaveMap" with key (CardID,ChannelID), value FinishedWaveform
-  std::map<uint64_t, int> BeamLoopbackMap;  //KEY: {MTCTime}, value: Beam loopback TDC value
-  std::map<uint64_t, int> CosmicLoopbackMap;  //KEY: {MTCTime}, value: Cosmic loopback TDC value
-  std::map<uint64_t, int> CStoreBeamLoopbackMap;  //KEY: {MTCTime}, value: Beam loopback TDC value
-  std::map<uint64_t, int> CStoreCosmicLoopbackMap;  //KEY: {MTCTime}, value: Cosmic loopback TDC value
-  std::map<uint64_t, std::string>  TriggerTypeMap;  //Key: {MTCTime}, value: string noting what type of trigger occured for the event 
-  std::map<uint64_t, std::string>  CStoreTriggerTypeMap;  //Key: {MTCTime}, value: string noting what type of trigger occured for the event 
+  //Queue of decoded MRD triggers not yet taken by the ANNIEEventBuilder.  Its address
+  //is set in the CStore as an intptr_t ("MRDEventQueue"); each trigger is appended once
+  //here and popped once by the event builder.  Owned and deleted by this tool.
+  MRDEventQueue* DecodedMRDEvents = nullptr;
+
+  //Pipelined decoding (LoadRawData DecodeMode Pipelined)
+  RawDecodePipeline* DecodePipeline = nullptr;
+  std::thread DecodeThread;
+  PipelineStageStats DecodeStats;
+
+  //Hand-off benchmark (BenchmarkHandoff config variable): the legacy full-map CStore
+  //round trip is replayed on a private BoostStore, constructed like the CStore, for
+  //comparison with the queue hand-off.
+  bool DoHandoffBenchmark = false;
+  int HandoffReportInterval = 1000;
+  BoostStore LegacyHandoffStore;
+  std::map<uint64_t, std::vector<std::pair<unsigned long, int> > > LegacyMRDEvents;
+  std::map<uint64_t, std::string> LegacyTriggerTypeMap;
+  std::map<uint64_t, int> LegacyBeamLoopbackMap;
+  std::map<uint64_t, int> LegacyCosmicLoopbackMap;
+  int HandoffEntries = 0;
+  double QueueHandoffSeconds = 0.;
+  double LegacyHandoffSeconds = 0.;
   
   uint64_t TimeZoneShift;  // why on earth are we saving data in local timezone not UTC?!
   bool DaylightSavings;  //If true, in the spring/summer.  If false, fall/winter
@@ -519,20 +519,21 @@ bool MonitorMRDLive::Execute(){
       int active_slot_nr = std::distance(nr_slot.begin(),it);
       int ch = active_slot_nr*num_channels+Channel.at(i_entry);
       if (verbosity > 2) std::cout <<", ch nr: "<<ch<<", TDC: "<<Value.at(i_entry)<<", timestamp: "<<TimeStamp<<std::endl;
-      live_tdc.at(ch).push_back(Value.at(i_entry));
-      live_timestamp.at(ch).push_back(TimeStamp);
-      live_tdc_hour.at(ch).push_back(Value.at(i_entry));
-      live_timestamp_hour.at(ch).push_back(TimeStamp);
+      live_window.AddHit(TimeStamp,ch,Value.at(i_entry));
+      live_window_hour.AddHit(TimeStamp,ch,Value.at(i_entry));
       for (unsigned int i_loopback=0; i_loopback< loopback_crate.size(); i_loopback++){
         if (Crate.at(i_entry) == loopback_crate.at(i_loopback) && Slot.at(i_entry) == loopback_slot.at(i_loopback) && Channel.at(i_entry) == loopback_channel.at(i_loopback)) trigger_type = loopback_name.at(i_loopback);
       }
     }
 
+    live_window.AddEvent(TimeStamp,Channel.size());
+    live_window_hour.AddEvent(TimeStamp,Channel.size());
     vector_timestamp.push_back(TimeStamp);
-    vector_timestamp_hour.push_back(TimeStamp);
-    vector_nchannels.push_back(Channel.size());
-    vector_nchannels_hour.push_back(Channel.size());
     vector_triggertype.push_back(trigger_type);
+    if (int(vector_timestamp.size()) > n_bins_loglive){   //only the last events are shown in the history plot
+      vector_timestamp.pop_front();
+      vector_triggertype.pop_front();
+    }
     current_stamp = TimeStamp;
 
     t = time(0);
@@ -930,14 +931,10 @@ void MonitorMRDLive::InitializeVectors(){
 
   if (verbosity > 2) std::cout <<"MonitorMRDLive: InitializeVectors"<<std::endl;
 
-  std::vector<unsigned int> vec_tdc, vec_tdc_hour;
-  std::vector<ULong64_t> vec_timestamp, vec_timestamp_hour;
-  for (int i_ch = 0; i_ch < num_active_slots*num_channels; i_ch++){
-    live_tdc.push_back(vec_tdc);
-    live_timestamp.push_back(vec_timestamp);
-    live_tdc_hour.push_back(vec_tdc_hour);
-    live_timestamp_hour.push_back(vec_timestamp_hour);
-  }
+  //binning as for TDC_hist(_hour) and n_paddles_hit(_hour)
+  live_window = MRDRateWindow(integration_period*60*1000,n_buckets_window,num_active_slots*num_channels,100,0,1000,50,0,50);
+  live_window_hour = MRDRateWindow(integration_period_hour*60*1000,n_buckets_window,num_active_slots*num_channels,100,0,1000,50,0,50);
+  current_stamp = 0;
 
 }
 
@@ -945,33 +942,9 @@ void MonitorMRDLive::EraseOldData(){
 
   if (verbosity > 2) std::cout <<"MonitorMRDLive: EraseOldData"<<std::endl;
 
-  for (int i_ch = 0; i_ch < num_active_slots*num_channels; i_ch++){
-    for (unsigned int i=0; i<live_tdc.at(i_ch).size();i++){
-      if (current_stamp - live_timestamp.at(i_ch).at(i) > integration_period*60*1000){
-      live_tdc.at(i_ch).erase(live_tdc.at(i_ch).begin()+i);
-      live_timestamp.at(i_ch).erase(live_timestamp.at(i_ch).begin()+i);
-      }
-    }
-    for (unsigned int i=0; i<live_tdc_hour.at(i_ch).size();i++){
-      if (current_stamp - live_timestamp_hour.at(i_ch).at(i) > integration_period_hour*60*1000){
-        live_tdc_hour.at(i_ch).erase(live_tdc_hour.at(i_ch).begin()+i);
-        live_timestamp_hour.at(i_ch).erase(live_timestamp_hour.at(i_ch).begin()+i);
-      }
-    }
-  }
-  for (unsigned int i_entry = 0; i_entry < vector_timestamp.size(); i_entry++){
-    if (current_stamp - vector_timestamp.at(i_entry) > integration_period*60*1000){
-      vector_timestamp.erase(vector_timestamp.begin()+i_entry);
-      vector_nchannels.erase(vector_nchannels.begin()+i_entry);
-      vector_triggertype.erase(vector_triggertype.begin()+i_entry);
-    }
-  }
-  for (unsigned int i_entry = 0; i_entry < vector_timestamp_hour.size(); i_entry++){
-    if (current_stamp - vector_timestamp_hour.at(i_entry) > integration_period_hour*60*1000){
-      vector_timestamp_hour.erase(vector_timestamp_hour.begin()+i_entry);
-      vector_nchannels_hour.erase(vector_nchannels_hour.begin()+i_entry);
-    }
-  }
+  //expired time buckets are subtracted from the integrated counts
+  live_window.Expire(current_stamp);
+  live_window_hour.Expire(current_stamp);
 
 }
 
@@ -1009,33 +982,40 @@ void MonitorMRDLive::UpdateRatePlots(){
     if (i_ch < n_active_slots_cr1*num_channels) slot_id = nr_slot.at(i_ch / num_channels);
     else slot_id = nr_slot.at(i_ch / num_channels) - 100.;
     int channel_id = i_ch % num_channels;
+    double rate = live_window.ChannelCount(i_ch)/(integration_period*60);    //display in Hz
+    double rate_hour = live_window_hour.ChannelCount(i_ch)/(integration_period_hour*60);
     if (verbosity > 2){
       std::cout <<"Crate: "<<crate_id<<", Slot: "<<slot_id<<", Channel: "<<channel_id<<std::endl;
-      std::cout <<"live_tdc.size: "<<live_tdc.at(i_ch).size()<<", rate: "<<live_tdc.at(i_ch).size()/(integration_period*60)<<std::endl;
+      std::cout <<"live hits: "<<live_window.ChannelCount(i_ch)<<", rate: "<<rate<<std::endl;
     }
-    for (unsigned int i_entry= 0; i_entry < live_tdc.at(i_ch).size(); i_entry++){
-      if (crate_id == min_crate) rate_crate1->SetBinContent(slot_id,channel_id+1,live_tdc.at(i_ch).size()/(integration_period*60));   //display in Hz
-      else if (crate_id == min_crate+1) rate_crate2->SetBinContent(slot_id,channel_id+1,live_tdc.at(i_ch).size()/(integration_period*60));
-      TDC_hist->Fill(live_tdc.at(i_ch).at(i_entry));
-      if (live_tdc.at(i_ch).size()/(integration_period*60) > max_ch) max_ch = live_tdc.at(i_ch).size()/(integration_period*60); 
-      if (live_tdc.at(i_ch).size()/(integration_period*60) < min_ch) min_ch = live_tdc.at(i_ch).size()/(integration_period*60); 
+    if (live_window.ChannelCount(i_ch) > 0){
+      if (crate_id == min_crate) rate_crate1->SetBinContent(slot_id,channel_id+1,rate);
+      else if (crate_id == min_crate+1) rate_crate2->SetBinContent(slot_id,channel_id+1,rate);
+      if (rate > max_ch) max_ch = rate;
+      if (rate < min_ch) min_ch = rate;
     }
-    for (unsigned int i_entry = 0; i_entry < live_tdc_hour.at(i_ch).size(); i_entry++){
-      if (crate_id == min_crate) rate_crate1_hour->SetBinContent(slot_id,channel_id+1,live_tdc_hour.at(i_ch).size()/(integration_period_hour*60));
-      else if (crate_id == min_crate+1) rate_crate2_hour->SetBinContent(slot_id,channel_id+1,live_tdc_hour.at(i_ch).size()/(integration_period_hour*60));
-      TDC_hist_hour->Fill(live_tdc_hour.at(i_ch).at(i_entry));
-      if (live_tdc_hour.at(i_ch).size()/(integration_period_hour*60) > max_ch_hour) max_ch_hour = live_tdc_hour.at(i_ch).size()/(integration_period_hour*60);
-      if (live_tdc_hour.at(i_ch).size()/(integration_period_hour*60) < min_ch_hour) min_ch_hour = live_tdc_hour.at(i_ch).size()/(integration_period_hour*60);
+    if (live_window_hour.ChannelCount(i_ch) > 0){
+      if (crate_id == min_crate) rate_crate1_hour->SetBinContent(slot_id,channel_id+1,rate_hour);
+      else if (crate_id == min_crate+1) rate_crate2_hour->SetBinContent(slot_id,channel_id+1,rate_hour);
+      if (rate_hour > max_ch_hour) max_ch_hour = rate_hour;
+      if (rate_hour < min_ch_hour) min_ch_hour = rate_hour;
     }
   }
 
-  for (unsigned int i_entry = 0; i_entry < vector_nchannels.size(); i_entry++){
-    n_paddles_hit->Fill(vector_nchannels.at(i_entry));
+  //TDC and n paddles histograms are copied from the integrated bin counts
+  for (unsigned int i_bin = 0; i_bin < live_window.TDCCounts().size(); i_bin++){
+    TDC_hist->SetBinContent(i_bin,live_window.TDCCounts().at(i_bin));
+    TDC_hist_hour->SetBinContent(i_bin,live_window_hour.TDCCounts().at(i_bin));
   }
+  TDC_hist->SetEntries(live_window.NumHits());
+  TDC_hist_hour->SetEntries(live_window_hour.NumHits());
 
-  for (unsigned int i_entry = 0; i_entry < vector_nchannels_hour.size(); i_entry++){
-    n_paddles_hit_hour->Fill(vector_nchannels_hour.at(i_entry));
+  for (unsigned int i_bin = 0; i_bin < live_window.PaddleCounts().size(); i_bin++){
+    n_paddles_hit->SetBinContent(i_bin,live_window.PaddleCounts().at(i_bin));
+    n_paddles_hit_hour->SetBinContent(i_bin,live_window_hour.PaddleCounts().at(i_bin));
   }
+  n_paddles_hit->SetEntries(live_window.NumEvents());
+  n_paddles_hit_hour->SetEntries(live_window_hour.NumEvents());
 
   //first plot the rate 2D histograms (most work)
 
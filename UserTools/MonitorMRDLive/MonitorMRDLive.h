@@ -3,6 +3,7 @@
 
 #include <string>
 #include <iostream>
+#include <deque>
 
 #include "Tool.h"
 #include "zmq.h"
@@ -16,6 +17,7 @@
 #include "TF1.h"
 #include "TThread.h"
 #include "MRDOut.h"
+#include "MRDRateWindow.h"
 #include "TPaletteAxis.h"
 #include "TPaveText.h"
 #include "TText.h"
@@ -93,12 +95,10 @@ class MonitorMRDLive: public Tool {
   boost::posix_time::ptime current;
 
   //storing variables
-  std::vector<std::vector<unsigned int> > live_tdc, vector_tdc, live_tdc_hour, vector_tdc_hour;
-  std::vector<unsigned int> vector_nchannels, vector_nslots, vector_nchannels_hour;
-  std::vector<unsigned int> tdc_paddle, tdc_paddle_hour;
-  std::vector<std::vector<ULong64_t> > live_timestamp, live_timestamp_hour;
-  std::vector<ULong64_t> vector_timestamp, vector_timestamp_hour;
-  std::vector<std::string> vector_triggertype;
+  MRDRateWindow live_window, live_window_hour;    //hits per channel, TDC values and n paddles of the last 5 mins / 1 hour
+  int n_buckets_window = 60;                      //time resolution of the integration windows (5 sec / 1 min)
+  std::deque<ULong64_t> vector_timestamp;         //time stamps and trigger types of the last live events
+  std::deque<std::string> vector_triggertype;
   std::map<std::string,int> map_triggertype_color;
   std::vector<TText*> trigger_labels;
   std::vector<TLine*> vector_lines;
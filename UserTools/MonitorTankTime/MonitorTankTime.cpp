@@ -1,5 +1,7 @@
 #include "MonitorTankTime.h"
 
+#include <chrono>
+
 MonitorTankTime::MonitorTankTime():Tool(){}
 
 
@@ -38,6 +40,16 @@ bool MonitorTankTime::Initialise(std::string configfile, DataModel &data){
   m_variables.Get("DrawMarker",draw_marker);
   m_variables.Get("DrawSingle",draw_single);
   m_variables.Get("verbose",verbosity);
+  use_time_series = true;
+  m_variables.Get("TimeSeriesStore",use_time_series);
+  time_series_resolutions = "1,60,1440";
+  m_variables.Get("TimeSeriesResolutions",time_series_resolutions);
+  time_series_retention = 0.;
+  m_variables.Get("TimeSeriesRetention",time_series_retention);
+  time_evolution_max_points = 0;
+  m_variables.Get("TimeEvolutionMaxPoints",time_evolution_max_points);
+  benchmark_time_series = false;
+  m_variables.Get("BenchmarkTimeSeries",benchmark_time_series);
 
   if (verbosity > 2) std::cout <<"MonitorTankTime: Outpath (temporary): "<<outpath_temp<<std::endl;
   if (outpath_temp == "fromStore") m_data->CStore.Get("OutPath",outpath);
@@ -194,6 +206,36 @@ bool MonitorTankTime::Initialise(std::string configfile, DataModel &data){
   InitializeHists();
   //omit warning messages from ROOT: 1001 - info messages, 2001 - warnings, 3001 - errors
   gROOT->ProcessLine("gErrorIgnoreLevel = 3001;");
+
+  //-------------------------------------------------------
+  //----------Set up the monitoring time series------------
+  //-------------------------------------------------------
+
+  //rollup resolutions are given in minutes, e.g. 1,60,1440
+  std::vector<uint64_t> resolutions;
+  std::stringstream ss_resolutions(time_series_resolutions);
+  std::string resolution;
+  while (std::getline(ss_resolutions,resolution,',')){
+    if (resolution.empty()) continue;
+    resolutions.push_back((uint64_t) (std::stod(resolution)*SEC_to_MIN*MSEC_to_SEC));
+  }
+  time_series.SetResolutions(resolutions);
+
+  //keep at least the longest configured time frame and the 24h file history in memory
+  if (time_series_retention <= 0.){
+    time_series_retention = 24.;
+    for (unsigned int i_time = 0; i_time < config_timeframes.size(); i_time++){
+      if (config_timeframes.at(i_time) > time_series_retention) time_series_retention = config_timeframes.at(i_time);
+    }
+  }
+
+  if (use_time_series){
+    boost::posix_time::ptime now(boost::posix_time::second_clock::local_time());
+    ULong64_t now_stamp = boost::posix_time::time_duration(now - *Epoch).total_milliseconds();
+    time_series_covered_from = now_stamp - time_series_retention*MIN_to_HOUR*SEC_to_MIN*MSEC_to_SEC;
+    LoadFromFiles(time_series_covered_from,now_stamp,time_series);
+    Log("MonitorTankTime: Loaded "+std::to_string(time_series.GetNRecords())+" files of the last "+std::to_string(time_series_retention)+" h into the monitoring time series",v_message,verbosity);
+  }
   
   return true;
 }
@@ -296,6 +338,8 @@ bool MonitorTankTime::Finalise(){
 
   Log("Tool MonitorTankTime: Finalising ....",v_message,verbosity);
 
+  if (benchmark_time_series) BenchmarkTimeSeries();
+
   //delete all histograms/canvases/other objects that were created
 
   //help objects
@@ -1125,21 +1169,92 @@ void MonitorTankTime::LoopThroughDecodedEvents(std::map<uint64_t, std::map<std::
   m_data->CStore.Get("FIFOError1",fifo1);
   m_data->CStore.Get("FIFOError2",fifo2);
 
+  if (!timestamp_file.empty()) BuildFileRecord();
 
 }
 
-void MonitorTankTime::WriteToFile(){
+void MonitorTankTime::BuildFileRecord(){
 
-  Log("MonitorTankTime: WriteToFile",v_message,verbosity);
+  Log("MonitorTankTime: BuildFileRecord",v_message,verbosity);
 
   //-------------------------------------------------------
-  //------------------WriteToFile -------------------------
+  //------------------BuildFileRecord ---------------------
   //-------------------------------------------------------
 
  // t_file_start = timestamp_file.at(0)*8/1000000.;	//conversion from clock ticks to UTC in msec
  // t_file_end = timestamp_file.at(timestamp_file.size()-1)*8/1000000.;       //conversion from clock ticks to UTC in msec
   t_file_start = timestamp_file.at(0)/1000000.;	//conversion from ns to UTC in msec
   t_file_end = timestamp_file.at(timestamp_file.size()-1)/1000000.;       //conversion from ns to UTC in msec
+
+  file_record = TankMonitorRecord();
+  file_record.t_start = t_file_start;
+  file_record.t_end = t_file_end;
+
+  for (int i_channel = 0; i_channel < num_active_slots*num_channels_tank; i_channel++){
+    double rate_temp = 0;
+    double mean_temp = 0;
+    double sigma_temp = 0.;
+    double channelcount_temp = 0.;
+    double samples_temp=0.;
+    int num_zero_buffers=0;
+    for (unsigned int i_t = 0; i_t < timestamp_file.size(); i_t++){
+      //if (i_channel == 0) std::cout <<"ped_file.at i_t = "<<i_t<<": "<<ped_file.at(i_t).at(i_channel)<<", sigma_file = "<<sigma_file.at(i_t).at(i_channel)<<", rate_temp: "<<rate_file.at(i_t).at(i_channel)<<std::endl; 
+      if (rate_file.at(i_t).at(i_channel) < 0.001 && sigma_file.at(i_t).at(i_channel) < 0.001 && ped_file.at(i_t).at(i_channel) < 0.001){
+	num_zero_buffers++;
+	continue;
+}
+      rate_temp += rate_file.at(i_t).at(i_channel);
+      mean_temp += ped_file.at(i_t).at(i_channel);
+      sigma_temp += sigma_file.at(i_t).at(i_channel);
+      samples_temp += samples_file.at(i_t).at(i_channel);
+    }
+    int num_buffers = int(ped_file.size()) - num_zero_buffers;
+    if (num_buffers>0) {
+    mean_temp/=num_buffers;
+    sigma_temp/=num_buffers;
+    samples_temp/=num_buffers;
+    }
+    channelcount_temp = rate_temp;
+    double t_acquisition = num_buffers*samples_temp*ADC_TO_NS;
+    //if (t_frame>0.) rate_temp /= (t_frame/1000.);  //convert into units of 1/s
+    if (t_acquisition > 0.) rate_temp /= (t_acquisition/1000000.);	//convert from us to seconds
+
+    file_record.ped.push_back(mean_temp);
+    file_record.sigma.push_back(sigma_temp);
+    file_record.rate.push_back(rate_temp);
+    file_record.channelcount.push_back(channelcount_temp);
+  }
+
+  //add the new file to the time series, dropping files that are older than needed
+  if (use_time_series){
+    if (!time_series.Append(file_record)) Log("MonitorTankTime: BuildFileRecord: File starting at "+std::to_string(t_file_start)+" is already in the time series.",v_message,verbosity);
+    ULong64_t retention = time_series_retention*MIN_to_HOUR*SEC_to_MIN*MSEC_to_SEC;
+    if (time_series.GetLastEnd() > retention && time_series.GetLastEnd() - retention > time_series_covered_from){
+      time_series_covered_from = time_series.GetLastEnd() - retention;
+      time_series.Prune(time_series_covered_from);
+    }
+  }
+
+  //the time frames have to be selected again from the updated time series
+  readfromfile_tend = 0;
+  readfromfile_timeframe = 0.;
+
+}
+
+void MonitorTankTime::WriteToFile(){
+
+  Log("MonitorTankTime: WriteToFile",v_message,verbosity);
+
+  //-------------------------------------------------------
+  //------------------WriteToFile -------------------------
+  //-------------------------------------------------------
+
+  if (timestamp_file.empty()){
+    Log("WARNING (MonitorTankTime): WriteToFile: No decoded events in the current file. Nothing to write.",v_warning,verbosity);
+    return;
+  }
+
+  //t_file_start, t_file_end and the averaged values were set in BuildFileRecord
   std::string file_start_date = convertTimeStamp_to_Date(t_file_start);
   std::stringstream root_filename;
   root_filename << path_monitoring << "PMT_" << file_start_date <<".root";
@@ -1186,15 +1301,20 @@ void MonitorTankTime::WriteToFile(){
     t->Branch("channelcount",&channelcount);
   }
 
+  //only the start times are needed to look for the current file
   int n_entries = t->GetEntries();
   bool omit_entries = false;
+  t->SetBranchStatus("*",0);
+  t->SetBranchStatus("t_start",1);
   for (int i_entry = 0; i_entry < n_entries; i_entry++){
     t->GetEntry(i_entry);
     if (t_start == t_file_start) {
       Log("WARNING (MonitorTankTime): WriteToFile: Wanted to write data from file that is already written to DB. Omit entries",v_warning,verbosity);
       omit_entries = true;
+      break;
     }
   }
+  t->SetBranchStatus("*",1);
   //if data is already written to DB/File, do not write it again
   if (omit_entries) {
 
@@ -1239,41 +1359,14 @@ void MonitorTankTime::WriteToFile(){
     unsigned int crate_temp = crateslotch_temp.at(0);
     unsigned int slot_temp = crateslotch_temp.at(1);
     unsigned int channel_temp = crateslotch_temp.at(2);    //channel numbering goes from 1-4
-    double rate_temp = 0;
-    double mean_temp = 0;
-    double sigma_temp = 0.;
-    double channelcount_temp = 0.;
-    double samples_temp=0.;
-    int num_zero_buffers=0;
-    for (unsigned int i_t = 0; i_t < timestamp_file.size(); i_t++){
-      //if (i_channel == 0) std::cout <<"ped_file.at i_t = "<<i_t<<": "<<ped_file.at(i_t).at(i_channel)<<", sigma_file = "<<sigma_file.at(i_t).at(i_channel)<<", rate_temp: "<<rate_file.at(i_t).at(i_channel)<<std::endl; 
-      if (rate_file.at(i_t).at(i_channel) < 0.001 && sigma_file.at(i_t).at(i_channel) < 0.001 && ped_file.at(i_t).at(i_channel) < 0.001){
-	num_zero_buffers++;
-	continue;
-}
-      rate_temp += rate_file.at(i_t).at(i_channel);
-      mean_temp += ped_file.at(i_t).at(i_channel);
-      sigma_temp += sigma_file.at(i_t).at(i_channel);
-      samples_temp += samples_file.at(i_t).at(i_channel);
-    }
-    int num_buffers = int(ped_file.size()) - num_zero_buffers;
-    if (num_buffers>0) {
-    mean_temp/=num_buffers;
-    sigma_temp/=num_buffers;
-    samples_temp/=num_buffers;
-    }
-    channelcount_temp = rate_temp;
-    double t_acquisition = num_buffers*samples_temp*ADC_TO_NS;
-    //if (t_frame>0.) rate_temp /= (t_frame/1000.);  //convert into units of 1/s
-    if (t_acquisition > 0.) rate_temp /= (t_acquisition/1000000.);	//convert from us to seconds
 
     crate->push_back(crate_temp);
     slot->push_back(slot_temp);
     channel->push_back(channel_temp);
-    ped->push_back(mean_temp);
-    sigma->push_back(sigma_temp);
-    rate->push_back(rate_temp);
-    channelcount->push_back(channelcount_temp);
+    ped->push_back(file_record.ped.at(i_channel));
+    sigma->push_back(file_record.sigma.at(i_channel));
+    rate->push_back(file_record.rate.at(i_channel));
+    channelcount->push_back(file_record.channelcount.at(i_channel));
   }
 
   t->Fill();
@@ -1301,10 +1394,7 @@ void MonitorTankTime::ReadFromFile(ULong64_t timestamp_end, double time_frame){
   //------------------ReadFromFile ------------------------
   //-------------------------------------------------------
 
-  ped_plot.clear();
-  sigma_plot.clear();
-  rate_plot.clear();
-  channelcount_plot.clear();
+  records_plot.clear();
   tstart_plot.clear();
   tend_plot.clear();
   labels_timeaxis.clear();
@@ -1312,12 +1402,47 @@ void MonitorTankTime::ReadFromFile(ULong64_t timestamp_end, double time_frame){
   //take the end time and calculate the start time with the given time_frame
   ULong64_t timestamp_start = timestamp_end - time_frame*MIN_to_HOUR*SEC_to_MIN*MSEC_to_SEC;
 
+  if (!use_time_series){
+    //read the whole time frame from the monitoring files
+    time_series.Clear();
+    LoadFromFiles(timestamp_start, timestamp_end, time_series);
+  } else if (timestamp_start < time_series_covered_from){
+    //time frame reaches back further than the files kept in memory
+    LoadFromFiles(timestamp_start, time_series_covered_from-1, time_series);
+    time_series_covered_from = timestamp_start;
+  }
+
+  time_series.Select(timestamp_start, timestamp_end, records_plot);
+  time_series.Aggregate(timestamp_start, timestamp_end, window_sum);
+  for (unsigned int i_file = 0; i_file < records_plot.size(); i_file++){
+    tstart_plot.push_back(records_plot.at(i_file)->t_start);
+    tend_plot.push_back(records_plot.at(i_file)->t_end);
+    labels_timeaxis.push_back(convertTimeStamp_to_TDatime(records_plot.at(i_file)->t_end));
+  }
+
+  Log("MonitorTankTime: ReadFromFile: "+std::to_string(records_plot.size())+" files in time frame",v_message,verbosity);
+
+  //Set the readfromfile time variables to make sure data is not read twice for the same time window
+  readfromfile_tstart = timestamp_start;
+  readfromfile_tend = timestamp_end;
+  readfromfile_timeframe = time_frame;
+
+}
+
+void MonitorTankTime::LoadFromFiles(ULong64_t timestamp_start, ULong64_t timestamp_end, TankMonitorTimeSeries &series){
+
+  Log("MonitorTankTime: LoadFromFiles",v_message,verbosity);
+
+  //-------------------------------------------------------
+  //------------------LoadFromFiles -----------------------
+  //-------------------------------------------------------
+
   boost::posix_time::ptime starttime = *Epoch + boost::posix_time::time_duration(int(timestamp_start/MSEC_to_SEC/SEC_to_MIN/MIN_to_HOUR),int(timestamp_start/MSEC_to_SEC/SEC_to_MIN)%60,int(timestamp_start/MSEC_to_SEC/1000.)%60,timestamp_start%1000);
   struct tm starttime_tm = boost::posix_time::to_tm(starttime);
   boost::posix_time::ptime endtime = *Epoch + boost::posix_time::time_duration(int(timestamp_end/MSEC_to_SEC/SEC_to_MIN/MIN_to_HOUR),int(timestamp_end/MSEC_to_SEC/SEC_to_MIN)%60,int(timestamp_end/MSEC_to_SEC/1000.)%60,timestamp_end%1000);
   struct tm endtime_tm = boost::posix_time::to_tm(endtime);
 
-   Log("MonitorTankTime: ReadFromFile: Reading in data for time frame "+std::to_string(starttime_tm.tm_year+1900)+"/"+std::to_string(starttime_tm.tm_mon+1)+"/"+std::to_string(starttime_tm.tm_mday)+"-"+std::to_string(starttime_tm.tm_hour)+":"+std::to_string(starttime_tm.tm_min)+":"+std::to_string(starttime_tm.tm_sec)
+   Log("MonitorTankTime: LoadFromFiles: Reading in data for time frame "+std::to_string(starttime_tm.tm_year+1900)+"/"+std::to_string(starttime_tm.tm_mon+1)+"/"+std::to_string(starttime_tm.tm_mday)+"-"+std::to_string(starttime_tm.tm_hour)+":"+std::to_string(starttime_tm.tm_min)+":"+std::to_string(starttime_tm.tm_sec)
     +" ... "+std::to_string(endtime_tm.tm_year+1900)+"/"+std::to_string(endtime_tm.tm_mon+1)+"/"+std::to_string(endtime_tm.tm_mday)+"-"+std::to_string(endtime_tm.tm_hour)+":"+std::to_string(endtime_tm.tm_min)+":"+std::to_string(endtime_tm.tm_sec),v_message,verbosity);
 
   std::stringstream ss_startdate, ss_enddate;
@@ -1355,72 +1480,38 @@ void MonitorTankTime::ReadFromFile(ULong64_t timestamp_end, double time_frame){
         Log("MonitorTankTime: Tree exists, start reading in data",v_message,verbosity);
 
         ULong64_t t_start, t_end;
-        std::vector<unsigned int> *crate = new std::vector<unsigned int>;
-        std::vector<unsigned int> *slot = new std::vector<unsigned int>;
-        std::vector<unsigned int> *channel = new std::vector<unsigned int>;
         std::vector<double> *ped = new std::vector<double>;
         std::vector<double> *sigma = new std::vector<double>;
         std::vector<double> *rate = new std::vector<double>;
         std::vector<int> *channelcount = new std::vector<int>;
 
-        int nevents;
-        int nentries_tree;
+        int nentries_tree = t->GetEntries();
 
         t->SetBranchAddress("t_start",&t_start);
         t->SetBranchAddress("t_end",&t_end);
-        t->SetBranchAddress("crate",&crate);
-        t->SetBranchAddress("slot",&slot);
-        t->SetBranchAddress("channel",&channel);
         t->SetBranchAddress("ped",&ped);
         t->SetBranchAddress("sigma",&sigma);
         t->SetBranchAddress("rate",&rate);
         t->SetBranchAddress("channelcount",&channelcount);
-
-        nentries_tree = t->GetEntries();
-	      
-	//Sort timestamps for the case that they are not in order
-
-	std::vector<ULong64_t> vector_timestamps;
-        std::map<ULong64_t,int> map_timestamp_entry;
-	for (int i_entry = 0; i_entry < nentries_tree; i_entry++){
-	  t->GetEntry(i_entry);
-	  if (t_start >= timestamp_start && t_end <= timestamp_end){
-	    vector_timestamps.push_back(t_start);
-	    map_timestamp_entry.emplace(t_start,i_entry);	    
-	  }
-	}
-
-	std::sort(vector_timestamps.begin(), vector_timestamps.end());
-	std::vector<int> vector_sorted_entry;
-
-	for (int i_entry = 0; i_entry < (int) vector_timestamps.size(); i_entry++){
-	  vector_sorted_entry.push_back(map_timestamp_entry.at(vector_timestamps.at(i_entry)));
-	}
-
-        for (int i_entry = 0; i_entry < (int) vector_sorted_entry.size(); i_entry++){
-		
-	  int next_entry = vector_sorted_entry.at(i_entry);
-
-          t->GetEntry(next_entry);
-          if (t_start >= timestamp_start && t_end <= timestamp_end){
-            ped_plot.push_back(*ped);
-            sigma_plot.push_back(*sigma);
-            rate_plot.push_back(*rate);
-            channelcount_plot.push_back(*channelcount);
-            tstart_plot.push_back(t_start);
-            tend_plot.push_back(t_end);
-            boost::posix_time::ptime boost_tend = *Epoch+boost::posix_time::time_duration(int(t_end/MSEC_to_SEC/SEC_to_MIN/MIN_to_HOUR),int(t_end/MSEC_to_SEC/SEC_to_MIN)%60,int(t_end/MSEC_to_SEC/1000.)%60,t_end%1000);
-            struct tm label_timestamp = boost::posix_time::to_tm(boost_tend);
-            
-            TDatime datime_timestamp(1900+label_timestamp.tm_year,label_timestamp.tm_mon+1,label_timestamp.tm_mday,label_timestamp.tm_hour,label_timestamp.tm_min,label_timestamp.tm_sec);
-            labels_timeaxis.push_back(datime_timestamp);
+        t->SetBranchStatus("crate",0);
+        t->SetBranchStatus("slot",0);
+        t->SetBranchStatus("channel",0);
+
+        //the time series keeps the files sorted by start time
+        for (int i_entry = 0; i_entry < nentries_tree; i_entry++){
+          t->GetEntry(i_entry);
+          if (t_start >= timestamp_start && t_start <= timestamp_end){
+            TankMonitorRecord record;
+            record.t_start = t_start;
+            record.t_end = t_end;
+            record.ped = *ped;
+            record.sigma = *sigma;
+            record.rate = *rate;
+            record.channelcount = *channelcount;
+            series.Append(record);
           }
-
         }
 
-        delete crate;
-        delete slot;
-        delete channel;
         delete ped;
         delete sigma;
         delete rate;
@@ -1433,15 +1524,11 @@ void MonitorTankTime::ReadFromFile(ULong64_t timestamp_end, double time_frame){
       gROOT->cd();
 
     } else {
-      Log("MonitorTankTime: ReadFromFile: File "+root_filename_i.str()+" does not exist. Omit file.",v_warning,verbosity);
+      Log("MonitorTankTime: LoadFromFiles: File "+root_filename_i.str()+" does not exist. Omit file.",v_warning,verbosity);
     }
 
   }
 
-  //Set the readfromfile time variables to make sure data is not read twice for the same time window
-  readfromfile_tend = timestamp_end;
-  readfromfile_timeframe = time_frame;
-
 }
 
 void MonitorTankTime::DrawLastFilePlots(){
@@ -1542,25 +1629,18 @@ void MonitorTankTime::DrawRatePlotElectronics(ULong64_t timestamp_end, double ti
 
   if (timestamp_end != readfromfile_tend || time_frame != readfromfile_timeframe) ReadFromFile(timestamp_end, time_frame);
 
+  //average over the files in the time frame, weighted with the file durations
   std::vector<double> overall_rates;
-  ULong64_t current_timeframe;
-  ULong64_t overall_timeframe = 0;
   overall_rates.assign(num_active_slots*num_channels_tank,0);
 
-  for (unsigned int i_file = 0; i_file < rate_plot.size(); i_file++){
-
-    current_timeframe = (tend_plot.at(i_file)-tstart_plot.at(i_file))/MSEC_to_SEC;
-    overall_timeframe += current_timeframe;
-
-  for (int i_ch = 0; i_ch < num_active_slots*num_channels_tank; i_ch++){
-      if (std::find(vec_disabled_global.begin(),vec_disabled_global.end(),i_ch)!=vec_disabled_global.end()) continue;
-      overall_rates.at(i_ch) += (rate_plot.at(i_file).at(i_ch)*current_timeframe);
-    }
+  for (int i_ch = 0; i_ch < num_active_slots*num_channels_tank && i_ch < int(window_sum.rate.size()); i_ch++){
+    if (std::find(vec_disabled_global.begin(),vec_disabled_global.end(),i_ch)!=vec_disabled_global.end()) continue;
+    overall_rates.at(i_ch) = window_sum.rate.at(i_ch);
   }
 
-  if (overall_timeframe > 0.){
+  if (window_sum.duration > 0){
     for (int i_ch = 0; i_ch < num_active_slots*num_channels_tank; i_ch++){
-      overall_rates.at(i_ch)/=overall_timeframe;
+      overall_rates.at(i_ch)/=window_sum.duration;
     }
   }
 
@@ -1671,25 +1751,18 @@ void MonitorTankTime::DrawPedPlotElectronics(ULong64_t timestamp_end, double tim
 
   if (timestamp_end != readfromfile_tend || time_frame != readfromfile_timeframe) ReadFromFile(timestamp_end, time_frame);
 
+  //average over the files in the time frame, weighted with the file durations
   std::vector<double> overall_peds;
-  ULong64_t current_timeframe;
-  ULong64_t overall_timeframe = 0;
   overall_peds.assign(num_active_slots*num_channels_tank,0);
 
-  for (unsigned int i_file = 0; i_file < ped_plot.size(); i_file++){
-
-    current_timeframe = (tend_plot.at(i_file)-tstart_plot.at(i_file))/MSEC_to_SEC;
-    overall_timeframe += current_timeframe;
-
-    for (int i_ch = 0; i_ch < num_active_slots*num_channels_tank; i_ch++){
-      if (std::find(vec_disabled_global.begin(),vec_disabled_global.end(),i_ch)!=vec_disabled_global.end()) continue;
-      overall_peds.at(i_ch) += (ped_plot.at(i_file).at(i_ch)*current_timeframe);
-    }
+  for (int i_ch = 0; i_ch < num_active_slots*num_channels_tank && i_ch < int(window_sum.ped.size()); i_ch++){
+    if (std::find(vec_disabled_global.begin(),vec_disabled_global.end(),i_ch)!=vec_disabled_global.end()) continue;
+    overall_peds.at(i_ch) = window_sum.ped.at(i_ch);
   }
 
-  if (overall_timeframe > 0.){
-    for (int i_ch = 0.; i_ch < num_active_slots*num_channels_tank; i_ch++){
-      overall_peds.at(i_ch)/=overall_timeframe;
+  if (window_sum.duration > 0){
+    for (int i_ch = 0; i_ch < num_active_slots*num_channels_tank; i_ch++){
+      overall_peds.at(i_ch)/=window_sum.duration;
     }
   }
 
@@ -1800,25 +1873,18 @@ void MonitorTankTime::DrawSigmaPlotElectronics(ULong64_t timestamp_end, double t
 
   if (timestamp_end != readfromfile_tend || time_frame != readfromfile_timeframe) ReadFromFile(timestamp_end, time_frame);
     
+  //average over the files in the time frame, weighted with the file durations
   std::vector<double> overall_sigmas;
-  ULong64_t current_timeframe;
-  ULong64_t overall_timeframe = 0;
   overall_sigmas.assign(num_active_slots*num_channels_tank,0);
 
-  for (unsigned int i_file = 0; i_file < sigma_plot.size(); i_file++){
-
-    current_timeframe = (tend_plot.at(i_file)-tstart_plot.at(i_file))/MSEC_to_SEC;
-    overall_timeframe += current_timeframe;
-
-    for (int i_ch = 0; i_ch < num_active_slots*num_channels_tank; i_ch++){
-      if (std::find(vec_disabled_global.begin(),vec_disabled_global.end(),i_ch)!=vec_disabled_global.end()) continue;
-      overall_sigmas.at(i_ch) += (sigma_plot.at(i_file).at(i_ch)*current_timeframe);
-    }
+  for (int i_ch = 0; i_ch < num_active_slots*num_channels_tank && i_ch < int(window_sum.sigma.size()); i_ch++){
+    if (std::find(vec_disabled_global.begin(),vec_disabled_global.end(),i_ch)!=vec_disabled_global.end()) continue;
+    overall_sigmas.at(i_ch) = window_sum.sigma.at(i_ch);
   }
 
-  if (overall_timeframe > 0.){
-    for (int i_ch = 0.; i_ch < num_active_slots*num_channels_tank; i_ch++){
-      overall_sigmas.at(i_ch)/=overall_timeframe;
+  if (window_sum.duration > 0){
+    for (int i_ch = 0; i_ch < num_active_slots*num_channels_tank; i_ch++){
+      overall_sigmas.at(i_ch)/=window_sum.duration;
     }
   }
 
@@ -1937,10 +2003,7 @@ void MonitorTankTime::DrawHitMap(ULong64_t timestamp_end, double time_frame, std
   for (int i_channel = 0; i_channel < num_active_slots*num_channels_tank; i_channel++){
 
     long sum_channel = 0;
-    
-    for (unsigned int i_file = 0; i_file < rate_plot.size(); i_file++){
-      sum_channel+=channelcount_plot.at(i_file).at(i_channel);
-    }
+    if (i_channel < int(window_sum.channelcount.size())) sum_channel = window_sum.channelcount.at(i_channel);
 
     int active_slot = i_channel / num_channels_tank;
     std::vector<unsigned int> crateslot = map_slot_to_crateslot[active_slot];
@@ -2052,16 +2115,42 @@ void MonitorTankTime::DrawTimeEvolution(ULong64_t timestamp_end, double time_fra
     gr_rate.at(i_channel)->Set(0);
   }
 
-  for (unsigned int i_file=0; i_file<ped_plot.size(); i_file++){
+  //for long time frames, optionally show the time series rollups instead of single files
+  std::vector<TankMonitorRollup> rollup_points;
+  if (time_evolution_max_points > 0 && int(records_plot.size()) > time_evolution_max_points){
+    time_series.Rollups(readfromfile_tstart, readfromfile_tend, time_evolution_max_points, rollup_points);
+  }
+
+  if (rollup_points.empty()){
+
+  for (unsigned int i_file=0; i_file<records_plot.size(); i_file++){
 
     //Updating channel graphs
 
     Log("MonitorTankTime: Stored data (file #"+std::to_string(i_file+1)+"): ",v_message,verbosity);
     for (int i_channel = 0; i_channel < num_active_slots*num_channels_tank; i_channel++){
-      gr_ped.at(i_channel)->SetPoint(i_file,labels_timeaxis[i_file].Convert(),ped_plot.at(i_file).at(i_channel));
-      gr_sigma.at(i_channel)->SetPoint(i_file,labels_timeaxis[i_file].Convert(),sigma_plot.at(i_file).at(i_channel));
-      gr_rate.at(i_channel)->SetPoint(i_file,labels_timeaxis[i_file].Convert(),rate_plot.at(i_file).at(i_channel));
+      gr_ped.at(i_channel)->SetPoint(i_file,labels_timeaxis[i_file].Convert(),records_plot.at(i_file)->ped.at(i_channel));
+      gr_sigma.at(i_channel)->SetPoint(i_file,labels_timeaxis[i_file].Convert(),records_plot.at(i_file)->sigma.at(i_channel));
+      gr_rate.at(i_channel)->SetPoint(i_file,labels_timeaxis[i_file].Convert(),records_plot.at(i_file)->rate.at(i_channel));
+    }
+
+  }
+
+  } else {
+
+  Log("MonitorTankTime: Showing "+std::to_string(rollup_points.size())+" time series rollups for "+std::to_string(records_plot.size())+" files",v_message,verbosity);
+  int i_point = 0;
+  for (unsigned int i_rollup=0; i_rollup<rollup_points.size(); i_rollup++){
+    const TankMonitorRollup &rollup = rollup_points.at(i_rollup);
+    if (rollup.duration == 0) continue;
+    double time_point = convertTimeStamp_to_TDatime(rollup.t_end).Convert();
+    for (int i_channel = 0; i_channel < num_active_slots*num_channels_tank && i_channel < int(rollup.ped.size()); i_channel++){
+      gr_ped.at(i_channel)->SetPoint(i_point,time_point,rollup.ped.at(i_channel)/rollup.duration);
+      gr_sigma.at(i_channel)->SetPoint(i_point,time_point,rollup.sigma.at(i_channel)/rollup.duration);
+      gr_rate.at(i_channel)->SetPoint(i_point,time_point,rollup.rate.at(i_channel)/rollup.duration);
     }
+    i_point++;
+  }
 
   }
 
@@ -2276,10 +2365,10 @@ void MonitorTankTime::DrawTimeDifference(ULong64_t timestamp_end, double time_fr
   std::vector<double> overall_peddiffs;
   overall_peddiffs.assign(num_active_slots*num_channels_tank,0.);
 
-  if (ped_plot.size() >= 1){
+  if (records_plot.size() >= 1){
     for (int i_ch = 0; i_ch < num_active_slots*num_channels_tank; i_ch++){
       if (std::find(vec_disabled_global.begin(),vec_disabled_global.end(),i_ch)!=vec_disabled_global.end()) overall_peddiffs.at(i_ch) = -9999;
-      else overall_peddiffs.at(i_ch) = ped_plot.at(ped_plot.size()-1).at(i_ch) - ped_plot.at(0).at(i_ch);
+      else overall_peddiffs.at(i_ch) = records_plot.back()->ped.at(i_ch) - records_plot.front()->ped.at(i_ch);
     }
     for (unsigned int i_inactive=0; i_inactive < inactive_xy.size(); i_inactive++){
       h2D_peddiff->SetBinContent(inactive_xy.at(i_inactive).at(0),inactive_xy.at(i_inactive).at(1),-9999);
@@ -2373,10 +2462,10 @@ void MonitorTankTime::DrawTimeDifference(ULong64_t timestamp_end, double time_fr
   std::vector<double> overall_sigmadiffs;
   overall_sigmadiffs.assign(num_active_slots*num_channels_tank,0.);
 
-  if (sigma_plot.size() >= 1){
+  if (records_plot.size() >= 1){
     for (int i_ch = 0; i_ch < num_active_slots*num_channels_tank; i_ch++){
       if (std::find(vec_disabled_global.begin(),vec_disabled_global.end(),i_ch)!=vec_disabled_global.end()) overall_sigmadiffs.at(i_ch) = -9999;
-      else overall_sigmadiffs.at(i_ch) = sigma_plot.at(sigma_plot.size()-1).at(i_ch) - sigma_plot.at(0).at(i_ch);
+      else overall_sigmadiffs.at(i_ch) = records_plot.back()->sigma.at(i_ch) - records_plot.front()->sigma.at(i_ch);
     }
     for (unsigned int i_inactive=0; i_inactive < inactive_xy.size(); i_inactive++){
       h2D_sigmadiff->SetBinContent(inactive_xy.at(i_inactive).at(0),inactive_xy.at(i_inactive).at(1),-9999);
@@ -2470,10 +2559,10 @@ void MonitorTankTime::DrawTimeDifference(ULong64_t timestamp_end, double time_fr
   std::vector<double> overall_ratediffs;
   overall_ratediffs.assign(num_active_slots*num_channels_tank,0.);
 
-  if (rate_plot.size() >= 1){
+  if (records_plot.size() >= 1){
     for (int i_ch = 0; i_ch < num_active_slots*num_channels_tank; i_ch++){
       if (std::find(vec_disabled_global.begin(),vec_disabled_global.end(),i_ch)!=vec_disabled_global.end()) overall_ratediffs.at(i_ch) = -9999; 
-      else overall_ratediffs.at(i_ch) = rate_plot.at(rate_plot.size()-1).at(i_ch) - rate_plot.at(0).at(i_ch);
+      else overall_ratediffs.at(i_ch) = records_plot.back()->rate.at(i_ch) - records_plot.front()->rate.at(i_ch);
     }
     for (unsigned int i_inactive=0; i_inactive < inactive_xy.size(); i_inactive++){
       h2D_ratediff->SetBinContent(inactive_xy.at(i_inactive).at(0),inactive_xy.at(i_inactive).at(1),-9999);
@@ -3163,6 +3252,63 @@ void MonitorTankTime::CardIDToElectronicsSpace(int CardID,
   return;
 }
 
+void MonitorTankTime::BenchmarkTimeSeries(){
+
+  //-------------------------------------------------------
+  //------------------BenchmarkTimeSeries -----------------
+  //-------------------------------------------------------
+
+  //Query latency for 1h / 24h / 7d time frames ending with the last file:
+  //re-reading the daily monitoring files vs. querying the time series
+
+  ULong64_t timestamp_end = (time_series.GetLastEnd() > 0) ? time_series.GetLastEnd() : (ULong64_t) t_file_end;
+  std::vector<double> bench_frames{1.,24.,168.};
+  int n_repeat = 100;
+
+  for (unsigned int i_frame = 0; i_frame < bench_frames.size(); i_frame++){
+
+    ULong64_t timestamp_start = timestamp_end - bench_frames.at(i_frame)*MIN_to_HOUR*SEC_to_MIN*MSEC_to_SEC;
+    std::vector<const TankMonitorRecord*> selected;
+    TankMonitorRollup sum_files, sum_series;
+
+    auto start_files = std::chrono::steady_clock::now();
+    TankMonitorTimeSeries series_files;
+    LoadFromFiles(timestamp_start,timestamp_end,series_files);
+    series_files.Select(timestamp_start,timestamp_end,selected);
+    series_files.Aggregate(timestamp_start,timestamp_end,sum_files);
+    double time_files = std::chrono::duration<double,std::milli>(std::chrono::steady_clock::now()-start_files).count();
+
+    //make sure the time series holds the whole time frame before timing it
+    if (timestamp_start < time_series_covered_from || !use_time_series){
+      if (!use_time_series) time_series.Clear();
+      LoadFromFiles(timestamp_start,use_time_series ? time_series_covered_from-1 : timestamp_end,time_series);
+      time_series_covered_from = timestamp_start;
+    }
+    auto start_series = std::chrono::steady_clock::now();
+    for (int i_repeat = 0; i_repeat < n_repeat; i_repeat++){
+      time_series.Select(timestamp_start,timestamp_end,selected);
+      time_series.Aggregate(timestamp_start,timestamp_end,sum_series);
+    }
+    double time_series_query = std::chrono::duration<double,std::milli>(std::chrono::steady_clock::now()-start_series).count()/n_repeat;
+
+    bool same_files = (sum_files.nrecords == sum_series.nrecords && sum_files.duration == sum_series.duration);
+    Log("MonitorTankTime: BenchmarkTimeSeries: "+std::to_string(bench_frames.at(i_frame))+" h ("+std::to_string(sum_series.nrecords)+" files): reading files "
+      +std::to_string(time_files)+" ms, time series "+std::to_string(time_series_query)+" ms per query"+(same_files ? "" : " (MISMATCH with files: "+std::to_string(sum_files.nrecords)+" files)"),v_message,verbosity);
+  }
+
+  Log("MonitorTankTime: BenchmarkTimeSeries: time series holds "+std::to_string(time_series.GetNRecords())+" files in "+std::to_string(time_series.GetNBuckets())+" rollup buckets",v_message,verbosity);
+
+}
+
+TDatime MonitorTankTime::convertTimeStamp_to_TDatime(ULong64_t timestamp){
+
+  boost::posix_time::ptime boost_time = *Epoch+boost::posix_time::time_duration(int(timestamp/MSEC_to_SEC/SEC_to_MIN/MIN_to_HOUR),int(timestamp/MSEC_to_SEC/SEC_to_MIN)%60,int(timestamp/MSEC_to_SEC/1000.)%60,timestamp%1000);
+  struct tm label_timestamp = boost::posix_time::to_tm(boost_time);
+  TDatime datime_timestamp(1900+label_timestamp.tm_year,label_timestamp.tm_mon+1,label_timestamp.tm_mday,label_timestamp.tm_hour,label_timestamp.tm_min,label_timestamp.tm_sec);
+  return datime_timestamp;
+
+}
+
 std::string MonitorTankTime::convertTimeStamp_to_Date(ULong64_t timestamp){
 
   //format of date is YYYY_MM-DD
@@ -37,6 +37,8 @@
 #include "TText.h"
 #include "TTree.h"
 
+#include "TankMonitorTimeSeries.h"
+
 
 
 /**
@@ -61,8 +63,11 @@ class MonitorTankTime: public Tool {
   void ReadInConfiguration();
   void InitializeHists(); ///< Function to initialize all histograms and canvases
   void LoopThroughDecodedEvents(std::map<uint64_t, std::map<std::vector<int>, std::vector<uint16_t>>> finishedPMTWaves);
+  void BuildFileRecord();   ///< Average the current file into file_record and add it to the time series
   void WriteToFile();
   void ReadFromFile(ULong64_t timestamp_end, double time_frame);
+  void LoadFromFiles(ULong64_t timestamp_start, ULong64_t timestamp_end, TankMonitorTimeSeries &series);   ///< Add the files starting in [start,end] from the daily monitoring files
+  void BenchmarkTimeSeries();
 
   //Draw functions
   void DrawLastFilePlots();
@@ -86,6 +91,7 @@ class MonitorTankTime: public Tool {
 
   //helper functions
   std::string convertTimeStamp_to_Date(ULong64_t timestamp);
+  TDatime convertTimeStamp_to_TDatime(ULong64_t timestamp);
   bool does_file_exist(std::string filename);
   void CardIDToElectronicsSpace(int CardID, int &CrateNum, int &SlotNum);
 
@@ -107,6 +113,11 @@ class MonitorTankTime: public Tool {
   int verbosity;
   std::string signal_channels;
   std::string disabled_channels;
+  bool use_time_series;
+  std::string time_series_resolutions;
+  double time_series_retention;
+  int time_evolution_max_points;
+  bool benchmark_time_series;
 
   //define variables that contain the configuration option for the plots
   std::vector<double> config_timeframes;
@@ -133,6 +144,7 @@ class MonitorTankTime: public Tool {
   time_t t;
   std::stringstream title_time; 
   long current_stamp, current_utc;
+  ULong64_t readfromfile_tstart;
   ULong64_t readfromfile_tend;
   double readfromfile_timeframe;
 
@@ -187,11 +199,16 @@ class MonitorTankTime: public Tool {
   double conversion_ADC_Volt = 2.415/pow(2.0, 12.0);          //conversion ADC counts --> Volts
 
 
+  //time series of the monitoring files: filled once from the files and appended for every new file
+  //(TimeSeriesStore 1), or re-read from the files for every time window (TimeSeriesStore 0)
+  TankMonitorTimeSeries time_series;
+  TankMonitorRecord file_record;        //averaged values of the current file
+  ULong64_t time_series_covered_from = 0;   //earliest time for which the time series holds all files
+
+
   //define storing variables for reading in data in a given time slot from monitoring file / database
-  std::vector<std::vector<double>> ped_plot;
-  std::vector<std::vector<double>> sigma_plot;
-  std::vector<std::vector<double>> rate_plot;
-  std::vector<std::vector<int>> channelcount_plot;
+  std::vector<const TankMonitorRecord*> records_plot;
+  TankMonitorRollup window_sum;         //sum over all files in the time frame
   std::vector<ULong64_t> tstart_plot;
   std::vector<ULong64_t> tend_plot;
 
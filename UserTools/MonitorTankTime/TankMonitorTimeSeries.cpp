@@ -0,0 +1,176 @@
+#include "TankMonitorTimeSeries.h"
+
+#include <algorithm>
+
+void TankMonitorRollup::Add(const TankMonitorRecord& record)
+{
+  if (nrecords == 0 || record.t_start < t_start) t_start = record.t_start;
+  if (nrecords == 0 || record.t_end > t_end) t_end = record.t_end;
+  nrecords++;
+  uint64_t weight = record.Duration();
+  duration += weight;
+  if (ped.size() < record.ped.size()) ped.resize(record.ped.size(), 0.);
+  if (sigma.size() < record.sigma.size()) sigma.resize(record.sigma.size(), 0.);
+  if (rate.size() < record.rate.size()) rate.resize(record.rate.size(), 0.);
+  if (channelcount.size() < record.channelcount.size()) channelcount.resize(record.channelcount.size(), 0);
+  for (size_t i_ch = 0; i_ch < record.ped.size(); i_ch++) ped[i_ch] += record.ped[i_ch]*weight;
+  for (size_t i_ch = 0; i_ch < record.sigma.size(); i_ch++) sigma[i_ch] += record.sigma[i_ch]*weight;
+  for (size_t i_ch = 0; i_ch < record.rate.size(); i_ch++) rate[i_ch] += record.rate[i_ch]*weight;
+  for (size_t i_ch = 0; i_ch < record.channelcount.size(); i_ch++) channelcount[i_ch] += record.channelcount[i_ch];
+}
+
+void TankMonitorRollup::Add(const TankMonitorRollup& rollup)
+{
+  if (rollup.nrecords == 0) return;
+  if (nrecords == 0 || rollup.t_start < t_start) t_start = rollup.t_start;
+  if (nrecords == 0 || rollup.t_end > t_end) t_end = rollup.t_end;
+  nrecords += rollup.nrecords;
+  duration += rollup.duration;
+  if (ped.size() < rollup.ped.size()) ped.resize(rollup.ped.size(), 0.);
+  if (sigma.size() < rollup.sigma.size()) sigma.resize(rollup.sigma.size(), 0.);
+  if (rate.size() < rollup.rate.size()) rate.resize(rollup.rate.size(), 0.);
+  if (channelcount.size() < rollup.channelcount.size()) channelcount.resize(rollup.channelcount.size(), 0);
+  for (size_t i_ch = 0; i_ch < rollup.ped.size(); i_ch++) ped[i_ch] += rollup.ped[i_ch];
+  for (size_t i_ch = 0; i_ch < rollup.sigma.size(); i_ch++) sigma[i_ch] += rollup.sigma[i_ch];
+  for (size_t i_ch = 0; i_ch < rollup.rate.size(); i_ch++) rate[i_ch] += rollup.rate[i_ch];
+  for (size_t i_ch = 0; i_ch < rollup.channelcount.size(); i_ch++) channelcount[i_ch] += rollup.channelcount[i_ch];
+}
+
+TankMonitorTimeSeries::TankMonitorTimeSeries()
+{
+  SetResolutions({60000, 3600000, 86400000});   // 1 min, 1 h, 1 day
+}
+
+void TankMonitorTimeSeries::SetResolutions(const std::vector<uint64_t>& resolutions)
+{
+  std::vector<uint64_t> sorted;
+  for (uint64_t resolution : resolutions) if (resolution > 0) sorted.push_back(resolution);
+  std::sort(sorted.begin(), sorted.end());
+  sorted.erase(std::unique(sorted.begin(), sorted.end()), sorted.end());
+
+  fLevels.clear();
+  for (uint64_t resolution : sorted) {
+    Level level;
+    level.resolution = resolution;
+    for (const auto& entry : fRecords) level.buckets[entry.first - entry.first % resolution].Add(entry.second);
+    fLevels.push_back(level);
+  }
+}
+
+void TankMonitorTimeSeries::Clear()
+{
+  fRecords.clear();
+  for (Level& level : fLevels) level.buckets.clear();
+  fLastEnd = 0;
+}
+
+bool TankMonitorTimeSeries::Append(const TankMonitorRecord& record)
+{
+  if (!fRecords.emplace(record.t_start, record).second) return false;
+  for (Level& level : fLevels) {
+    level.buckets[record.t_start - record.t_start % level.resolution].Add(record);
+  }
+  fLastEnd = std::max(fLastEnd, record.t_end);
+  return true;
+}
+
+void TankMonitorTimeSeries::Prune(uint64_t tmin)
+{
+  fRecords.erase(fRecords.begin(), fRecords.lower_bound(tmin));
+  for (Level& level : fLevels) {
+    uint64_t first_kept = tmin - tmin % level.resolution;
+    level.buckets.erase(level.buckets.begin(), level.buckets.lower_bound(first_kept));
+    // the bucket containing tmin may hold files that were just removed: rebuild it
+    auto bucket = level.buckets.find(first_kept);
+    if (bucket == level.buckets.end() || first_kept == tmin) continue;
+    TankMonitorRollup rebuilt;
+    for (auto it = fRecords.lower_bound(first_kept); it != fRecords.end() && it->first < first_kept + level.resolution; ++it) {
+      rebuilt.Add(it->second);
+    }
+    if (rebuilt.nrecords > 0) bucket->second = rebuilt;
+    else level.buckets.erase(bucket);
+  }
+}
+
+void TankMonitorTimeSeries::Select(uint64_t tstart, uint64_t tend, std::vector<const TankMonitorRecord*>& records) const
+{
+  records.clear();
+  for (auto it = fRecords.lower_bound(tstart); it != fRecords.end() && it->first <= tend; ++it) {
+    if (it->second.t_end <= tend) records.push_back(&it->second);
+  }
+}
+
+void TankMonitorTimeSeries::Aggregate(uint64_t tstart, uint64_t tend, TankMonitorRollup& sum) const
+{
+  sum = TankMonitorRollup();
+  if (tend < tstart) return;
+  AggregateRange(int(fLevels.size()) - 1, tstart, tend + 1, tstart, tend, sum);
+}
+
+void TankMonitorTimeSeries::AggregateRange(int ilevel, uint64_t from, uint64_t to, uint64_t tstart, uint64_t tend,
+    TankMonitorRollup& sum) const
+{
+  if (from >= to) return;
+  if (ilevel < 0) {
+    for (auto it = fRecords.lower_bound(from); it != fRecords.end() && it->first < to; ++it) {
+      if (it->first >= tstart && it->second.t_end <= tend) sum.Add(it->second);
+    }
+    return;
+  }
+
+  const Level& level = fLevels[ilevel];
+  uint64_t resolution = level.resolution;
+  for (auto it = level.buckets.lower_bound(from - from % resolution); it != level.buckets.end() && it->first < to; ++it) {
+    uint64_t bucket_start = it->first;
+    uint64_t bucket_end = bucket_start + resolution;
+    // every file of the bucket is in range and inside the window: take the whole bucket
+    if (bucket_start >= from && bucket_end <= to && bucket_start >= tstart && it->second.t_end <= tend) {
+      sum.Add(it->second);
+    } else {
+      AggregateRange(ilevel - 1, std::max(bucket_start, from), std::min(bucket_end, to), tstart, tend, sum);
+    }
+  }
+}
+
+size_t TankMonitorTimeSeries::CountBuckets(int ilevel, uint64_t from, uint64_t to) const
+{
+  if (ilevel < 0) {
+    return std::distance(fRecords.lower_bound(from), fRecords.lower_bound(to));
+  }
+  const Level& level = fLevels[ilevel];
+  return std::distance(level.buckets.lower_bound(from - from % level.resolution), level.buckets.lower_bound(to));
+}
+
+void TankMonitorTimeSeries::Rollups(uint64_t tstart, uint64_t tend, size_t max_points,
+    std::vector<TankMonitorRollup>& rollups) const
+{
+  rollups.clear();
+  if (tend < tstart) return;
+
+  int ilevel = -1;
+  while (ilevel + 1 < int(fLevels.size()) && (max_points > 0 && CountBuckets(ilevel, tstart, tend + 1) > max_points)) ilevel++;
+
+  if (ilevel < 0) {
+    for (auto it = fRecords.lower_bound(tstart); it != fRecords.end() && it->first <= tend; ++it) {
+      if (it->second.t_end > tend) continue;
+      TankMonitorRollup single;
+      single.Add(it->second);
+      rollups.push_back(single);
+    }
+    return;
+  }
+
+  const Level& level = fLevels[ilevel];
+  for (auto it = level.buckets.lower_bound(tstart - tstart % level.resolution); it != level.buckets.end() && it->first <= tend; ++it) {
+    TankMonitorRollup point;
+    AggregateRange(ilevel, std::max(it->first, tstart), std::min(it->first + level.resolution, tend + 1), tstart, tend, point);
+    if (point.nrecords > 0) rollups.push_back(point);
+  }
+}
+
+size_t TankMonitorTimeSeries::GetNBuckets() const
+{
+  size_t nbuckets = 0;
+  for (const Level& level : fLevels) nbuckets += level.buckets.size();
+  return nbuckets;
+}
@@ -0,0 +1,101 @@
+#ifndef TANKMONITORTIMESERIES_H
+#define TANKMONITORTIMESERIES_H
+
+#include <cstddef>
+#include <map>
+#include <vector>
+#include <stdint.h>
+
+/**
+ * \struct TankMonitorRecord
+ *
+ * Monitoring values of one data file, as written to the tankmonitor_tree:
+ * per channel the mean pedestal, sigma and rate and the number of signal counts.
+ * Times are in msec since the StartTime of the MonitorTankTime tool.
+*/
+struct TankMonitorRecord {
+  uint64_t t_start = 0;
+  uint64_t t_end = 0;
+  std::vector<double> ped, sigma, rate;
+  std::vector<int> channelcount;
+
+  // Weight of the file in time averages: its length in full seconds
+  uint64_t Duration() const { return (t_end - t_start)/1000; }
+};
+
+/**
+ * \struct TankMonitorRollup
+ *
+ * Sum over a set of TankMonitorRecords. Pedestal, sigma and rate are weighted
+ * with the file duration, so the time average of a channel is ped[ch]/duration.
+*/
+struct TankMonitorRollup {
+  uint64_t t_start = 0;           // earliest file start
+  uint64_t t_end = 0;             // latest file end
+  int nrecords = 0;
+  uint64_t duration = 0;          // summed file durations, in seconds
+  std::vector<double> ped, sigma, rate;
+  std::vector<long> channelcount;
+
+  void Add(const TankMonitorRecord& record);
+  void Add(const TankMonitorRollup& rollup);
+};
+
+/**
+ * \class TankMonitorTimeSeries
+ *
+ * In-memory time series of the tank monitoring files. Every record is also
+ * summed into rollup buckets of a few fixed resolutions (by default 1 min, 1 h
+ * and 1 day, bucketed by file start time). A query over a time window adds up
+ * the coarsest buckets that lie completely inside the window and only looks at
+ * finer buckets and single files at its edges.
+ *
+ * A record belongs to the window [tstart, tend] if t_start >= tstart and
+ * t_end <= tend, as for the plots made from the monitoring files.
+*/
+class TankMonitorTimeSeries {
+
+ public:
+  TankMonitorTimeSeries();
+
+  // Rollup resolutions in msec; replaces the current buckets
+  void SetResolutions(const std::vector<uint64_t>& resolutions);
+  void Clear();
+
+  // Add one file; returns false if a file with the same start time is already stored
+  bool Append(const TankMonitorRecord& record);
+  // Drop all files that start before tmin
+  void Prune(uint64_t tmin);
+
+  // Files in the window, ordered by start time
+  void Select(uint64_t tstart, uint64_t tend, std::vector<const TankMonitorRecord*>& records) const;
+  // Sum of all files in the window
+  void Aggregate(uint64_t tstart, uint64_t tend, TankMonitorRollup& sum) const;
+  // The window split into the buckets of the finest resolution that gives at most
+  // max_points non-empty buckets (the coarsest resolution if none does). With
+  // max_points = 0, or few enough files, every file is its own entry
+  void Rollups(uint64_t tstart, uint64_t tend, size_t max_points, std::vector<TankMonitorRollup>& rollups) const;
+
+  size_t GetNRecords() const { return fRecords.size(); }
+  size_t GetNBuckets() const;
+  // Start time of the earliest stored file, 0 if empty
+  uint64_t GetFirstStart() const { return fRecords.empty() ? 0 : fRecords.begin()->first; }
+  uint64_t GetLastEnd() const { return fLastEnd; }
+
+ private:
+  struct Level {
+    uint64_t resolution;
+    std::map<uint64_t, TankMonitorRollup> buckets;   // keyed by bucket start time
+  };
+
+  // Sum the files in the window that start in [from, to), using levels <= ilevel
+  void AggregateRange(int ilevel, uint64_t from, uint64_t to, uint64_t tstart, uint64_t tend,
+      TankMonitorRollup& sum) const;
+  size_t CountBuckets(int ilevel, uint64_t from, uint64_t to) const;
+
+  std::map<uint64_t, TankMonitorRecord> fRecords;   // keyed by file start time
+  std::vector<Level> fLevels;                       // finest resolution first
+  uint64_t fLastEnd = 0;
+};
+
+#endif
@@ -10,6 +10,7 @@ bool PMTDataDecoder::Initialise(std::string configfile, DataModel &data){
   //m_variables.Print();
 
   m_data= &data; //assigning transient data pointer
+  DecoderLog.SetToolChainThread();
   /////////////////////////////////////////////////////////////////
 
   verbosity = 0;
@@ -21,6 +22,7 @@ bool PMTDataDecoder::Initialise(std::string configfile, DataModel &data){
   m_variables.Get("Mode",Mode);
   m_variables.Get("ADCCountsToBuildWaves",ADCCountsToBuild);
   m_variables.Get("EntriesPerExecute",EntriesPerExecute);
+  m_variables.Get("BenchmarkDecoder",BenchmarkDecoder);
 
   if (Mode != "Monitoring" && Mode != "Offline") Mode = "Offline";
   if (Mode == "Monitoring") PMTData = new BoostStore(false,2);
@@ -34,14 +36,55 @@ bool PMTDataDecoder::Initialise(std::string configfile, DataModel &data){
   // Initialize RawData
 
   FinishedPMTWaves = new std::map<uint64_t, std::map<std::vector<int>, std::vector<uint16_t> > >; 
+  WaveBank.resize(WAVEBANK_MAX_CRATES*WAVEBANK_MAX_SLOTS*WAVEBANK_MAX_CHANNELS);
 
   m_data->CStore.Set("PauseTankDecoding",false);
+
+  //Pipelined decoding (LoadRawData DecodeMode Pipelined): entries are decoded in a
+  //worker thread instead of one per Execute
+  intptr_t DecodePipelinePtr = 0;
+  if (Mode == "Offline") m_data->CStore.Get("RawDecodePipeline",DecodePipelinePtr);
+  DecodePipeline = RawDecodePipeline::FromCStore(DecodePipelinePtr);
+  if (DecodePipeline){
+    DecodePipeline->Retain();
+    DecodePipeline->Attach(RawDecodePipeline::Tank);
+    DecodeStats = PipelineStageStats();
+    DecodeThread = std::thread(&PMTDataDecoder::DecodeLoop,this);
+    Log("PMTDataDecoder Tool: Decoding PMT entries in a worker thread",v_message,verbosity);
+  }
+
+  //Part-file parallel decoding (LoadRawData FileList mode): whole part files are
+  //decoded ahead of the ToolChain by PartFileWorkers threads
+  m_variables.Get("PartFileWorkers",PartFileWorkers);
+  m_variables.Get("ValidatePartDecoding",ValidatePartDecoding);
+  if (PartFileWorkers > 0 && Mode == "Offline" && !DecodePipeline){
+    m_data->CStore.Get("RawDataFileList",PartFiles);
+    if (PartFiles.size() == 0){
+      Log("PMTDataDecoder Tool: PartFileWorkers needs LoadRawData in FileList mode. Decoding serially",v_warning,verbosity);
+      PartFileWorkers = 0;
+    }
+  } else PartFileWorkers = 0;
+  if (PartFileWorkers > 0){
+    //When validating, LoadRawData still passes on each entry's CardData so it can be decoded serially too
+    m_data->CStore.Set("PMTPartFileDecoding",!ValidatePartDecoding);
+    if (ValidatePartDecoding){
+      SerialDecoder = new PMTDataDecoder();
+      SerialDecoder->CopyDecoderSettings(*this);
+      SerialDecoder->DecoderLog.SetToolChainThread();
+    }
+    PartResults.resize(PartFiles.size());
+    PartStartTime = std::chrono::steady_clock::now();
+    for (int i=0; i<PartFileWorkers; i++) PartThreads.emplace_back(&PMTDataDecoder::PartFileWorker,this);
+    Log("PMTDataDecoder Tool: Decoding "+to_string(PartFiles.size())+" part files with "+
+            to_string(PartFileWorkers)+" worker threads",v_message,verbosity);
+  }
   std::cout << "PMTDataDecoder Tool: Initialized successfully" << std::endl;
   return true;
 }
 
 
 bool PMTDataDecoder::Execute(){
+  FlushWorkerLog();
   Log("PMTDataDecoder Tool: Executing",v_debug, verbosity);
   NewWavesBuilt = false;
   //Set in CStore that there's currently no new tank data available
@@ -78,8 +121,7 @@ bool PMTDataDecoder::Execute(){
       fifo1.clear();
       fifo2.clear();
       SequenceMap.clear();
-      TriggerTimeBank.clear();
-      WaveBank.clear();
+      ClearWaveBank();
       
       /*NumPMTDataProcessed = 0;
       int ExecuteEntryNum = 0;
@@ -103,7 +145,7 @@ bool PMTDataDecoder::Execute(){
 	     std::map<int,std::vector<CardData>>::iterator it;
         for (it=CardData_Map.begin(); it!= CardData_Map.end(); it++){
             int CDEntryNum = it->first;
-            std::vector<CardData> Cdata_old = it->second;
+            const std::vector<CardData>& Cdata_old = it->second;
             //std::cout <<"CDEntryNum: "<<CDEntryNum<<", CData vector size: "<<Cdata_old.size()<<std::endl;
 
 	      Log("PMTDataDecoder Tool: entry has #CardData classes = "+to_string(Cdata_old.size()),v_debug, verbosity);
@@ -113,7 +155,7 @@ bool PMTDataDecoder::Execute(){
             std::cout<<"PMTDataDecoder Tool: CardData's CardID="<<Cdata_old.at(CardDataIndex).CardID<<std::endl;
             std::cout<<"PMTDataDecoder Tool: CardData's data vector size="<<Cdata_old.at(CardDataIndex).Data.size()<<std::endl;
           }
-          CardData aCardData = Cdata_old.at(CardDataIndex);
+          const CardData& aCardData = Cdata_old.at(CardDataIndex);
           //Check if card experienced any data loss
           int FIFOstate = aCardData.FIFOstate;
           if(FIFOstate == 1){  //FIFO overflow
@@ -134,21 +176,16 @@ bool PMTDataDecoder::Execute(){
                     to_string(aCardData.SequenceID),v_warning, verbosity);
           }
 
-          //Decode raw binary data frames
-          std::vector<DecodedFrame> ThisCardDFs;
-          ThisCardDFs = this->DecodeFrames(aCardData.Data);
-          if(ThisCardDFs.size() == 0) Log("PMTDataDecoder Tool:  CardData object has no data. ",v_debug, verbosity);
-          else{
-            // Parse each decoded frame's data stream and frame header 
-            for (unsigned int i=0; i < ThisCardDFs.size(); i++){
-              this->ParseFrame(aCardData.CardID,ThisCardDFs.at(i));
-            }
-          }
+          //Decode raw binary data frames directly from the CardData bank
+          if (BenchmarkDecoder) this->BenchmarkDecoders(aCardData);
+          if(aCardData.Data.size() < WORDS_PER_FRAME) Log("PMTDataDecoder Tool:  CardData object has no data. ",v_debug, verbosity);
+          else this->DecodeCardData(aCardData.CardID,aCardData.Data.data(),aCardData.Data.size());
 	}
         Log("PMTDataDecoder Tool: PMTData Entry "+to_string(CDEntryNum)+" processed",v_debug, verbosity);
         //ExecuteEntryNum += 1; 
         //CDEntryNum+=1; 
       }
+      UpdateWaveBankUsage();
         
       CStorePMTWaves = *FinishedPMTWaves;
       m_data->CStore.Set("FinishedPMTWaves",CStorePMTWaves);
@@ -169,6 +206,8 @@ bool PMTDataDecoder::Execute(){
  
   //******** PROCESSING DATA IN OFFLINE MODE (REQUIRES LOADRAWDATA TOOL UPSTREAM) ********** 
   else if (Mode == "Offline"){
+    if (DecodePipeline) return true;  //entries are decoded by DecodeLoop
+
     bool NewEntryAvailable;
     m_data->CStore.Get("NewRawDataEntryAccessed",NewEntryAvailable);
     if(!NewEntryAvailable){ //Something went wrong processing raw data.  Stop and save what's left
@@ -197,77 +236,34 @@ bool PMTDataDecoder::Execute(){
     RunInfoPostgress.Get("RunType",RunType);
     RunInfoPostgress.Get("StarTime",StarTime);
 
-    if (CurrentRunNum == -1){ //Initializing current run number and subrun number
-      CurrentRunNum = RunNumber;
-      CurrentSubrunNum = SubRunNumber;
-    }
-    else if (RunNumber != CurrentRunNum){ //New run has been encountered
-      Log("PMTDataDecoder Tool: New run encountered.  Clearing event building maps",v_message,verbosity); 
-      fifo1.clear();
-      fifo2.clear();
-      SequenceMap.clear();
-      TriggerTimeBank.clear();
-      WaveBank.clear();
-      CurrentRunNum = RunNumber;
-    }
-    else if (SubRunNumber != CurrentSubrunNum){ //New subrun has been encountered
-      Log("PMTDataDecoder Tool: New subrun encountered.",v_message,verbosity); 
-      fifo1.clear();
-      fifo2.clear();
-      SequenceMap.clear();
-      TriggerTimeBank.clear();
-      WaveBank.clear();
-      CurrentSubrunNum = SubRunNumber;
-    }
     bool NewRawDataFile = false;
     m_data->CStore.Get("NewRawDataFileAccessed",NewRawDataFile);
-    if(NewRawDataFile){
-      fifo1.clear();
-      fifo2.clear();
-      SequenceMap.clear();  //New part file has been encountered
-    }
-
-    Log("PMTDataDecoder Tool: Procesing PMTData Entry from CStore",v_debug, verbosity);
-    m_data->CStore.Get("CardData",Cdata);
-    Log("PMTDataDecoder Tool: entry has #CardData classes = "+to_string(Cdata->size()),v_debug, verbosity);
-    
-    for (unsigned int CardDataIndex=0; CardDataIndex<Cdata->size(); CardDataIndex++){
-      CardData aCardData = Cdata->at(CardDataIndex);
-      if(verbosity>v_debug){
-        std::cout<<"PMTDataDecoder Tool: Loading next CardData from entry's index " << CardDataIndex <<std::endl;
-        std::cout<<"PMTDataDecoder Tool: CardData's CardID="<<aCardData.CardID<<std::endl;
-        std::cout<<"PMTDataDecoder Tool: CardData's data vector size="<<aCardData.Data.size()<<std::endl;
-      }
-      //Check if card experienced any data loss
-      int FIFOstate = aCardData.FIFOstate;
-      if(FIFOstate == 1){  //FIFO overflow
-        Log("PMTDataDecoder Tool: WARNING FIFO Overflow on card ID"+to_string(aCardData.CardID),v_error,verbosity);
-        fifo1.push_back(aCardData.CardID);
-      }
-      if(FIFOstate == 2){  //FIFO overflow and error clearing overvlow
-        Log("PMTDataDecoder Tool: WARNING Failure to clear FIFO Overflow on card ID"+to_string(aCardData.CardID),v_error,verbosity);
-        fifo2.push_back(aCardData.CardID);
-      }
-      Log("PMTDataDecoder Tool:  CardData has SequenceID... "+to_string(aCardData.SequenceID),v_debug, verbosity);
-      bool IsNextInSequence = this->CheckIfCardNextInSequence(aCardData);
-      if (!IsNextInSequence) {
-        Log("PMTDataDecoder Tool WARNING: CardData found OUT OF SEQUENCE!!!",v_warning, verbosity);
-        Log("PMTDataDecoder Tool:  OOO CardID... " +
-                to_string(aCardData.CardID),v_warning, verbosity);
-        Log("PMTDataDecoder Tool:  OOO SequenceID... " + 
-                to_string(aCardData.SequenceID),v_warning, verbosity);
+    this->CheckForRunChange(RunNumber, SubRunNumber, NewRawDataFile);
+
+    int EntryNum = 0;
+    m_data->CStore.Get("TankEntryNum",EntryNum);
+    if (PartFileWorkers > 0){
+      int PartNum = 0;
+      m_data->CStore.Get("RawDataFileNum",PartNum);
+      Log("PMTDataDecoder Tool: Using decoded PMTData Entry "+to_string(EntryNum)+" of part file "+to_string(PartNum),v_debug, verbosity);
+      if (!this->UsePartFileEntry(PartNum, EntryNum)){
+        Log("PMTDataDecoder Tool: ERROR decoding part file "+to_string(PartNum)+".  Stopping at next loop.",v_error,verbosity);
+        m_data->vars.Set("StopLoop",1);
+        return true;
       }
+    } else {
+      Log("PMTDataDecoder Tool: Procesing PMTData Entry from CStore",v_debug, verbosity);
+      m_data->CStore.Get("CardData",Cdata);
+      Log("PMTDataDecoder Tool: entry has #CardData classes = "+to_string(Cdata->size()),v_debug, verbosity);
       
-      //Decode raw binary frames
-      std::vector<DecodedFrame> ThisCardDFs;
-      ThisCardDFs = this->DecodeFrames(aCardData.Data);
-      if(ThisCardDFs.size() == 0) Log("PMTDataDecoder Tool:  CardData object has no data. ",v_debug, verbosity);
-      else{
-        // Parse each decoded frame's data stream and frame header 
-        for (unsigned int i=0; i < ThisCardDFs.size(); i++){
-          this->ParseFrame(aCardData.CardID,ThisCardDFs.at(i));
-        }
+      //Earliest entry with samples of the waves this entry can finish (used by the RawDataIndexer)
+      DecodeEntryNum = EntryNum;
+      int LookBackEntry = EntryNum;
+      for (unsigned int i=0; i<WaveBank.size(); i++){
+        if (WaveBank[i].active && WaveBank[i].StartEntry < LookBackEntry) LookBackEntry = WaveBank[i].StartEntry;
       }
+      this->DecodeCardDataEntry(*Cdata);
+      m_data->CStore.Set("TankEntryLookBack",LookBackEntry);
     }
     Log("PMTDataDecoder Tool: PMTData Entry processed",v_debug, verbosity);
     
@@ -286,8 +282,9 @@ bool PMTDataDecoder::Execute(){
     m_data->CStore.Set("NewTankPMTDataAvailable",NewWavesBuilt);
 
     //Check the size of the WaveBank to see if things are bloating
+    UpdateWaveBankUsage();
     Log("PMTDataDecoder Tool: Size of WaveBank (# waveforms partially built): " + 
-            to_string(WaveBank.size()),v_message, verbosity);
+            to_string(WaveBankActive),v_message, verbosity);
     Log("PMTDataDecoder Tool: Size of FinishedPMTWaves from this execution (# triggers with at least one wave fully):" + 
             to_string(FinishedPMTWaves->size()),v_message, verbosity);
   } 
@@ -297,28 +294,352 @@ bool PMTDataDecoder::Execute(){
 
 bool PMTDataDecoder::Finalise(){
 
+  if (DecodePipeline){
+    DecodePipeline->Shutdown(RawDecodePipeline::Tank);
+    if (DecodeThread.joinable()) DecodeThread.join();
+    FlushWorkerLog();
+    Log("PMTDataDecoder Tool: Pipelined decoding: "+DecodeStats.Summary(),v_warning,verbosity);
+    Log("PMTDataDecoder Tool: Pipelined decoding: "+DecodePipeline->QueueSummary(RawDecodePipeline::Tank),v_warning,verbosity);
+    RawDecodePipeline::Release(DecodePipeline);
+  }
+  if (PartFileWorkers > 0){
+    this->StopPartFileWorkers();
+    for (unsigned int i=0; i<PartResults.size(); i++) if (PartResults[i].Done) PartDecodeSeconds += PartResults[i].DecodeSeconds;
+    double WallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now()-PartStartTime).count();
+    std::cout << "PMTDataDecoder Tool: Part-file decoding with " << PartFileWorkers << " workers: " << PartsUsed << " part files used, " <<
+        PartDecodeSeconds << " s decoding in the workers, " << WallSeconds << " s wall time, " << PartWaitSeconds <<
+        " s waiting for decoded parts" << std::endl;
+    if (WallSeconds > 0) std::cout << "PMTDataDecoder Tool:   parallel speedup of the decoding (worker time / wall time): " << PartDecodeSeconds/WallSeconds << std::endl;
+    if (SerialDecoder){
+      std::cout << "PMTDataDecoder Tool:   entries checked against serial decoding: " << PartEntriesChecked <<
+          ", entries that differ: " << PartEntryMismatches << std::endl;
+      delete SerialDecoder->FinishedPMTWaves;
+      delete SerialDecoder;
+      SerialDecoder = nullptr;
+    }
+  }
+  PrintWaveBankUsage(CurrentRunNum);
+
+  if (BenchmarkDecoder){
+    double MBytes = BenchmarkBytes/1.0e6;
+    std::cout << "PMTDataDecoder Tool: Decoder benchmark over " << BenchmarkFrames << " frames (" << MBytes << " MB)" << std::endl;
+    if (ReferenceDecodeSeconds > 0) std::cout << "PMTDataDecoder Tool:   reference decoder:    " << MBytes/ReferenceDecodeSeconds << " MB/s" << std::endl;
+    if (TableDecodeSeconds > 0) std::cout << "PMTDataDecoder Tool:   table-driven decoder: " << MBytes/TableDecodeSeconds << " MB/s" << std::endl;
+    std::cout << "PMTDataDecoder Tool:   frames where decoders disagree: " << BenchmarkMismatches << std::endl;
+  }
   Log("PMTDataDecoder tool exitting",v_warning,verbosity);
   return true;
 }
 
-bool PMTDataDecoder::CheckIfCardNextInSequence(CardData aCardData)
+void PMTDataDecoder::Log(const std::string& message, int messagelevel, int verb){
+  //The ToolChain's logger is not thread-safe; worker threads buffer their messages
+  if (DecoderLog.OnToolChainThread()) Tool::Log(message,messagelevel,verb);
+  else DecoderLog.Add(message,messagelevel,verb);
+}
+
+void PMTDataDecoder::FlushWorkerLog(){
+  for (const WorkerLogMessage& message : DecoderLog.Take()) Tool::Log(message.Message,message.Level,verbosity);
+}
+
+void PMTDataDecoder::CheckForRunChange(int RunNumber, int SubRunNumber, bool NewRawDataFile)
+{
+  if (CurrentRunNum == -1){ //Initializing current run number and subrun number
+    CurrentRunNum = RunNumber;
+    CurrentSubrunNum = SubRunNumber;
+  }
+  else if (RunNumber != CurrentRunNum){ //New run has been encountered
+    Log("PMTDataDecoder Tool: New run encountered.  Clearing event building maps",v_message,verbosity); 
+    PrintWaveBankUsage(CurrentRunNum);
+    fifo1.clear();
+    fifo2.clear();
+    SequenceMap.clear();
+    ClearWaveBank();
+    WaveBankMaxActive = 0;
+    WaveBankMaxSamples = 0;
+    WaveBankMaxBytes = 0;
+    CurrentRunNum = RunNumber;
+  }
+  else if (SubRunNumber != CurrentSubrunNum){ //New subrun has been encountered
+    Log("PMTDataDecoder Tool: New subrun encountered.",v_message,verbosity); 
+    fifo1.clear();
+    fifo2.clear();
+    SequenceMap.clear();
+    ClearWaveBank();
+    CurrentSubrunNum = SubRunNumber;
+  }
+  if(NewRawDataFile){
+    fifo1.clear();
+    fifo2.clear();
+    SequenceMap.clear();  //New part file has been encountered
+    //Waves carried over from the previous part are counted from the first entry of this one
+    for (unsigned int i=0; i<WaveBank.size(); i++) if (WaveBank[i].active) WaveBank[i].StartEntry = 0;
+  }
+}
+
+void PMTDataDecoder::DecodeCardDataEntry(const std::vector<CardData>& CardDataEntry)
+{
+  for (unsigned int CardDataIndex=0; CardDataIndex<CardDataEntry.size(); CardDataIndex++){
+    const CardData& aCardData = CardDataEntry.at(CardDataIndex);
+    if(verbosity>v_debug){
+      Log("PMTDataDecoder Tool: Loading next CardData from entry's index "+to_string(CardDataIndex),vv_debug,verbosity);
+      Log("PMTDataDecoder Tool: CardData's CardID="+to_string(aCardData.CardID),vv_debug,verbosity);
+      Log("PMTDataDecoder Tool: CardData's data vector size="+to_string(aCardData.Data.size()),vv_debug,verbosity);
+    }
+    //Check if card experienced any data loss
+    int FIFOstate = aCardData.FIFOstate;
+    if(FIFOstate == 1){  //FIFO overflow
+      Log("PMTDataDecoder Tool: WARNING FIFO Overflow on card ID"+to_string(aCardData.CardID),v_error,verbosity);
+      fifo1.push_back(aCardData.CardID);
+    }
+    if(FIFOstate == 2){  //FIFO overflow and error clearing overvlow
+      Log("PMTDataDecoder Tool: WARNING Failure to clear FIFO Overflow on card ID"+to_string(aCardData.CardID),v_error,verbosity);
+      fifo2.push_back(aCardData.CardID);
+    }
+    Log("PMTDataDecoder Tool:  CardData has SequenceID... "+to_string(aCardData.SequenceID),v_debug, verbosity);
+    bool IsNextInSequence = this->CheckIfCardNextInSequence(aCardData);
+    if (!IsNextInSequence) {
+      Log("PMTDataDecoder Tool WARNING: CardData found OUT OF SEQUENCE!!!",v_warning, verbosity);
+      Log("PMTDataDecoder Tool:  OOO CardID... " +
+              to_string(aCardData.CardID),v_warning, verbosity);
+      Log("PMTDataDecoder Tool:  OOO SequenceID... " + 
+              to_string(aCardData.SequenceID),v_warning, verbosity);
+    }
+    
+    //Decode raw binary frames directly from the CardData bank
+    if (BenchmarkDecoder) this->BenchmarkDecoders(aCardData);
+    if(aCardData.Data.size() < WORDS_PER_FRAME) Log("PMTDataDecoder Tool:  CardData object has no data. ",v_debug, verbosity);
+    else this->DecodeCardData(aCardData.CardID,aCardData.Data.data(),aCardData.Data.size());
+  }
+}
+
+void PMTDataDecoder::DecodeLoop()
+{
+  //Runs on the worker thread in pipelined mode: decodes the PMT entries read by
+  //LoadRawData in order, and hands the waveforms finished by each entry to the
+  //ANNIEEventBuilder.  Only this thread touches the decoding state while it runs.
+  RawPMTEntry entry;
+  while (DecodePipeline->PopInput(entry,DecodeStats)){
+    auto start = std::chrono::steady_clock::now();
+    this->CheckForRunChange(entry.RunNumber, entry.SubRunNumber, entry.NewFile);
+    this->DecodeCardDataEntry(entry.Data);
+    UpdateWaveBankUsage();
+    DecodedTankWaves FinishedWaves;
+    FinishedWaves.swap(*FinishedPMTWaves);
+    DecodeStats.Items++;
+    DecodeStats.BusySeconds += std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count();
+    if (!DecodePipeline->PushOutput(std::move(FinishedWaves),DecodeStats)) break;
+  }
+  DecodePipeline->CloseOutput(RawDecodePipeline::Tank);
+}
+
+void PMTDataDecoder::CopyDecoderSettings(const PMTDataDecoder& parent)
+{
+  m_data = parent.m_data;
+  verbosity = parent.verbosity;
+  ADCCountsToBuild = parent.ADCCountsToBuild;
+  Mode = parent.Mode;
+  BenchmarkDecoder = false;
+  CurrentRunNum = -1;
+  CurrentSubrunNum = -1;
+  NewWavesBuilt = false;
+  WaveBank.resize(WAVEBANK_MAX_CRATES*WAVEBANK_MAX_SLOTS*WAVEBANK_MAX_CHANNELS);
+  FinishedPMTWaves = new std::map<uint64_t, std::map<std::vector<int>, std::vector<uint16_t> > >;
+}
+
+void PMTDataDecoder::PartFileWorker()
+{
+  //Runs on a worker thread: takes the next part file in order and decodes it with a
+  //private decoder.  At most PartFileWorkers parts past the one the ToolChain is
+  //using are decoded, which bounds the memory held by decoded parts.  The private
+  //decoder buffers its log messages, which go back with the part's result.
+  PMTDataDecoder PartDecoder;
+  PartDecoder.CopyDecoderSettings(*this);
+  PartDecoder.IsPartDecoder = true;
+  while (true){
+    int PartNum;
+    {
+      std::unique_lock<std::mutex> lock(PartMutex);
+      PartCondition.wait(lock, [this]{ return StopPartWorkers || NextPart < OldestPart + PartFileWorkers; });
+      if (StopPartWorkers || NextPart >= int(PartFiles.size())) break;
+      PartNum = NextPart++;
+    }
+    PMTPartResult result;
+    auto start = std::chrono::steady_clock::now();
+    result.Ok = PartDecoder.DecodePartFile(PartFiles.at(PartNum), result);
+    result.DecodeSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count();
+    result.LogMessages = PartDecoder.DecoderLog.Take();
+    result.Done = true;
+    {
+      std::lock_guard<std::mutex> lock(PartMutex);
+      PartResults[PartNum] = std::move(result);
+    }
+    PartCondition.notify_all();
+  }
+  delete PartDecoder.FinishedPMTWaves;
+}
+
+bool PMTDataDecoder::DecodePartFile(const std::string& PartFile, PMTPartResult& result)
+{
+  //Each part starts with an empty WaveBank, as if nothing had been seen before it
+  fifo1.clear();
+  fifo2.clear();
+  SequenceMap.clear();
+  SyncCounters.clear();
+  ClearWaveBank();
+  FinishedPMTWaves->clear();
+  LeadingSamples.assign(WaveBank.size(), std::vector<uint16_t>());
+  FirstHeaderEntry.assign(WaveBank.size(), -1);
+
+  BoostStore RawData(false,0);
+  if (!RawData.Initialise(PartFile.c_str())){
+    Log("PMTDataDecoder Tool: ERROR could not open part file "+PartFile,v_error,verbosity);
+    return false;
+  }
+  BoostStore PartPMTData(false,2);
+  if (!RawData.Get("PMTData",PartPMTData)){
+    Log("PMTDataDecoder Tool: ERROR no PMTData in part file "+PartFile,v_error,verbosity);
+    return false;
+  }
+  int totalentries = 0;
+  PartPMTData.Header->Get("TotalEntries",totalentries);
+  Log("PMTDataDecoder Tool: Decoding "+to_string(totalentries)+" PMTData entries of "+PartFile,v_message,verbosity);
+
+  result.EntryWaves.resize(totalentries);
+  std::vector<CardData> PartCdata;
+  for (PartEntryNum=0; PartEntryNum<totalentries; PartEntryNum++){
+    PartPMTData.GetEntry(PartEntryNum);
+    PartPMTData.Get("CardData",PartCdata);
+    this->DecodeCardDataEntry(PartCdata);
+    result.EntryWaves[PartEntryNum].swap(*FinishedPMTWaves);
+  }
+  PartPMTData.Close(); PartPMTData.Delete();
+  RawData.Close(); RawData.Delete();
+
+  result.Tail.swap(WaveBank);
+  WaveBank.resize(result.Tail.size());
+  result.Leading.swap(LeadingSamples);
+  result.FirstHeaderEntry.swap(FirstHeaderEntry);
+  result.SyncCounters.swap(SyncCounters);
+  return true;
+}
+
+void PMTDataDecoder::StitchPartFile(PMTPartResult& result)
+{
+  //Replays the boundary with the previous part as the serial decoding sees it: the
+  //samples before a channel's first record header extend the wave in progress in
+  //the WaveBank, which that header finishes; the part's open waves carry on.
+  for (unsigned int i=0; i<WaveBank.size(); i++){
+    WaveBankSlot& slot = WaveBank[i];
+    if (slot.active) slot.Samples.insert(slot.Samples.end(), result.Leading[i].begin(), result.Leading[i].end());
+    if (result.FirstHeaderEntry[i] < 0) continue;
+    if (slot.active && slot.Samples.size()>ADCCountsToBuild){
+      //The first wave finished for the channel in this part, so it takes precedence
+      //over any later one with the same trigger time
+      std::vector<int> wave_key{slot.CardID,slot.ChannelID};
+      result.EntryWaves[result.FirstHeaderEntry[i]][slot.TriggerTime][wave_key] = std::move(slot.Samples);
+    }
+    slot = std::move(result.Tail[i]);
+  }
+  WaveBankActive = 0;
+  for (unsigned int i=0; i<WaveBank.size(); i++) if (WaveBank[i].active) WaveBankActive++;
+  for (auto& counters : result.SyncCounters){
+    std::vector<uint64_t>& CardCounters = SyncCounters[counters.first];
+    CardCounters.insert(CardCounters.end(), counters.second.begin(), counters.second.end());
+  }
+  result.Tail.clear();
+  result.Leading.clear();
+}
+
+bool PMTDataDecoder::UsePartFileEntry(int PartNum, int EntryNum)
+{
+  if (PartNum < 0 || PartNum >= int(PartResults.size())) return false;
+  //Move on to the part, stitching on any parts in between without PMT entries
+  while (CurrentPart < PartNum){
+    int NewPart = CurrentPart + 1;
+    if (CurrentPart >= 0) PartResults[CurrentPart] = PMTPartResult();
+    auto start = std::chrono::steady_clock::now();
+    {
+      std::unique_lock<std::mutex> lock(PartMutex);
+      OldestPart = NewPart;
+      PartCondition.notify_all();
+      PartCondition.wait(lock, [this,NewPart]{ return PartResults[NewPart].Done; });
+    }
+    PartWaitSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count();
+    PartDecodeSeconds += PartResults[NewPart].DecodeSeconds;
+    PartResults[NewPart].DecodeSeconds = 0.;
+    PartsUsed++;
+    for (const WorkerLogMessage& message : PartResults[NewPart].LogMessages) Tool::Log(message.Message,message.Level,verbosity);
+    PartResults[NewPart].LogMessages.clear();
+    if (!PartResults[NewPart].Ok) return false;
+    this->StitchPartFile(PartResults[NewPart]);
+    CurrentPart = NewPart;
+  }
+  std::vector<DecodedTankWaves>& EntryWaves = PartResults[CurrentPart].EntryWaves;
+  if (PartNum != CurrentPart || EntryNum < 0 || EntryNum >= int(EntryWaves.size())) return false;
+  DecodedTankWaves& Waves = EntryWaves[EntryNum];
+
+  if (SerialDecoder){
+    //Decode the entry serially as well and compare the finished waves
+    Store RunInfoPostgress;
+    m_data->CStore.Get("RunInfoPostgress",RunInfoPostgress);
+    int RunNumber;
+    int SubRunNumber;
+    RunInfoPostgress.Get("RunNumber",RunNumber);
+    RunInfoPostgress.Get("SubRunNumber",SubRunNumber);
+    bool NewRawDataFile = false;
+    m_data->CStore.Get("NewRawDataFileAccessed",NewRawDataFile);
+    m_data->CStore.Get("CardData",Cdata);
+    SerialDecoder->CheckForRunChange(RunNumber, SubRunNumber, NewRawDataFile);
+    SerialDecoder->DecodeCardDataEntry(*Cdata);
+    PartEntriesChecked++;
+    if (*SerialDecoder->FinishedPMTWaves != Waves){
+      PartEntryMismatches++;
+      Log("PMTDataDecoder Tool: WARNING part-file and serial decoding differ for entry "+to_string(EntryNum)+
+              " of part file "+to_string(PartNum),v_warning,verbosity);
+    }
+    SerialDecoder->FinishedPMTWaves->clear();
+  }
+
+  for (auto& trigger : Waves){
+    std::map<std::vector<int>, std::vector<uint16_t> >& WaveMap = (*FinishedPMTWaves)[trigger.first];
+    for (auto& wave : trigger.second){
+      if (WaveMap.count(wave.first) == 0) WaveMap.emplace(wave.first, std::move(wave.second));
+    }
+  }
+  if (!Waves.empty()) NewWavesBuilt = true;
+  DecodedTankWaves().swap(Waves);
+  return true;
+}
+
+void PMTDataDecoder::StopPartFileWorkers()
+{
+  {
+    std::lock_guard<std::mutex> lock(PartMutex);
+    StopPartWorkers = true;
+  }
+  PartCondition.notify_all();
+  for (unsigned int i=0; i<PartThreads.size(); i++) if (PartThreads[i].joinable()) PartThreads[i].join();
+  PartThreads.clear();
+}
+
+bool PMTDataDecoder::CheckIfCardNextInSequence(const CardData& aCardData)
 {
   bool IsNextInSequence = false;
   //Check if this CardData is next in it's sequence for processing
   std::map<int, int>::iterator it = SequenceMap.find(aCardData.CardID);
   if(it != SequenceMap.end()){ //Data from this Card has been seen before
-    if(verbosity>v_debug)std::cout << "ExpectedSID,FoundSIE " << it->second << "," << aCardData.SequenceID << std::endl;
+    if(verbosity>v_debug) Log(LogLine() << "ExpectedSID,FoundSIE " << it->second << "," << aCardData.SequenceID,vv_debug,verbosity);
     if (it->second == aCardData.SequenceID){ //This CardData is expected next
       IsNextInSequence = true;
       it->second+=1;
     }
   } else if ((it == SequenceMap.end())){  //This is the first CardData seen by this CardID
     if (aCardData.SequenceID!=0) Log("PMTDataDecoder Tool: NOTE First data seen for this card is not SequenceID=0",v_warning,verbosity);
-    if(verbosity>v_debug) std::cout << "CARD ID " << aCardData.CardID << "NEXT IN SEQUENCE SHOULD BE " << aCardData.SequenceID+1 << std::endl;
+    if(verbosity>v_debug) Log(LogLine() << "CARD ID " << aCardData.CardID << "NEXT IN SEQUENCE SHOULD BE " << aCardData.SequenceID+1,vv_debug,verbosity);
     SequenceMap.emplace(aCardData.CardID, aCardData.SequenceID+1); //Assume this is the first sequenceID even if not zero
     IsNextInSequence = true;
   } else {
-    if(verbosity>v_error) std::cout << "SEQUENCE JUMP BY " << (aCardData.SequenceID - it->second) << "!!!!" << std::endl;
+    if(verbosity>v_error) Log(LogLine() << "SEQUENCE JUMP BY " << (aCardData.SequenceID - it->second) << "!!!!",v_warning,verbosity);
     it->second = aCardData.SequenceID;
     IsNextInSequence = false;
   }
@@ -332,13 +653,13 @@ std::vector<DecodedFrame> PMTDataDecoder::DecodeFrames(std::vector<uint32_t> ban
 {
   Log("PMTDataDecoder Tool: Decoding frames now ",v_debug, verbosity);
   Log("PMTDataDecoder Tool: Bank size is "+to_string(bank.size()),v_debug, verbosity);
-  uint64_t tempword;
+  uint64_t tempword = 0;
   std::vector<DecodedFrame> frames;  //What we will return
   std::vector<uint16_t> samples;
   samples.resize(40); //Well, if there's 480 bits per frame of samples max, this fits it
-  if(verbosity>v_message) std::cout << "DECODING A CARDDATA'S DATA BANK.  SIZE OF BANK: " << bank.size() << std::endl;
-  if(verbosity>v_message) std::cout << "THIS SHOULD HOLD AN INTEGER NUMBER OF FRAMES.  EACH FRAME HAS" << std::endl;
-  if(verbosity>v_message) std::cout << "512 BITs, split into 16 32-bit INTEGERS.  THIS SHOUDL BE DIVISIBLE BY 16" << std::endl;
+  if(verbosity>v_message) Log(LogLine() << "DECODING A CARDDATA'S DATA BANK.  SIZE OF BANK: " << bank.size(),v_debug,verbosity);
+  if(verbosity>v_message) Log(LogLine() << "THIS SHOULD HOLD AN INTEGER NUMBER OF FRAMES.  EACH FRAME HAS",v_debug,verbosity);
+  if(verbosity>v_message) Log(LogLine() << "512 BITs, split into 16 32-bit INTEGERS.  THIS SHOUDL BE DIVISIBLE BY 16",v_debug,verbosity);
   for (unsigned int frame = 0; frame<bank.size()/16; ++frame) {  // if each frame has 16 32-bit ints, nframes = bank_size/16
     struct DecodedFrame thisframe;
     int sampleindex = 0;
@@ -347,16 +668,16 @@ std::vector<DecodedFrame> PMTDataDecoder::DecodeFrames(std::vector<uint32_t> ban
     bool haverecheader_part1 = false;
     while (sampleindex < 40) {  //Parse out this whole frame
       if (bitsleft < 12) {
-        if(verbosity>vv_debug) std::cout << "DATA STREAM STEP AT SAMPLE INDEX" << sampleindex << std::endl;
+        if(verbosity>vv_debug) Log(LogLine() << "DATA STREAM STEP AT SAMPLE INDEX" << sampleindex,vv_debug+1,verbosity);
         tempword += ((uint64_t)be32toh(bank[wordindex]))<<bitsleft;
-        if(verbosity>vv_debug) std::cout << "DATA STREAM SNAPSHOT WITH NEXT 32-bit WORD FROM FRAME " << std::bitset<64>(tempword) << std::endl;
+        if(verbosity>vv_debug) Log(LogLine() << "DATA STREAM SNAPSHOT WITH NEXT 32-bit WORD FROM FRAME " << std::bitset<64>(tempword),vv_debug+1,verbosity);
         bitsleft += 32;
         wordindex += 1;
       }
       //Logic to search for record headers
       if((tempword&0xfff)==RECORD_HEADER_LABELPART1) haverecheader_part1 = true;
       else if (haverecheader_part1 && ((tempword&0xfff)==RECORD_HEADER_LABELPART2)){
-        if(verbosity>vv_debug) std::cout << "FOUND A RECORD HEADER. AT INDEX " << sampleindex << std::endl;
+        if(verbosity>vv_debug) Log(LogLine() << "FOUND A RECORD HEADER. AT INDEX " << sampleindex,vv_debug+1,verbosity);
         thisframe.has_recordheader=true;
         thisframe.recordheader_starts.push_back(sampleindex-1);
         haverecheader_part1 = false;
@@ -365,134 +686,161 @@ std::vector<DecodedFrame> PMTDataDecoder::DecodeFrames(std::vector<uint32_t> ban
      
       //Takie the first 12 bits of the tempword at each loop, and shift tempword
       samples[sampleindex] = tempword&0xfff;
-      if(verbosity>vv_debug) std::cout << "FIRST 12 BITS IN THIS SNAPSHOT: " << std::bitset<16>(tempword&0xfff) << dec << std::endl;
+      if(verbosity>vv_debug) Log(LogLine() << "FIRST 12 BITS IN THIS SNAPSHOT: " << std::bitset<16>(tempword&0xfff),vv_debug+1,verbosity);
       tempword = tempword>>12;
       bitsleft -= 12;
       sampleindex += 1;
     } //END parse out this frame
     thisframe.frameheader = be32toh(bank[16*frame+15]);  //Frameid is held in the frame's last 32-bit word
-    if(verbosity>vv_debug) std::cout << "FRAMEHEADER last 8 bits: " << std::bitset<32>(thisframe.frameheader>>24) << std::endl;
+    if(verbosity>vv_debug) Log(LogLine() << "FRAMEHEADER last 8 bits: " << std::bitset<32>(thisframe.frameheader>>24),vv_debug+1,verbosity);
     thisframe.samples = samples;
-    if(verbosity>vv_debug) std::cout << "LENGTH OF SAMPLES AFTER DECODING A FRAME: " << dec << thisframe.samples.size() << std::endl;
+    if(verbosity>vv_debug) Log(LogLine() << "LENGTH OF SAMPLES AFTER DECODING A FRAME: " << dec << thisframe.samples.size(),vv_debug+1,verbosity);
     frames.push_back(thisframe);
   }
   Log("PMTDataDecoder Tool: Decoding frames complete ",v_debug, verbosity);
   return frames;
 }
 
-void PMTDataDecoder::ParseFrame(int CardID, DecodedFrame DF)
+void PMTDataDecoder::DecodeCardData(int CardID, const uint32_t* bank, size_t nwords)
+{
+  Log("PMTDataDecoder Tool: Decoding frames now ",v_debug, verbosity);
+  Log("PMTDataDecoder Tool: Bank size is "+to_string(nwords),v_debug, verbosity);
+  size_t nframes = nwords/WORDS_PER_FRAME;  //bank holds an integer number of 16-word frames
+  for (size_t frame = 0; frame < nframes; ++frame){
+    const uint32_t* thisframe = bank + WORDS_PER_FRAME*frame;
+    uint64_t recordheader_mask = this->UnpackFrame(thisframe, FrameSamples);
+    uint32_t frameheader = be32toh(thisframe[WORDS_PER_FRAME-1]);  //Frameid is held in the frame's last 32-bit word
+    this->ParseFrame(CardID, frameheader, FrameSamples, recordheader_mask);
+  }
+  Log("PMTDataDecoder Tool: Decoding frames complete ",v_debug, verbosity);
+}
+
+uint64_t PMTDataDecoder::UnpackFrame(const uint32_t* frame, uint16_t* samples)
+{
+  //The 40 12-bit samples are packed little-endian across the first 15 (big-endian)
+  //32-bit words of the frame.  Each group of 3 words holds exactly 8 samples at
+  //fixed bit offsets, so the unpack is the same shift/mask pattern 5 times over.
+  for (int group = 0; group < 5; group++){
+    uint32_t w0 = be32toh(frame[3*group]);
+    uint32_t w1 = be32toh(frame[3*group+1]);
+    uint32_t w2 = be32toh(frame[3*group+2]);
+    uint16_t* s = samples + 8*group;
+    s[0] = w0 & 0xfff;
+    s[1] = (w0 >> 12) & 0xfff;
+    s[2] = (w0 >> 24) | ((w1 & 0xf) << 8);
+    s[3] = (w1 >> 4) & 0xfff;
+    s[4] = (w1 >> 16) & 0xfff;
+    s[5] = (w1 >> 28) | ((w2 & 0xff) << 4);
+    s[6] = (w2 >> 8) & 0xfff;
+    s[7] = (w2 >> 20) & 0xfff;
+  }
+  //A record header starts where a 0x000 sample is directly followed by a 0xFFF
+  //sample.  Build one mask per label and combine them, bit i = header at sample i.
+  uint64_t label1_mask = 0;
+  uint64_t label2_mask = 0;
+  for (int i = 0; i < SAMPLES_PER_FRAME; i++){
+    label1_mask |= ((uint64_t)(samples[i] == RECORD_HEADER_LABELPART1)) << i;
+    label2_mask |= ((uint64_t)(samples[i] == RECORD_HEADER_LABELPART2)) << i;
+  }
+  return label1_mask & (label2_mask >> 1);
+}
+
+void PMTDataDecoder::ParseFrame(int CardID, uint32_t frameheader, const uint16_t* samples, uint64_t recordheader_mask)
 { 
   //Decoded frame infomration is moved to the
   //TriggerTimeBank and WaveBank.  
   //Get the ID in the frame header.  Need to know if a channel, or sync signal
-  unsigned channel_mask; 
-  int ChannelID = DF.frameheader >> 24; //TODO: Use something more intricate?
+  int ChannelID = frameheader >> 24; //TODO: Use something more intricate?
                                   //Bitrange defined by Jonathan (511 downto 504)
-  if(verbosity>4) std::cout << "Parsing frame with CardID and ChannelID-" << 
-      CardID << "," << ChannelID << std::endl;
-  if(!DF.has_recordheader && (ChannelID != SYNCFRAME_HEADERID)){
-    //All samples are waveforms for channel record that already exists in the WaveBank.
-    this->AddSamplesToWaveBank(CardID, ChannelID, DF.samples);
-  } else if (ChannelID != SYNCFRAME_HEADERID){
-    int WaveSecBegin = 0;
-    //We need to get the rest of a wave from WaveSecBegin to where the header starts
-    //FIXME: this works if there's already a wave being built.  You need to parse 
-    //a record header in the wavebank first if it's the first thing in the frame though
-    if(verbosity>v_debug) {
-      for (unsigned int j = 0; j<DF.recordheader_starts.size(); j++){
-          std::cout << DF.recordheader_starts.at(j) << std::endl;
-      }
-    }
-    for (unsigned int j = 0; j<DF.recordheader_starts.size(); j++){
-      //TODO: More graceful way to handle this?  It's already happened once
-      if(WaveSecBegin>DF.recordheader_starts.at(j)){
-        if (verbosity > v_warning) std::cout << "WARNING: Record header label found inside another record header." << 
-            "This is likely due a 000FFF in the counter.  Skipping record header and " <<
-            "continuing" << std::endl;
-        continue;
-      }
-      if(verbosity>vv_debug)std::cout << "RECORD HEADER INDEX" << DF.recordheader_starts.at(j) << std::endl;
-      if(verbosity>vv_debug)std::cout << "WAVESECBEGIN IS " << WaveSecBegin << std::endl;
-      std::vector<uint16_t> WaveSlice(DF.samples.begin()+WaveSecBegin, 
-              DF.samples.begin()+DF.recordheader_starts.at(j));
-      Log("PMTDataDecoder Tool: Length of waveslice: "+to_string(WaveSlice.size()),vv_debug, verbosity);
-      //Add this WaveSlice to the wave bank
-      this->AddSamplesToWaveBank(CardID, ChannelID, WaveSlice);
-      //Since we have acquired the wave up to the next record header, the wave is done.
-      //Store it in the FinishedWaves map.
-      this->StoreFinishedWaveform(CardID, ChannelID);
-      //Now, we have the header coming next.  Get it and parse it, starting whatever
-      //Entries in maps are needed. 
-      std::vector<uint16_t> RecordHeader(DF.samples.begin()+
-              DF.recordheader_starts.at(j), DF.samples.begin()+
-              DF.recordheader_starts.at(j)+SAMPLES_RIGHTOF_000+1);
-      this->ParseRecordHeader(CardID, ChannelID, RecordHeader);
-      WaveSecBegin = DF.recordheader_starts.at(j)+SAMPLES_RIGHTOF_000+1;
+  if(verbosity>4) Log(LogLine() << "Parsing frame with CardID and ChannelID-" << CardID << "," << ChannelID,vv_debug+1,verbosity);
+  if (ChannelID == SYNCFRAME_HEADERID){
+    this->ParseSyncFrame(CardID, samples);
+    return;
+  }
+  int WaveSecBegin = 0;
+  //We need to get the rest of a wave from WaveSecBegin to where the header starts
+  //FIXME: this works if there's already a wave being built.  You need to parse 
+  //a record header in the wavebank first if it's the first thing in the frame though
+  while (recordheader_mask){
+    int RecordHeaderStart = __builtin_ctzll(recordheader_mask);
+    recordheader_mask &= recordheader_mask - 1;
+    //TODO: More graceful way to handle this?  It's already happened once
+    if(WaveSecBegin>RecordHeaderStart){
+      Log("WARNING: Record header label found inside another record header."
+          "This is likely due a 000FFF in the counter.  Skipping record header and "
+          "continuing",v_message,verbosity);
+      continue;
     }
-    // No more record headers from here; just parse the rest of whatever 
-    // waveform is being looked at
-    int WaveSecEnd = DF.samples.size()-1;
-    std::vector<uint16_t> WaveSlice(DF.samples.begin()+WaveSecBegin, 
-            DF.samples.end());
-    this->AddSamplesToWaveBank(CardID, ChannelID, WaveSlice);
+    if(verbosity>vv_debug) Log(LogLine() << "RECORD HEADER INDEX" << RecordHeaderStart,vv_debug+1,verbosity);
+    if(verbosity>vv_debug) Log(LogLine() << "WAVESECBEGIN IS " << WaveSecBegin,vv_debug+1,verbosity);
+    //Add the samples up to the record header to the wave bank
+    this->AddSamplesToWaveBank(CardID, ChannelID, samples+WaveSecBegin, samples+RecordHeaderStart);
+    //Since we have acquired the wave up to the next record header, the wave is done.
+    //Store it in the FinishedWaves map.
+    this->StoreFinishedWaveform(CardID, ChannelID);
+    //Now, we have the header coming next.  Get it and parse it, starting whatever
+    //Entries in maps are needed. 
+    this->ParseRecordHeader(CardID, ChannelID, samples+RecordHeaderStart);
+    WaveSecBegin = RecordHeaderStart+SAMPLES_RIGHTOF_000+1;
   }
-  else {
-    this->ParseSyncFrame(CardID, DF);
+  // No more record headers from here; just parse the rest of whatever 
+  // waveform is being looked at
+  if (WaveSecBegin < SAMPLES_PER_FRAME){
+    this->AddSamplesToWaveBank(CardID, ChannelID, samples+WaveSecBegin, samples+SAMPLES_PER_FRAME);
   }
   return;
 }
 
-void PMTDataDecoder::ParseSyncFrame(int CardID, DecodedFrame DF)
+void PMTDataDecoder::ParseSyncFrame(int CardID, const uint16_t* samples)
 {
-  if(verbosity>vv_debug) std::cout << "PRINTING ALL DATA IN A SYNC FRAME FOR CARD" << CardID << std::endl;
+  if(verbosity>vv_debug) Log(LogLine() << "PRINTING ALL DATA IN A SYNC FRAME FOR CARD" << CardID,vv_debug+1,verbosity);
   uint64_t SyncCounter = 0;
   for (int i=0; i < 6; i++){
-    if(verbosity>vv_debug) std::cout << "SYNC FRAME DATA AT INDEX " << i << ": " << DF.samples.at(i) << std::endl;
-    SyncCounter += ((uint64_t)DF.samples.at(i)) << (12*i);
-    if(verbosity>vv_debug) std::cout << "SYNC COUNTER WITH CURRENT SAMPLE PUT AT LEFT: " << SyncCounter << std::endl;
-  }
-  std::map<int, std::vector<uint64_t>>::iterator it = SyncCounters.find(CardID);
-  if(it != SyncCounters.end()) SyncCounters.at(CardID).push_back(SyncCounter);
-  else {
-    std::vector<uint64_t> SyncVec{SyncCounter};
-    SyncCounters.emplace(CardID,SyncVec);
+    if(verbosity>vv_debug) Log(LogLine() << "SYNC FRAME DATA AT INDEX " << i << ": " << samples[i],vv_debug+1,verbosity);
+    SyncCounter += ((uint64_t)samples[i]) << (12*i);
+    if(verbosity>vv_debug) Log(LogLine() << "SYNC COUNTER WITH CURRENT SAMPLE PUT AT LEFT: " << SyncCounter,vv_debug+1,verbosity);
   }
+  SyncCounters[CardID].push_back(SyncCounter);
   return;
 }
 
-void PMTDataDecoder::ParseRecordHeader(int CardID, int ChannelID, std::vector<uint16_t> RH)
+void PMTDataDecoder::ParseRecordHeader(int CardID, int ChannelID, const uint16_t* RH)
 {
   //We need to get the MTC count and make a new entry in TriggerTimeBank and WaveBank
   //First 4 samples; Just get the bits from 24 to 37 (is counter (61 downto 48)
   //Last 4 samples; All the first 48 bits of the MTC count.
   Log("PMTDataDecoder Tool: Parsing an encountered header ",v_debug, verbosity);
   if(verbosity>vv_debug){
-    std::cout << "BIT WORDS IN RECORD HEADER: " << std::endl;
-    for (unsigned int j=0; j<RH.size(); j++){
-      std::cout << std::bitset<16>(RH.at(j)) << dec << std::endl;
+    Log("BIT WORDS IN RECORD HEADER: ",vv_debug+1,verbosity);
+    for (unsigned int j=0; j<SAMPLES_RIGHTOF_000+1; j++){
+      Log(LogLine() << std::bitset<16>(RH[j]),vv_debug+1,verbosity);
     }
   }
-  std::vector<uint16_t> CounterEnd(RH.begin()+2, RH.begin()+4);
-  std::vector<uint16_t> CounterBegin(RH.begin()+4, RH.begin()+8);
+  //RH[4..7] hold the low 48 bits of the counter, RH[2..3] the upper bits
   uint64_t ClockCount=0;
-  int samplewidth=12;  //each uint16 really only holds 12 bits of info. (see DecodeFrame)
-  //std::reverse(CounterBegin.begin(),CounterBegin.end());
-  for (unsigned int j=0; j<CounterBegin.size(); j++){
-    ClockCount += ((uint64_t)CounterBegin.at(j) << j*samplewidth);
+  int samplewidth=12;  //each uint16 really only holds 12 bits of info. (see UnpackFrame)
+  for (unsigned int j=0; j<4; j++){
+    ClockCount += ((uint64_t)RH[4+j] << j*samplewidth);
   }
-  for (unsigned int j=0; j<CounterEnd.size(); j++){
-    ClockCount += ((uint64_t)CounterEnd.at(j) << ((CounterBegin.size() + j)*samplewidth));
+  for (unsigned int j=0; j<2; j++){
+    ClockCount += ((uint64_t)RH[2+j] << ((4 + j)*samplewidth));
   }
-  std::vector<int> wave_key{CardID,ChannelID};
-  std::vector<uint16_t> Waveform;
-  
-  //Update the TriggerTimeBank and WaveBank with new entries, since this channel's
+  //Start a new wave in this channel's WaveBank slot, since this channel's
   //Wave data is coming up next
   Log("PMTDataDecoder Tool: Parsed Clock counter for header is "+to_string(ClockCount),v_debug, verbosity);
   Log("PMTDataDecoder Tool: Parsed Clock time for header is "+to_string(ClockCount*8),v_debug, verbosity);
-  TriggerTimeBank.emplace(wave_key,ClockCount*8);
+  int bank_index = this->WaveBankIndex(CardID, ChannelID);
+  if (bank_index < 0) return;
+  WaveBankSlot& slot = WaveBank[bank_index];
+  if (slot.active) return;  //Wave already being built for this channel
   Log("PMTDataDecoder Tool: Placing empty waveform in WaveBank ",v_debug, verbosity);
-  WaveBank.emplace(wave_key,Waveform);
+  slot.active = true;
+  slot.CardID = CardID;
+  slot.ChannelID = ChannelID;
+  slot.TriggerTime = ClockCount*8;
+  slot.StartEntry = DecodeEntryNum;
+  slot.Samples.clear();
+  WaveBankActive++;
   return;
 }
 
@@ -500,51 +848,144 @@ void PMTDataDecoder::ParseRecordHeader(int CardID, int ChannelID, std::vector<ui
 void PMTDataDecoder::StoreFinishedWaveform(int CardID, int ChannelID)
 {
   //Get the full waveform from the Wave Bank
-  std::vector<int> wave_key{CardID,ChannelID};
-  //Check there's a wave in the map
-  if(WaveBank.count(wave_key)==0){
+  int bank_index = this->WaveBankIndex(CardID, ChannelID);
+  //Check there's a wave in the bank
+  if(bank_index < 0 || (!WaveBank[bank_index].active && !(IsPartDecoder && FirstHeaderEntry[bank_index] < 0))){
     Log("PMTDataDecoder::StoreFinishedWaveform: No waveform available for CardID,ChannelID " + 
             to_string(CardID) + "," + to_string(ChannelID),v_message, verbosity);
     Log("PMTDataDecoder::StoreFinishedWaveForm: Continuing without saving any waves",v_message, verbosity);
     return;
   }
-  std::vector<uint16_t> FinishedWave = WaveBank.at(wave_key);
-  uint64_t FinishedWaveTrigTime = TriggerTimeBank.at(wave_key);  //Conversion from counter ticks to ns
-  Log("PMTDataDecoder Tool: Finished Wave Length"+to_string(WaveBank.size()),v_debug, verbosity);
+  WaveBankSlot& slot = WaveBank[bank_index];
+  if (IsPartDecoder && !slot.active && FirstHeaderEntry[bank_index] < 0){
+    //First record header of this channel in the part file: the wave it ends began
+    //in the previous part and is finished when the parts are stitched together
+    FirstHeaderEntry[bank_index] = PartEntryNum;
+    return;
+  }
+  size_t FinishedWaveLength = slot.Samples.size();
+  uint64_t FinishedWaveTrigTime = slot.TriggerTime;
+  Log("PMTDataDecoder Tool: Finished Wave Length"+to_string(FinishedWaveLength),v_debug, verbosity);
   Log("PMTDataDecoder Tool: Finished Wave Clock time (ns)"+to_string(FinishedWaveTrigTime),v_debug, verbosity);
 
-  if(FinishedWave.size()>ADCCountsToBuild){
+  if(FinishedWaveLength>ADCCountsToBuild){
     NewWavesBuilt = true;
-    if(FinishedPMTWaves->count(FinishedWaveTrigTime) == 0) {
-      std::map<std::vector<int>, std::vector<uint16_t> > WaveMap;
-      WaveMap.emplace(wave_key,FinishedWave);
-      FinishedPMTWaves->emplace(FinishedWaveTrigTime,WaveMap);
-    } else {
-      FinishedPMTWaves->at(FinishedWaveTrigTime).emplace(wave_key,FinishedWave);
+    std::map<std::vector<int>, std::vector<uint16_t> >& WaveMap = (*FinishedPMTWaves)[FinishedWaveTrigTime];
+    std::vector<int> wave_key{CardID,ChannelID};
+    if(WaveMap.count(wave_key) == 0) {
+      //Hand the sample buffer over to the finished waves rather than copying it, and
+      //give the slot a fresh buffer sized for the next wave on this channel
+      WaveMap.emplace(std::move(wave_key),std::move(slot.Samples));
+      slot.Samples = std::vector<uint16_t>();
+      slot.Samples.reserve(FinishedWaveLength);
     }
   }
-  //Clear the finished wave from WaveBank and TriggerTimeBank for the new wave
-  //to start being put together
-  WaveBank.erase(wave_key);
-  TriggerTimeBank.erase(wave_key);
+  //Free the slot for the new wave to start being put together
+  slot.active = false;
+  slot.Samples.clear();
+  WaveBankActive--;
   return;
 }
   
 void PMTDataDecoder::AddSamplesToWaveBank(int CardID, int ChannelID, 
-        std::vector<uint16_t> WaveSlice)
+        const uint16_t* SliceBegin, const uint16_t* SliceEnd)
 {
-  Log("PMTDataDecoder Tool: Adding Waveslice to waveform.  Num. Samples: "+to_string(WaveSlice.size()),vv_debug, verbosity);
+  Log("PMTDataDecoder Tool: Adding Waveslice to waveform.  Num. Samples: "+to_string(SliceEnd-SliceBegin),vv_debug, verbosity);
   //TODO: Make sure the above is always divisible by 4!
-  //Add the WaveSlice to the proper vector in the WaveBank.
-  std::vector<int> wave_key{CardID,ChannelID};
-  if(WaveBank.count(wave_key)==0){
+  //Add the WaveSlice to the proper slot in the WaveBank.
+  int bank_index = this->WaveBankIndex(CardID, ChannelID);
+  if(IsPartDecoder && bank_index >= 0 && !WaveBank[bank_index].active && FirstHeaderEntry[bank_index] < 0){
+    //Samples before the channel's first record header in the part file belong to a
+    //wave started in the previous part
+    LeadingSamples[bank_index].insert(LeadingSamples[bank_index].end(), SliceBegin, SliceEnd);
+    return;
+  }
+  if(bank_index < 0 || !WaveBank[bank_index].active){
     Log("PMTDataDecoder Tool: HAVE WAVE SLICE BUT NO WAVE BEING BUILT.: ",v_warning, verbosity);
     Log("PMTDataDecoder Tool: WAVE SLICE WILL NOT BE SAVED, DATA LOST",v_warning, verbosity);
     return;
-  } else {
-  WaveBank.at(wave_key).insert(WaveBank.at(wave_key).end(),
-                               WaveSlice.begin(),
-                               WaveSlice.end());
   }
+  std::vector<uint16_t>& BankWave = WaveBank[bank_index].Samples;
+  BankWave.insert(BankWave.end(), SliceBegin, SliceEnd);
   return;
 }
+
+int PMTDataDecoder::WaveBankIndex(int CardID, int ChannelID)
+{
+  //CardID = CrateNum * 1000 + SlotNum (see ANNIEEventBuilder::CardIDToElectronicsSpace)
+  int CrateNum = CardID / 1000;
+  int SlotNum = CardID % 100;
+  if (CardID < 0 || CrateNum >= WAVEBANK_MAX_CRATES || SlotNum >= WAVEBANK_MAX_SLOTS || 
+          ChannelID < 0 || ChannelID >= WAVEBANK_MAX_CHANNELS){
+    Log("PMTDataDecoder Tool: WARNING CardID,ChannelID " + to_string(CardID) + "," + 
+            to_string(ChannelID) + " outside of WaveBank capacity",v_warning, verbosity);
+    return -1;
+  }
+  return (CrateNum*WAVEBANK_MAX_SLOTS + SlotNum)*WAVEBANK_MAX_CHANNELS + ChannelID;
+}
+
+void PMTDataDecoder::ClearWaveBank()
+{
+  for (unsigned int i=0; i<WaveBank.size(); i++){
+    WaveBank[i].active = false;
+    WaveBank[i].Samples.clear();
+  }
+  WaveBankActive = 0;
+}
+
+void PMTDataDecoder::UpdateWaveBankUsage()
+{
+  size_t samples = 0;
+  size_t bytes = 0;
+  for (unsigned int i=0; i<WaveBank.size(); i++){
+    samples += WaveBank[i].Samples.size();
+    bytes += WaveBank[i].Samples.capacity()*sizeof(uint16_t);
+  }
+  if (WaveBankActive > WaveBankMaxActive) WaveBankMaxActive = WaveBankActive;
+  if (samples > WaveBankMaxSamples) WaveBankMaxSamples = samples;
+  if (bytes > WaveBankMaxBytes) WaveBankMaxBytes = bytes;
+}
+
+void PMTDataDecoder::PrintWaveBankUsage(int RunNumber)
+{
+  Log("PMTDataDecoder Tool: WaveBank high-water mark for run " + to_string(RunNumber) + ": " +
+          to_string(WaveBankMaxActive) + " waveforms partially built, " + to_string(WaveBankMaxSamples) +
+          " samples held, " + to_string(WaveBankMaxBytes/1024) + " kB of sample buffers",v_message, verbosity);
+}
+
+void PMTDataDecoder::BenchmarkDecoders(const CardData& aCardData)
+{
+  //Decode the same bank with the reference (per-sample) decoder and the
+  //table-driven unpack, timing each and checking the two agree frame by frame.
+  size_t nframes = aCardData.Data.size()/WORDS_PER_FRAME;
+  if (nframes == 0) return;
+  std::vector<uint16_t> TableSamples(nframes*SAMPLES_PER_FRAME);
+  std::vector<uint64_t> TableMasks(nframes);
+
+  auto start = std::chrono::steady_clock::now();
+  std::vector<DecodedFrame> ReferenceFrames = this->DecodeFrames(aCardData.Data);
+  auto mid = std::chrono::steady_clock::now();
+  for (size_t frame = 0; frame < nframes; ++frame){
+    TableMasks[frame] = this->UnpackFrame(aCardData.Data.data()+WORDS_PER_FRAME*frame,
+            TableSamples.data()+SAMPLES_PER_FRAME*frame);
+  }
+  auto end = std::chrono::steady_clock::now();
+
+  ReferenceDecodeSeconds += std::chrono::duration<double>(mid-start).count();
+  TableDecodeSeconds += std::chrono::duration<double>(end-mid).count();
+  BenchmarkBytes += nframes*WORDS_PER_FRAME*sizeof(uint32_t);
+  BenchmarkFrames += nframes;
+
+  for (size_t frame = 0; frame < nframes; ++frame){
+    const DecodedFrame& DF = ReferenceFrames.at(frame);
+    uint64_t ReferenceMask = 0;
+    for (unsigned int j = 0; j < DF.recordheader_starts.size(); j++) ReferenceMask |= ((uint64_t)1) << DF.recordheader_starts.at(j);
+    bool agree = (ReferenceMask == TableMasks[frame]) &&
+        std::equal(DF.samples.begin(), DF.samples.end(), TableSamples.begin()+SAMPLES_PER_FRAME*frame);
+    if (!agree){
+      BenchmarkMismatches++;
+      Log("PMTDataDecoder Tool: WARNING reference and table-driven decoders disagree for card "+to_string(aCardData.CardID)+
+              ", frame "+to_string(frame),v_warning,verbosity);
+    }
+  }
+}
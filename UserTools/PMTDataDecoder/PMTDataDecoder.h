@@ -5,12 +5,19 @@
 #include <iostream>
 #include <bitset>
 #include <deque>
+#include <chrono>
+#include <algorithm>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 
 #include "Tool.h"
 #include "CardData.h"
 #include "TriggerData.h"
 #include "BoostStore.h"
 #include "Store.h"
+#include "RawDecodePipeline.h"
+#include "WorkerLog.h"
 
 #include <boost/algorithm/string.hpp>
 
@@ -27,8 +34,10 @@
 */
 
 
+//Reference (per-sample) decoding of a frame.  Only used by DecodeFrames, which is
+//kept to validate and benchmark the table-driven decoder (see BenchmarkDecoder).
 struct DecodedFrame{
-  bool has_recordheader;
+  bool has_recordheader = false;
   uint32_t frameheader;
   std::vector<uint16_t> samples;
   std::vector<int> recordheader_starts; //Holds indices where a record header starts in samples
@@ -38,6 +47,34 @@ struct DecodedFrame{
 
 
 
+//One in-progress waveform of the channel bank.  Slots are reused for the whole run;
+//Samples keeps its capacity between waves of the same channel.
+struct WaveBankSlot{
+  bool active = false;
+  int CardID = -1;
+  int ChannelID = -1;
+  uint64_t TriggerTime = 0;  //trigger time (ns) from the wave's record header
+  int StartEntry = 0;        //PMTData entry holding the wave's record header
+  std::vector<uint16_t> Samples;
+};
+
+
+//One raw data part file decoded by a part-file worker (PartFileWorkers config
+//variable).  Each part is decoded starting from an empty WaveBank; the samples and
+//record headers needed to finish the waves left open by the previous part are kept,
+//so they can be stitched on in part order (see StitchPartFile).
+struct PMTPartResult{
+  bool Done = false;
+  bool Ok = false;
+  std::vector<DecodedTankWaves> EntryWaves;  //Waves finished while decoding each PMTData entry
+  std::vector<WaveBankSlot> Tail;   //WaveBank at the end of the part
+  std::vector<std::vector<uint16_t> > Leading;  //Per WaveBank slot: samples seen before the slot's first record header
+  std::vector<int> FirstHeaderEntry;  //Per WaveBank slot: entry holding the slot's first record header, -1 if none
+  std::map<int,std::vector<uint64_t> > SyncCounters;
+  std::vector<WorkerLogMessage> LogMessages;  //Logged while decoding; the ToolChain thread logs them when it uses the part
+  double DecodeSeconds = 0.;
+};
+
 class PMTDataDecoder: public Tool {
 
 
@@ -47,15 +84,35 @@ class PMTDataDecoder: public Tool {
   bool Initialise(std::string configfile,DataModel &data); ///< Initialise Function for setting up Tool resources. @param configfile The path and name of the dynamic configuration file to read in. @param data A reference to the transient data class used to pass information between Tools.
   bool Execute(); ///< Execute function used to perform Tool purpose.
   bool Finalise(); ///< Finalise function used to clean up resources.
-  std::vector<DecodedFrame> DecodeFrames(std::vector<uint32_t> bank);
+  std::vector<DecodedFrame> DecodeFrames(std::vector<uint32_t> bank); ///< Reference decoder, used only by the decoder benchmark
 
-  void ParseFrame(int CardID, DecodedFrame DF);
-  void ParseSyncFrame(int CardID, DecodedFrame DF);
-  void ParseRecordHeader(int CardID, int ChannelID, std::vector<uint16_t> RH);
+  void DecodeCardData(int CardID, const uint32_t* bank, size_t nwords); ///< Decode and parse all frames of a CardData bank in place
+  uint64_t UnpackFrame(const uint32_t* frame, uint16_t* samples); ///< Unpack the 40 samples of one frame. @return bitmask of record header start indices
+  void ParseFrame(int CardID, uint32_t frameheader, const uint16_t* samples, uint64_t recordheader_mask);
+  void ParseSyncFrame(int CardID, const uint16_t* samples);
+  void ParseRecordHeader(int CardID, int ChannelID, const uint16_t* RH);
   void StoreFinishedWaveform(int CardID, int ChannelID);
-  void AddSamplesToWaveBank(int CardID, int ChannelID, std::vector<uint16_t> WaveSlice);
-  bool CheckIfCardNextInSequence(CardData aCardData);
+  void AddSamplesToWaveBank(int CardID, int ChannelID, const uint16_t* SliceBegin, const uint16_t* SliceEnd);
+  bool CheckIfCardNextInSequence(const CardData& aCardData);
+  int WaveBankIndex(int CardID, int ChannelID); ///< Index of a card/channel in the WaveBank, or -1 if outside its capacity
+  void ClearWaveBank(); ///< Drop all in-progress waves, keeping slot buffers allocated
+  void UpdateWaveBankUsage(); ///< Update the WaveBank memory high-water mark for this run
+  void PrintWaveBankUsage(int RunNumber); ///< Report the WaveBank memory high-water mark of a run
+  void BenchmarkDecoders(const CardData& aCardData); ///< Time reference and table-driven decoders on the same bank and check they agree
   void BuildReadyEvents();
+  void CheckForRunChange(int RunNumber, int SubRunNumber, bool NewRawDataFile); ///< Reset the decoding state at a new run, subrun or part file
+  void DecodeCardDataEntry(const std::vector<CardData>& CardDataEntry); ///< Check and decode every CardData of a PMTData entry
+  void DecodeLoop(); ///< Worker thread of the pipelined decoding
+  void Log(const std::string& message, int messagelevel, int verb); ///< Tool::Log, buffered when called from a worker thread
+  void FlushWorkerLog(); ///< Log the messages buffered by the worker threads
+
+  //Part-file parallel decoding (PartFileWorkers config variable)
+  void CopyDecoderSettings(const PMTDataDecoder& parent); ///< Set up a private decoder with this tool's settings
+  void PartFileWorker(); ///< Worker thread: decode whole part files, a bounded number ahead of the ToolChain
+  bool DecodePartFile(const std::string& PartFile, PMTPartResult& result); ///< Decode every PMTData entry of a part file
+  void StitchPartFile(PMTPartResult& result); ///< Finish the waves straddling the boundary with the previous part
+  bool UsePartFileEntry(int PartNum, int EntryNum); ///< Hand the waves of one entry over, as if it had been decoded here
+  void StopPartFileWorkers();
 
 
  private:
@@ -67,6 +124,7 @@ class PMTDataDecoder: public Tool {
   int ADCCountsToBuild;  //If a finished wave doesn't have this many ADC counts at least, don't add it for building
   int EntriesPerExecute;
   int PMTDEntryNum = 0; 
+  int DecodeEntryNum = 0;  //PMTData entry being decoded (Offline mode)
   int FileNum = 0;
   int CurrentRunNum;
   int CurrentSubrunNum;
@@ -84,6 +142,56 @@ class PMTDataDecoder: public Tool {
   //get the entire header.
   unsigned int SAMPLES_RIGHTOF_000 = 7;
 
+  //Each frame is 16 32-bit words: 15 words hold 40 packed 12-bit samples, the last
+  //word holds the frame header.  Every 3 words hold exactly 8 samples.
+  static const int WORDS_PER_FRAME = 16;
+  static const int SAMPLES_PER_FRAME = 40;
+
+  //Scratch buffer the current frame is unpacked into.  Padded so a record header
+  //starting near the end of a frame can always be read as 8 samples.
+  uint16_t FrameSamples[SAMPLES_PER_FRAME+8] = {0};
+
+  //Decoder benchmark (BenchmarkDecoder config variable)
+  bool BenchmarkDecoder = false;
+  double ReferenceDecodeSeconds = 0.;
+  double TableDecodeSeconds = 0.;
+  uint64_t BenchmarkBytes = 0;
+  uint64_t BenchmarkFrames = 0;
+  uint64_t BenchmarkMismatches = 0;
+
+  //Pipelined decoding (LoadRawData DecodeMode Pipelined)
+  RawDecodePipeline* DecodePipeline = nullptr;
+  std::thread DecodeThread;
+  PipelineStageStats DecodeStats;
+  WorkerLog DecoderLog;
+
+  //Part-file parallel decoding (PartFileWorkers config variable).  The part files
+  //of a LoadRawData FileList are decoded by worker threads; the ToolChain then takes
+  //each entry's waves from PartResults instead of decoding the entry itself.
+  int PartFileWorkers = 0;
+  bool ValidatePartDecoding = false;
+  std::vector<std::string> PartFiles;
+  std::vector<PMTPartResult> PartResults;
+  std::vector<std::thread> PartThreads;
+  std::mutex PartMutex;
+  std::condition_variable PartCondition;
+  int NextPart = 0;    //Next part file to hand to a worker
+  int OldestPart = 0;  //Parts up to OldestPart+PartFileWorkers-1 may be decoded
+  bool StopPartWorkers = false;
+  int CurrentPart = -1;
+  double PartWaitSeconds = 0.;
+  double PartDecodeSeconds = 0.;
+  int PartsUsed = 0;
+  std::chrono::steady_clock::time_point PartStartTime;
+  PMTDataDecoder* SerialDecoder = nullptr;  //ValidatePartDecoding: reference serial decoding of every entry
+  uint64_t PartEntriesChecked = 0;
+  uint64_t PartEntryMismatches = 0;
+  //State of a worker's private decoder
+  bool IsPartDecoder = false;
+  int PartEntryNum = 0;
+  std::vector<std::vector<uint16_t> > LeadingSamples;
+  std::vector<int> FirstHeaderEntry;
+
   BoostStore* PMTData;
   std::vector<CardData>* Cdata = nullptr;
   std::vector<CardData> Cdata_old;
@@ -100,8 +208,18 @@ class PMTDataDecoder: public Tool {
 
 
   //Maps used in decoding frames; specifically, holds record header and record waveform info
-  std::map<std::vector<int>, uint64_t> TriggerTimeBank;  //Key: {cardID, channelID}. Value: trigger time associated with wave in WaveBank 
-  std::map<std::vector<int>, std::vector<uint16_t>> WaveBank;  //Key: {cardID, channelID}. Value: Waveform being built for this Card and ADC Channel. 
+  //Channel bank of waveforms being built, one slot per (card, channel).  CardIDs are
+  //CrateNum*1000+SlotNum, so a slot's index is ((crate*MAX_SLOTS)+slot)*MAX_CHANNELS+channel.
+  static const int WAVEBANK_MAX_CRATES = 8;
+  static const int WAVEBANK_MAX_SLOTS = 32;
+  static const int WAVEBANK_MAX_CHANNELS = 16;
+  std::vector<WaveBankSlot> WaveBank;
+  size_t WaveBankActive = 0;  //# waveforms partially built
+
+  //WaveBank memory high-water marks for the current run
+  size_t WaveBankMaxActive = 0;
+  size_t WaveBankMaxSamples = 0;
+  size_t WaveBankMaxBytes = 0; 
   std::map<int,std::vector<uint64_t>> SyncCounters; //Key: cardID.  Value: vector of sync counters filled in the order they arrive.
 
   //Maps that store completed waveforms from cards
@@ -22,6 +22,7 @@ bool PhaseIIADCHitFinder::Initialise(std::string config_filename, DataModel& dat
   pulse_window_start_shift = -3;
   pulse_window_end_shift = 25;
   adc_window_db = "none"; //Used when pulse_finding_approach="fixed_windows"
+  benchmark_pulse_finding = false;
 
   //Load any configurables set in the config file
   m_variables.Get("verbosity",verbosity); 
@@ -34,6 +35,7 @@ bool PhaseIIADCHitFinder::Initialise(std::string config_filename, DataModel& dat
   m_variables.Get("PulseWindowStart", pulse_window_start_shift);
   m_variables.Get("PulseWindowEnd", pulse_window_end_shift);
   m_variables.Get("WindowIntegrationDB", adc_window_db); 
+  m_variables.Get("BenchmarkPulseFinding", benchmark_pulse_finding);
 
   if ((pulse_window_start_shift > 0) || (pulse_window_end_shift) < 0){
     Log("PhaseIIADCHitFinder Tool: WARNING... trigger threshold crossing will not be inside pulse window.  Threshold" 
@@ -144,18 +146,10 @@ bool PhaseIIADCHitFinder::Execute() {
     }
 
     //Find pulses in the raw detector data
-    for (const auto& temp_pair : raw_waveform_map) {
-      const auto& achannel_key = temp_pair.first;
-      const auto& araw_waveforms = temp_pair.second;
-      //Don't make hit objects for any offline channels
-      Channel* thischannel = geom->GetChannel(achannel_key);
-      if(thischannel->GetStatus() == channelstatus::OFF) continue;
-      std::vector<CalibratedADCWaveform<double> > acalibrated_waveforms = calibrated_waveform_map.at(achannel_key);
-      bool MadeMaps = this->build_pulse_and_hit_map(achannel_key, araw_waveforms, acalibrated_waveforms, pulse_map,*hit_map);
-      if(!MadeMaps){
-        Log("PhaseIIADCHitFinder Error: problem making PMT hit and pulse maps", 0, verbosity);
-        return false;
-      }
+    bool MadeMaps = this->build_pulse_and_hit_maps(raw_waveform_map, calibrated_waveform_map, pulse_map, *hit_map, false);
+    if(!MadeMaps){
+      Log("PhaseIIADCHitFinder Error: problem making PMT hit and pulse maps", 0, verbosity);
+      return false;
     }
     Log("PhaseIIADCHitFinder Tool: setting PMT RecoADCHits in annie event", v_debug, verbosity);
     annie_event->Set("RecoADCHits", pulse_map);
@@ -164,17 +158,10 @@ bool PhaseIIADCHitFinder::Execute() {
 
     Log("PhaseIIADCHitFinder Tool: Finding SiPM pulses in auxiliary channels", v_debug, verbosity);
     //Find pulses in the raw auxiliary channel data
-    for (const auto& temp_pair : raw_aux_waveform_map) {
-      const auto& achannel_key = temp_pair.first;
-      if(AuxChannelNumToTypeMap->at(achannel_key) != "SiPM1" &&
-        AuxChannelNumToTypeMap->at(achannel_key) != "SiPM2") continue; 
-      const auto& araw_waveforms = temp_pair.second;
-      std::vector<CalibratedADCWaveform<double> > acalibrated_waveforms = calibrated_aux_waveform_map.at(achannel_key);
-      bool MadeAuxMaps = this->build_pulse_and_hit_map(achannel_key, araw_waveforms, acalibrated_waveforms, aux_pulse_map,*aux_hit_map);
-      if(!MadeAuxMaps){
-        Log("PhaseIIADCHitFinder Error: problem making  Aux hit and pulse maps", 0, verbosity);
-        return false;
-      }
+    bool MadeAuxMaps = this->build_pulse_and_hit_maps(raw_aux_waveform_map, calibrated_aux_waveform_map, aux_pulse_map, *aux_hit_map, true);
+    if(!MadeAuxMaps){
+      Log("PhaseIIADCHitFinder Error: problem making  Aux hit and pulse maps", 0, verbosity);
+      return false;
     }
     Log("PhaseIIADCHitFinder Tool: setting RecoADCAuxHits in annie event", v_debug, verbosity);
     annie_event->Set("RecoADCAuxHits", aux_pulse_map);
@@ -191,6 +178,25 @@ bool PhaseIIADCHitFinder::Execute() {
 
 
 bool PhaseIIADCHitFinder::Finalise() {
+  if (benchmark_pulse_finding && !benchmark_samples.empty()) {
+    double total_legacy = 0., total_fused = 0., total_samples = 0.;
+    for (const auto& samples_pair : benchmark_samples) {
+      unsigned long channel_key = samples_pair.first;
+      double nsamples = samples_pair.second;
+      total_legacy += benchmark_legacy_ns.at(channel_key);
+      total_fused += benchmark_fused_ns.at(channel_key);
+      total_samples += nsamples;
+      Log("PhaseIIADCHitFinder benchmark: channel " + std::to_string(channel_key)
+        + " legacy " + std::to_string(benchmark_legacy_ns.at(channel_key)/nsamples)
+        + " ns/sample, single-pass " + std::to_string(benchmark_fused_ns.at(channel_key)/nsamples)
+        + " ns/sample", v_debug, verbosity);
+    }
+    Log("PhaseIIADCHitFinder benchmark: " + std::to_string(benchmark_samples.size())
+      + " channels, legacy " + std::to_string(total_legacy/total_samples)
+      + " ns/sample, single-pass " + std::to_string(total_fused/total_samples)
+      + " ns/sample, " + std::to_string(benchmark_mismatches)
+      + " minibuffers with different pulses", v_message, verbosity);
+  }
   return true;
 }
 
@@ -284,10 +290,33 @@ std::map<unsigned long, std::vector<std::vector<int>>> PhaseIIADCHitFinder::load
   return chanwindowmap;
 }
 
+bool PhaseIIADCHitFinder::build_pulse_and_hit_maps(
+  const std::map<unsigned long, std::vector<Waveform<unsigned short> > >& raw_waveforms,
+  const std::map<unsigned long, std::vector<CalibratedADCWaveform<double> > >& calibrated_waveforms,
+  std::map<unsigned long, std::vector< std::vector<ADCPulse>> > & pmap,
+  std::map<unsigned long,std::vector<Hit>>& hmap, bool aux_channels)
+{
+  for (const auto& temp_pair : raw_waveforms) {
+    const auto& achannel_key = temp_pair.first;
+    if (aux_channels) {
+      if(AuxChannelNumToTypeMap->at(achannel_key) != "SiPM1" &&
+        AuxChannelNumToTypeMap->at(achannel_key) != "SiPM2") continue; 
+    } else {
+      //Don't make hit objects for any offline channels
+      Channel* thischannel = geom->GetChannel(achannel_key);
+      if(thischannel->GetStatus() == channelstatus::OFF) continue;
+    }
+    const auto& araw_waveforms = temp_pair.second;
+    const auto& acalibrated_waveforms = calibrated_waveforms.at(achannel_key);
+    if (!this->build_pulse_and_hit_map(achannel_key, araw_waveforms, acalibrated_waveforms, pmap, hmap)) return false;
+  }
+  return true;
+}
+
 bool PhaseIIADCHitFinder::build_pulse_and_hit_map(
   unsigned long channel_key,
-  std::vector<Waveform<unsigned short> > raw_waveforms, 
-  std::vector<CalibratedADCWaveform<double> > calibrated_waveforms,
+  const std::vector<Waveform<unsigned short> >& raw_waveforms, 
+  const std::vector<CalibratedADCWaveform<double> >& calibrated_waveforms,
   std::map<unsigned long, std::vector< std::vector<ADCPulse>> > & pmap,
   std::map<unsigned long,std::vector<Hit>>& hmap)
 {
@@ -310,8 +339,7 @@ bool PhaseIIADCHitFinder::build_pulse_and_hit_map(
 
     // Integrate each whole dang minibuffer and background subtract 
     for (size_t mb = 0; mb < num_minibuffers; ++mb) {
-        Waveform<unsigned short> buffer_wave = raw_waveforms.at(mb);
-        int window_end = buffer_wave.GetSamples()->size()-1;
+        int window_end = raw_waveforms.at(mb).Samples().size()-1;
         std::vector<int> fullwindow{0,window_end};
         std::vector<std::vector<int>> onewindowvec{fullwindow};
         pulse_vec.push_back(this->find_pulses_bywindow(raw_waveforms.at(mb),
@@ -322,8 +350,7 @@ bool PhaseIIADCHitFinder::build_pulse_and_hit_map(
   if (pulse_finding_approach == "full_window_maxpeak"){
     // Integrate each whole dang minibuffer and background subtract 
     for (size_t mb = 0; mb < num_minibuffers; ++mb) {
-        Waveform<unsigned short> buffer_wave = raw_waveforms.at(mb);
-        int window_end = buffer_wave.GetSamples()->size()-1;
+        int window_end = raw_waveforms.at(mb).Samples().size()-1;
         std::vector<int> fullwindow{0,window_end};
         std::vector<std::vector<int>> onewindowvec{fullwindow};
         pulse_vec.push_back(this->find_pulses_bywindow(raw_waveforms.at(mb),
@@ -360,8 +387,38 @@ bool PhaseIIADCHitFinder::build_pulse_and_hit_map(
         + std::to_string( channel_key ),
         2, verbosity);
 
+      if (pulse_window_type != "fixed") {
         pulse_vec.push_back(this->find_pulses_bythreshold(raw_waveforms.at(mb),
           calibrated_waveforms.at(mb), thispmt_adc_threshold, channel_key));
+        continue;
+      }
+
+      pulse_vec.emplace_back();
+      if (!benchmark_pulse_finding) {
+        this->find_pulses_fixed_window(raw_waveforms.at(mb),
+          calibrated_waveforms.at(mb), thispmt_adc_threshold, channel_key, pulse_vec.back());
+      } else {
+        // time the original finder against the single-pass one on this minibuffer
+        auto start = std::chrono::steady_clock::now();
+        std::vector<ADCPulse> legacy_pulses = this->find_pulses_bythreshold(raw_waveforms.at(mb),
+          calibrated_waveforms.at(mb), thispmt_adc_threshold, channel_key);
+        auto mid = std::chrono::steady_clock::now();
+        this->find_pulses_fixed_window(raw_waveforms.at(mb),
+          calibrated_waveforms.at(mb), thispmt_adc_threshold, channel_key, pulse_vec.back());
+        auto stop = std::chrono::steady_clock::now();
+        benchmark_legacy_ns[channel_key] += std::chrono::duration<double,std::nano>(mid-start).count();
+        benchmark_fused_ns[channel_key] += std::chrono::duration<double,std::nano>(stop-mid).count();
+        benchmark_samples[channel_key] += raw_waveforms.at(mb).Samples().size();
+        const std::vector<ADCPulse>& fused_pulses = pulse_vec.back();
+        bool same = (legacy_pulses.size() == fused_pulses.size());
+        for (size_t i = 0; same && i < legacy_pulses.size(); i++) {
+          same = (legacy_pulses.at(i).start_time() == fused_pulses.at(i).start_time()
+            && legacy_pulses.at(i).peak_time() == fused_pulses.at(i).peak_time()
+            && legacy_pulses.at(i).raw_area() == fused_pulses.at(i).raw_area()
+            && legacy_pulses.at(i).charge() == fused_pulses.at(i).charge());
+        }
+        if (!same) benchmark_mismatches++;
+      }
     }
   } 
   
@@ -374,15 +431,14 @@ bool PhaseIIADCHitFinder::build_pulse_and_hit_map(
   Log("PhaseIIADCHitFinder: Filling pulse map.",
       v_debug, verbosity);
   if(verbosity > v_debug) std::cout << "Number of pulses in pulse_vec's first entry: " << pulse_vec.at(0).size() << std::endl;
-  pmap.emplace(channel_key,pulse_vec);
   //Convert ADCPulses to Hits and fill into Hit map
   HitsOnPMT = this->convert_adcpulses_to_hits(channel_key,pulse_vec);
+  pmap.emplace(channel_key,std::move(pulse_vec));
   Log("PhaseIIADCHitFinder: Filling hit map.",
       v_debug, verbosity);
-  for(int j=0; j < HitsOnPMT.size(); j++){
-    Hit ahit = HitsOnPMT.at(j);
-    if(hmap.count(channel_key)==0) hmap.emplace(channel_key, std::vector<Hit>{ahit});
-    else hmap.at(channel_key).push_back(ahit);
+  if(!HitsOnPMT.empty()){
+    if(hmap.count(channel_key)==0) hmap.emplace(channel_key, std::move(HitsOnPMT));
+    else hmap.at(channel_key).insert(hmap.at(channel_key).end(), HitsOnPMT.begin(), HitsOnPMT.end());
   }
   return true;
 }
@@ -486,6 +542,82 @@ std::vector<ADCPulse> PhaseIIADCHitFinder::find_pulses_bywindow(
 }
 
 
+void PhaseIIADCHitFinder::find_pulses_fixed_window(
+  const Waveform<unsigned short>& raw_minibuffer_data,
+  const CalibratedADCWaveform<double>& calibrated_minibuffer_data,
+  unsigned short adc_threshold, unsigned long channel_key,
+  std::vector<ADCPulse>& pulses)
+{
+  const std::vector<unsigned short>& raw_samples = raw_minibuffer_data.Samples();
+  const std::vector<double>& calibrated_samples = calibrated_minibuffer_data.Samples();
+
+  //Sanity check that raw/calibrated minibuffers are same size
+  if ( raw_samples.size() != calibrated_samples.size() )
+  {
+    throw std::runtime_error("Size mismatch between the raw and calibrated"
+      " waveforms encountered in PhaseIIADCHitFinder::find_pulses_fixed_window()");
+  }
+
+  // Same search range as find_pulses_bythreshold: the last 50 samples can't start a pulse
+  if ( raw_samples.size() <= 50 ) return;
+  int num_samples = static_cast<int>(raw_samples.size()) - 50;
+
+  // Windows are opened in sample order, so their starts and ends both increase.
+  // A sample lies inside an earlier window exactly when the last window starting
+  // before it hasn't ended yet; n_started tracks how many windows start before s.
+  window_start_buffer.clear();
+  window_end_buffer.clear();
+  size_t n_started = 0;
+
+  for (int s = 0; s < num_samples; ++s) {
+    while ( n_started < window_start_buffer.size() && window_start_buffer[n_started] < s ) ++n_started;
+    if ( n_started > 0 && s < window_end_buffer[n_started-1] ) continue;
+    if ( raw_samples[s] <= adc_threshold ) continue;
+
+    int pulse_start = s + pulse_window_start_shift;
+    int pulse_end = s + pulse_window_end_shift;
+    // find_pulses_bythreshold compares the (unsigned) sample number against the
+    // window start, so a window shifted below sample 0 never contains a later sample.
+    // Keep that so both finders return the same pulses.
+    if ( pulse_start >= 0 ) {
+      window_start_buffer.push_back(pulse_start);
+      window_end_buffer.push_back(pulse_end);
+    }
+    //If the pulse crosses the sampling window, restrict it's value to within window
+    if ( pulse_start < 0 ) pulse_start = 0;
+    if ( pulse_end > num_samples ) pulse_end = num_samples - 1;
+
+    // Raw area, raw amplitude (first maximum) and calibrated charge in one loop
+    unsigned long raw_area = 0; // ADC * samples
+    unsigned short max_ADC = std::numeric_limits<unsigned short>::lowest();
+    size_t peak_sample = BOGUS_INT;
+    double charge = 0.;
+    for (int p = pulse_start; p <= pulse_end; ++p) {
+      unsigned short raw_sample = raw_samples.at(p);
+      raw_area += raw_sample;
+      if ( max_ADC < raw_sample ) {
+        max_ADC = raw_sample;
+        peak_sample = p;
+      }
+      charge += calibrated_samples[p];
+    }
+
+    // The amplitude of the pulse (V)
+    double calibrated_amplitude = calibrated_samples.at(peak_sample);
+
+    // Convert the pulse integral to nC
+    charge *= NS_PER_ADC_SAMPLE / ADC_IMPEDANCE;
+
+    pulses.emplace_back(channel_key,
+      ( pulse_start * NS_PER_SAMPLE ),
+      peak_sample * NS_PER_SAMPLE,
+      calibrated_minibuffer_data.GetBaseline(),
+      calibrated_minibuffer_data.GetSigmaBaseline(),
+      raw_area, max_ADC, calibrated_amplitude, charge);
+  }
+  if(verbosity > v_debug) std::cout << "Number of pulses in channels pulse vector: " << pulses.size() << std::endl;
+}
+
 std::vector<ADCPulse> PhaseIIADCHitFinder::find_pulses_bythreshold(
   const Waveform<unsigned short>& raw_minibuffer_data,
   const CalibratedADCWaveform<double>& calibrated_minibuffer_data,
@@ -653,12 +785,12 @@ std::vector<ADCPulse> PhaseIIADCHitFinder::find_pulses_bythreshold(
   return pulses;
 }
 
-std::vector<Hit> PhaseIIADCHitFinder::convert_adcpulses_to_hits(unsigned long channel_key,std::vector<std::vector<ADCPulse>> pulses){
+std::vector<Hit> PhaseIIADCHitFinder::convert_adcpulses_to_hits(unsigned long channel_key,const std::vector<std::vector<ADCPulse>>& pulses){
   std::vector<Hit> thispmt_hits;
   for(int i=0; i < pulses.size(); i++){
-    std::vector<ADCPulse> apulsevector = pulses.at(i);
+    const std::vector<ADCPulse>& apulsevector = pulses.at(i);
     for(int j=0; j < apulsevector.size(); j++){
-      ADCPulse apulse = apulsevector.at(j);
+      const ADCPulse& apulse = apulsevector.at(j);
       //Get the time and charge
       double time = apulse.peak_time();
       double charge = apulse.charge();
@@ -13,6 +13,7 @@
 #include <cmath>
 #include <limits>
 #include <stdexcept>
+#include <chrono>
 
 // ToolAnalysis includes
 #include "ADCPulse.h"
@@ -56,6 +57,7 @@ class PhaseIIADCHitFinder : public Tool {
     bool use_led_waveforms;
     int pulse_window_start_shift;
     int pulse_window_end_shift;
+    bool benchmark_pulse_finding;
     std::map<unsigned long, unsigned short> channel_threshold_map;
     std::map<unsigned long, std::vector<std::vector<int>>> channel_window_map;
     
@@ -92,9 +94,16 @@ class PhaseIIADCHitFinder : public Tool {
     std::map<unsigned long, std::vector<std::vector<int>>> load_integration_window_map(std::string window_db);
 
     void ClearMaps();
+    // Batch mode: find the pulses and hits of every channel of an event in one call.
+    // aux_channels selects the SiPM channel filter instead of the offline PMT filter.
+    bool build_pulse_and_hit_maps(
+      const std::map<unsigned long, std::vector<Waveform<unsigned short> > >& raw_waveforms,
+      const std::map<unsigned long, std::vector<CalibratedADCWaveform<double> > >& calibrated_waveforms,
+      std::map<unsigned long, std::vector< std::vector<ADCPulse>> > & pmap,
+      std::map<unsigned long,std::vector<Hit>>& hmap, bool aux_channels);
     bool build_pulse_and_hit_map(unsigned long ckey,
-       std::vector<Waveform<unsigned short> > rawmap, 
-      std::vector<CalibratedADCWaveform<double> > calmap,
+      const std::vector<Waveform<unsigned short> >& rawmap, 
+      const std::vector<CalibratedADCWaveform<double> >& calmap,
       std::map<unsigned long, std::vector< std::vector<ADCPulse>> > & pmap,
       std::map<unsigned long,std::vector<Hit>>& hmap);
     // Create a vector of ADCPulse objects using the raw and calibrated signals
@@ -106,6 +115,16 @@ class PhaseIIADCHitFinder : public Tool {
       const CalibratedADCWaveform<double>& calibrated_minibuffer_data,
       unsigned short adc_threshold, const unsigned long& channel_key) const;
 
+    // Single-pass version of find_pulses_bythreshold for pulse_window_type "fixed":
+    // threshold crossings are found and each window's raw area, peak and calibrated
+    // charge are integrated in the same sweep. Pulses are appended to 'pulses', so
+    // the caller can reuse one buffer.
+    void find_pulses_fixed_window(
+      const Waveform<unsigned short>& raw_minibuffer_data,
+      const CalibratedADCWaveform<double>& calibrated_minibuffer_data,
+      unsigned short adc_threshold, unsigned long channel_key,
+      std::vector<ADCPulse>& pulses);
+
     std::vector<ADCPulse> find_pulses_bywindow(
       const Waveform<unsigned short>& raw_minibuffer_data,
       const CalibratedADCWaveform<double>& calibrated_minibuffer_data,
@@ -113,7 +132,17 @@ class PhaseIIADCHitFinder : public Tool {
       bool MaxHeightPulseOnly) const;
 
     //Takes the ADC pulse vectors (one per minibuffer) and converts them to a vector of hits
-    std::vector<Hit> convert_adcpulses_to_hits(unsigned long channel_key,std::vector<std::vector<ADCPulse>> pulses);
+    std::vector<Hit> convert_adcpulses_to_hits(unsigned long channel_key,const std::vector<std::vector<ADCPulse>>& pulses);
+
+    // Windows found so far in the current minibuffer (find_pulses_fixed_window)
+    std::vector<int> window_start_buffer;
+    std::vector<int> window_end_buffer;
+
+    // BenchmarkPulseFinding: per channel time (ns) and samples scanned by each finder
+    std::map<unsigned long, double> benchmark_legacy_ns;
+    std::map<unsigned long, double> benchmark_fused_ns;
+    std::map<unsigned long, double> benchmark_samples;
+    long benchmark_mismatches = 0;
 
 };
 
@@ -1,7 +1,7 @@
 #include "PythonScript.h"
 PyMODINIT_FUNC test(void){
 
-  return PyModule_Create(&StoreModule);
+  return CreateStoreModule();
 
   }
 
@@ -21,8 +21,13 @@ bool PythonScript::Initialise(std::string configfile, DataModel &data){
   m_variables.Get("InitialiseFunction",initialisefunction);
   m_variables.Get("ExecuteFunction",executefunction);
   m_variables.Get("FinaliseFunction",finalisefunction);
+  benchmarkfeatures=0;
+  benchmarkevents=1000;
+  m_variables.Get("BenchmarkFeatures",benchmarkfeatures);
+  m_variables.Get("BenchmarkEvents",benchmarkevents);
 
   gstore=m_data->Stores["DataName"];
+  gstores=&(m_data->Stores);
 
 
   PyImport_AppendInittab("Store", test);
@@ -210,9 +215,102 @@ bool PythonScript::Finalise(){
 
   }
   
+  if(benchmarkfeatures>0) BenchmarkFeatureHandoff();
+
   int tmpinit=0;
   m_data->CStore.Get("PythonInit",tmpinit);
   if(tmpinit==pyinit)  Py_Finalize();
   
   return true;
 }
+
+
+// Times handing benchmarkfeatures doubles per event to python: as a row of a
+// csv file, the way FindTrackLengthInWater passes features to the DNN and BDT
+// scripts, and as a Store.GetArray view of a vector in a store.
+void PythonScript::BenchmarkFeatureHandoff(){
+
+  const char* code=
+    "import Store\n"
+    "try:\n"
+    "    import numpy as np\n"
+    "except ImportError:\n"
+    "    np = None\n"
+    "csvfile = open(csvname)\n"
+    "def from_csv():\n"
+    "    fields = csvfile.readline().rstrip(',\\n').split(',')\n"
+    "    if np is not None: return float(np.array(fields, dtype=float).sum())\n"
+    "    return sum([float(x) for x in fields])\n"
+    "def from_store():\n"
+    "    a = Store.GetArray('PythonScriptBenchmark', 'features', 'double')\n"
+    "    if np is not None: return float(np.asarray(a).sum())\n"
+    "    return sum(memoryview(a))\n";
+
+  std::string csvname="PythonScriptBenchmark.csv";
+  std::ofstream csvout(csvname.c_str());
+
+  BoostStore* benchstore=new BoostStore(false,0);
+  std::vector<double>* features=new std::vector<double>(benchmarkfeatures);
+  benchstore->Set("features",features,false);
+  m_data->Stores["PythonScriptBenchmark"]=benchstore;
+
+  PyObject* globals=PyDict_New();
+  PyDict_SetItemString(globals, "__builtins__", PyEval_GetBuiltins());
+  PyObject* pyname=PyUnicode_FromString(csvname.c_str());
+  PyDict_SetItemString(globals, "csvname", pyname);
+  Py_DECREF(pyname);
+  PyObject* result=PyRun_String(code, Py_file_input, globals, globals);
+  Py_XDECREF(result);
+  PyObject* csvin=PyDict_GetItemString(globals, "csvfile");
+  PyObject* fromcsv=PyDict_GetItemString(globals, "from_csv");
+  PyObject* fromstore=PyDict_GetItemString(globals, "from_store");
+
+  if(csvin==NULL || fromcsv==NULL || fromstore==NULL){
+    PyErr_Print();
+    fprintf(stderr,"PythonScript: could not set up the feature hand-off benchmark\n");
+  }
+  else {
+    double csvtime=0., storetime=0.;
+    int nevents=0;
+    for(int event=0; event<benchmarkevents; event++){
+      for(int i=0; i<benchmarkfeatures; i++) features->at(i)=0.001*i+event;
+
+      std::chrono::steady_clock::time_point start=std::chrono::steady_clock::now();
+      for(int i=0; i<benchmarkfeatures; i++) csvout<<features->at(i)<<",";
+      csvout<<'\n';
+      csvout.flush();
+      PyObject* csvsum=PyObject_CallObject(fromcsv, NULL);
+      csvtime+=std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now()-start).count();
+
+      start=std::chrono::steady_clock::now();
+      PyObject* storesum=PyObject_CallObject(fromstore, NULL);
+      storetime+=std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now()-start).count();
+
+      if(csvsum==NULL || storesum==NULL){
+        Py_XDECREF(csvsum);
+        Py_XDECREF(storesum);
+        PyErr_Print();
+        break;
+      }
+      Py_DECREF(csvsum);
+      Py_DECREF(storesum);
+      nevents++;
+    }
+    if(nevents>0){
+      std::cout<<"PythonScript: hand-off of "<<benchmarkfeatures<<" features per event to python, "<<nevents<<" events:"<<std::endl;
+      std::cout<<"  csv row:          "<<csvtime/nevents<<" us/event"<<std::endl;
+      std::cout<<"  Store.GetArray:   "<<storetime/nevents<<" us/event"<<std::endl;
+      if(storetime>0.) std::cout<<"  speedup: "<<csvtime/storetime<<std::endl;
+    }
+    PyObject* closed=PyObject_CallMethod(csvin, "close", NULL);
+    Py_XDECREF(closed);
+  }
+  Py_DECREF(globals);
+
+  csvout.close();
+  std::remove(csvname.c_str());
+  m_data->Stores.erase("PythonScriptBenchmark");
+  delete benchstore;
+
+}
+
@@ -3,6 +3,9 @@
 
 #include <string>
 #include <iostream>
+#include <fstream>
+#include <chrono>
+#include <cstdio>
 #include <Python.h>
 #include <PythonAPI.h>
 
@@ -21,10 +24,14 @@ class PythonScript: public Tool {
 
  private:
 
+  void BenchmarkFeatureHandoff();
+
   std::string pythonscript;
   std::string initialisefunction;
   std::string executefunction;
   std::string finalisefunction;
+  int benchmarkfeatures;   // features per event for the hand-off benchmark, 0 to skip it
+  int benchmarkevents;
 
   PyObject *pName, *pModule, *pFuncI, *pFuncE, *pFuncF;
   PyObject *pArgs, *pValue;
@@ -0,0 +1,122 @@
+#include "RawDataIndexer.h"
+
+RawDataIndexer::RawDataIndexer():Tool(){}
+
+
+bool RawDataIndexer::Initialise(std::string configfile, DataModel &data){
+
+  /////////////////// Useful header ///////////////////////
+  if(configfile!="") m_variables.Initialise(configfile); // loading config file
+  //m_variables.Print();
+
+  m_data= &data; //assigning transient data pointer
+  /////////////////////////////////////////////////////////////////
+
+  verbosity = 0;
+  m_variables.Get("verbosity",verbosity);
+
+  //The decoded data is taken from the CStore each loop, as the ANNIEEventBuilder does.
+  //LoadRawData (RawDecodePipeline) and the MRDDataDecoder (MRDEventQueue) set their
+  //shared objects as intptr_t addresses; the pipeline is only set when pipelined.
+  intptr_t DecodePipelinePtr = 0;
+  m_data->CStore.Get("RawDecodePipeline",DecodePipelinePtr);
+  if(DecodePipelinePtr){
+    Log("RawDataIndexer Tool: ERROR the index can only be built with LoadRawData DecodeMode Sequential",v_error,verbosity);
+    return false;
+  }
+  intptr_t DecodedMRDEventsPtr = 0;
+  m_data->CStore.Get("MRDEventQueue",DecodedMRDEventsPtr);
+  DecodedMRDEvents = reinterpret_cast<MRDEventQueue*>(DecodedMRDEventsPtr);
+
+  Index.Clear();
+  return true;
+}
+
+
+bool RawDataIndexer::Execute(){
+
+  std::string RawFile;
+  if(!m_data->CStore.Get("RawDataFileName",RawFile)) return true;
+  if(RawFile != CurrentFile){
+    if(CurrentFile != "") this->WriteIndex();
+    Index.Clear();
+    CurrentFile = RawFile;
+    LastTankEntry = -1;
+    LastMRDEntry = -1;
+    LastTrigEntry = -1;
+  }
+
+  //PMT data: trigger times of the waves finished by the entry, the entry holding the
+  //start of the oldest of them, and the SequenceIDs of the entry's CardData
+  int Entry;
+  if(this->NewStreamEntry("TankEntryNum",LastTankEntry,Entry)){
+    RawTimeIndexEntry& Record = Index.Entry(RawTimeIndex::Tank,Entry);
+    m_data->CStore.Get("TankEntryLookBack",Record.lookback_entry);
+    if(m_data->CStore.Get("CardData",Cdata)){
+      for(unsigned int i=0; i<Cdata->size(); i++){
+        int SequenceID = Cdata->at(i).SequenceID;
+        if(Record.min_sequence_id < 0 || SequenceID < Record.min_sequence_id) Record.min_sequence_id = SequenceID;
+        if(SequenceID > Record.max_sequence_id) Record.max_sequence_id = SequenceID;
+      }
+    }
+    if(m_data->CStore.Get("InProgressTankEvents",InProgressTankEvents) && InProgressTankEvents && InProgressTankEvents->size()>0){
+      Record.first_ns = InProgressTankEvents->begin()->first;
+      Record.last_ns = InProgressTankEvents->rbegin()->first;
+      InProgressTankEvents->clear();
+    }
+  }
+
+  //MRD data: one trigger per entry
+  if(this->NewStreamEntry("MRDEntryNum",LastMRDEntry,Entry)){
+    RawTimeIndexEntry& Record = Index.Entry(RawTimeIndex::MRD,Entry);
+    Record.lookback_entry = Entry;
+    while(DecodedMRDEvents && !DecodedMRDEvents->empty()){
+      uint64_t Timestamp = DecodedMRDEvents->front().Timestamp;
+      if(Record.last_ns == 0 || Timestamp < Record.first_ns) Record.first_ns = Timestamp;
+      if(Timestamp > Record.last_ns) Record.last_ns = Timestamp;
+      DecodedMRDEvents->pop_front();
+    }
+  }
+
+  //Trigger data: the CTC timestamps decoded from the entry
+  if(this->NewStreamEntry("TrigEntryNum",LastTrigEntry,Entry)){
+    RawTimeIndexEntry& Record = Index.Entry(RawTimeIndex::CTC,Entry);
+    Record.lookback_entry = Entry;
+    if(m_data->CStore.Get("TimeToTriggerWordMap",TimeToTriggerWordMap) && TimeToTriggerWordMap && TimeToTriggerWordMap->size()>0){
+      Record.first_ns = TimeToTriggerWordMap->begin()->first;
+      Record.last_ns = TimeToTriggerWordMap->rbegin()->first;
+      TimeToTriggerWordMap->clear();
+    }
+  }
+
+  return true;
+}
+
+
+bool RawDataIndexer::Finalise(){
+  if(CurrentFile != "") this->WriteIndex();
+  Log("RawDataIndexer Tool: Wrote the timestamp index of "+to_string(FilesIndexed)+" raw data files",v_message,verbosity);
+  return true;
+}
+
+bool RawDataIndexer::NewStreamEntry(std::string EntryKey, int& LastEntry, int& Entry){
+  //LoadRawData sets the number of each entry it loads, and -1 when it opens a file;
+  //the number only goes up when a new entry of the stream was loaded (and decoded)
+  //this loop, so the last entry of the previous file is not indexed again
+  Entry = -1;
+  if(!m_data->CStore.Get(EntryKey,Entry) || Entry <= LastEntry) return false;
+  LastEntry = Entry;
+  return true;
+}
+
+void RawDataIndexer::WriteIndex(){
+  std::string IndexFile = RawTimeIndex::SidecarName(CurrentFile);
+  if(!Index.Write(IndexFile)){
+    Log("RawDataIndexer Tool: ERROR could not write "+IndexFile,v_error,verbosity);
+    return;
+  }
+  Log("RawDataIndexer Tool: Wrote "+IndexFile+" ("+to_string(Index.Entries(RawTimeIndex::Tank).size())+" PMT, "+
+      to_string(Index.Entries(RawTimeIndex::MRD).size())+" MRD, "+to_string(Index.Entries(RawTimeIndex::CTC).size())+
+      " trigger entries)",v_message,verbosity);
+  FilesIndexed++;
+}
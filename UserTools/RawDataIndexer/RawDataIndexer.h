@@ -0,0 +1,61 @@
+#ifndef RawDataIndexer_H
+#define RawDataIndexer_H
+
+#include <string>
+#include <iostream>
+#include <map>
+#include <vector>
+
+#include "Tool.h"
+#include "CardData.h"
+#include "MRDEventQueue.h"
+#include "RawDecodePipeline.h"
+#include "RawTimeIndex.h"
+
+/**
+ * \class RawDataIndexer
+ *
+ * Writes the timestamp index (RawTimeIndex) of each raw data file processed by
+ * LoadRawData and the PMT, MRD and Trigger data decoders.  It takes the place of the
+ * ANNIEEventBuilder in the ToolChain: each loop it records the timestamps decoded
+ * from the entries loaded in that loop, then drops the decoded data.  The index is
+ * written next to the raw file as <raw file>.tidx and lets LoadRawData load only
+ * the entries of a time window (TimeWindowStart/TimeWindowEnd).
+ */
+class RawDataIndexer: public Tool {
+
+
+ public:
+
+  RawDataIndexer(); ///< Simple constructor
+  bool Initialise(std::string configfile,DataModel &data); ///< Initialise Function for setting up Tool resources. @param configfile The path and name of the dynamic configuration file to read in. @param data A reference to the transient data class used to pass information between Tools.
+  bool Execute(); ///< Execute function used to perform Tool purpose.
+  bool Finalise(); ///< Finalise function used to clean up resources.
+
+ private:
+
+  bool NewStreamEntry(std::string EntryKey, int& LastEntry, int& Entry); ///< Check whether a stream's entry was loaded this loop
+  void WriteIndex(); ///< Write the index of the current raw file next to it
+
+  std::string CurrentFile = "";
+  RawTimeIndex Index;
+  int LastTankEntry = -1;
+  int LastMRDEntry = -1;
+  int LastTrigEntry = -1;
+  int FilesIndexed = 0;
+
+  std::vector<CardData>* Cdata = nullptr;
+  std::map<uint64_t, std::map<std::vector<int>, std::vector<uint16_t> > >* InProgressTankEvents = nullptr;
+  std::map<uint64_t,uint32_t>* TimeToTriggerWordMap = nullptr;
+  MRDEventQueue* DecodedMRDEvents = nullptr;
+
+  int verbosity;
+  int v_error=0;
+  int v_warning=1;
+  int v_message=2;
+  int v_debug=3;
+
+};
+
+
+#endif
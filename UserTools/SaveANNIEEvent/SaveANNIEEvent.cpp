@@ -1,5 +1,7 @@
 #include "SaveANNIEEvent.h"
 
+#include <sstream>
+
 SaveANNIEEvent::SaveANNIEEvent():Tool(){}
 
 
@@ -13,12 +15,37 @@ bool SaveANNIEEvent::Initialise(std::string configfile, DataModel &data){
   /////////////////////////////////////////////////////////////////
 
   m_variables.Get("path", path);
+
+  // Bulky keys (e.g. RawADCData,RawADCAuxData) are written one block per key to
+  // <path>.blocks, so LoadANNIEEvent only reads them when they are needed
+  std::string keys;
+  m_variables.Get("BlockKeys", keys);
+  std::stringstream key_stream(keys);
+  std::string key;
+  while(std::getline(key_stream, key, ',')){
+    if(key=="") continue;
+    if(!ANNIEEventBlockCodec::find(key)){
+      std::cout<<"SaveANNIEEvent: "<<key<<" has no registered block type, it stays in the ANNIEEvent store"<<std::endl;
+      continue;
+    }
+    block_keys.push_back(key);
+  }
+  if(block_keys.size()>0 && !block_writer.Open(ANNIEEventBlockFile::BlockFileName(path))){
+    std::cout<<"SaveANNIEEvent: could not open "<<ANNIEEventBlockFile::BlockFileName(path)<<std::endl;
+    return false;
+  }
+
   return true;
 }
 
 
 bool SaveANNIEEvent::Execute(){
 
+  if(block_keys.size()>0 && block_writer.AddEntry(*m_data->Stores["ANNIEEvent"], block_keys, true)<0){
+    std::cout<<"SaveANNIEEvent: error writing "<<ANNIEEventBlockFile::BlockFileName(path)<<std::endl;
+    return false;
+  }
+
   m_data->Stores["ANNIEEvent"]->Save(path);
   m_data->Stores["ANNIEEvent"]->Delete();
 
@@ -30,6 +57,9 @@ bool SaveANNIEEvent::Finalise(){
 
 
   m_data->Stores["ANNIEEvent"]->Close();
+  if(block_keys.size()>0 && !block_writer.Close()){
+    std::cout<<"SaveANNIEEvent: error closing "<<ANNIEEventBlockFile::BlockFileName(path)<<std::endl;
+  }
 
   return true;
 }
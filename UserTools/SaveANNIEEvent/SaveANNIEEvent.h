@@ -3,8 +3,10 @@
 
 #include <string>
 #include <iostream>
+#include <vector>
 
 #include "Tool.h"
+#include "ANNIEEventBlockFile.h"
 
 class SaveANNIEEvent: public Tool {
 
@@ -19,6 +21,8 @@ class SaveANNIEEvent: public Tool {
 
  private:
   std::string path;
+  std::vector<std::string> block_keys; ///< keys written to the block file <path>.blocks instead of the store
+  ANNIEEventBlockFileWriter block_writer;
 
 
 
@@ -10,6 +10,7 @@ bool TriggerDataDecoder::Initialise(std::string configfile, DataModel &data){
   //m_variables.Print();
 
   m_data= &data; //assigning transient data pointer
+  DecoderLog.SetToolChainThread();
   /////////////////////////////////////////////////////////////////
   verbosity = 0;
   TriggerMaskFile = "none";
@@ -42,14 +43,29 @@ bool TriggerDataDecoder::Initialise(std::string configfile, DataModel &data){
     m_data->CStore.Set("TriggerWordMap",TriggerWords);
   }
 
+  //Pipelined decoding (LoadRawData DecodeMode Pipelined): entries are decoded in a
+  //worker thread, and the trigger words go to the event builder through the pipeline
+  intptr_t DecodePipelinePtr = 0;
+  if (mode == "EventBuilding") m_data->CStore.Get("RawDecodePipeline",DecodePipelinePtr);
+  DecodePipeline = RawDecodePipeline::FromCStore(DecodePipelinePtr);
+  if (DecodePipeline){
+    DecodePipeline->Retain();
+    DecodePipeline->Attach(RawDecodePipeline::CTC);
+    DecodeStats = PipelineStageStats();
+    DecodeThread = std::thread(&TriggerDataDecoder::DecodeLoop,this);
+    Log("TriggerDataDecoder Tool: Decoding trigger entries in a worker thread",v_message,verbosity);
+  }
+
   return true;
 }
 
 
 bool TriggerDataDecoder::Execute(){
+  FlushWorkerLog();
 
   if (mode == "EventBuilding"){
     m_data->CStore.Set("NewCTCDataAvailable",false);
+    if (DecodePipeline) return true;  //entries are decoded by DecodeLoop
     bool PauseCTCDecoding = false;
     m_data->CStore.Get("PauseCTCDecoding",PauseCTCDecoding);
     if (PauseCTCDecoding){
@@ -66,32 +82,10 @@ bool TriggerDataDecoder::Execute(){
       if(verbosity>0) std::cout << "TriggerDataDecoder error: No TriggerData in CStore!" << std::endl;
       return false;
     }
-    bool new_ts_available = false;
-    std::vector<uint32_t> aTimeStampData = Tdata->TimeStampData;
-    for(int i = 0; i < (int) aTimeStampData.size(); i++){
-      if(verbosity>v_debug) std::cout<<"TriggerDataDecoder Tool: Loading next TrigData from entry's index " << i <<std::endl;
-      new_ts_available = this->AddWord(aTimeStampData.at(i));
-      if(new_ts_available){
-        if(verbosity>4){
-          std::cout << "PARSED TRIGGER TIME: " << processed_ns.back() << std::endl;
-          std::cout << "PARSED TRIGGER WORD: " << processed_sources.back() << std::endl;
-        }
-        if(UseTrigMask){
-          uint32_t recent_trigger_word = processed_sources.back();
-          for(int j = 0; j<(int) TriggerMask.size(); j++){
-            if(TriggerMask.at(j) == recent_trigger_word){
-              m_data->CStore.Set("NewCTCDataAvailable",true);
-              if(verbosity>4) std::cout << "TRIGGER WORD BEING ADDED TO TRIGWORDMAP" << std::endl;
-              TimeToTriggerWordMap->emplace(processed_ns.back(),processed_sources.back());
-            }
-          }
-        } else {
-          m_data->CStore.Set("NewCTCDataAvailable",true);
-          if(verbosity>4) std::cout << "TRIGGER WORD BEING ADDED TO TRIGWORDMAP" << std::endl;
-          TimeToTriggerWordMap->emplace(processed_ns.back(),processed_sources.back());
-        }
-      }
-    }
+    std::vector<std::pair<uint64_t,uint32_t> > NewTriggers;
+    this->DecodeTriggerWords(Tdata->TimeStampData, NewTriggers);
+    if(!NewTriggers.empty()) m_data->CStore.Set("NewCTCDataAvailable",true);
+    for(const auto& atrigger : NewTriggers) TimeToTriggerWordMap->emplace(atrigger.first,atrigger.second);
   } 
   else if (mode == "Monitoring"){
     TimeToTriggerWordMap->clear();
@@ -99,34 +93,12 @@ bool TriggerDataDecoder::Execute(){
     processed_ns.clear();
     std::map<int,TriggerData> TrigData_Map;
     m_data->Stores["TrigData"]->Get("TrigDataMap",TrigData_Map);
-    bool new_ts_available = false;
+    std::vector<std::pair<uint64_t,uint32_t> > NewTriggers;
     for (int i_entry=0; i_entry < int(TrigData_Map.size()); i_entry++){
-      TriggerData TData = TrigData_Map.at(i_entry);
-      std::vector<uint32_t> aTimeStampData = TData.TimeStampData;
-      for (int i=0; i < (int) aTimeStampData.size(); i++){
-        new_ts_available = this->AddWord(aTimeStampData.at(i));
-        if (new_ts_available){
-          if(verbosity>4){
-            std::cout << "PARSED TRIGGER TIME: " << processed_ns.back() << std::endl;
-            std::cout << "PARSED TRIGGER WORD: " << processed_sources.back() << std::endl;
-          }
-          if(UseTrigMask){
-            uint32_t recent_trigger_word = processed_sources.back();
-            for(int j = 0; j<(int) TriggerMask.size(); j++){
-              if(TriggerMask.at(j) == recent_trigger_word){
-                m_data->CStore.Set("NewCTCDataAvailable",true);
-                if(verbosity>4) std::cout << "TRIGGER WORD BEING ADDED TO TRIGWORDMAP" << std::endl;
-                TimeToTriggerWordMap->emplace(processed_ns.back(),processed_sources.back());
-              }
-            }
-          } else {
-            m_data->CStore.Set("NewCTCDataAvailable",true);
-            if(verbosity>4) std::cout << "TRIGGER WORD BEING ADDED TO TRIGWORDMAP" << std::endl;
-            TimeToTriggerWordMap->emplace(processed_ns.back(),processed_sources.back());
-          }
-        }     
-      }
+      this->DecodeTriggerWords(TrigData_Map.at(i_entry).TimeStampData, NewTriggers);
     }
+    if(!NewTriggers.empty()) m_data->CStore.Set("NewCTCDataAvailable",true);
+    for(const auto& atrigger : NewTriggers) TimeToTriggerWordMap->emplace(atrigger.first,atrigger.second);
   }
 
   if(verbosity>3) Log("TriggerDataDecoder Tool: size of TimeToTriggerWordMap: "+to_string(TimeToTriggerWordMap->size()),v_message,verbosity); 
@@ -138,11 +110,29 @@ bool TriggerDataDecoder::Execute(){
 
 
 bool TriggerDataDecoder::Finalise(){
+  if (DecodePipeline){
+    DecodePipeline->Shutdown(RawDecodePipeline::CTC);
+    if (DecodeThread.joinable()) DecodeThread.join();
+    FlushWorkerLog();
+    Log("TriggerDataDecoder Tool: Pipelined decoding: "+DecodeStats.Summary(),v_warning,verbosity);
+    Log("TriggerDataDecoder Tool: Pipelined decoding: "+DecodePipeline->QueueSummary(RawDecodePipeline::CTC),v_warning,verbosity);
+    RawDecodePipeline::Release(DecodePipeline);
+  }
   //delete TimeToTriggerWordMap;	//DONT delete TimeToTriggerWordMap since it wil be deleted by the CStore automatically
   std::cout << "TriggerDataDecoder tool exitting" << std::endl;
   return true;
 }
 
+void TriggerDataDecoder::Log(const std::string& message, int messagelevel, int verb){
+  //The ToolChain's logger is not thread-safe; worker threads buffer their messages
+  if (DecoderLog.OnToolChainThread()) Tool::Log(message,messagelevel,verb);
+  else DecoderLog.Add(message,messagelevel,verb);
+}
+
+void TriggerDataDecoder::FlushWorkerLog(){
+  for (const WorkerLogMessage& message : DecoderLog.Take()) Tool::Log(message.Message,message.Level,verbosity);
+}
+
 bool TriggerDataDecoder::AddWord(uint32_t word){
   bool new_timestamp_available = false;
   uint64_t payload = 0;
@@ -209,6 +199,55 @@ void TriggerDataDecoder::CheckForRunChange()
   return;
 }
 
+void TriggerDataDecoder::DecodeTriggerWords(const std::vector<uint32_t>& aTimeStampData, std::vector<std::pair<uint64_t,uint32_t> >& Triggers)
+{
+  //Appends the (time, word) of every trigger passing the trigger mask
+  bool new_ts_available = false;
+  for(int i = 0; i < (int) aTimeStampData.size(); i++){
+    if(verbosity>v_debug) Log(LogLine() << "TriggerDataDecoder Tool: Loading next TrigData from entry's index " << i,vv_debug,verbosity);
+    new_ts_available = this->AddWord(aTimeStampData.at(i));
+    if(new_ts_available){
+      if(verbosity>4){
+        Log("PARSED TRIGGER TIME: "+to_string(processed_ns.back()),vv_debug+1,verbosity);
+        Log("PARSED TRIGGER WORD: "+to_string(processed_sources.back()),vv_debug+1,verbosity);
+      }
+      bool keep_trigger = !UseTrigMask;
+      for(int j = 0; j<(int) TriggerMask.size() && !keep_trigger; j++){
+        if(TriggerMask.at(j) == (int) processed_sources.back()) keep_trigger = true;
+      }
+      if(keep_trigger){
+        if(verbosity>4) Log("TRIGGER WORD BEING ADDED TO TRIGWORDMAP",vv_debug+1,verbosity);
+        Triggers.emplace_back(processed_ns.back(),processed_sources.back());
+      }
+    }
+  }
+}
+
+void TriggerDataDecoder::DecodeLoop()
+{
+  //Runs on the worker thread in pipelined mode: decodes the CTC entries read by
+  //LoadRawData and hands the trigger words of each entry to the ANNIEEventBuilder
+  int WorkerRunNum = -1;
+  int WorkerSubrunNum = -1;
+  RawCTCEntry entry;
+  while (DecodePipeline->PopInput(entry,DecodeStats)){
+    auto start = std::chrono::steady_clock::now();
+    DecodedCTCTriggers Decoded;
+    //A new run or subrun drops the trigger words still waiting to be built
+    if (WorkerRunNum != -1 && (entry.RunNumber != WorkerRunNum || entry.SubRunNumber != WorkerSubrunNum)){
+      Log("TriggerDataDecoder Tool: New run or subrun encountered.  Clearing event building maps",v_message,verbosity);
+      Decoded.NewRun = true;
+    }
+    WorkerRunNum = entry.RunNumber;
+    WorkerSubrunNum = entry.SubRunNumber;
+    this->DecodeTriggerWords(entry.Data.TimeStampData, Decoded.Triggers);
+    DecodeStats.Items++;
+    DecodeStats.BusySeconds += std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count();
+    if (!DecodePipeline->PushOutput(std::move(Decoded),DecodeStats)) break;
+  }
+  DecodePipeline->CloseOutput(RawDecodePipeline::CTC);
+}
+
 std::vector<int> TriggerDataDecoder::LoadTriggerMask(std::string triggermask_file){
   std::vector<int> trigger_mask;
   std::string fileline;
@@ -3,11 +3,15 @@
 
 #include <string>
 #include <iostream>
+#include <chrono>
+#include <thread>
 
 #include <boost/algorithm/string.hpp>
 
 #include "Tool.h"
 #include "TriggerData.h"
+#include "RawDecodePipeline.h"
+#include "WorkerLog.h"
 
 /**
  * \class TriggerDataDecoder
@@ -31,6 +35,10 @@ class TriggerDataDecoder: public Tool {
   std::vector<int> LoadTriggerMask(std::string triggermask_file);
   std::map<int,std::string> LoadTriggerWords(std::string triggerwords_file);
   void CheckForRunChange();
+  void DecodeTriggerWords(const std::vector<uint32_t>& aTimeStampData, std::vector<std::pair<uint64_t,uint32_t> >& Triggers);
+  void DecodeLoop();
+  void Log(const std::string& message, int messagelevel, int verb); ///< Tool::Log, buffered when called from the decoding thread
+  void FlushWorkerLog(); ///< Log the messages buffered by the decoding thread
  private:
 
   //std::vector<TriggerData> *Tdata = nullptr;
@@ -40,6 +48,12 @@ class TriggerDataDecoder: public Tool {
   std::string TriggerWordFile;
   std::string mode;
 
+  //Pipelined decoding (LoadRawData DecodeMode Pipelined)
+  RawDecodePipeline* DecodePipeline = nullptr;
+  std::thread DecodeThread;
+  PipelineStageStats DecodeStats;
+  WorkerLog DecoderLog;
+
   std::string TriggerMaskFile;
   std::vector<int> TriggerMask;
 
@@ -129,3 +129,4 @@
 #include "MonitorTrigger.h"
 #include "EventClassification.h"
 #include "DataSummary.h"
+#include "RawDataIndexer.h"
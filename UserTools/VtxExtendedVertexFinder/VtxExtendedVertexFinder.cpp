@@ -1,4 +1,5 @@
 #include "VtxExtendedVertexFinder.h"
+#include "TROOT.h"
 
 VtxExtendedVertexFinder::VtxExtendedVertexFinder():Tool(){}
 
@@ -22,6 +23,31 @@ bool VtxExtendedVertexFinder::Initialise(std::string configfile, DataModel &data
   m_variables.Get("verbosity", verbosity);
   m_variables.Get("FitTimeWindowMin", fTmin);
   m_variables.Get("FitTimeWindowMax", fTmax);
+  m_variables.Get("NumFitThreads", fNumFitThreads);
+  m_variables.Get("BenchmarkFoMKernels", fBenchmarkFoMKernels);
+  m_variables.Get("BenchmarkFoMTrials", fBenchmarkFoMTrials);
+  m_variables.Get("SeedSearch", fSeedSearch);
+  m_variables.Get("AdaptiveSeedsKept", fAdaptiveSeedsKept);
+  m_variables.Get("AdaptiveRefineDepth", fAdaptiveRefineDepth);
+  m_variables.Get("CompareAdaptiveToFullGrid", fCompareAdaptiveToFullGrid);
+  if(fSeedSearch!="Full" && fSeedSearch!="Adaptive"){
+    Log("VtxExtendedVertexFinder Tool: SeedSearch <"+fSeedSearch+"> not recognized. Fitting every grid seed",v_error,verbosity);
+    fSeedSearch = "Full";
+  }
+  if(fAdaptiveSeedsKept<1) fAdaptiveSeedsKept = 1;
+  if(fAdaptiveRefineDepth<0) fAdaptiveRefineDepth = 0;
+  if(fNumFitThreads==0) fNumFitThreads = std::thread::hardware_concurrency();
+  if(fNumFitThreads<1) fNumFitThreads = 1;
+  
+  if(fSeedGridFits && fNumFitThreads>1){
+    Log("VtxExtendedVertexFinder Tool: Fitting grid seeds on "+to_string(fNumFitThreads)+" threads",v_message,verbosity);
+    ROOT::EnableThreadSafety();
+    // Each worker gets its own residual workspace
+    for(int ithread=0; ithread<fNumFitThreads; ithread++) fThreadVtxGeo.push_back(new VertexGeometry());
+    // Singletons used while fitting are created lazily; do it here, before any worker runs
+    Parameters::Instance();
+    ANNIEGeometry::Instance();
+  }
   
   /// Create extended vertex
   /// Note that the objects created by "new" must be added to the "RecoEvent" store. 
@@ -74,6 +100,7 @@ bool VtxExtendedVertexFinder::Execute(){
   // Load digits to VertexGeometry
   myvtxgeo = VertexGeometry::Instance();
   myvtxgeo->LoadDigits(fDigitList);
+  if( fBenchmarkFoMKernels ) this->RunFoMKernelBenchmark();
   // Do extended vertex (muon track) reconstruction using MC truth information
   if( fUseTrueVertexAsSeed ){
   Log("VtxExtendedVertexFinder Tool: Run vertex reconstruction using MC truth information",v_message,verbosity);
@@ -110,7 +137,9 @@ bool VtxExtendedVertexFinder::Execute(){
       return false;
     }
     //Now, run FindGridSeeds.
-    fExtendedVertex = (RecoVertex*)(this->FitGridSeeds(vSeedVtxList));
+    if(fSeedSearch=="Adaptive") fExtendedVertex = (RecoVertex*)(this->FitAdaptiveSeeds(vSeedVtxList));
+    else if(fNumFitThreads>1) fExtendedVertex = (RecoVertex*)(this->FitGridSeedsParallel(vSeedVtxList));
+    else fExtendedVertex = (RecoVertex*)(this->FitGridSeeds(vSeedVtxList));
     // Push fitted vertex to RecoEvent store
     this->PushExtendedVertex(fExtendedVertex, true);
   }
@@ -136,6 +165,27 @@ bool VtxExtendedVertexFinder::Execute(){
 bool VtxExtendedVertexFinder::Finalise(){
   // memory has to be freed in the Finalise() function
   delete fExtendedVertex; fExtendedVertex = 0;
+  if(fSeedGridFits && fSeedSearch=="Adaptive" && fAdaptiveEvents>0){
+    logmessage = "VtxExtendedVertexFinder Tool: adaptive seed search saved " + to_string(fAdaptiveFitsSaved)
+               + " Minuit fits over " + to_string(fAdaptiveEvents) + " events ("
+               + to_string(double(fAdaptiveFitsSaved)/fAdaptiveEvents) + " per event)";
+    Log(logmessage,v_message,verbosity);
+    if(fAdaptiveCompared>0){
+      logmessage = "VtxExtendedVertexFinder Tool: adaptive vs full grid over " + to_string(fAdaptiveCompared)
+                 + " events: mean vertex shift " + to_string(fSumAdaptiveShift/fAdaptiveCompared)
+                 + " cm, mean direction change " + to_string(fSumAdaptiveAngle/fAdaptiveCompared)
+                 + " deg, mean FOM change " + to_string(fSumAdaptiveDeltaFOM/fAdaptiveCompared);
+      Log(logmessage,v_message,verbosity);
+    }
+    if(fAdaptiveTruthCompared>0){
+      logmessage = "VtxExtendedVertexFinder Tool: mean distance to the true vertex over " + to_string(fAdaptiveTruthCompared)
+                 + " events: adaptive " + to_string(fSumAdaptiveTruthError/fAdaptiveTruthCompared)
+                 + " cm, full grid " + to_string(fSumFullTruthError/fAdaptiveTruthCompared) + " cm";
+      Log(logmessage,v_message,verbosity);
+    }
+  }
+  for(auto&& vtxgeo : fThreadVtxGeo) delete vtxgeo;
+  fThreadVtxGeo.clear();
   if(verbosity>0) cout<<"VtxExtendedVertexFinder exitting"<<endl;
   return true;
 }
@@ -206,6 +256,248 @@ RecoVertex* VtxExtendedVertexFinder::FitGridSeeds(std::vector<RecoVertex>* vSeed
   return bestGridVertex;
 }
 
+RecoVertex* VtxExtendedVertexFinder::FitGridSeedsParallel(std::vector<RecoVertex>* vSeedVtxList) {
+  double vtxFOM = -9999.;
+  double bestFOM = -1.0;
+  int vtxRecoStatus = -1;
+  unsigned int nlast = vSeedVtxList->size();
+  RecoVertex* bestGridVertex = new RecoVertex(); // FIXME: pointer must be deleted by the invoker
+  
+  // Fit every seed; each worker keeps its fitted vertices in the slot of its seed
+  std::vector<RecoVertex> vFittedVtxList(nlast);
+  std::atomic<unsigned int> nextSeed(0);
+  int nthreads = std::min(fNumFitThreads, (int)nlast);
+  std::vector<std::thread> workers;
+  for(int ithread=1; ithread<nthreads; ithread++){
+    workers.push_back(std::thread(&VtxExtendedVertexFinder::FitSeedsOnThread, this, ithread, 
+                                  vSeedVtxList, &nextSeed, &vFittedVtxList));
+  }
+  this->FitSeedsOnThread(0, vSeedVtxList, &nextSeed, &vFittedVtxList);
+  for(auto&& worker : workers) worker.join();
+  
+  // Reduce in seed order, so the chosen vertex is the same as in FitGridSeeds
+  for( unsigned int n=0; n<nlast; n++ ){
+    vtxFOM = vFittedVtxList.at(n).GetFOM();
+    vtxRecoStatus = vFittedVtxList.at(n).GetStatus();
+    if((vtxFOM>bestFOM) && (vtxRecoStatus==0)){
+      bestGridVertex->CloneVertex(&(vFittedVtxList.at(n)));
+      bestFOM = vtxFOM;
+    }
+  }
+  if (verbosity>4){
+    std::cout << "Best fit vertex information: " << std::endl;
+    std::cout << "bestFOM: " << bestFOM << std::endl;
+    std::cout << "best fit reco status: " << bestGridVertex->GetStatus() << std::endl;
+    std::cout << "BestVertex info: " << bestGridVertex->Print() << std::endl;
+  }
+  return bestGridVertex;
+}
+
+void VtxExtendedVertexFinder::FitSeedsOnThread(int ithread, std::vector<RecoVertex>* vSeedVtxList,
+                                               std::atomic<unsigned int>* nextSeed, std::vector<RecoVertex>* vFittedVtxList) {
+  VertexGeometry* threadvtxgeo = fThreadVtxGeo.at(ithread);
+  threadvtxgeo->LoadDigits(fDigitList);
+  for( unsigned int n=(*nextSeed)++; n<vSeedVtxList->size(); n=(*nextSeed)++ ){
+    MinuitOptimizer* myOptimizer = new MinuitOptimizer();
+    myOptimizer->SetPrintLevel(0);
+    myOptimizer->SetMeanTimeCalculatorType(1);
+    myOptimizer->LoadVertexGeometry(threadvtxgeo); //Load this thread's vertex geometry
+    myOptimizer->SetFitterTimeRange(fTmin, fTmax); //Set time range to fit over 
+    RecoVertex* simpleVertex = this->FindSimpleDirection(&(vSeedVtxList->at(n)));
+    myOptimizer->LoadVertex(simpleVertex); //Load vertex seed
+    myOptimizer->FitExtendedVertexWithMinuit(); //scan the point position in 4D space
+    vFittedVtxList->at(n).CloneVertex(myOptimizer->GetFittedVertex());
+    delete simpleVertex;
+    delete myOptimizer; myOptimizer = 0;
+  }
+}
+
+void VtxExtendedVertexFinder::RunFoMKernelBenchmark() {
+  int ndigits = myvtxgeo->GetNDigits();
+  if( ndigits<=0 || fBenchmarkFoMTrials<=0 ) return;
+  
+  FoMCalculator legacyfom;
+  FoMCalculator fastfom;
+  legacyfom.LoadVertexGeometry(myvtxgeo);
+  fastfom.LoadVertexGeometry(myvtxgeo);
+  legacyfom.SetUseFastKernels(false);
+  fastfom.SetUseFastKernels(true);
+  
+  // deterministic trial vertices spread over +-100 cm around the tank centre
+  std::vector<double> tx, ty, tz, dx, dy, dz;
+  for(int itrial=0; itrial<fBenchmarkFoMTrials; itrial++){
+    tx.push_back(100.0*sin(0.7*itrial));
+    ty.push_back(100.0*sin(1.3*itrial+0.5));
+    tz.push_back(100.0*sin(2.1*itrial+1.0));
+    double costh = cos(0.9*itrial);
+    double sinth = sqrt(1.0-costh*costh);
+    double phi = 2.3*itrial;
+    dx.push_back(sinth*cos(phi));
+    dy.push_back(sinth*sin(phi));
+    dz.push_back(costh);
+  }
+  double coneAngle = Parameters::CherenkovAngle();
+  double vtxTime = 0.0;
+  
+  std::string modes[3] = {"PointPosition","PointVertex","ExtendedVertex"};
+  for(int imode=0; imode<3; imode++){
+    std::vector<double> foms[2];
+    double nsperdigit[2];
+    for(int ifast=0; ifast<2; ifast++){
+      FoMCalculator* fom = (ifast==1) ? &fastfom : &legacyfom;
+      foms[ifast].resize(fBenchmarkFoMTrials);
+      auto start = std::chrono::steady_clock::now();
+      for(int itrial=0; itrial<fBenchmarkFoMTrials; itrial++){
+        double thisfom = -9999.;
+        if(imode==0) fom->PointPositionChi2(tx[itrial],ty[itrial],tz[itrial],vtxTime,thisfom);
+        else if(imode==1) fom->PointVertexChi2(tx[itrial],ty[itrial],tz[itrial],dx[itrial],dy[itrial],dz[itrial],coneAngle,vtxTime,thisfom);
+        else fom->ExtendedVertexChi2(tx[itrial],ty[itrial],tz[itrial],dx[itrial],dy[itrial],dz[itrial],coneAngle,vtxTime,thisfom);
+        foms[ifast][itrial] = thisfom;
+      }
+      auto stop = std::chrono::steady_clock::now();
+      double elapsed = std::chrono::duration<double,std::nano>(stop-start).count();
+      nsperdigit[ifast] = elapsed/(double(fBenchmarkFoMTrials)*ndigits);
+    }
+    double maxdiff = 0.0;
+    for(int itrial=0; itrial<fBenchmarkFoMTrials; itrial++){
+      maxdiff = std::max(maxdiff, fabs(foms[1][itrial]-foms[0][itrial]));
+    }
+    logmessage = "VtxExtendedVertexFinder Tool: FoM benchmark " + modes[imode] + " (" + to_string(ndigits) + " digits, "
+               + to_string(fBenchmarkFoMTrials) + " evaluations): legacy " + to_string(nsperdigit[0])
+               + " ns/digit/eval, fast " + to_string(nsperdigit[1]) + " ns/digit/eval, max |dFOM| = " + to_string(maxdiff);
+    Log(logmessage,v_message,verbosity);
+  }
+}
+
+RecoVertex* VtxExtendedVertexFinder::FitAdaptiveSeeds(std::vector<RecoVertex>* vSeedVtxList) {
+  int nseeds = vSeedVtxList->size();
+  int nkeep = std::min(fAdaptiveSeedsKept, nseeds);
+  
+  FoMCalculator fom;
+  fom.LoadVertexGeometry(myvtxgeo);
+  
+  // candidate positions with their cheap FOM; grid seeds keep their own seed time
+  struct SeedCandidate { double x, y, z, t, score, spacing; };
+  std::vector<SeedCandidate> candidates;
+  for(int n=0; n<nseeds; n++){
+    Position pos = vSeedVtxList->at(n).GetPosition();
+    double vtxTime = 0.;
+    double score = this->ScoreSeedPosition(&fom, pos.X(), pos.Y(), pos.Z(), vtxTime);
+    candidates.push_back({pos.X(), pos.Y(), pos.Z(), vSeedVtxList->at(n).GetTime(), score, 0.});
+  }
+  // stable, so equal scores keep seed order
+  auto byscore = [](const SeedCandidate& a, const SeedCandidate& b){ return a.score > b.score; };
+  std::stable_sort(candidates.begin(), candidates.end(), byscore);
+  candidates.resize(nkeep);
+  
+  // local grid spacing: distance to the nearest other grid seed
+  for(auto&& cand : candidates){
+    double mindistsq = -1.;
+    for(int n=0; n<nseeds; n++){
+      Position pos = vSeedVtxList->at(n).GetPosition();
+      double dx = pos.X()-cand.x, dy = pos.Y()-cand.y, dz = pos.Z()-cand.z;
+      double distsq = dx*dx+dy*dy+dz*dz;
+      if(distsq>0. && (mindistsq<0. || distsq<mindistsq)) mindistsq = distsq;
+    }
+    cand.spacing = (mindistsq>0.) ? sqrt(mindistsq) : 0.;
+  }
+  
+  // refine: score the 26 neighbours of each candidate on a grid half as coarse
+  // as the previous level and keep the best nkeep of old and new points
+  for(int ilevel=1; ilevel<=fAdaptiveRefineDepth; ilevel++){
+    std::vector<SeedCandidate> refined = candidates;
+    for(auto&& cand : candidates){
+      double step = cand.spacing/pow(2.0,ilevel);
+      if(step<=0.) continue;
+      for(int ix=-1; ix<=1; ix++){
+        for(int iy=-1; iy<=1; iy++){
+          for(int iz=-1; iz<=1; iz++){
+            if(ix==0 && iy==0 && iz==0) continue;
+            double x = cand.x+ix*step, y = cand.y+iy*step, z = cand.z+iz*step;
+            if(!ANNIEGeometry::Instance()->InsideDetector(x,y,z)) continue;
+            double vtxTime = 0.;
+            double score = this->ScoreSeedPosition(&fom, x, y, z, vtxTime);
+            refined.push_back({x, y, z, vtxTime, score, cand.spacing});
+          }
+        }
+      }
+    }
+    std::stable_sort(refined.begin(), refined.end(), byscore);
+    refined.resize(nkeep);
+    candidates.swap(refined);
+  }
+  
+  // Minuit only on the survivors
+  std::vector<RecoVertex> survivors(candidates.size());
+  for(unsigned int n=0; n<candidates.size(); n++){
+    survivors.at(n).SetVertex(candidates.at(n).x, candidates.at(n).y, candidates.at(n).z, candidates.at(n).t);
+  }
+  RecoVertex* bestVertex = 0;
+  if(fNumFitThreads>1) bestVertex = this->FitGridSeedsParallel(&survivors);
+  else bestVertex = this->FitGridSeeds(&survivors);
+  
+  fAdaptiveEvents++;
+  fAdaptiveFitsSaved += nseeds - (int)survivors.size();
+  logmessage = "VtxExtendedVertexFinder Tool: adaptive seed search fitted " + to_string(survivors.size())
+             + " of " + to_string(nseeds) + " grid seeds";
+  Log(logmessage,v_debug,verbosity);
+  
+  if(fCompareAdaptiveToFullGrid) this->CompareAdaptiveToFullGrid(bestVertex, vSeedVtxList);
+  return bestVertex;
+}
+
+double VtxExtendedVertexFinder::ScoreSeedPosition(FoMCalculator* fom, double vtxX, double vtxY, double vtxZ, double& vtxTime) {
+  myvtxgeo->CalcPointDeltas(vtxX, vtxY, vtxZ, 0.0);
+  const double* delta = myvtxgeo->GetDeltaArray();
+  const double* sigma = myvtxgeo->GetDeltaSigmaArray();
+  const bool* filtered = myvtxgeo->GetIsFilteredArray();
+  double Swx = 0.0;
+  double Sw = 0.0;
+  for(int idigit=0; idigit<myvtxgeo->GetNDigits(); idigit++){
+    if(!filtered[idigit]) continue;
+    double weight = 1.0/(sigma[idigit]*sigma[idigit]);
+    Swx += weight*delta[idigit];
+    Sw += weight;
+  }
+  vtxTime = (Sw>0.0) ? Swx/Sw : 0.0;
+  double score = -9999.;
+  fom->TimePropertiesLnL(vtxTime, score);
+  return score;
+}
+
+void VtxExtendedVertexFinder::CompareAdaptiveToFullGrid(RecoVertex* adaptiveVertex, std::vector<RecoVertex>* vSeedVtxList) {
+  RecoVertex* fullVertex = 0;
+  if(fNumFitThreads>1) fullVertex = this->FitGridSeedsParallel(vSeedVtxList);
+  else fullVertex = this->FitGridSeeds(vSeedVtxList);
+  
+  Position adaptivepos = adaptiveVertex->GetPosition();
+  Position fullpos = fullVertex->GetPosition();
+  Direction adaptivedir = adaptiveVertex->GetDirection();
+  Direction fulldir = fullVertex->GetDirection();
+  double shift = (adaptivepos - fullpos).Mag();
+  double cosangle = adaptivedir.X()*fulldir.X() + adaptivedir.Y()*fulldir.Y() + adaptivedir.Z()*fulldir.Z();
+  cosangle = std::max(-1.0, std::min(1.0, cosangle));
+  double angle = acos(cosangle)*180.0/TMath::Pi();
+  double deltafom = adaptiveVertex->GetFOM() - fullVertex->GetFOM();
+  fAdaptiveCompared++;
+  fSumAdaptiveShift += shift;
+  fSumAdaptiveAngle += angle;
+  fSumAdaptiveDeltaFOM += deltafom;
+  logmessage = "VtxExtendedVertexFinder Tool: adaptive - full grid: vertex shift " + to_string(shift)
+             + " cm, direction change " + to_string(angle) + " deg, FOM change " + to_string(deltafom);
+  Log(logmessage,v_message,verbosity);
+  
+  // with MC truth, compare each method's distance to the true vertex
+  RecoVertex* trueVertex = 0;
+  if(m_data->Stores.at("RecoEvent")->Get("TrueVertex", trueVertex) && trueVertex){
+    Position truepos = trueVertex->GetPosition();
+    fAdaptiveTruthCompared++;
+    fSumAdaptiveTruthError += (adaptivepos - truepos).Mag();
+    fSumFullTruthError += (fullpos - truepos).Mag();
+  }
+  delete fullVertex;
+}
+
 RecoVertex* VtxExtendedVertexFinder::FindSimpleDirection(RecoVertex* myVertex) {
 	
   /// get vertex position
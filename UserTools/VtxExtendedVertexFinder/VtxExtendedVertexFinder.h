@@ -3,11 +3,16 @@
 
 #include <string>
 #include <iostream>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <chrono>
 
 #include "Tool.h"
 #include <VertexGeometry.h>
 #include <TMinuit.h>
 #include <MinuitOptimizer.h>
+#include <FoMCalculator.h>
 
 class VtxExtendedVertexFinder: public Tool {
 
@@ -42,6 +47,27 @@ class VtxExtendedVertexFinder: public Tool {
   /// \brief Run ExtendedVertex with every grid seed
   RecoVertex* FitGridSeeds(std::vector<RecoVertex>* vSeedVtxList);
   
+  /// \brief Fit grid seeds on fNumFitThreads worker threads and keep the best FOM
+  RecoVertex* FitGridSeedsParallel(std::vector<RecoVertex>* vSeedVtxList);
+  
+  /// \brief Worker for FitGridSeedsParallel: fits seeds taken from nextSeed until none are left
+  void FitSeedsOnThread(int ithread, std::vector<RecoVertex>* vSeedVtxList, 
+                        std::atomic<unsigned int>* nextSeed, std::vector<RecoVertex>* vFittedVtxList);
+  
+  /// \brief Time the fast and legacy FoM evaluations on the loaded digits and compare them
+  void RunFoMKernelBenchmark();
+  
+  /// \brief Adaptive seed search: rank the grid seeds with a cheap time-residual FOM,
+  /// refine the best fAdaptiveSeedsKept on finer local grids and fit only those
+  RecoVertex* FitAdaptiveSeeds(std::vector<RecoVertex>* vSeedVtxList);
+  
+  /// \brief Time-residual FOM of a point vertex, with the vertex time taken as the
+  /// resolution-weighted mean of the filtered digits' residuals
+  double ScoreSeedPosition(FoMCalculator* fom, double vtxX, double vtxY, double vtxZ, double& vtxTime);
+  
+  /// \brief Fit the adaptive survivors and the full grid, and record how far apart they are
+  void CompareAdaptiveToFullGrid(RecoVertex* adaptiveVertex, std::vector<RecoVertex>* vSeedVtxList);
+  
   /// \brief Find a simple direction using weighted sum of digit charges 
   RecoVertex* FindSimpleDirection(RecoVertex* myvertex);
   
@@ -63,6 +89,34 @@ class VtxExtendedVertexFinder: public Tool {
   /// Vertex Geometry shared by Fitter tools
   VertexGeometry* myvtxgeo;
   
+  /// Number of threads used to fit the grid seeds (FitAllOnGridSeed mode)
+  int fNumFitThreads = 1;
+  
+  /// Per-thread residual workspaces used when fNumFitThreads > 1
+  std::vector<VertexGeometry*> fThreadVtxGeo;
+  
+  /// Benchmark the FoM kernels on each event before fitting (BenchmarkFoMKernels)
+  bool fBenchmarkFoMKernels = false;
+  int fBenchmarkFoMTrials = 200;
+  
+  /// Grid seed search (FitAllOnSeedGrid mode): "Full" fits every seed, "Adaptive"
+  /// only the best fAdaptiveSeedsKept after fAdaptiveRefineDepth refinement steps
+  std::string fSeedSearch = "Full";
+  int fAdaptiveSeedsKept = 10;
+  int fAdaptiveRefineDepth = 2;
+  bool fCompareAdaptiveToFullGrid = false;
+  
+  /// Adaptive seed search report, summed over events
+  long fAdaptiveEvents = 0;
+  long fAdaptiveFitsSaved = 0;
+  long fAdaptiveCompared = 0;
+  double fSumAdaptiveShift = 0.;       // |adaptive - full grid| position, cm
+  double fSumAdaptiveAngle = 0.;       // angle between the fitted directions, deg
+  double fSumAdaptiveDeltaFOM = 0.;    // adaptive - full grid FOM
+  long fAdaptiveTruthCompared = 0;
+  double fSumAdaptiveTruthError = 0.;  // distance to the true vertex, cm
+  double fSumFullTruthError = 0.;
+  
   /// verbosity levels: if 'verbosity' < this level, the message type will be logged.
   int verbosity=-1;
   int v_error=0;
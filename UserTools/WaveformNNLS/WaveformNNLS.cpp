@@ -31,6 +31,9 @@ time-series.
 #include <TCanvas.h>
 #include <math.h>
 #include <string>
+#include <sstream>
+#include <chrono>
+#include <algorithm>
 
 
 
@@ -46,21 +49,9 @@ bool WaveformNNLS::Initialise(std::string configfile, DataModel &data){
   m_data= &data; //assigning transient data pointer
   /////////////////////////////////////////////////////////////////
 
-  return true;
-}
-
-
-bool WaveformNNLS::Execute(){
-
-	
-
 	//rawdata loaded in format of LAPPDSim
-	string RawDataName;
 	m_variables.Get("rawdataname", RawDataName);
 
-	map<int,vector<Waveform<double>>> rawData;
-	m_data->Stores["ANNIEEvent"]->Get(RawDataName,rawData);
-
 	//This variable controls the sampling depth of the
 	//nnls algorithm and allows the template to have
 	//more samples than the signal waveform. The template
@@ -68,24 +59,55 @@ bool WaveformNNLS::Execute(){
 	//number of samples. The timestep between template
 	//and signal waveform is made equal by expanding the
 	//signal waveform to a larger number of total samples. 
-	double samplingFactor;
 	m_variables.Get("sampling_factor", samplingFactor);
 
 	//you can use any template you want for the 
 	//algorithm. It assumes that it is a histogram
 	//in a root file named ""
-	TString tempfilename = "dummy.root";
+	tempfilename = "dummy.root";
 	m_variables.Get("tempfilename", tempfilename);
-	TString temphistname = "dummy";
+	temphistname = "dummy";
 	m_variables.Get("temphistname", temphistname);
 
-	//get the template waveform. This assumes
-	//that the file is .root file with a TH1D
-	//named templatehistname
+	//maximum number of nnls iterations
+	maxiter = 20;
+	m_variables.Get("maxiter", maxiter);
+
+	//the template matrix is banded: each row holds the template
+	//shifted by one sample. "Banded" (default) stores only the
+	//template and does the matrix products in O(nrows*ntemplate);
+	//"Dense" builds the full nrows x nrows matrix as before.
+	string matrixtype = "Banded";
+	m_variables.Get("NNLSMatrix", matrixtype);
+	useDenseMatrix = (matrixtype == "Dense");
+
+	//optional comma separated list of trace lengths, e.g. 256,1024,4096, for which
+	//dense and banded solves are timed and compared in Finalise
+	benchmarkLengths = "";
+	m_variables.Get("BenchmarkTraceLengths", benchmarkLengths);
+
+	if(!LoadTemplate()) return false;
+
+	solver = new nnls();
+
+  return true;
+}
+
+//get the template waveform. This assumes
+//that the file is .root file with a TH1D
+//named templatehistname. The template does
+//not change during a run, so the file is only read once.
+bool WaveformNNLS::LoadTemplate()
+{
 	TFile* tempfile = new TFile(tempfilename, "READ");
 	TH1D* temphist = (TH1D*)tempfile->Get(temphistname);
-	Waveform<double> tempwave; //signal of template
-	vector<double> temptimes;  //times of template
+	if(!temphist)
+	{
+		cout << "WaveformNNLS: could not find template " << temphistname << " in " << tempfilename << endl;
+		tempfile->Close();
+		delete tempfile;
+		return false;
+	}
 	int nbins = temphist->GetNbinsX(); 
 	double binwidth = temphist->GetBinWidth(0); //should be in ns
 	double starttime = temphist->GetBinLowEdge(0); //first time in template histogram, used to set template to start at 0ps
@@ -95,7 +117,7 @@ bool WaveformNNLS::Execute(){
 	//raw data. Even if the raw data is sampled at a non-constant
 	//rate (for example, well calibrated LAPPD electronics), the raw
 	//waveform is re-sampled (not interpolated) at this new timestep
-	double newtimestep = binwidth*samplingFactor; //in ps
+	newtimestep = binwidth*samplingFactor; //in ps
 
 	// check units and such
 	/*
@@ -119,6 +141,16 @@ bool WaveformNNLS::Execute(){
 		temptimes.push_back((t - starttime)); 
 	}
 
+	tempfile->Close();
+	delete tempfile;
+	return true;
+}
+
+
+bool WaveformNNLS::Execute(){
+
+	map<int,vector<Waveform<double>>> rawData;
+	m_data->Stores["ANNIEEvent"]->Get(RawDataName,rawData);
 
 	//It is necessary to make sure that the template
 	//and the rawdata are on the same time-scale. 
@@ -172,27 +204,28 @@ bool WaveformNNLS::Execute(){
 	//waveform and the signal waveform. Here, we get
 	//the signal waveform and expand it to that nrows sampling rate
 	map <int, vector<Waveform<double>>> :: iterator itr;
-    Waveform<double> signalwave; 
     size_t nrows = newsignaltimes.size();
     int flag; //error flag on nnls solver
 
-    cout << "doing a " << nrows << " x " << nrows << " = " << nrows*nrows << " matrix " << endl;
-
     //***Assumes all waveforms are same number of samples
     //a number of things in this tool would change if that
     //were not the case
 
     //initialize the main algebra variables
-    //for the nnls algo
-
-    //maximum number of nnls iterations
-	int maxiter;
-	m_variables.Get("maxiter", maxiter);
-
-    nnlsvector* b = new nnlsvector(nrows);
-    nnlsvector* x = new nnlsvector(nrows);
-    nnlsmatrix* A = new denseMatrix(nrows, nrows);
-    BuildTemplateMatrix(A, tempwave, nrows);
+    //for the nnls algo. They are kept until the
+    //number of samples changes.
+    if(nrows != matrix_rows)
+    {
+    	cout << "doing a " << nrows << " x " << nrows << (useDenseMatrix ? " dense" : " banded") << " matrix" << endl;
+    	delete A;
+    	delete b;
+    	delete bsolv;
+    	A = MakeTemplateMatrix(useDenseMatrix, nrows);
+    	b = new nnlsvector(nrows);
+    	bsolv = new nnlsvector(nrows);
+    	matrix_rows = nrows;
+    }
+    solver->setMaxit(maxiter);
 
     //The solution to the NNLS algorithm is 
     //stored in a class defined in the DataModel. 
@@ -214,19 +247,19 @@ bool WaveformNNLS::Execute(){
     	//of the vector<Waveform<double>> component of the rawData
     	//populated. Is this true with PMTs? If not, you will need 
     	//another loop here. 
-    	signalwave = itr->second.front(); 
+    	const Waveform<double>& signalwave = itr->second.front(); 
     	
 		//pass the signal vector pointer that gets
 		//modified in the following function
 		BuildWaveformVector(b, signalwave, sampletimes, newtimestep);
     	
-    	nnls* solver = new nnls(A, b, maxiter);
+    	solver->setData(A, b);
     	flag = solver->optimize();
     	if(flag < 0)
     	{
     		cout << "NNLS solver terminated with an error flag" << endl;
     	}
-    	x = solver->getSolution();
+    	nnlsvector* x = solver->getSolution();
 
     	SaveNNLSOutput(&soln[ch], A, x, newsignaltimes);
     }
@@ -239,6 +272,20 @@ bool WaveformNNLS::Execute(){
 	return true;
 }
 
+//builds the template matrix for nrows resampled samples, either
+//as a full denseMatrix or as a toeplitzMatrix that only keeps the template
+nnlsmatrix* WaveformNNLS::MakeTemplateMatrix(bool dense, size_t nrows)
+{
+	if(dense)
+	{
+		nnlsmatrix* dm = new denseMatrix(nrows, nrows);
+		BuildTemplateMatrix(dm, tempwave, nrows);
+		return dm;
+	}
+	const vector<double>* temp = tempwave.GetSamples();
+	return new toeplitzMatrix(nrows, nrows, temp->data(), temp->size());
+}
+
 //makes the nnls matrix A given a root template file. 
 //The algorithm requires a careful accounting of the
 //number of samples in both the template and the signal waveform.
@@ -288,9 +335,13 @@ void WaveformNNLS::BuildTemplateMatrix(nnlsmatrix* A, Waveform<double> tempwave,
 
 //formats the waveform into the vector format expected by nnls algo.
 //see comment above BuildTemplateMatrix for explanation of nrows
-void WaveformNNLS::BuildWaveformVector(nnlsvector* b, Waveform<double> wave, vector<float> times, double template_timestep)
+void WaveformNNLS::BuildWaveformVector(nnlsvector* b, const Waveform<double>& wave, const vector<float>& times, double template_timestep)
 {
 
+	//the vector is reused between channels, clear samples
+	//that fall outside of the waveform
+	b->zeroOut();
+
 	//make a new signal vector that is
 	//NOT interpolated, but has more samples
 	// so that the timesteps of the template
@@ -329,11 +380,10 @@ void WaveformNNLS::BuildWaveformVector(nnlsvector* b, Waveform<double> wave, vec
 //Each element of x represents a template waveform scaled by
 //the magnitude of the element and placed at a time "t" 
 //(read off of the index of the element)
-void WaveformNNLS::SaveNNLSOutput(NnlsSolution* soln, nnlsmatrix* A, nnlsvector* x, vector<double> signaltimes)
+void WaveformNNLS::SaveNNLSOutput(NnlsSolution* soln, nnlsmatrix* A, nnlsvector* x, const vector<double>& signaltimes)
 {
 
 	//first, the fully composed (full fit) solution
-	nnlsvector* bsolv = new nnlsvector(x->length());
 	A->dot(false, x, bsolv); //now bsolv is the fitted vector waveform
 	//turn vector into waveform
 	Waveform<double> ff; //waveform version of nnls full (summed) solution
@@ -364,7 +414,78 @@ void WaveformNNLS::SaveNNLSOutput(NnlsSolution* soln, nnlsmatrix* A, nnlsvector*
 
 
 
+//solves the same synthetic trace with the dense and the banded
+//template matrix for each configured trace length, and prints
+//the solve times and the largest difference between the solutions
+void WaveformNNLS::BenchmarkTraceLengths()
+{
+	string lengthlist = benchmarkLengths;
+	std::replace(lengthlist.begin(), lengthlist.end(), ',', ' ');
+	std::stringstream lengths(lengthlist);
+	size_t n;
+	nnls benchsolver;
+	benchsolver.setVerbose(false);
+	benchsolver.setMaxit(maxiter);
+
+	cout << "WaveformNNLS: dense vs banded NNLS, " << maxiter << " iterations max, "
+		<< tempwave.GetSamples()->size() << " template samples" << endl;
+	while(lengths >> n)
+	{
+		if(n == 0) continue;
+		nnlsmatrix* banded = MakeTemplateMatrix(false, n);
+		auto buildstart = std::chrono::steady_clock::now();
+		nnlsmatrix* dense = MakeTemplateMatrix(true, n);
+		double buildtime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - buildstart).count();
+
+		//a few template pulses of different heights
+		nnlsvector truth(n);
+		truth.set(n/5, 1.0);
+		truth.set(n/2, 0.5);
+		truth.set((3*n)/4, 2.0);
+		nnlsvector trace(n);
+		banded->dot(false, &truth, &trace);
+
+		benchsolver.setData(dense, &trace);
+		auto densestart = std::chrono::steady_clock::now();
+		benchsolver.optimize();
+		double densetime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - densestart).count();
+		nnlsvector densesoln(n);
+		densesoln.copy(benchsolver.getSolution());
+
+		benchsolver.setData(banded, &trace);
+		auto bandedstart = std::chrono::steady_clock::now();
+		benchsolver.optimize();
+		double bandedtime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - bandedstart).count();
+		nnlsvector* bandedsoln = benchsolver.getSolution();
+
+		double maxdiff = 0.;
+		for(size_t i = 0; i < n; i++)
+		{
+			maxdiff = std::max(maxdiff, fabs(densesoln.get(i) - bandedsoln->get(i)));
+		}
+
+		cout << "  trace length " << n << ": dense build " << buildtime << " ms, dense solve "
+			<< densetime << " ms, banded solve " << bandedtime << " ms, speedup "
+			<< (bandedtime > 0. ? densetime/bandedtime : 0.) << ", max |x_dense - x_banded| = " << maxdiff << endl;
+
+		delete dense;
+		delete banded;
+	}
+}
+
+
 bool WaveformNNLS::Finalise(){
 
+  if(benchmarkLengths != "") BenchmarkTraceLengths();
+
+  delete solver;
+  delete A;
+  delete b;
+  delete bsolv;
+  solver = nullptr;
+  A = nullptr;
+  b = nullptr;
+  bsolv = nullptr;
+
   return true;
 }
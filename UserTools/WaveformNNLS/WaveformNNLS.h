@@ -3,7 +3,9 @@
 
 #include <string>
 #include <iostream>
+#include <vector>
 #include "nnls.h"
+#include "toeplitzMatrix.h"
 
 #include <TFile.h>
 #include <TString.h>
@@ -22,13 +24,40 @@ class WaveformNNLS: public Tool {
   bool Execute();
   bool Finalise();
   void BuildTemplateMatrix(nnlsmatrix* A, Waveform<double> tempwave, size_t nrows); //makes the nnls matrix A given a root template file
-  void BuildWaveformVector(nnlsvector* b, Waveform<double> wave, vector<float> times, double template_timestep); //formats the waveform into the vector format expected by nnls algo
-  void SaveNNLSOutput(NnlsSolution* soln, nnlsmatrix* A, nnlsvector* x, vector<double> signaltimes);
+  void BuildWaveformVector(nnlsvector* b, const Waveform<double>& wave, const vector<float>& times, double template_timestep); //formats the waveform into the vector format expected by nnls algo
+  void SaveNNLSOutput(NnlsSolution* soln, nnlsmatrix* A, nnlsvector* x, const vector<double>& signaltimes);
 
 
 
  private:
 
+  bool LoadTemplate(); //reads the template histogram once, in Initialise
+  nnlsmatrix* MakeTemplateMatrix(bool dense, size_t nrows); //banded (Toeplitz) or dense template matrix
+  void BenchmarkTraceLengths(); //times dense vs banded solves for the configured trace lengths
+
+  //configuration
+  string RawDataName;
+  double samplingFactor;
+  TString tempfilename;
+  TString temphistname;
+  int maxiter;
+  bool useDenseMatrix; //"NNLSMatrix Dense" keeps the original dense template matrix
+  string benchmarkLengths; //comma separated list of trace lengths
+
+  //template, cached in Initialise
+  Waveform<double> tempwave; //signal of template
+  vector<double> temptimes;  //times of template
+  double newtimestep; //template time step after resampling, in ps
+
+  //workspace reused across channels and events. The matrix,
+  //signal vector and fitted vector are only rebuilt when the
+  //number of resampled samples changes.
+  nnlsmatrix* A = nullptr;
+  nnlsvector* b = nullptr;
+  nnlsvector* bsolv = nullptr;
+  nnls* solver = nullptr;
+  size_t matrix_rows = 0;
+
 
 
 
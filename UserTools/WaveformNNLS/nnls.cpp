@@ -43,8 +43,10 @@ int nnls::optimize()
   double step;
   double *px = x->getData();
 
-  cerr << "Iter           Obj           ||g||" << endl;
-  cerr << "----------------------------------" << endl;
+  if (verbose) {
+    cerr << "Iter           Obj           ||g||" << endl;
+    cerr << "----------------------------------" << endl;
+  }
 
   while (!term) {
     out.iter++;
@@ -70,16 +72,16 @@ int nnls::optimize()
 
     computeObjGrad();
     // check the descent condition
-    if (out.iter % M == 0) {
+    // (needs the objective from M iterations ago)
+    if (out.iter >= M && out.iter % M == 0) {
       checkDescentUpdateBeta();
     }
-    if (out.iter % 10 == 0)
+    if (verbose && out.iter % 10 == 0)
       showStatus();
 
     //return 0;
   }
-  showStatus();
-  cleanUp();
+  if (verbose) showStatus();
   return 0;
 }
 
@@ -201,36 +203,56 @@ void nnls::checkDescentUpdateBeta()
   }
 }
 
-int nnls::initialize()
+void nnls::allocate()
 {
   size_t n = A->ncols();
-  x = new nnlsvector(n);
-  g = new nnlsvector(n);
-  refx = new nnlsvector(n);
-  refg = new nnlsvector(n);
-  oldx = new nnlsvector(n);
-  oldg = new nnlsvector(n);
-  xdelta = new nnlsvector(n);
-  gdelta =  new nnlsvector(n);
-  out.memory += 8*n*sizeof(double);
+  if (!x || x->length() != n) {
+    delete x; delete g; delete refx; delete refg;
+    delete oldx; delete oldg; delete xdelta; delete gdelta;
+    free(fset);
+    x = new nnlsvector(n);
+    g = new nnlsvector(n);
+    refx = new nnlsvector(n);
+    refg = new nnlsvector(n);
+    oldx = new nnlsvector(n);
+    oldg = new nnlsvector(n);
+    xdelta = new nnlsvector(n);
+    gdelta =  new nnlsvector(n);
+    out.memory += 8*n*sizeof(double);
+
+    fset = (size_t*) malloc(sizeof(size_t)*n);
+
+    out.memory += sizeof(size_t)*n;
+  }
 
-  ax = new nnlsvector(A->nrows());
-  out.memory += sizeof(double)*ax->length();
+  if (!ax || ax->length() != A->nrows()) {
+    delete ax;
+    ax = new nnlsvector(A->nrows());
+    out.memory += sizeof(double)*ax->length();
+  }
 
+  if (!out.obj || out.obj->length() != size_t(maxit+1)) {
+    delete out.obj; delete out.pgnorms; delete out.time;
+    out.obj = new nnlsvector(maxit+1);
+    out.pgnorms = new nnlsvector(maxit+1);
+    out.time = new nnlsvector(maxit+1);
 
-  fset = (size_t*) malloc(sizeof(size_t)*n);
+    out.memory += sizeof(double)*3*(maxit+1);
+  }
+}
 
-  out.memory += sizeof(size_t)*n;
+int nnls::initialize()
+{
+  allocate();
 
+  // start from the same state as a freshly constructed solver
+  out.iter = -1;
+  beta = beta0;
+  oldx->zeroOut();
+  oldg->zeroOut();
 
   x->setAll(.5);
 
-  out.obj = new nnlsvector(maxit+1);
-  out.pgnorms = new nnlsvector(maxit+1);
-  out.time = new nnlsvector(maxit+1);
-
-  out.memory += sizeof(double)*3*(maxit+1);
-
 
   if (x0) {
 
@@ -302,12 +324,21 @@ void nnls::showStatus()
 
 int nnls::cleanUp()
 {
+  delete x;
+  delete g;
   delete ax;
   delete oldx;
   delete oldg;
   delete xdelta;
   delete gdelta;
-  delete fset;
+  free(fset);
   delete refx;
+  delete refg;
+  delete out.obj;
+  delete out.pgnorms;
+  delete out.time;
+  x = g = ax = oldx = oldg = xdelta = gdelta = refx = refg = 0;
+  fset = 0;
+  out.obj = out.pgnorms = out.time = 0;
   return 0;
 }
@@ -53,6 +53,8 @@ private:
   int   M;                    // max num. of null iterations
   double decay;               // parameter to make diminishing scalar to decay by
   double beta;                // diminishing scalar
+  double beta0;               // diminishing scalar at the start of a solve
+  bool verbose;               // print the iteration status
   double pgtol;               // projected gradient tolerance
   double sigma;               // constant for descent condition
 
@@ -74,6 +76,7 @@ private:
   int    checkTermination();      // embodies various termination criteria
   void   showStatus();            // 
   int    cleanUp();               // memory deallocation and friends
+  void   allocate();              // (re)allocates the workspace if the problem size changed
   void   findFixedVariables();    // compute fixed set (binding set)
   void   computeXandGradDelta();  //  
   void   computeObjGrad();        // compute both together to sav time
@@ -83,19 +86,26 @@ private:
 
   // The actual interface to the world!
 public:
-  nnls() { x = 0; A = 0; b = 0; maxit = 0;}
+  nnls() { init(0, 0, 0); }
 
-  nnls (nnlsmatrix* A, nnlsvector* b, int maxit) {
+  nnls (nnlsmatrix* A, nnlsvector* b, int maxit) { init(A, b, maxit); }
+
+  nnls (nnlsmatrix* A, nnlsvector* b, nnlsvector* x0, int maxit)  { init(A, b, maxit); this->x0 = x0;}
+
+  // The workspace is kept between calls to optimize() and freed here
+  ~nnls(){ cleanUp(); }
+
+private:
+  void init(nnlsmatrix* A, nnlsvector* b, int maxit) {
     this->x = 0; this->A = A; this->b = b;
     this->maxit = maxit; this->x0 = 0;
-    out.obj = 0; out.iter = -1; out.time = 0;
-    fset = 0; out.memory = 0;
+    g = oldx = oldg = xdelta = gdelta = refx = refg = ax = 0;
+    out.obj = 0; out.iter = -1; out.time = 0; out.pgnorms = 0;
+    fset = 0; out.memory = 0; verbose = true;
     // convergence controlling parameters
-    M = 100; beta = 1.0; decay = 0.9; pgtol = 1e-3;  sigma = .01;
+    M = 100; beta = 1.0; beta0 = 1.0; decay = 0.9; pgtol = 1e-3;  sigma = .01;
   }
-
-  nnls (nnlsmatrix* A, nnlsvector* b, nnlsvector* x0, int maxit)  { nnls(A, b, maxit); this->x0 = x0;}
-  ~nnls(){beta = 0.0;}
+public:
 
   // The various accessors and mutators (or whatever one calls 'em!)
 
@@ -111,11 +121,15 @@ public:
 
   void  setDecay(double d) { decay = d;  }
   void  setM(int m)        { M = m;      }
-  void  setBeta(double b)  { beta = b;   }
+  void  setBeta(double b)  { beta = b; beta0 = b; }
   void  setPgTol(double pg){ pgtol = pg; }
   void  setMaxit(size_t m) { maxit = m;  }
   void  setSigma(double s) { sigma = s; }
+  void  setVerbose(bool v) { verbose = v; }
 
+  // A solver can be reused for any number of problems: the workspace is only
+  // reallocated when the size of A changes. The solution returned by
+  // getSolution() is overwritten by the next call to optimize().
   void  setData(nnlsmatrix* A, nnlsvector* b)  { this->A = A; this->b = b;}
 
   // The functions that actually launch the ship, and land it!
@@ -0,0 +1,98 @@
+// File: toeplitzMatrix.cpp -- banded Toeplitz matrix for the WaveformNNLS template fit
+
+#include "toeplitzMatrix.h"
+
+#include <algorithm>
+
+
+toeplitzMatrix::toeplitzMatrix() : nnlsmatrix(0, 0) {}
+
+
+toeplitzMatrix::toeplitzMatrix(size_t r, size_t c, const double* temp, size_t len)
+  : nnlsmatrix(r, c), band(temp, temp + len) {}
+
+
+toeplitzMatrix::~toeplitzMatrix() {}
+
+
+/// Returns 'r'-th row into pre-alloced nnlsvector
+int toeplitzMatrix::get_row (size_t i, nnlsvector*& v)
+{
+  if (i >= nrows() || v->length() < ncols()) return -1;
+  double* pv = v->getData();
+  for (size_t j = 0; j < ncols(); j++) pv[j] = get(i, j);
+  return 0;
+}
+
+/// Returns 'c'-th col as a nnlsvector
+int toeplitzMatrix::get_col (size_t j, nnlsvector*& c)
+{
+  if (j >= ncols() || c->length() < nrows()) return -1;
+  double* pc = c->getData();
+  for (size_t i = 0; i < nrows(); i++) pc[i] = get(i, j);
+  return 0;
+}
+
+/// Returns main or second diagonal (if p == true)
+int toeplitzMatrix::get_diag(bool p, nnlsvector*& d)
+{
+  size_t offset = p ? 1 : 0;
+  size_t n = std::min(nrows(), ncols());
+  if (d->length() < n) return -1;
+  double* pd = d->getData();
+  for (size_t i = 0; i < n; i++) pd[i] = get(i, i + offset);
+  return 0;
+}
+
+/// r = a*row(i) + r
+int    toeplitzMatrix::row_daxpy(size_t i, double a, nnlsvector* r)
+{
+  if (i >= nrows()) return -1;
+  double* pr = r->getData();
+  size_t end = std::min(ncols(), i + band.size());
+  for (size_t j = i; j < end; j++) pr[j] += a * band[j - i];
+  return 0;
+}
+
+/// c = a*col(j) + c
+int  toeplitzMatrix::col_daxpy(size_t j, double a, nnlsvector* c)
+{
+  if (j >= ncols()) return -1;
+  double* pc = c->getData();
+  size_t first = (j + 1 > band.size()) ? j + 1 - band.size() : 0;
+  size_t end = std::min(nrows(), j + 1);
+  for (size_t i = first; i < end; i++) pc[i] += a * band[j - i];
+  return 0;
+}
+
+/// Let r := this * x or  this^T * x depending on tranA
+int toeplitzMatrix::dot (bool transp, nnlsvector* x, nnlsvector*r)
+{
+  double* pr = r->getData();
+  double* px = x->getData();
+  const double* pt = band.data();
+  size_t L = band.size();
+  r->zeroOut();
+
+  if (!transp) {
+    // M*x: row i only overlaps columns i .. i+L-1
+    for (size_t i = 0; i < nrows(); i++) {
+      if (i >= ncols()) break;
+      size_t len = std::min(L, ncols() - i);
+      const double* pxi = px + i;
+      double sum = 0.0;
+      for (size_t k = 0; k < len; k++) sum += pt[k] * pxi[k];
+      pr[i] = sum;
+    }
+  } else {                      // M'*x
+    // scatter row i into r, in the same order as the dense product
+    for (size_t i = 0; i < nrows(); i++) {
+      if (i >= ncols()) break;
+      size_t len = std::min(L, ncols() - i);
+      double* pri = pr + i;
+      double xi = px[i];
+      for (size_t k = 0; k < len; k++) pri[k] += pt[k] * xi;
+    }
+  }
+  return 0;
+}
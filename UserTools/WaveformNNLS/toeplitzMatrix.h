@@ -0,0 +1,93 @@
+// File: toeplitzMatrix.h -*- c++ -*-
+// Banded Toeplitz matrix for the WaveformNNLS template fit.
+//
+// The template matrix used by WaveformNNLS has the template waveform written
+// into every row, shifted by one sample per row: A(i,j) = t[j-i] for
+// 0 <= j-i < L and 0 otherwise, with L the number of template samples.
+// Only the L template samples are stored and the products A*x and A'*x cost
+// O(nrows*L) instead of O(nrows*ncols). The products accumulate in the same
+// order as denseMatrix::dot (without BLAS), so the NNLS solver iterates
+// exactly as it does on the equivalent denseMatrix.
+
+#ifndef toeplitzMatrix_H
+#define toeplitzMatrix_H
+
+#include <vector>
+
+#include "nnlsmatrix.h"
+
+class toeplitzMatrix : public nnlsmatrix {
+std::vector<double> band;       // the template samples t[0..L-1]
+public:
+
+
+toeplitzMatrix();
+
+/// r x c matrix built from the 'len' template samples in 'temp'
+toeplitzMatrix(size_t r, size_t c, const double* temp, size_t len);
+
+~toeplitzMatrix();
+
+
+/// Not supported: the matrix is defined by its template
+int load(const char* fn, bool asbin) { return -1; }
+
+/// Resize the matrix, keeping the template
+void resize(size_t r, size_t c) { setsize(r, c); }
+
+/// Replace the template samples
+void setTemplate(const double* temp, size_t len) { band.assign(temp, temp + len); }
+
+/// Number of template samples
+size_t bandwidth() const { return band.size(); }
+
+/// Get the (i,j) entry of the matrix
+double operator()   (size_t i, size_t j) { return get(i, j); }
+
+/// Get the (i,j) entry of the matrix
+double get (size_t i, size_t j) { return (j >= i && j - i < band.size()) ? band[j - i] : 0.0; }
+
+/// Not supported: entries are shared along each diagonal
+int set (size_t i, size_t j, double val) { return -1; }
+
+
+/// Returns 'r'-th row into pre-alloced nnlsvector
+int get_row (size_t, nnlsvector*&);
+/// Returns 'c'-th col as a nnlsvector
+int get_col (size_t, nnlsvector*&);
+/// Returns main or second diagonal (if p == true)
+int get_diag(bool p, nnlsvector*& d);
+
+/// Sets the specified row to the given nnlsvector
+int set_row(size_t r, nnlsvector*&) { return -1; }
+/// Sets the specified col to the given nnlsvector
+int set_col(size_t c, nnlsvector*&) { return -1; }
+/// Sets the specified diagonal to the given nnlsvector
+int set_diag(bool p, nnlsvector*&) { return -1; }
+
+/// nnlsvector l_p norms for this matrix, p > 0
+double norm (double p) { return -1; }
+/// nnlsvector l_p norms, p is 'l1', 'l2', 'fro', 'inf'
+double norm (const char*  p) { return -1; }
+
+/// Not supported: fn(0) would fill the zeros outside the band
+int apply (double (* fn)(double)) { return -1; }
+
+/// Scale the matrix so that x_ij := s * x_ij
+int scale (double s) { for (size_t k = 0; k < band.size(); k++) band[k] *= s; return 0; }
+
+/// Not supported: the matrix would no longer be banded
+int add_const(double s) { return -1; }
+
+/// r = a*row(i) + r
+ int    row_daxpy(size_t i, double a, nnlsvector* r);
+/// c = a*col(j) + c
+ int  col_daxpy(size_t j, double a, nnlsvector* c);
+
+/// Let r := this * x or  this^T * x depending on tranA
+int dot (bool transp, nnlsvector* x, nnlsvector*r);
+
+size_t memoryUsage() { return band.size()*sizeof(double); }
+};
+
+#endif